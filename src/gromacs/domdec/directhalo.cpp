@@ -0,0 +1,374 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ *
+ * \brief This file implements the direct halo communication.
+ *
+ * \ingroup module_domdec
+ */
+
+#include "gmxpre.h"
+
+#include "directhalo.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+
+#include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/domdec_internal.h"
+#include "gromacs/domdec/domdec_network.h"
+#include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxmpi.h"
+
+
+bool dd_direct_halo_is_supported(const gmx_domdec_t *dd)
+{
+    const gmx_domdec_comm_t *comm = dd->comm;
+
+    if (!GMX_MPI || !comm->useDirectHalo || dd->ndim < 2 || dd->bScrewPBC)
+    {
+        return false;
+    }
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        if (comm->cd[d].numPulses() != 1)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#if GMX_MPI
+/*! \brief Spreads the home atom indices over the zones with the staged communication
+ *
+ * After this call, \p v contains for each zone atom its index
+ * in the home atom range of the rank the atom originates from.
+ */
+static void spreadOriginIndex(gmx_domdec_t *dd, std::vector<int> *v)
+{
+    gmx_domdec_comm_t            *comm         = dd->comm;
+    const gmx::RangePartitioning &atomGrouping = dd->atomGrouping();
+
+    v->resize(comm->atomRanges.end(DDAtomRanges::Type::Zones));
+
+    int nat_tot = comm->atomRanges.numHomeAtoms();
+    for (int i = 0; i < nat_tot; i++)
+    {
+        (*v)[i] = i;
+    }
+
+    int nzone = 1;
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        const gmx_domdec_comm_dim_t &cd = comm->cd[d];
+        for (const gmx_domdec_ind_t &ind : cd.ind)
+        {
+            std::vector<int> sendBuffer;
+            sendBuffer.reserve(ind.nsend[nzone + 1]);
+            for (int g : ind.index)
+            {
+                for (int j : atomGrouping.block(g))
+                {
+                    sendBuffer.push_back((*v)[j]);
+                }
+            }
+
+            std::vector<int> receiveBuffer(ind.nrecv[nzone + 1]);
+            ddSendrecv<int>(dd, d, dddirBackward,
+                            sendBuffer, receiveBuffer);
+            if (cd.receiveInPlace)
+            {
+                std::copy(receiveBuffer.begin(), receiveBuffer.end(),
+                          v->begin() + nat_tot);
+            }
+            else
+            {
+                int j = 0;
+                for (int zone = 0; zone < nzone; zone++)
+                {
+                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+                    {
+                        (*v)[i] = receiveBuffer[j++];
+                    }
+                }
+            }
+            nat_tot += ind.nrecv[nzone + 1];
+        }
+        nzone += nzone;
+    }
+}
+#endif
+
+void dd_direct_halo_setup(gmx_domdec_t *dd)
+{
+    gmx_domdec_comm_t *comm = dd->comm;
+    DirectHalo        &dh   = comm->directHalo;
+
+    dh.active = dd_direct_halo_is_supported(dd);
+    if (!dh.active)
+    {
+        return;
+    }
+
+#if GMX_MPI
+    const gmx_domdec_zones_t     &zones        = comm->zones;
+    const gmx::RangePartitioning &atomGrouping = dd->atomGrouping();
+
+    spreadOriginIndex(dd, &dh.originIndex);
+
+    dh.zones.resize(zones.n - 1);
+    int bufferSize = 0;
+    for (int zone = 1; zone < zones.n; zone++)
+    {
+        DirectHaloZone &dhz = dh.zones[zone - 1];
+
+        dhz.zone = zone;
+        copy_ivec(zones.shift[zone], dhz.shift);
+
+        ivec sendCoord, receiveCoord;
+        for (int dim = 0; dim < DIM; dim++)
+        {
+            sendCoord[dim]    = (dd->ci[dim] - dhz.shift[dim] + dd->nc[dim]) % dd->nc[dim];
+            receiveCoord[dim] = (dd->ci[dim] + dhz.shift[dim]) % dd->nc[dim];
+        }
+        dhz.sendRank    = ddcoord2ddnodeid(dd, sendCoord);
+        dhz.receiveRank = ddcoord2ddnodeid(dd, receiveCoord);
+
+        gmx::RangePartitioning::Block atoms =
+            atomGrouping.subRange(zones.cg_range[zone], zones.cg_range[zone + 1]);
+        dhz.receiveStart = *atoms.begin();
+        dhz.receiveEnd   = *atoms.end();
+
+        /* Request our zone atoms from the origin rank and receive
+         * the list of home atoms requested by the destination rank.
+         */
+        int        numRequest = dhz.receiveEnd - dhz.receiveStart;
+        int        numSend;
+        MPI_Status mpiStatus;
+        MPI_Sendrecv(&numRequest, 1, MPI_INT, dhz.receiveRank, zone,
+                     &numSend,    1, MPI_INT, dhz.sendRank,    zone,
+                     dd->mpi_comm_all, &mpiStatus);
+        dhz.sendIndex.resize(numSend);
+        MPI_Sendrecv(dh.originIndex.data() + dhz.receiveStart, numRequest, MPI_INT,
+                     dhz.receiveRank, zone,
+                     dhz.sendIndex.data(), numSend, MPI_INT,
+                     dhz.sendRank, zone,
+                     dd->mpi_comm_all, &mpiStatus);
+
+        bufferSize += std::max(numSend, numRequest);
+    }
+    dh.buffer.resize(bufferSize);
+#endif
+}
+
+void dd_direct_halo_move_x_start(gmx_domdec_t             *dd,
+                                 const matrix              box,
+                                 gmx::ArrayRef<gmx::RVec>  x)
+{
+#if GMX_MPI
+    DirectHalo &dh          = dd->comm->directHalo;
+    int        &numRequests = dh.numRequests;
+
+    GMX_ASSERT(dh.active, "Direct halo communication should be active");
+    GMX_ASSERT(numRequests == 0, "No halo communication should be in flight");
+
+    int offset = 0;
+    for (const DirectHaloZone &dhz : dh.zones)
+    {
+        int numReceive = dhz.receiveEnd - dhz.receiveStart;
+        if (numReceive > 0)
+        {
+            MPI_Irecv(x.data() + dhz.receiveStart, numReceive*sizeof(gmx::RVec), MPI_BYTE,
+                      dhz.receiveRank, dhz.zone,
+                      dd->mpi_comm_all, &dh.requests[numRequests++]);
+        }
+
+        int numSend = dhz.sendIndex.size();
+        if (numSend > 0)
+        {
+            /* Apply the same shifts, in the same order, as the staged
+             * communication does, so the result is identical.
+             */
+            bool  bPBC = false;
+            rvec  shift[DIM];
+            int   numShift = 0;
+            for (int d = 0; d < dd->ndim; d++)
+            {
+                int dim = dd->dim[d];
+                if (dhz.shift[dim] == 1 && dd->ci[dim] == 0)
+                {
+                    copy_rvec(box[dim], shift[numShift++]);
+                    bPBC = true;
+                }
+            }
+
+            gmx::RVec *sendBuffer = dh.buffer.data() + offset;
+            if (!bPBC)
+            {
+                for (int i = 0; i < numSend; i++)
+                {
+                    sendBuffer[i] = x[dhz.sendIndex[i]];
+                }
+            }
+            else
+            {
+                for (int i = 0; i < numSend; i++)
+                {
+                    sendBuffer[i] = x[dhz.sendIndex[i]];
+                    for (int s = 0; s < numShift; s++)
+                    {
+                        for (int d = 0; d < DIM; d++)
+                        {
+                            sendBuffer[i][d] += shift[s][d];
+                        }
+                    }
+                }
+            }
+            MPI_Isend(sendBuffer, numSend*sizeof(gmx::RVec), MPI_BYTE,
+                      dhz.sendRank, dhz.zone,
+                      dd->mpi_comm_all, &dh.requests[numRequests++]);
+            offset += numSend;
+        }
+    }
+#else
+    GMX_UNUSED_VALUE(dd);
+    GMX_UNUSED_VALUE(box);
+    GMX_UNUSED_VALUE(x);
+#endif
+}
+
+void dd_direct_halo_move_x_wait(gmx_domdec_t *dd)
+{
+#if GMX_MPI
+    DirectHalo &dh = dd->comm->directHalo;
+
+    MPI_Waitall(dh.numRequests, dh.requests.data(), MPI_STATUSES_IGNORE);
+    dh.numRequests = 0;
+#else
+    GMX_UNUSED_VALUE(dd);
+#endif
+}
+
+void dd_direct_halo_move_x(gmx_domdec_t             *dd,
+                           const matrix              box,
+                           gmx::ArrayRef<gmx::RVec>  x)
+{
+    dd_direct_halo_move_x_start(dd, box, x);
+    dd_direct_halo_move_x_wait(dd);
+}
+
+void dd_direct_halo_move_f(gmx_domdec_t             *dd,
+                           gmx::ArrayRef<gmx::RVec>  f,
+                           rvec                     *fshift)
+{
+#if GMX_MPI
+    DirectHalo                                &dh = dd->comm->directHalo;
+    std::array<MPI_Request, c_directHaloMaxNumRequests>  requests;
+    int                                        numRequests = 0;
+
+    GMX_ASSERT(dh.active, "Direct halo communication should be active");
+    GMX_ASSERT(dh.numRequests == 0, "No coordinate halo communication should be in flight");
+
+    int offset = 0;
+    for (const DirectHaloZone &dhz : dh.zones)
+    {
+        int numSend = dhz.receiveEnd - dhz.receiveStart;
+        if (numSend > 0)
+        {
+            MPI_Isend(f.data() + dhz.receiveStart, numSend*sizeof(gmx::RVec), MPI_BYTE,
+                      dhz.receiveRank, dhz.zone,
+                      dd->mpi_comm_all, &requests[numRequests++]);
+        }
+
+        int numReceive = dhz.sendIndex.size();
+        if (numReceive > 0)
+        {
+            MPI_Irecv(dh.buffer.data() + offset, numReceive*sizeof(gmx::RVec), MPI_BYTE,
+                      dhz.sendRank, dhz.zone,
+                      dd->mpi_comm_all, &requests[numRequests++]);
+            offset += numReceive;
+        }
+    }
+
+    MPI_Waitall(numRequests, requests.data(), MPI_STATUSES_IGNORE);
+
+    /* Add the received forces in a fixed order to keep results reproducible */
+    offset = 0;
+    for (const DirectHaloZone &dhz : dh.zones)
+    {
+        int              numReceive    = dhz.sendIndex.size();
+        const gmx::RVec *receiveBuffer = dh.buffer.data() + offset;
+        for (int i = 0; i < numReceive; i++)
+        {
+            rvec_inc(f[dhz.sendIndex[i]], receiveBuffer[i]);
+        }
+
+        if (fshift != nullptr && numReceive > 0)
+        {
+            /* The shift forces are added for each dimension separately,
+             * as the staged communication does.
+             */
+            for (int d = 0; d < dd->ndim; d++)
+            {
+                int dim = dd->dim[d];
+                if (dhz.shift[dim] == 1 && dd->ci[dim] == 0)
+                {
+                    ivec vis;
+                    clear_ivec(vis);
+                    vis[dim] = 1;
+                    int  is  = IVEC2IS(vis);
+                    for (int i = 0; i < numReceive; i++)
+                    {
+                        rvec_inc(fshift[is], receiveBuffer[i]);
+                    }
+                }
+            }
+        }
+        offset += numReceive;
+    }
+#else
+    GMX_UNUSED_VALUE(dd);
+    GMX_UNUSED_VALUE(f);
+    GMX_UNUSED_VALUE(fshift);
+#endif
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ *
+ * \brief This file declares functions for the direct halo communication.
+ *
+ * The standard halo communication sends the zone coordinates in sequential
+ * pulses along the decomposition dimensions, with data for the edge and
+ * corner zones forwarded through the intermediate ranks. With the direct
+ * halo communication, each non-home zone is received directly from the rank
+ * it originates from, so all messages of a halo update are in flight
+ * simultaneously. The zone setup and the communicated volume are identical
+ * to the staged communication; only the routing differs.
+ *
+ * \ingroup module_domdec
+ */
+
+#ifndef GMX_DOMDEC_DIRECTHALO_H
+#define GMX_DOMDEC_DIRECTHALO_H
+
+#include <array>
+#include <vector>
+
+#include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxmpi.h"
+
+//! The maximum number of simultaneous messages, a send and receive per non-home zone
+static constexpr int c_directHaloMaxNumRequests = 2*(DD_MAXZONE - 1);
+
+/*! \internal \brief Direct communication setup for one non-home zone */
+struct DirectHaloZone
+{
+    int              zone;          /**< The zone index */
+    ivec             shift;         /**< The shift of the zone with respect to the home zone */
+    int              sendRank;      /**< The rank we send our home atoms to, at -shift */
+    int              receiveRank;   /**< The rank the zone atoms are received from, at +shift */
+    std::vector<int> sendIndex;     /**< Indices of home atoms to send */
+    int              receiveStart;  /**< Start of the local atom range of the zone */
+    int              receiveEnd;    /**< End of the local atom range of the zone */
+};
+
+/*! \internal \brief Direct halo communication setup and buffers */
+struct DirectHalo
+{
+    bool                                                active = false;   /**< Whether the direct halo communication is used with the current partitioning */
+    std::vector<DirectHaloZone>                         zones;            /**< The non-home zones */
+    std::vector<gmx::RVec>                              buffer;           /**< Send buffer for x, receive buffer for f */
+    std::vector<int>                                    originIndex;      /**< Work array for the home atom indices at the origin */
+    std::array<MPI_Request, c_directHaloMaxNumRequests> requests;         /**< The requests of the coordinate communication in flight */
+    int                                                 numRequests = 0;  /**< The number of coordinate requests in flight */
+};
+
+/*! \brief Returns whether the direct halo communication can be used with the current setup
+ *
+ * Requires a single pulse along all, at least two, decomposition dimensions
+ * and no screw pbc.
+ */
+bool dd_direct_halo_is_supported(const gmx_domdec_t *dd);
+
+/*! \brief Sets up the direct halo communication after setup_dd_communication()
+ *
+ * Deactivates the direct communication when not supported.
+ * Has to be called on all DD ranks.
+ */
+void dd_direct_halo_setup(gmx_domdec_t *dd);
+
+/*! \brief Posts the coordinate communication of all non-home zones
+ *
+ * The coordinates of the non-home zones should not be accessed
+ * before dd_direct_halo_move_x_wait() has been called.
+ */
+void dd_direct_halo_move_x_start(gmx_domdec_t             *dd,
+                                 const matrix              box,
+                                 gmx::ArrayRef<gmx::RVec>  x);
+
+/*! \brief Waits for the coordinate communication posted by dd_direct_halo_move_x_start() */
+void dd_direct_halo_move_x_wait(gmx_domdec_t *dd);
+
+/*! \brief Communicates the coordinates of all non-home zones in one stage */
+void dd_direct_halo_move_x(gmx_domdec_t             *dd,
+                           const matrix              box,
+                           gmx::ArrayRef<gmx::RVec>  x);
+
+/*! \brief Sums the forces of all non-home zones in one stage
+ *
+ * When \p fshift!=nullptr the shift forces are updated.
+ */
+void dd_direct_halo_move_f(gmx_domdec_t             *dd,
+                           gmx::ArrayRef<gmx::RVec>  f,
+                           rvec                     *fshift);
+
+#endif
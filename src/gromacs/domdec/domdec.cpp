@@ -152,7 +152,7 @@ static void ddindex2xyz(const ivec nc, int ind, ivec xyz)
     xyz[ZZ] = ind % nc[ZZ];
 }
 
-static int ddcoord2ddnodeid(gmx_domdec_t *dd, ivec c)
+int ddcoord2ddnodeid(gmx_domdec_t *dd, ivec c)
 {
     int ddindex;
     int ddnodeid = -1;
@@ -300,6 +300,13 @@ void dd_move_x(gmx_domdec_t             *dd,
 {
     wallcycle_start(wcycle, ewcMOVEX);
 
+    if (dd->comm->directHalo.active)
+    {
+        dd_direct_halo_move_x(dd, box, x);
+        wallcycle_stop(wcycle, ewcMOVEX);
+        return;
+    }
+
     int                    nzone, nat_tot;
     gmx_domdec_comm_t     *comm;
     gmx_domdec_comm_dim_t *cd;
@@ -405,6 +412,38 @@ void dd_move_x(gmx_domdec_t             *dd,
     wallcycle_stop(wcycle, ewcMOVEX);
 }
 
+bool dd_async_halo_is_active(const gmx_domdec_t *dd)
+{
+    return dd->comm->useAsyncHalo && dd->comm->directHalo.active;
+}
+
+bool dd_move_x_start(gmx_domdec_t             *dd,
+                     matrix                    box,
+                     gmx::ArrayRef<gmx::RVec>  x,
+                     gmx_wallcycle            *wcycle)
+{
+    if (!dd_async_halo_is_active(dd))
+    {
+        dd_move_x(dd, box, x, wcycle);
+
+        return false;
+    }
+
+    wallcycle_start(wcycle, ewcMOVEX);
+    dd_direct_halo_move_x_start(dd, box, x);
+    wallcycle_stop(wcycle, ewcMOVEX);
+
+    return true;
+}
+
+void dd_move_x_wait(gmx_domdec_t  *dd,
+                    gmx_wallcycle *wcycle)
+{
+    wallcycle_start_nocount(wcycle, ewcMOVEX);
+    dd_direct_halo_move_x_wait(dd);
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
 void dd_move_f(gmx_domdec_t             *dd,
                gmx::ArrayRef<gmx::RVec>  f,
                rvec                     *fshift,
@@ -412,6 +451,13 @@ void dd_move_f(gmx_domdec_t             *dd,
 {
     wallcycle_start(wcycle, ewcMOVEF);
 
+    if (dd->comm->directHalo.active)
+    {
+        dd_direct_halo_move_f(dd, f, fshift);
+        wallcycle_stop(wcycle, ewcMOVEF);
+        return;
+    }
+
     int                    nzone, nat_tot;
     gmx_domdec_comm_t     *comm;
     gmx_domdec_comm_dim_t *cd;
@@ -2923,6 +2969,8 @@ static void set_dd_envvar_options(const gmx::MDLogger &mdlog,
     gmx_domdec_comm_t *comm = dd->comm;
 
     dd->bSendRecv2      = (dd_getenv(mdlog, "GMX_DD_USE_SENDRECV2", 0) != 0);
+    comm->useDirectHalo = (dd_getenv(mdlog, "GMX_DD_DIRECT_HALO", 0) != 0);
+    comm->useAsyncHalo  = (dd_getenv(mdlog, "GMX_DD_ASYNC_HALO", 0) != 0);
     comm->dlb_scale_lim = dd_getenv(mdlog, "GMX_DLB_MAX_BOX_SCALING", 10);
     comm->eFlop         = dd_getenv(mdlog, "GMX_DLB_BASED_ON_FLOPS", 0);
     int recload         = dd_getenv(mdlog, "GMX_DD_RECORD_LOAD", 1);
@@ -2935,6 +2983,19 @@ static void set_dd_envvar_options(const gmx::MDLogger &mdlog,
         GMX_LOG(mdlog.info).appendText("Will use two sequential MPI_Sendrecv calls instead of two simultaneous non-blocking MPI_Irecv and MPI_Isend pairs for constraint and vsite communication");
     }
 
+    if (comm->useAsyncHalo)
+    {
+        /* The asynchronous communication is built on the direct communication */
+        comm->useDirectHalo = TRUE;
+
+        GMX_LOG(mdlog.info).appendText("Will overlap the halo coordinate communication with the local non-bonded computation on the CPU");
+    }
+
+    if (comm->useDirectHalo)
+    {
+        GMX_LOG(mdlog.info).appendText("Will communicate the halo directly with all zone ranks in one stage, when using a single pulse along two or three decomposition dimensions");
+    }
+
     if (comm->eFlop)
     {
         GMX_LOG(mdlog.info).appendText("Will load balance based on FLOP count");
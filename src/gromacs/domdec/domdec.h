@@ -259,6 +259,30 @@ void dd_move_x(struct gmx_domdec_t      *dd,
                gmx::ArrayRef<gmx::RVec>  x,
                gmx_wallcycle            *wcycle);
 
+/*! \brief Returns whether dd_move_x_start() posts the coordinate communication asynchronously
+ *
+ * This is the case with GMX_DD_ASYNC_HALO set and the direct halo
+ * communication active with the current partitioning.
+ */
+bool dd_async_halo_is_active(const gmx_domdec_t *dd);
+
+/*! \brief Start communicating the coordinates to the neighboring cells.
+ *
+ * With the asynchronous halo communication active, the communication
+ * is only posted and true is returned. The non-local coordinates
+ * should then not be accessed before dd_move_x_wait() has been called.
+ * Otherwise the communication is completed, as dd_move_x() does,
+ * and false is returned.
+ */
+bool dd_move_x_start(struct gmx_domdec_t      *dd,
+                     matrix                    box,
+                     gmx::ArrayRef<gmx::RVec>  x,
+                     gmx_wallcycle            *wcycle);
+
+/*! \brief Wait for the coordinate communication started by dd_move_x_start() */
+void dd_move_x_wait(struct gmx_domdec_t *dd,
+                    gmx_wallcycle       *wcycle);
+
 /*! \brief Sum the forces over the neighboring cells.
  *
  * When fshift!=NULL the shift forces are updated to obtain
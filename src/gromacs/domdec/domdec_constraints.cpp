@@ -71,6 +71,25 @@
 
 #include "domdec_specatomcomm.h"
 
+/*! \brief A constraint with a non-home atom found by a thread, processed serially afterwards */
+struct BorderConstraint
+{
+    int numHomeBefore; /**< The number of home constraints found by the thread before this one */
+    int con;           /**< The constraint index in the molecule type */
+    int conOffset;     /**< The global constraint number offset for the molecule */
+    int bMol;          /**< The non-home atom index in the molecule */
+    int offset;        /**< The global atom number offset for the molecule */
+    int molType;       /**< The molecule type */
+};
+
+/*! \brief Constraint assignment output of one thread */
+struct ConstraintThreadData
+{
+    std::vector<int>              homeIatoms; /**< Local iatoms of the fully home constraints */
+    std::vector<int>              homeConGl;  /**< Global indices of the fully home constraints */
+    std::vector<BorderConstraint> border;     /**< Constraints involving non-home atoms */
+};
+
 /*! \brief Struct used during constraint setup with domain decomposition */
 struct gmx_domdec_constraints_t
 {
@@ -91,6 +110,7 @@ struct gmx_domdec_constraints_t
     /* Multi-threading stuff */
     int                  nthread; /**< Number of threads used for DD constraint setup */
     std::vector<t_ilist> ils;     /**< Constraint ilist working arrays, size \p nthread */
+    std::vector<ConstraintThreadData> threadData; /**< Constraint assignment working data, size \p nthread */
 
     /* Buffers for requesting atoms */
     std::vector < std::vector < int>> requestedGlobalAtomIndices; /**< Buffers for requesting global atom indices, one per thread */
@@ -304,28 +324,51 @@ static void atoms_to_settles(gmx_domdec_t *dd,
     }
 }
 
-/*! \brief Looks up constraint for the local atoms */
-static void atoms_to_constraints(gmx_domdec_t *dd,
-                                 const gmx_mtop_t *mtop,
-                                 const int *cginfo,
-                                 gmx::ArrayRef<const t_blocka> at2con_mt, int nrec,
-                                 t_ilist *ilc_local,
-                                 std::vector<int> *ireq)
+/*! \brief Appends the home constraints \p begin to \p end found by a thread to the local constraints */
+static void add_home_constraints(const ConstraintThreadData &td,
+                                 int begin, int end,
+                                 gmx_domdec_constraints_t *dc,
+                                 t_ilist *ilc_local)
 {
-    const t_blocka             *at2con;
-    int                         b_lo, offset, b_mol, i, con, con_offset;
-
-    gmx_domdec_constraints_t   *dc     = dd->constraints;
-    gmx_domdec_specat_comm_t   *dcc    = dd->constraint_comm;
+    if (ilc_local->nr + 3*(end - begin) > ilc_local->nalloc)
+    {
+        ilc_local->nalloc = over_alloc_dd(ilc_local->nr + 3*(end - begin));
+        srenew(ilc_local->iatoms, ilc_local->nalloc);
+    }
+    for (int c = begin; c < end; c++)
+    {
+        dc->con_gl.push_back(td.homeConGl[c]);
+        dc->con_nlocat.push_back(2);
+        for (int i = 0; i < 3; i++)
+        {
+            ilc_local->iatoms[ilc_local->nr++] = td.homeIatoms[c*3 + i];
+        }
+        dc->ncon++;
+    }
+}
 
-    const gmx_ga2la_t          &ga2la  = *dd->ga2la;
+/*! \brief Looks up the constraints of the home atoms in a range of charge groups
+ *
+ * Fully home constraints are stored directly. Constraints involving
+ * non-home atoms are stored for serial processing, as those require
+ * checking and marking the global constraint and atom requests.
+ */
+static void find_home_atom_constraints(const gmx_domdec_t *dd,
+                                       const gmx_mtop_t *mtop,
+                                       const int *cginfo,
+                                       gmx::ArrayRef<const t_blocka> at2con_mt,
+                                       int cg_start, int cg_end,
+                                       ConstraintThreadData *td)
+{
+    const gmx_domdec_constraints_t *dc     = dd->constraints;
+    const gmx_ga2la_t              &ga2la  = *dd->ga2la;
 
-    dc->con_gl.clear();
-    dc->con_nlocat.clear();
+    td->homeIatoms.clear();
+    td->homeConGl.clear();
+    td->border.clear();
 
     int mb    = 0;
-    int nhome = 0;
-    for (int cg = 0; cg < dd->ncg_home; cg++)
+    for (int cg = cg_start; cg < cg_end; cg++)
     {
         if (GET_CGINFO_CONSTR(cginfo[cg]))
         {
@@ -344,16 +387,17 @@ static void atoms_to_constraints(gmx_domdec_t *dd,
                  * This is only required for the global index to make sure
                  * that we use each constraint only once.
                  */
-                con_offset =
+                int con_offset =
                     dc->molb_con_offset[mb] + molnr*dc->molb_ncon_mol[mb];
 
                 /* The global atom number offset for this molecule */
-                offset = a_gl - a_mol;
-                at2con = &at2con_mt[molb.type];
-                for (i = at2con->index[a_mol]; i < at2con->index[a_mol+1]; i++)
+                int             offset = a_gl - a_mol;
+                const t_blocka *at2con = &at2con_mt[molb.type];
+                for (int i = at2con->index[a_mol]; i < at2con->index[a_mol+1]; i++)
                 {
-                    con            = at2con->a[i];
+                    int        con = at2con->a[i];
                     const int *iap = constr_iatomptr(ia1, ia2, con);
+                    int        b_mol;
                     if (a_mol == iap[1])
                     {
                         b_mol = iap[2];
@@ -367,37 +411,112 @@ static void atoms_to_constraints(gmx_domdec_t *dd,
                         /* Add this fully home constraint at the first atom */
                         if (a_mol < b_mol)
                         {
-                            dc->con_gl.push_back(con_offset + con);
-                            dc->con_nlocat.push_back(2);
-                            if (ilc_local->nr + 3 > ilc_local->nalloc)
-                            {
-                                ilc_local->nalloc = over_alloc_dd(ilc_local->nr + 3);
-                                srenew(ilc_local->iatoms, ilc_local->nalloc);
-                            }
-                            b_lo = *a_loc;
-                            ilc_local->iatoms[ilc_local->nr++] = iap[0];
-                            ilc_local->iatoms[ilc_local->nr++] = (a_gl == iap[1] ? a    : b_lo);
-                            ilc_local->iatoms[ilc_local->nr++] = (a_gl == iap[1] ? b_lo : a   );
-                            dc->ncon++;
-                            nhome++;
+                            int b_lo = *a_loc;
+                            td->homeConGl.push_back(con_offset + con);
+                            td->homeIatoms.push_back(iap[0]);
+                            td->homeIatoms.push_back(a_gl == iap[1] ? a    : b_lo);
+                            td->homeIatoms.push_back(a_gl == iap[1] ? b_lo : a   );
                         }
                     }
                     else
                     {
-                        /* We need the nrec constraints coupled to this constraint,
-                         * so we need to walk out of the home cell by nrec+1 atoms,
-                         * since already atom bg is not locally present.
-                         * Therefore we call walk_out with nrec recursions to go
-                         * after this first call.
-                         */
-                        walk_out(con, con_offset, b_mol, offset, nrec,
-                                 ia1, ia2, at2con,
-                                 ga2la, TRUE, dc, dcc, ilc_local, ireq);
+                        td->border.push_back({ static_cast<int>(td->homeConGl.size()),
+                                               con, con_offset, b_mol, offset, molb.type });
                     }
                 }
             }
         }
     }
+}
+
+/*! \brief Replaces the negative, global, atom indices in \p il by local indices using \p ga2la_specat */
+static void fill_missing_indices(const gmx::HashedMap<int> &ga2la_specat,
+                                 t_ilist *il, int nral1, int numThreads)
+{
+    const int numInteractions = il->nr/nral1;
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int n = 0; n < numInteractions; n++)
+    {
+        try
+        {
+            int *iap = il->iatoms + n*nral1;
+            for (int j = 1; j < nral1; j++)
+            {
+                if (iap[j] < 0)
+                {
+                    const int *a = ga2la_specat.find(-iap[j] - 1);
+                    GMX_ASSERT(a, "We have checked before that this atom index has been set");
+                    iap[j] = *a;
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
+/*! \brief Looks up constraint for the local atoms
+ *
+ * The home atoms are processed in parallel. The results are merged
+ * in the order of the home atoms, so the output does not depend
+ * on the number of threads.
+ */
+static void atoms_to_constraints(gmx_domdec_t *dd,
+                                 const gmx_mtop_t *mtop,
+                                 const int *cginfo,
+                                 gmx::ArrayRef<const t_blocka> at2con_mt, int nrec,
+                                 t_ilist *ilc_local,
+                                 std::vector<int> *ireq)
+{
+    gmx_domdec_constraints_t   *dc     = dd->constraints;
+    gmx_domdec_specat_comm_t   *dcc    = dd->constraint_comm;
+
+    const gmx_ga2la_t          &ga2la  = *dd->ga2la;
+
+    dc->con_gl.clear();
+    dc->con_nlocat.clear();
+
+    const int numThreads = dc->nthread;
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            int cg0 = (dd->ncg_home* thread     )/numThreads;
+            int cg1 = (dd->ncg_home*(thread + 1))/numThreads;
+
+            find_home_atom_constraints(dd, mtop, cginfo, at2con_mt,
+                                       cg0, cg1, &dc->threadData[thread]);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    int nhome = 0;
+    for (const ConstraintThreadData &td : dc->threadData)
+    {
+        int numHomeDone = 0;
+        for (const BorderConstraint &bc : td.border)
+        {
+            add_home_constraints(td, numHomeDone, bc.numHomeBefore,
+                                 dc, ilc_local);
+            numHomeDone = bc.numHomeBefore;
+
+            gmx::ArrayRef<const int>  ia1 = mtop->moltype[bc.molType].ilist[F_CONSTR].iatoms;
+            gmx::ArrayRef<const int>  ia2 = mtop->moltype[bc.molType].ilist[F_CONSTRNC].iatoms;
+
+            /* We need the nrec constraints coupled to this constraint,
+             * so we need to walk out of the home cell by nrec+1 atoms,
+             * since already atom bg is not locally present.
+             * Therefore we call walk_out with nrec recursions to go
+             * after this first call.
+             */
+            walk_out(bc.con, bc.conOffset, bc.bMol, bc.offset, nrec,
+                     ia1, ia2, &at2con_mt[bc.molType],
+                     ga2la, TRUE, dc, dcc, ilc_local, ireq);
+        }
+        add_home_constraints(td, numHomeDone, td.homeConGl.size(),
+                             dc, ilc_local);
+        nhome += td.homeConGl.size();
+    }
 
     GMX_ASSERT(dc->con_gl.size() == static_cast<size_t>(dc->ncon), "con_gl size should match the number of constraints");
     GMX_ASSERT(dc->con_nlocat.size() == static_cast<size_t>(dc->ncon), "con_nlocat size should match the number of constraints");
@@ -422,8 +541,7 @@ int dd_make_local_constraints(gmx_domdec_t *dd, int at_start,
     std::vector<int>             *ireq;
     gmx::ArrayRef<const t_blocka> at2con_mt;
     gmx::HashedMap<int>          *ga2la_specat;
-    int at_end, i, j;
-    t_iatom                      *iap;
+    int at_end;
 
     // This code should not be called unless this condition is true,
     // because that's the only time init_domdec_constraints is
@@ -469,63 +587,47 @@ int dd_make_local_constraints(gmx_domdec_t *dd, int at_start,
         ils_local->nr = 0;
     }
 
-    if (at2settle_mt.empty())
+    if (at2settle_mt.empty() || !at2con_mt.empty())
     {
         atoms_to_constraints(dd, mtop, cginfo, at2con_mt, nrec,
                              ilc_local, ireq);
     }
-    else
+
+    if (!at2settle_mt.empty())
     {
-        int t0_set;
         int thread;
 
-        /* Do the constraints, if present, on the first thread.
-         * Do the settles on all other threads.
-         */
-        t0_set = ((!at2con_mt.empty() && dc->nthread > 1) ? 1 : 0);
-
 #pragma omp parallel for num_threads(dc->nthread) schedule(static)
         for (thread = 0; thread < dc->nthread; thread++)
         {
             try
             {
-                if (!at2con_mt.empty() && thread == 0)
+                int        cg0, cg1;
+                t_ilist   *ilst;
+
+                /* Distribute the settle check+assignments over dc->nthread threads */
+                cg0 = (dd->ncg_home* thread   )/dc->nthread;
+                cg1 = (dd->ncg_home*(thread+1))/dc->nthread;
+
+                if (thread == 0)
                 {
-                    atoms_to_constraints(dd, mtop, cginfo, at2con_mt, nrec,
-                                         ilc_local, ireq);
+                    ilst = ils_local;
                 }
-
-                if (thread >= t0_set)
+                else
                 {
-                    int        cg0, cg1;
-                    t_ilist   *ilst;
-
-                    /* Distribute the settle check+assignments over
-                     * dc->nthread or dc->nthread-1 threads.
-                     */
-                    cg0 = (dd->ncg_home*(thread-t0_set  ))/(dc->nthread-t0_set);
-                    cg1 = (dd->ncg_home*(thread-t0_set+1))/(dc->nthread-t0_set);
-
-                    if (thread == t0_set)
-                    {
-                        ilst = ils_local;
-                    }
-                    else
-                    {
-                        ilst = &dc->ils[thread];
-                    }
-                    ilst->nr = 0;
-
-                    std::vector<int> &ireqt = dc->requestedGlobalAtomIndices[thread];
-                    if (thread > 0)
-                    {
-                        ireqt.clear();
-                    }
+                    ilst = &dc->ils[thread];
+                }
+                ilst->nr = 0;
 
-                    atoms_to_settles(dd, mtop, cginfo, at2settle_mt,
-                                     cg0, cg1,
-                                     ilst, &ireqt);
+                std::vector<int> &ireqt = dc->requestedGlobalAtomIndices[thread];
+                if (thread > 0)
+                {
+                    ireqt.clear();
                 }
+
+                atoms_to_settles(dd, mtop, cginfo, at2settle_mt,
+                                 cg0, cg1,
+                                 ilst, &ireqt);
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
@@ -536,20 +638,17 @@ int dd_make_local_constraints(gmx_domdec_t *dd, int at_start,
             t_ilist   *ilst;
             int        ia;
 
-            if (thread > t0_set)
+            ilst = &dc->ils[thread];
+            if (ils_local->nr + ilst->nr > ils_local->nalloc)
             {
-                ilst = &dc->ils[thread];
-                if (ils_local->nr + ilst->nr > ils_local->nalloc)
-                {
-                    ils_local->nalloc = over_alloc_large(ils_local->nr + ilst->nr);
-                    srenew(ils_local->iatoms, ils_local->nalloc);
-                }
-                for (ia = 0; ia < ilst->nr; ia++)
-                {
-                    ils_local->iatoms[ils_local->nr+ia] = ilst->iatoms[ia];
-                }
-                ils_local->nr += ilst->nr;
+                ils_local->nalloc = over_alloc_large(ils_local->nr + ilst->nr);
+                srenew(ils_local->iatoms, ils_local->nalloc);
             }
+            for (ia = 0; ia < ilst->nr; ia++)
+            {
+                ils_local->iatoms[ils_local->nr+ia] = ilst->iatoms[ia];
+            }
+            ils_local->nr += ilst->nr;
 
             const std::vector<int> &ireqt = dc->requestedGlobalAtomIndices[thread];
             ireq->insert(ireq->end(), ireqt.begin(), ireqt.end());
@@ -563,46 +662,17 @@ int dd_make_local_constraints(gmx_domdec_t *dd, int at_start,
 
     if (dd->constraint_comm)
     {
-        int nral1;
-
         at_end =
             setup_specat_communication(dd, ireq, dd->constraint_comm,
                                        dd->constraints->ga2la.get(),
                                        at_start, 2,
                                        "constraint", " or lincs-order");
 
-        /* Fill in the missing indices */
+        /* Fill in the missing indices, these lookups are independent */
         ga2la_specat = dd->constraints->ga2la.get();
 
-        nral1 = 1 + NRAL(F_CONSTR);
-        for (i = 0; i < ilc_local->nr; i += nral1)
-        {
-            iap = ilc_local->iatoms + i;
-            for (j = 1; j < nral1; j++)
-            {
-                if (iap[j] < 0)
-                {
-                    const int *a = ga2la_specat->find(-iap[j] - 1);
-                    GMX_ASSERT(a, "We have checked before that this atom index has been set");
-                    iap[j] = *a;
-                }
-            }
-        }
-
-        nral1 = 1 + NRAL(F_SETTLE);
-        for (i = 0; i < ils_local->nr; i += nral1)
-        {
-            iap = ils_local->iatoms + i;
-            for (j = 1; j < nral1; j++)
-            {
-                if (iap[j] < 0)
-                {
-                    const int *a = ga2la_specat->find(-iap[j] - 1);
-                    GMX_ASSERT(a, "We have checked before that this atom index has been set");
-                    iap[j] = *a;
-                }
-            }
-        }
+        fill_missing_indices(*ga2la_specat, ilc_local, 1 + NRAL(F_CONSTR), dc->nthread);
+        fill_missing_indices(*ga2la_specat, ils_local, 1 + NRAL(F_SETTLE), dc->nthread);
     }
     else
     {
@@ -655,6 +725,7 @@ void init_domdec_constraints(gmx_domdec_t     *dd,
 
     dc->nthread = gmx_omp_nthreads_get(emntDomdec);
     dc->ils.resize(dc->nthread);
+    dc->threadData.resize(dc->nthread);
 
     dd->constraint_comm = new gmx_domdec_specat_comm_t;
 
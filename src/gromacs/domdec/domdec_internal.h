@@ -45,6 +45,7 @@
 
 #include "config.h"
 
+#include "gromacs/domdec/directhalo.h"
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/mdlib/updategroupscog.h"
@@ -503,6 +504,11 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
     /* Communication buffer only used with multiple grid pulses */
     DDBuffer<gmx::RVec> rvecBuffer2; /**< Another rvec comm. buffer */
 
+    /* Direct halo communication */
+    gmx_bool   useDirectHalo; /**< Communicate the halo in one stage directly with all zone ranks, when supported */
+    gmx_bool   useAsyncHalo;  /**< Overlap the direct halo coordinate communication with computation */
+    DirectHalo directHalo;    /**< The direct halo communication setup, only used when active */
+
     /* Communication buffers for local redistribution */
     std::array<std::vector<int>, DIM*2>       cggl_flag;  /**< Charge group flag comm. buffers */
     std::array<std::vector<gmx::RVec>, DIM*2> cgcm_state; /**< Charge group center comm. buffers */
@@ -601,6 +607,9 @@ static inline int dd_index(const ivec numDomains,
     return ((domainCoordinates[XX]*numDomains[YY] + domainCoordinates[YY])*numDomains[ZZ]) + domainCoordinates[ZZ];
 };
 
+/*! \brief Returns the rank of the DD rank with domain coordinates \p c */
+int ddcoord2ddnodeid(gmx_domdec_t *dd, ivec c);
+
 /*! Returns the size of the buffer to hold fractional cell boundaries for DD dimension index dimIndex */
 static inline int ddCellFractionBufferSize(const gmx_domdec_t *dd,
                                            int                 dimIndex)
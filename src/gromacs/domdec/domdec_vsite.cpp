@@ -55,10 +55,12 @@
 #include "gromacs/domdec/ga2la.h"
 #include "gromacs/domdec/hashedmap.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/mtop_util.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 
@@ -146,24 +148,37 @@ int dd_make_local_vsites(gmx_domdec_t *dd, int at_start, t_ilist *lil)
         setup_specat_communication(dd, &ireq, dd->vsite_comm, ga2la_specat,
                                    at_start, 1, "vsite", "");
 
-    /* Fill in the missing indices */
-    for (int ftype = 0; ftype < F_NRE; ftype++)
+    /* Fill in the missing indices, the lookups are independent,
+     * also between the vsite types, so the threads do not need to wait
+     * for each other between the types.
+     */
+    const int numThreads = gmx_omp_nthreads_get(emntDomdec);
+#pragma omp parallel num_threads(numThreads)
     {
-        if (interaction_function[ftype].flags & IF_VSITE)
+        for (int ftype = 0; ftype < F_NRE; ftype++)
         {
-            const int  nral = NRAL(ftype);
-            t_ilist   &lilf = lil[ftype];
-            for (int i = 0; i < lilf.nr; i += 1 + nral)
+            if (interaction_function[ftype].flags & IF_VSITE)
             {
-                t_iatom *iatoms = lilf.iatoms + i;
-                for (int j = 1; j < 1 + nral; j++)
+                const int  nral      = NRAL(ftype);
+                t_ilist   &lilf      = lil[ftype];
+                const int  numVsites = lilf.nr/(1 + nral);
+#pragma omp for schedule(static) nowait
+                for (int v = 0; v < numVsites; v++)
                 {
-                    if (iatoms[j] < 0)
+                    try
                     {
-                        const int *a = ga2la_specat->find(-iatoms[j] - 1);
-                        GMX_ASSERT(a, "We have checked before that this atom index has been set");
-                        iatoms[j] = *a;
+                        t_iatom *iatoms = lilf.iatoms + v*(1 + nral);
+                        for (int j = 1; j < 1 + nral; j++)
+                        {
+                            if (iatoms[j] < 0)
+                            {
+                                const int *a = ga2la_specat->find(-iatoms[j] - 1);
+                                GMX_ASSERT(a, "We have checked before that this atom index has been set");
+                                iatoms[j] = *a;
+                            }
+                        }
                     }
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
                 }
             }
         }
@@ -45,16 +45,18 @@
 
 #include "ga2la.h"
 
+#include <algorithm>
+#include <array>
+
 /*! \brief Returns whether to use a direct list only
  *
  * There are two methods implemented for finding the local atom number
  * belonging to a global atom number:
  * 1) a simple, direct array
- * 2) a hash table consisting of list of linked lists indexed with
- *    the global number modulo mod.
+ * 2) an open addressing hash table indexed with a hash of the global number.
  * Memory requirements:
  * 1) numAtomsTotal*2 ints
- * 2) numAtomsLocal*(2+1-2(1-e^-1/2))*4 ints
+ * 2) numAtomsLocal*(1.5 to 3)*3 ints
  * where numAtomsLocal is the number of atoms in the home + communicated zones.
  * Method 1 is faster for low parallelization, 2 for high parallelization.
  * We switch to method 2 when it uses less than half the memory method 1.
@@ -82,3 +84,35 @@ gmx_ga2la_t::gmx_ga2la_t(int numAtomsTotal,
         new(&(data_.hashed)) gmx::HashedMap<Entry>(numAtomsLocal);
     }
 }
+
+void gmx_ga2la_t::findHome(gmx::ArrayRef<const int> globalIndices,
+                           gmx::ArrayRef<int>       localIndices) const
+{
+    GMX_ASSERT(globalIndices.size() == localIndices.size(), "The index arrays should have the same size");
+
+    if (usingDirect_)
+    {
+        for (size_t i = 0; i < globalIndices.size(); i++)
+        {
+            const Entry &entry = data_.direct[globalIndices[i]];
+            localIndices[i]    = (entry.cell == 0 ? entry.la : -1);
+        }
+    }
+    else
+    {
+        /* Look up the entries in batches, so the table accesses can overlap */
+        constexpr size_t                       c_batchSize = gmx::HashedMap<Entry>::c_batchSize;
+        std::array<const Entry *, c_batchSize> entries;
+        for (size_t start = 0; start < globalIndices.size(); start += c_batchSize)
+        {
+            const size_t numAtoms = std::min(globalIndices.size() - start, c_batchSize);
+            data_.hashed.find(globalIndices.subArray(start, numAtoms),
+                              gmx::arrayRefFromArray(entries.data(), numAtoms));
+            for (size_t i = 0; i < numAtoms; i++)
+            {
+                const Entry *entry      = entries[i];
+                localIndices[start + i] = ((entry && entry->cell == 0) ? entry->la : -1);
+            }
+        }
+    }
+}
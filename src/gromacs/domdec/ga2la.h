@@ -51,6 +51,7 @@
 #include <vector>
 
 #include "gromacs/domdec/hashedmap.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/gmxassert.h"
 
 /*! \libinternal \brief Global to local atom mapping
@@ -126,6 +127,19 @@ class gmx_ga2la_t
             }
         }
 
+        //! Returns a pointer to the modifiable entry when present, nullptr otherwise
+        Entry* find(int a_gl)
+        {
+            if (usingDirect_)
+            {
+                return (data_.direct[a_gl].cell == -1) ? nullptr : &(data_.direct[a_gl]);
+            }
+            else
+            {
+                return (data_.hashed.find(a_gl));
+            }
+        }
+
         //! Returns the local atom index if it is a home atom, nullptr otherwise
         const int* findHome(int a_gl) const
         {
@@ -133,6 +147,15 @@ class gmx_ga2la_t
             return (e && e->cell == 0) ? &(e->la) : nullptr;
         }
 
+        /*! \brief Looks up the local indices of multiple global atoms
+         *
+         * Sets \p localIndices[i] to the local index of global atom
+         * \p globalIndices[i] when it is a home atom, -1 otherwise.
+         * This is more efficient than calling findHome() for each atom.
+         */
+        void findHome(gmx::ArrayRef<const int> globalIndices,
+                      gmx::ArrayRef<int>       localIndices) const;
+
         /*! \brief Returns a reference to the entry for a_gl
          *
          * A non-release assert checks that a_gl is present.
@@ -48,11 +48,13 @@
 #define GMX_DOMDEC_HASHEDMAP_H
 
 #include <climits>
+#include <cstdint>
 
 #include <algorithm>
 #include <vector>
 
 #include "gromacs/compat/utility.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/exceptions.h"
 
@@ -64,25 +66,28 @@ namespace gmx
  * Efficiently manages mapping from integer keys to values.
  * Note that this basically implements a subset of the functionality of
  * std::unordered_map, but is an order of magnitude faster.
+ *
+ * The table uses open addressing with linear probing. The keys are
+ * stored in a separate, contiguous array, so a probe sequence usually
+ * stays within a single cache line and the values are only accessed
+ * for the matching key. Erasing uses backward shifting, so no
+ * tombstones are needed and lookups stay fast after many erasures.
+ * Any key except INT_MIN can be stored.
  */
 template <class T>
 class HashedMap
 {
     private:
-        /*! \libinternal \brief Structure for the key/value hash table */
-        struct hashEntry
-        {
-            int  key   = -1; /**< The key */
-            T    value;      /**< The value(s) */
-            int  next = -1;  /**< Index in the list of the next element with the same hash, -1 if none */
-        };
-
+        /*! \brief The key value signaling an empty table entry */
+        static constexpr int   c_emptyKey                 = INT_MIN;
         /*! \brief The table size is set to at least this factor time the nr of keys */
         static constexpr float c_relTableSizeSetMin       = 1.5;
         /*! \brief Threshold for increasing the table size */
-        static constexpr float c_relTableSizeThresholdMin = 1.3;
+        static constexpr float c_relTableSizeThresholdMin = 1.4;
         /*! \brief Threshold for decreasing the table size */
         static constexpr float c_relTableSizeThresholdMax = 3.5;
+        /*! \brief The maximum occupation of the table before the table grows during insertion */
+        static constexpr float c_maxLoadFactor            = 0.75;
 
         /*! \brief Resizes the table
          *
@@ -92,27 +97,82 @@ class HashedMap
         {
             GMX_RELEASE_ASSERT(numElements_ == 0, "Table needs to be empty for resize");
 
-            /* The fraction of table entries with 0   size lists is e^-f.
-             * The fraction of table entries with >=1 size lists is 1 - e^-f
-             * where f is: the #elements / tableSize
-             * The fraction of elements not in the direct list is: 1 - (1 - e^-f)/f.
-             * Thus the optimal table size is roughly double #elements.
+            /* With linear probing the average number of probes for
+             * an unsuccessful search is (1 + 1/(1 - f)^2)/2, where f is
+             * #elements / tableSize, so we should keep f well below 1.
              */
             /* Make the hash table a power of 2 and at least 1.5 * #elements */
             int tableSize = 64;
+            int log2Size  = 6;
             while (tableSize <= INT_MAX/2 &&
                    numElementsEstimate*c_relTableSizeSetMin > tableSize)
             {
                 tableSize *= 2;
+                log2Size++;
+            }
+            keys_.assign(tableSize, static_cast<int>(c_emptyKey));
+            values_.resize(tableSize);
+
+            bitMask_   = tableSize - 1;
+            hashShift_ = 32 - log2Size;
+        }
+
+        /*! \brief Doubles the table size, keeping the elements */
+        void grow()
+        {
+            std::vector<int> oldKeys;
+            std::vector<T>   oldValues;
+            std::swap(oldKeys, keys_);
+            std::swap(oldValues, values_);
+
+            numElements_ = 0;
+            resize(oldKeys.size());
+            for (size_t i = 0; i < oldKeys.size(); i++)
+            {
+                if (oldKeys[i] != c_emptyKey)
+                {
+                    insert_assign<false>(oldKeys[i], oldValues[i]);
+                }
             }
-            table_.resize(tableSize);
+        }
+
+        /*! \brief Returns the hash of \p key, the start index of its probe sequence
+         *
+         * Fibonacci hashing spreads consecutive keys over the whole table,
+         * which avoids the clustering a plain bit mask would give with
+         * linear probing.
+         */
+        size_t hash(int key) const
+        {
+            return (static_cast<uint32_t>(key)*2654435769U) >> hashShift_;
+        }
 
-            /* Table size is a power of 2, so a binary mask gives the hash */
-            bitMask_                        = tableSize - 1;
-            startIndexForSpaceForListEntry_ = tableSize;
+        /*! \brief Returns the table index of \p key starting the probe sequence at \p index, -1 when not present */
+        int findIndex(int    key,
+                      size_t index) const
+        {
+            while (true)
+            {
+                const int tableKey = keys_[index];
+                if (tableKey == key)
+                {
+                    return static_cast<int>(index);
+                }
+                if (tableKey == c_emptyKey)
+                {
+                    return -1;
+                }
+                index = (index + 1) & bitMask_;
+            }
         }
 
     public:
+        /*! \brief The number of keys that are hashed together in batched lookups
+         *
+         * Callers that look up keys in batches should use this size.
+         */
+        static constexpr int c_batchSize = 32;
+
         /*! \brief Constructor
          *
          * \param[in] numElementsEstimate  An estimate of the number of elements that will be stored, used for optimizing initial performance
@@ -135,7 +195,7 @@ class HashedMap
         /*! \brief Returns the number of buckets, i.e. the number of possible hashes */
         int bucket_count() const
         {
-            return bitMask_ + 1;
+            return static_cast<int>(bitMask_ + 1);
         }
 
     private:
@@ -150,19 +210,21 @@ class HashedMap
         template<bool allowAssign> void insert_assign(int      key,
                                                       const T &value)
         {
-            size_t ind = (key & bitMask_);
+            GMX_ASSERT(key != c_emptyKey, "INT_MIN can not be used as a key");
+
+            if (numElements_ + 1 > c_maxLoadFactor*bucket_count())
+            {
+                grow();
+            }
 
-            if (table_[ind].key >= 0)
+            size_t ind = hash(key);
+            while (keys_[ind] != c_emptyKey)
             {
-                /* Loop over the entries for this hash.
-                 * If we find the matching key, return the value.
-                 */
-                int ind_prev = ind;
-                if (table_[ind_prev].key == key)
+                if (keys_[ind] == key)
                 {
                     if (allowAssign)
                     {
-                        table_[ind].value = value;
+                        values_[ind] = value;
                         return;
                     }
                     else
@@ -173,44 +235,13 @@ class HashedMap
 #endif
                     }
                 }
-                while (table_[ind_prev].next >= 0)
-                {
-                    ind_prev = table_[ind_prev].next;
-                    if (table_[ind_prev].key == key)
-                    {
-                        if (allowAssign)
-                        {
-                            table_[ind_prev].value = value;
-                            return;
-                        }
-                        else
-                        {
-#ifndef NDEBUG
-                            GMX_THROW(InvalidInputError("Attempt to insert duplicate key"));
-#endif
-                        }
-                    }
-                }
-                /* Search for space in table_ */
-                ind = startIndexForSpaceForListEntry_;
-                while (ind < table_.size() && table_[ind].key >= 0)
-                {
-                    ind++;
-                }
-                /* If we are at the end of the list we need to increase the size */
-                if (ind == table_.size())
-                {
-                    table_.resize(table_.size() + 1);
-                }
-                table_[ind_prev].next           = ind;
-
-                startIndexForSpaceForListEntry_ = ind + 1;
+                ind = (ind + 1) & bitMask_;
             }
 
-            table_[ind].key    = key;
-            table_[ind].value  = value;
+            keys_[ind]    = key;
+            values_[ind]  = value;
 
-            numElements_      += 1;
+            numElements_ += 1;
         }
 
     public:
@@ -242,35 +273,31 @@ class HashedMap
          */
         void erase(int key)
         {
-            int ind_prev = -1;
-            int ind      = (key & bitMask_);
-            do
+            int ind = findIndex(key, hash(key));
+            if (ind < 0)
             {
-                if (table_[ind].key == key)
-                {
-                    if (ind_prev >= 0)
-                    {
-                        table_[ind_prev].next = table_[ind].next;
-
-                        /* This index is a linked entry, so we free an entry.
-                         * Check if we are creating the first empty space.
-                         */
-                        if (ind < startIndexForSpaceForListEntry_)
-                        {
-                            startIndexForSpaceForListEntry_ = ind;
-                        }
-                    }
-                    table_[ind].key   = -1;
-                    table_[ind].next  = -1;
-
-                    numElements_     -= 1;
+                return;
+            }
 
-                    return;
+            /* Shift later entries of the probe sequence back into the hole,
+             * when the hole lies within their probe sequence.
+             */
+            size_t hole = ind;
+            size_t next = (hole + 1) & bitMask_;
+            while (keys_[next] != c_emptyKey)
+            {
+                const size_t home = hash(keys_[next]);
+                if (((next - home) & bitMask_) >= ((next - hole) & bitMask_))
+                {
+                    keys_[hole]   = keys_[next];
+                    values_[hole] = values_[next];
+                    hole          = next;
                 }
-                ind_prev = ind;
-                ind      = table_[ind].next;
+                next = (next + 1) & bitMask_;
             }
-            while (ind >= 0);
+            keys_[hole]   = c_emptyKey;
+
+            numElements_ -= 1;
         }
 
         /*! \brief Returns a pointer to the value for the given key or nullptr when not present
@@ -287,18 +314,39 @@ class HashedMap
          */
         const T *find(int key) const
         {
-            int ind = (key & bitMask_);
-            do
+            const int ind = findIndex(key, hash(key));
+
+            return (ind >= 0 ? &values_[ind] : nullptr);
+        }
+
+        /*! \brief Looks up multiple keys at once
+         *
+         * Sets \p values[i] to a pointer to the value for \p keys[i],
+         * or nullptr when not present. The hashes are computed in batches
+         * before probing, so the independent table accesses can overlap.
+         *
+         * \param[in]  keys    The keys
+         * \param[out] values  Pointers to the values, should have the same size as \p keys
+         */
+        void find(ArrayRef<const int> keys,
+                  ArrayRef<const T *> values) const
+        {
+            GMX_ASSERT(keys.size() == values.size(), "keys and values should have the same size");
+
+            size_t hashes[c_batchSize];
+            for (size_t start = 0; start < keys.size(); start += c_batchSize)
             {
-                if (table_[ind].key == key)
+                const size_t numKeys = std::min(keys.size() - start, static_cast<size_t>(c_batchSize));
+                for (size_t i = 0; i < numKeys; i++)
+                {
+                    hashes[i] = hash(keys[start + i]);
+                }
+                for (size_t i = 0; i < numKeys; i++)
                 {
-                    return &table_[ind].value;
+                    const int ind     = findIndex(keys[start + i], hashes[i]);
+                    values[start + i] = (ind >= 0 ? &values_[ind] : nullptr);
                 }
-                ind = table_[ind].next;
             }
-            while (ind >= 0);
-
-            return nullptr;
         }
 
         /*! \brief Clear all the entries in the list
@@ -310,13 +358,8 @@ class HashedMap
         {
             const int oldNumElements = numElements_;
 
-            for (hashEntry &entry : table_)
-            {
-                entry.key  = -1;
-                entry.next = -1;
-            }
-            startIndexForSpaceForListEntry_ = bucket_count();
-            numElements_                    = 0;
+            std::fill(keys_.begin(), keys_.end(), static_cast<int>(c_emptyKey));
+            numElements_ = 0;
 
             /* Resize the hash table when the occupation is far from optimal.
              * Do not resize with 0 elements to avoid minimal size when clear()
@@ -330,14 +373,16 @@ class HashedMap
         }
 
     private:
-        /*! \brief The hash table list */
-        std::vector<hashEntry> table_;
-        /*! \brief The bit mask for computing the hash of a key */
-        int                    bitMask_                        = 0;
-        /*! \brief Index in table_ at which to start looking for empty space for a new linked list entry */
-        int                    startIndexForSpaceForListEntry_ = 0;
+        /*! \brief The keys, c_emptyKey for empty entries */
+        std::vector<int> keys_;
+        /*! \brief The values, only valid for entries with a key */
+        std::vector<T>   values_;
+        /*! \brief The bit mask for wrapping table indices */
+        size_t           bitMask_      = 0;
+        /*! \brief The right shift of the scaled key to obtain the hash */
+        int              hashShift_    = 0;
         /*! \brief The number of elements currently stored in the table */
-        int                    numElements_                    = 0;
+        int              numElements_  = 0;
 };
 
 } // namespace gmx
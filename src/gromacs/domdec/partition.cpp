@@ -51,6 +51,7 @@
 #include <cstdio>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/domdec/collect.h"
 #include "gromacs/domdec/dlb.h"
@@ -560,6 +561,57 @@ static void make_dd_indices(gmx_domdec_t *dd,
     }
 }
 
+/*! \brief Updates the mappings between global and local home atom indices after sorting
+ *
+ * Instead of clearing and refilling the whole global to local lookup,
+ * only the entries of home atoms that changed local index are updated
+ * and entries for atoms that arrived from other domains are inserted.
+ * The entries for atoms that left and for non-home atoms should already
+ * have been removed.
+ */
+static void updateHomeIndices(gmx_domdec_t *dd,
+                              const int    *gcgs_index)
+{
+    gmx::ArrayRef<const int>  globalAtomGroupIndices = dd->globalAtomGroupIndices;
+    const gmx_bool            bCGs                   = dd->comm->bCGs;
+
+    std::vector<int>         &globalAtomIndices      = dd->globalAtomIndices;
+    gmx_ga2la_t              &ga2la                  = *dd->ga2la;
+
+    globalAtomIndices.resize(dd->comm->atomRanges.numHomeAtoms());
+
+    int a = 0;
+    for (int cg = 0; cg < dd->ncg_home; cg++)
+    {
+        int cg_gl = globalAtomGroupIndices[cg];
+        int a_gl0, a_gl1;
+        if (bCGs)
+        {
+            a_gl0 = gcgs_index[cg_gl];
+            a_gl1 = gcgs_index[cg_gl + 1];
+        }
+        else
+        {
+            a_gl0 = cg_gl;
+            a_gl1 = cg_gl + 1;
+        }
+        for (int a_gl = a_gl0; a_gl < a_gl1; a_gl++)
+        {
+            globalAtomIndices[a] = a_gl;
+            if (gmx_ga2la_t::Entry *entry = ga2la.find(a_gl))
+            {
+                GMX_ASSERT(entry->cell == 0, "Only home atoms should be present in ga2la");
+                entry->la = a;
+            }
+            else
+            {
+                ga2la.insert(a_gl, {a, 0});
+            }
+            a++;
+        }
+    }
+}
+
 //! Checks the charge-group assignements.
 static int check_bLocalCG(gmx_domdec_t *dd, int ncg_sys, const char *bLocalCG,
                           const char *where)
@@ -596,7 +648,44 @@ static int check_bLocalCG(gmx_domdec_t *dd, int ncg_sys, const char *bLocalCG,
 }
 
 //! Checks whether global and local atom indices are consistent.
+/*! \brief Checks that the global to local atom lookup matches a full rebuild by make_dd_indices()
+ *
+ * Returns the number of global atoms with a different lookup entry.
+ */
+static int checkGa2laMatchesRebuild(gmx_domdec_t *dd,
+                                    const int    *gcgs_index,
+                                    int           natoms_sys,
+                                    const char   *where)
+{
+    const int              numAtomsInZones   = dd->comm->atomRanges.end(DDAtomRanges::Type::Zones);
+    gmx_ga2la_t           *ga2la             = dd->ga2la;
+    const std::vector<int> globalAtomIndices = dd->globalAtomIndices;
+
+    gmx_ga2la_t            rebuilt(natoms_sys, numAtomsInZones);
+    dd->ga2la = &rebuilt;
+    make_dd_indices(dd, gcgs_index, 0);
+    dd->ga2la             = ga2la;
+    dd->globalAtomIndices = globalAtomIndices;
+
+    int nerr = 0;
+    for (int i = 0; i < natoms_sys; i++)
+    {
+        const gmx_ga2la_t::Entry *entry    = ga2la->find(i);
+        const gmx_ga2la_t::Entry *expected = rebuilt.find(i);
+        if ((entry == nullptr) != (expected == nullptr) ||
+            (entry != nullptr && (entry->la != expected->la || entry->cell != expected->cell)))
+        {
+            fprintf(stderr, "DD rank %d, %s: the lookup entry of global atom %d does not match a full rebuild\n",
+                    dd->rank, where, i + 1);
+            nerr++;
+        }
+    }
+
+    return nerr;
+}
+
 static void check_index_consistency(gmx_domdec_t *dd,
+                                    const int    *gcgs_index,
                                     int natoms_sys, int ncg_sys,
                                     const char *where)
 {
@@ -662,6 +751,8 @@ static void check_index_consistency(gmx_domdec_t *dd,
         }
     }
 
+    nerr += checkGa2laMatchesRebuild(dd, gcgs_index, natoms_sys, where);
+
     nerr += check_bLocalCG(dd, ncg_sys, dd->comm->bLocalCG, where);
 
     if (nerr > 0)
@@ -685,8 +776,9 @@ static void clearDDStateIndices(gmx_domdec_t *dd,
     }
     else
     {
+        /* The entries of home atoms that moved are erased at redistribution */
         const int numAtomsInZones = dd->comm->atomRanges.end(DDAtomRanges::Type::Zones);
-        for (int i = 0; i < numAtomsInZones; i++)
+        for (int i = atomStart; i < numAtomsInZones; i++)
         {
             ga2la.erase(dd->globalAtomIndices[i]);
         }
@@ -3461,9 +3553,11 @@ void dd_partition_system(FILE                    *fplog,
         /* After sorting and compacting we set the correct size */
         dd_resize_state(state_local, f, comm->atomRanges.numHomeAtoms());
 
-        /* Rebuild all the indices */
-        dd->ga2la->clear();
-        ncgindex_set = 0;
+        /* Update the home atom indices in place, the non-home indices
+         * are set after the communication setup below.
+         */
+        updateHomeIndices(dd, cgs_gl->index);
+        ncgindex_set = dd->ncg_home;
 
         wallcycle_sub_stop(wcycle, ewcsDD_GRID);
     }
@@ -3491,6 +3585,25 @@ void dd_partition_system(FILE                    *fplog,
     /* Setup up the communication and communicate the coordinates */
     setup_dd_communication(dd, state_local->box, &ddbox, fr, state_local, f);
 
+    /* Set up the single stage halo communication, when requested */
+    const bool directHaloWasActive = comm->directHalo.active;
+    dd_direct_halo_setup(dd);
+    if (comm->useDirectHalo &&
+        (dd->ddp_count == 0 || comm->directHalo.active != directHaloWasActive))
+    {
+        /* The number of pulses, which determines this, can change with DLB.
+         * The coordinate communication is only overlapped when the
+         * non-bonded interactions are computed on the CPU.
+         */
+        const bool overlapX = (dd_async_halo_is_active(dd) &&
+                               !(fr->nbv->useGpu() || fr->nbv->emulateGpu()));
+        GMX_LOG(mdlog.info).appendTextFormatted(
+                "Step %s: using the %s halo communication%s",
+                gmx_step_str(step, sbuf),
+                comm->directHalo.active ? "single-stage direct" : "staged",
+                overlapX ? ", overlapping the coordinate communication with the local non-bonded computation" : "");
+    }
+
     /* Set the indices */
     make_dd_indices(dd, cgs_gl->index, ncgindex_set);
 
@@ -3672,7 +3785,7 @@ void dd_partition_system(FILE                    *fplog,
     if (comm->DD_debug > 0)
     {
         /* Set the env var GMX_DD_DEBUG if you suspect corrupted indices */
-        check_index_consistency(dd, top_global.natoms, ncg_mtop(&top_global),
+        check_index_consistency(dd, cgs_gl->index, top_global.natoms, ncg_mtop(&top_global),
                                 "after partitioning");
     }
 
@@ -43,6 +43,8 @@
 
 #include "gromacs/domdec/hashedmap.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "testutils/testasserts.h"
@@ -188,7 +190,8 @@ TEST(HashedMap, ResizesTable)
     // This test assumes the minimum bucket count is 64 or less
     EXPECT_LT(map.bucket_count(), 128);
 
-    for (int i = 0; i < 60; i++)
+    // Insert up to the maximum occupation before the table grows
+    for (int i = 0; i < 48; i++)
     {
         map.insert(2*i + 3, 'a');
     }
@@ -210,4 +213,81 @@ TEST(HashedMap, ResizesTable)
     EXPECT_LT(map.bucket_count(), 128);
 }
 
+// Check that the table grows during insertion and keeps all entries
+TEST(HashedMap, GrowsTable)
+{
+    gmx::HashedMap<char> map(1);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        map.insert(i, 'a' + i % 26);
+    }
+    EXPECT_EQ(map.size(), 1000);
+    EXPECT_GE(map.bucket_count(), 1000);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        checkFinds(map, i, 'a' + i % 26);
+    }
+    checkDoesNotFind(map, 1000);
+}
+
+// Check that erasing many entries keeps the remaining entries findable
+TEST(HashedMap, ErasesMany)
+{
+    gmx::HashedMap<char> map(100);
+
+    const int largePowerOf2 = 4096;
+
+    for (int i = 0; i < 100; i++)
+    {
+        map.insert(i, 'a');
+        map.insert(i + largePowerOf2, 'b');
+    }
+    for (int i = 0; i < 100; i += 2)
+    {
+        map.erase(i);
+        map.erase(i + 1 + largePowerOf2);
+    }
+    EXPECT_EQ(map.size(), 100);
+
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 2 == 0)
+        {
+            checkDoesNotFind(map, i);
+            checkFinds(map, i + largePowerOf2, 'b');
+        }
+        else
+        {
+            checkFinds(map, i, 'a');
+            checkDoesNotFind(map, i + largePowerOf2);
+        }
+    }
+}
+
+TEST(HashedMap, FindsBatched)
+{
+    gmx::HashedMap<char> map(3);
+
+    map.insert(10, 'a');
+    map.insert(5,  'b');
+    map.insert(-7, 'c');
+
+    std::vector<int>          keys;
+    for (int key = -50; key < 50; key++)
+    {
+        keys.push_back(key);
+    }
+    std::vector<const char *> values(keys.size());
+    map.find(keys, values);
+
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        EXPECT_EQ(values[i], map.find(keys[i]));
+    }
+    EXPECT_EQ(*values[10 + 50], 'a');
+    EXPECT_EQ(*values[-7 + 50], 'c');
+}
+
 }      // namespace
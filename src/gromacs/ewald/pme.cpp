@@ -414,6 +414,8 @@ static void destroy_atomcomm(pme_atomcomm_t *atc)
             sfree(atc->thread_plist[i].i);
         }
         sfree(atc->spline[i].ind);
+        sfree(atc->spline[i].sort_buf);
+        sfree(atc->spline[i].sort_cell);
         for (int d = 0; d < ZZ; d++)
         {
             sfree(atc->spline[i].theta[d]);
@@ -642,7 +644,7 @@ gmx_pme_t *gmx_pme_init(const t_commrec         *cr,
                         PmeGpu                  *pmeGpu,
                         const gmx_device_info_t *gpuInfo,
                         PmeGpuProgramHandle      pmeGpuProgram,
-                        const gmx::MDLogger      & /*mdlog*/)
+                        const gmx::MDLogger     &mdlog)
 {
     int               use_threads, sum_use_threads, i;
     ivec              ndata;
@@ -781,6 +783,32 @@ gmx_pme_t *gmx_pme_init(const t_commrec         *cr,
     pme->nky           = ir->nky;
     pme->nkz           = ir->nkz;
     pme->bP3M          = (ir->coulombtype == eelP3M_AD || getenv("GMX_PME_P3M") != nullptr);
+    /* With double precision, the grid and FFT transpose communication
+     * can optionally be done in single precision. The rounding errors
+     * are far below the PME splitting accuracy set by ewald-rtol.
+     */
+    pme->bReducedPrecisionComm = false;
+    if (getenv("GMX_PME_REDUCED_PRECISION_COMM") != nullptr)
+    {
+        if (GMX_DOUBLE)
+        {
+            pme->bReducedPrecisionComm = true;
+            GMX_LOG(mdlog.info).asParagraph().appendText("PME grid and FFT communication is done in single precision");
+        }
+        else
+        {
+            GMX_LOG(mdlog.info).asParagraph().appendText("GMX_PME_REDUCED_PRECISION_COMM has no effect in a mixed-precision build");
+        }
+    }
+    /* Spreading and gathering in grid cell order improves cache reuse
+     * on large grids, where the local atom order is not correlated
+     * with the grid position.
+     */
+    pme->bSortAtoms = (getenv("GMX_PME_SORT_ATOMS") != nullptr);
+    if (pme->bSortAtoms)
+    {
+        GMX_LOG(mdlog.info).asParagraph().appendText("Sorting the PME atoms on grid cell for spreading and gathering");
+    }
     pme->pme_order     = ir->pme_order;
     pme->ewaldcoeff_q  = ewaldcoeff_q;
     pme->ewaldcoeff_lj = ewaldcoeff_lj;
@@ -942,7 +970,8 @@ gmx_pme_t *gmx_pme_init(const t_commrec         *cr,
             gmx_parallel_3dfft_init(&pme->pfft_setup[i], ndata,
                                     &pme->fftgrid[i], &pme->cfftgrid[i],
                                     pme->mpi_comm_d,
-                                    bReproducible, pme->nthread, allocateRealGridForGpu);
+                                    bReproducible, pme->nthread, allocateRealGridForGpu,
+                                    pme->bReducedPrecisionComm);
 
         }
     }
@@ -1465,7 +1494,10 @@ int gmx_pme_do(struct gmx_pme_t *pme,
     } /* of grid_index-loop */
 
     /* For Lorentz-Berthelot combination rules in LJ-PME, we need to calculate
-     * seven terms. */
+     * seven terms. The grids are spread and gathered one at a time,
+     * which keeps the grid in cache, but all transforms and the solve
+     * are done in a single thread parallel region.
+     */
 
     if (pme->doLJ && pme->ljpme_combination_rule == eljpmeLB)
     {
@@ -1475,10 +1507,10 @@ int gmx_pme_do(struct gmx_pme_t *pme,
             real *local_c6 = nullptr, *local_sigma = nullptr, *RedistC6 = nullptr, *RedistSigma = nullptr;
             if (pme->nnodes == 1)
             {
-                if (pme->lb_buf1 == nullptr)
+                if (pme->lb_buf_nalloc < pme->atc[0].n)
                 {
                     pme->lb_buf_nalloc = pme->atc[0].n;
-                    snew(pme->lb_buf1, pme->lb_buf_nalloc);
+                    srenew(pme->lb_buf1, pme->lb_buf_nalloc);
                 }
                 pme->atc[0].coefficient = pme->lb_buf1;
                 switch (fep_state)
@@ -1537,18 +1569,17 @@ int gmx_pme_do(struct gmx_pme_t *pme,
             }
             calc_initial_lb_coeffs(pme, local_c6, local_sigma);
 
-            /*Seven terms in LJ-PME with LB, grid_index < 2 reserved for electrostatics*/
-            for (grid_index = 2; grid_index < 9; ++grid_index)
+            if (flags & GMX_PME_SPREAD)
             {
-                /* Unpack structure */
-                pmegrid    = &pme->pmegrid[grid_index];
-                fftgrid    = pme->fftgrid[grid_index];
-                pfft_setup = pme->pfft_setup[grid_index];
-                calc_next_lb_coeffs(pme, local_sigma);
-                grid = pmegrid->grid.grid;
-
-                if (flags & GMX_PME_SPREAD)
+                /*Seven terms in LJ-PME with LB, grid_index < 2 reserved for electrostatics*/
+                for (grid_index = PME_GRID_C6A; grid_index < DO_Q_AND_LJ_LB; ++grid_index)
                 {
+                    /* Unpack structure */
+                    pmegrid = &pme->pmegrid[grid_index];
+                    fftgrid = pme->fftgrid[grid_index];
+                    calc_next_lb_coeffs(pme, local_sigma);
+                    grid = pmegrid->grid.grid;
+
                     wallcycle_start(wcycle, ewcPME_SPREAD);
                     /* Spread the c6 on a grid */
                     spread_on_grid(pme, &pme->atc[0], pmegrid, bFirst, TRUE, fftgrid, bDoSplines, grid_index);
@@ -1560,7 +1591,7 @@ int gmx_pme_do(struct gmx_pme_t *pme,
 
                     inc_nrnb(nrnb, eNR_SPREADBSP,
                              pme->pme_order*pme->pme_order*pme->pme_order*atc->n);
-                    if (pme->nthread == 1)
+                    if (!pme->bUseThreads)
                     {
                         wrap_periodic_pmegrid(pme, grid);
                         /* sum contributions to local grid from other nodes */
@@ -1573,49 +1604,44 @@ int gmx_pme_do(struct gmx_pme_t *pme,
                         copy_pmegrid_to_fftgrid(pme, grid, fftgrid, grid_index);
                     }
                     wallcycle_stop(wcycle, ewcPME_SPREAD);
-                }
-                /*Here we start a large thread parallel region*/
-#pragma omp parallel num_threads(pme->nthread) private(thread)
-                {
-                    try
-                    {
-                        thread = gmx_omp_get_thread_num();
-                        if (flags & GMX_PME_SOLVE)
-                        {
-                            /* do 3d-fft */
-                            if (thread == 0)
-                            {
-                                wallcycle_start(wcycle, ewcPME_FFT);
-                            }
 
-                            gmx_parallel_3dfft_execute(pfft_setup, GMX_FFT_REAL_TO_COMPLEX,
-                                                       thread, wcycle);
-                            if (thread == 0)
-                            {
-                                wallcycle_stop(wcycle, ewcPME_FFT);
-                            }
-                        }
-                    }
-                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+                    bFirst = FALSE;
                 }
-                bFirst = FALSE;
             }
-            if (flags & GMX_PME_SOLVE)
-            {
-                /* solve in k-space for our local cells */
+
+            /*Here we start a large thread parallel region*/
 #pragma omp parallel num_threads(pme->nthread) private(thread)
+            {
+                try
                 {
-                    try
+                    thread = gmx_omp_get_thread_num();
+                    if (flags & GMX_PME_SOLVE)
                     {
                         int loop_count;
-                        thread = gmx_omp_get_thread_num();
+
+                        /* do 3d-fft */
+                        if (thread == 0)
+                        {
+                            wallcycle_start(wcycle, ewcPME_FFT);
+                        }
+                        for (int g = PME_GRID_C6A; g < DO_Q_AND_LJ_LB; ++g)
+                        {
+                            gmx_parallel_3dfft_execute(pme->pfft_setup[g], GMX_FFT_REAL_TO_COMPLEX,
+                                                       thread, wcycle);
+                        }
+                        if (thread == 0)
+                        {
+                            wallcycle_stop(wcycle, ewcPME_FFT);
+                        }
+
+                        /* solve in k-space for our local cells */
                         if (thread == 0)
                         {
                             wallcycle_start(wcycle, ewcLJPME);
                         }
 
                         loop_count =
-                            solve_pme_lj_yzx(pme, &pme->cfftgrid[2], TRUE,
+                            solve_pme_lj_yzx(pme, &pme->cfftgrid[PME_GRID_C6A], TRUE,
                                              scaledBox[XX][XX]*scaledBox[YY][YY]*scaledBox[ZZ][ZZ],
                                              bCalcEnerVir,
                                              pme->nthread, thread);
@@ -1625,9 +1651,48 @@ int gmx_pme_do(struct gmx_pme_t *pme,
                             inc_nrnb(nrnb, eNR_SOLVEPME, loop_count);
                         }
                     }
-                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+
+                    if (bBackFFT)
+                    {
+                        /* do 3d-invfft */
+                        if (thread == 0)
+                        {
+                            wallcycle_start(wcycle, ewcPME_FFT);
+                        }
+                        for (int g = PME_GRID_C6A; g < DO_Q_AND_LJ_LB; ++g)
+                        {
+                            gmx_parallel_3dfft_execute(pme->pfft_setup[g], GMX_FFT_COMPLEX_TO_REAL,
+                                                       thread, wcycle);
+                        }
+                        if (thread == 0)
+                        {
+                            wallcycle_stop(wcycle, ewcPME_FFT);
+
+                            if (pme->nodeid == 0)
+                            {
+                                real ntot = pme->nkx*pme->nky*pme->nkz;
+                                npme  = static_cast<int>(ntot*std::log(ntot)/std::log(2.0));
+                                inc_nrnb(nrnb, eNR_FFT, (DO_Q_AND_LJ_LB - PME_GRID_C6A)*2*npme);
+                            }
+
+                            /* Note: this wallcycle region is closed below
+                               outside an OpenMP region, so take care if
+                               refactoring code here. */
+                            wallcycle_start(wcycle, ewcPME_GATHER);
+                        }
+
+                        for (int g = PME_GRID_C6A; g < DO_Q_AND_LJ_LB; ++g)
+                        {
+                            copy_fftgrid_to_pmegrid(pme, pme->fftgrid[g], pme->pmegrid[g].grid.grid,
+                                                    g, pme->nthread, thread);
+                        }
+                    }
                 }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
             }
+            /* End of thread parallel section.
+             * With MPI we have to synchronize here before gmx_sum_qgrid_dd.
+             */
 
             if (bCalcEnerVir)
             {
@@ -1639,47 +1704,9 @@ int gmx_pme_do(struct gmx_pme_t *pme,
 
             if (bBackFFT)
             {
-                bFirst = !pme->doCoulomb;
-                calc_initial_lb_coeffs(pme, local_c6, local_sigma);
-                for (grid_index = 8; grid_index >= 2; --grid_index)
+                for (grid_index = PME_GRID_C6A; grid_index < DO_Q_AND_LJ_LB; ++grid_index)
                 {
-                    /* Unpack structure */
-                    pmegrid    = &pme->pmegrid[grid_index];
-                    fftgrid    = pme->fftgrid[grid_index];
-                    pfft_setup = pme->pfft_setup[grid_index];
-                    grid       = pmegrid->grid.grid;
-                    calc_next_lb_coeffs(pme, local_sigma);
-#pragma omp parallel num_threads(pme->nthread) private(thread)
-                    {
-                        try
-                        {
-                            thread = gmx_omp_get_thread_num();
-                            /* do 3d-invfft */
-                            if (thread == 0)
-                            {
-                                wallcycle_start(wcycle, ewcPME_FFT);
-                            }
-
-                            gmx_parallel_3dfft_execute(pfft_setup, GMX_FFT_COMPLEX_TO_REAL,
-                                                       thread, wcycle);
-                            if (thread == 0)
-                            {
-                                wallcycle_stop(wcycle, ewcPME_FFT);
-
-
-                                if (pme->nodeid == 0)
-                                {
-                                    real ntot = pme->nkx*pme->nky*pme->nkz;
-                                    npme  = static_cast<int>(ntot*std::log(ntot)/std::log(2.0));
-                                    inc_nrnb(nrnb, eNR_FFT, 2*npme);
-                                }
-                                wallcycle_start(wcycle, ewcPME_GATHER);
-                            }
-
-                            copy_fftgrid_to_pmegrid(pme, fftgrid, grid, grid_index, pme->nthread, thread);
-                        }
-                        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-                    } /*#pragma omp parallel*/
+                    grid = pme->pmegrid[grid_index].grid.grid;
 
                     /* distribute local grid to all nodes */
 #if GMX_MPI
@@ -1690,13 +1717,23 @@ int gmx_pme_do(struct gmx_pme_t *pme,
 #endif
 
                     unwrap_periodic_pmegrid(pme, grid);
+                }
+
+                if (bCalcF)
+                {
+                    /* interpolate forces for our local atoms,
+                     * only clear them when Coulomb PME did not add forces yet
+                     */
+                    bClearF = (fep_state == 0 && !pme->doCoulomb && PAR(cr));
 
-                    if (bCalcF)
+                    calc_initial_lb_coeffs(pme, local_c6, local_sigma);
+                    for (grid_index = DO_Q_AND_LJ_LB - 1; grid_index >= PME_GRID_C6A; --grid_index)
                     {
-                        /* interpolate forces for our local atoms */
-                        bClearF = (bFirst && PAR(cr));
-                        scale   = pme->bFEP ? (fep_state < 1 ? 1.0-lambda_lj : lambda_lj) : 1.0;
-                        scale  *= lb_scale_factor[grid_index-2];
+                        grid = pme->pmegrid[grid_index].grid.grid;
+                        calc_next_lb_coeffs(pme, local_sigma);
+
+                        scale  = pme->bFEP ? (fep_state < 1 ? 1.0-lambda_lj : lambda_lj) : 1.0;
+                        scale *= lb_scale_factor[grid_index-2];
 
 #pragma omp parallel for num_threads(pme->nthread) schedule(static)
                         for (thread = 0; thread < pme->nthread; thread++)
@@ -1710,15 +1747,16 @@ int gmx_pme_do(struct gmx_pme_t *pme,
                             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
                         }
 
-
                         inc_nrnb(nrnb, eNR_GATHERFBSP,
                                  pme->pme_order*pme->pme_order*pme->pme_order*pme->atc[0].n);
-                    }
-                    wallcycle_stop(wcycle, ewcPME_GATHER);
 
-                    bFirst = FALSE;
-                } /* for (grid_index = 8; grid_index >= 2; --grid_index) */
-            }     /* if (bCalcF) */
+                        bClearF = FALSE;
+                    }
+                }
+                /* Note: this wallcycle region is opened above inside an OpenMP
+                   region, so take care if refactoring code here. */
+                wallcycle_stop(wcycle, ewcPME_GATHER);
+            }
         }         /* for (fep_state = 0; fep_state < fep_states_lj; ++fep_state) */
     }             /* if ((flags & GMX_PME_DO_LJ) && pme->ljpme_combination_rule == eljpmeLB) */
 
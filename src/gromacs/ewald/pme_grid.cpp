@@ -43,6 +43,8 @@
 
 #include <cstdlib>
 
+#include <algorithm>
+
 #include "gromacs/ewald/pme.h"
 #include "gromacs/fft/parallel_3dfft.h"
 #include "gromacs/math/vec.h"
@@ -66,12 +68,38 @@
 #define GMX_CACHE_SEP 64
 
 #if GMX_MPI
+void sendrecvGridData(pme_overlap_t *overlap, bool bReducedPrecision,
+                      const real *sendptr, int sendCount, int send_id,
+                      real *recvptr, int recvCount, int recv_id, int tag)
+{
+    MPI_Status stat;
+
+    if (!bReducedPrecision)
+    {
+        MPI_Sendrecv(sendptr, sendCount, GMX_MPI_REAL,
+                     send_id, tag,
+                     recvptr, recvCount, GMX_MPI_REAL,
+                     recv_id, tag,
+                     overlap->mpi_comm, &stat);
+        return;
+    }
+
+    overlap->sendbufFloat.resize(sendCount);
+    overlap->recvbufFloat.resize(recvCount);
+    std::copy(sendptr, sendptr + sendCount, overlap->sendbufFloat.begin());
+    MPI_Sendrecv(overlap->sendbufFloat.data(), sendCount, MPI_FLOAT,
+                 send_id, tag,
+                 overlap->recvbufFloat.data(), recvCount, MPI_FLOAT,
+                 recv_id, tag,
+                 overlap->mpi_comm, &stat);
+    std::copy(overlap->recvbufFloat.begin(), overlap->recvbufFloat.end(), recvptr);
+}
+
 void gmx_sum_qgrid_dd(struct gmx_pme_t *pme, real *grid, int direction)
 {
     pme_overlap_t *overlap;
     int            send_index0, send_nindex;
     int            recv_index0, recv_nindex;
-    MPI_Status     stat;
     int            i, j, k, ix, iy, iz, icnt;
     int            send_id, recv_id, datasize;
     real          *p;
@@ -130,11 +158,10 @@ void gmx_sum_qgrid_dd(struct gmx_pme_t *pme, real *grid, int direction)
 
         datasize      = pme->pmegrid_nx * pme->nkz;
 
-        MPI_Sendrecv(overlap->sendbuf.data(), send_nindex*datasize, GMX_MPI_REAL,
-                     send_id, ipulse,
-                     overlap->recvbuf.data(), recv_nindex*datasize, GMX_MPI_REAL,
-                     recv_id, ipulse,
-                     overlap->mpi_comm, &stat);
+        sendrecvGridData(overlap, pme->bReducedPrecisionComm,
+                         overlap->sendbuf.data(), send_nindex*datasize, send_id,
+                         overlap->recvbuf.data(), recv_nindex*datasize, recv_id,
+                         ipulse);
 
         /* Get data from contiguous recv buffer */
         if (debug)
@@ -215,11 +242,10 @@ void gmx_sum_qgrid_dd(struct gmx_pme_t *pme, real *grid, int direction)
                     recv_index0-pme->pmegrid_start_ix+recv_nindex);
         }
 
-        MPI_Sendrecv(sendptr, send_nindex*datasize, GMX_MPI_REAL,
-                     send_id, ipulse,
-                     recvptr, recv_nindex*datasize, GMX_MPI_REAL,
-                     recv_id, ipulse,
-                     overlap->mpi_comm, &stat);
+        sendrecvGridData(overlap, pme->bReducedPrecisionComm,
+                         sendptr, send_nindex*datasize, send_id,
+                         recvptr, recv_nindex*datasize, recv_id,
+                         ipulse);
 
         /* ADD data from contiguous recv buffer */
         if (direction == GMX_SUM_GRID_FORWARD)
@@ -55,10 +55,22 @@ constexpr int c_pmeMaxUnitcellShift = 2;
  */
 constexpr int c_pmeNeighborUnitcellCount = 2*c_pmeMaxUnitcellShift + 1;
 
+struct pme_overlap_t;
 struct pmegrid_t;
 struct pmegrids_t;
 
 #if GMX_MPI
+/*! \brief Sends and receives grid data over the communicator of \p overlap
+ *
+ * With \p bReducedPrecision the data is sent in single precision,
+ * which halves the communication volume in double precision builds.
+ * The data is converted by the calling thread.
+ */
+void
+sendrecvGridData(pme_overlap_t *overlap, bool bReducedPrecision,
+                 const real *sendptr, int sendCount, int send_id,
+                 real *recvptr, int recvCount, int recv_id, int tag);
+
 void
 gmx_sum_qgrid_dd(gmx_pme_t *pme, real *grid, int direction);
 #endif
@@ -140,6 +140,8 @@ struct pme_overlap_t
     std::vector<pme_grid_comm_t> comm_data;      //!< All the individual communication data for each rank
     std::vector<real>            sendbuf;        //!< Shared buffer for sending
     std::vector<real>            recvbuf;        //!< Shared buffer for receiving
+    std::vector<float>           sendbufFloat;   //!< Send buffer for reduced precision communication
+    std::vector<float>           recvbufFloat;   //!< Receive buffer for reduced precision communication
 };
 
 /*! \brief Data structure for organizing particle allocation to threads */
@@ -160,6 +162,12 @@ typedef struct {
     real     *ptr_theta_z;
     splinevec dtheta;
     real     *ptr_dtheta_z;
+    ivec      used0;            /* Start of the spread region of the thread grid */
+    ivec      used1;            /* End of the spread region of the thread grid   */
+    int       sort_nalloc;      /* Allocation size of sort_buf                   */
+    int      *sort_buf;         /* Buffer for sorting ind on grid cell           */
+    int       sort_cell_nalloc; /* Allocation size of sort_cell                  */
+    int      *sort_cell;        /* Atom count per grid cell for sorting          */
 } splinedata_t;
 
 /*! \brief Data structure for coordinating transfer between PP and PME ranks*/
@@ -255,6 +263,8 @@ struct gmx_pme_t {            //NOLINT(clang-analyzer-optin.performance.Padding)
     gmx_bool   bFEP_lj;
     int        nkx, nky, nkz; /* Grid dimensions */
     gmx_bool   bP3M;          /* Do P3M: optimize the influence function */
+    bool       bReducedPrecisionComm; /* Communicate grids in single precision, only with GMX_DOUBLE */
+    bool       bSortAtoms;            /* Spread in the order of the grid cells of the atoms */
     int        pme_order;
     real       ewaldcoeff_q;  /* Ewald splitting coefficient for Coulomb */
     real       ewaldcoeff_lj; /* Ewald splitting coefficient for r^-6 */
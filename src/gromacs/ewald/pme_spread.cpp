@@ -211,6 +211,58 @@ static void make_thread_local_ind(const pme_atomcomm_t *atc,
     spline->n = n;
 }
 
+/* Sorts the first spline->n entries of spline->ind on the x/y grid cell
+ * of pmegrid the atoms are spread to. A counting sort is used, which
+ * keeps the original order within each cell. Spreading and gathering
+ * in this order accesses the grid column by column, which strongly
+ * reduces cache misses with large grids.
+ */
+static void sort_ind_on_grid_cell(const pme_atomcomm_t *atc,
+                                  const pmegrid_t      *pmegrid,
+                                  splinedata_t         *spline)
+{
+    const int ny    = pmegrid->n[YY];
+    const int ncell = pmegrid->n[XX]*ny;
+    const int offx  = pmegrid->offset[XX];
+    const int offy  = pmegrid->offset[YY];
+
+    if (ncell + 1 > spline->sort_cell_nalloc)
+    {
+        spline->sort_cell_nalloc = over_alloc_large(ncell + 1);
+        srenew(spline->sort_cell, spline->sort_cell_nalloc);
+    }
+    if (spline->n > spline->sort_nalloc)
+    {
+        spline->sort_nalloc = over_alloc_large(spline->n);
+        srenew(spline->sort_buf, spline->sort_nalloc);
+    }
+
+    int *cell = spline->sort_cell;
+    for (int c = 0; c <= ncell; c++)
+    {
+        cell[c] = 0;
+    }
+    for (int nn = 0; nn < spline->n; nn++)
+    {
+        const int *idxptr = atc->idx[spline->ind[nn]];
+
+        cell[(idxptr[XX] - offx)*ny + idxptr[YY] - offy + 1]++;
+    }
+    /* Convert the counts to the start index of each cell */
+    for (int c = 0; c < ncell; c++)
+    {
+        cell[c + 1] += cell[c];
+    }
+    for (int nn = 0; nn < spline->n; nn++)
+    {
+        const int  n      = spline->ind[nn];
+        const int *idxptr = atc->idx[n];
+
+        spline->sort_buf[cell[(idxptr[XX] - offx)*ny + idxptr[YY] - offy]++] = n;
+    }
+    std::copy(spline->sort_buf, spline->sort_buf + spline->n, spline->ind);
+}
+
 /* Macro to force loop unrolling by fixing order.
  * This gives a significant performance gain.
  */
@@ -349,6 +401,15 @@ static void spread_coefficients_bsplines_thread(const pmegrid_t
 
     order = pmegrid->order;
 
+    /* Track the region of the grid we spread to, so the reduction
+     * can skip the parts of our grid that are still zero.
+     */
+    for (i = 0; i < DIM; i++)
+    {
+        spline->used0[i] = pmegrid->n[i];
+        spline->used1[i] = 0;
+    }
+
     for (nn = 0; nn < spline->n; nn++)
     {
         n           = spline->ind[nn];
@@ -363,6 +424,13 @@ static void spread_coefficients_bsplines_thread(const pmegrid_t
             j0   = idxptr[YY] - offy;
             k0   = idxptr[ZZ] - offz;
 
+            spline->used0[XX] = std::min(spline->used0[XX], i0);
+            spline->used0[YY] = std::min(spline->used0[YY], j0);
+            spline->used0[ZZ] = std::min(spline->used0[ZZ], k0);
+            spline->used1[XX] = std::max(spline->used1[XX], i0 + order);
+            spline->used1[YY] = std::max(spline->used1[YY], j0 + order);
+            spline->used1[ZZ] = std::max(spline->used1[ZZ], k0 + order);
+
             thx = spline->theta[XX] + norder;
             thy = spline->theta[YY] + norder;
             thz = spline->theta[ZZ] + norder;
@@ -451,7 +519,7 @@ static void copy_local_grid(const gmx_pme_t *pme, const pmegrids_t *pmegrids,
 }
 
 static void
-reduce_threadgrid_overlap(const gmx_pme_t *pme,
+reduce_threadgrid_overlap(const gmx_pme_t *pme, const pme_atomcomm_t *atc,
                           const pmegrids_t *pmegrids, int thread,
                           real *fftgrid, real *commbuf_x, real *commbuf_y,
                           int grid_index)
@@ -469,6 +537,7 @@ reduce_threadgrid_overlap(const gmx_pme_t *pme,
     int  d;
     int  thread_f;
     const pmegrid_t *pmegrid, *pmegrid_g, *pmegrid_f;
+    const splinedata_t *spline_f;
     const real *grid_th;
     real *commbuf = nullptr;
 
@@ -618,14 +687,26 @@ reduce_threadgrid_overlap(const gmx_pme_t *pme,
 
                 if (!(bCommX || bCommY))
                 {
+                    /* Only the region thread_f spread to can be non-zero,
+                     * restrict the copy to that region. Atoms sorted on
+                     * grid cell in the thread grids keep this region small.
+                     */
+                    spline_f = &atc->spline[thread_f];
+                    const int rx0 = std::max(offx, ox + spline_f->used0[XX]);
+                    const int rx1 = std::min(tx1, ox + spline_f->used1[XX]);
+                    const int ry0 = std::max(offy, oy + spline_f->used0[YY]);
+                    const int ry1 = std::min(ty1, oy + spline_f->used1[YY]);
+                    const int rz0 = std::max(offz, oz + spline_f->used0[ZZ]);
+                    const int rz1 = std::min(tz1, oz + spline_f->used1[ZZ]);
+
                     /* Copy from the thread local grid to the node grid */
-                    for (x = offx; x < tx1; x++)
+                    for (x = rx0; x < rx1; x++)
                     {
-                        for (y = offy; y < ty1; y++)
+                        for (y = ry0; y < ry1; y++)
                         {
                             i0  = (x*fft_my + y)*fft_mz;
                             i0t = ((x - ox)*nsy + (y - oy))*nsz - oz;
-                            for (z = offz; z < tz1; z++)
+                            for (z = rz0; z < rz1; z++)
                             {
                                 fftgrid[i0+z] += grid_th[i0t+z];
                             }
@@ -701,14 +782,11 @@ reduce_threadgrid_overlap(const gmx_pme_t *pme,
 }
 
 
-static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
+static void sum_fftgrid_dd(gmx_pme_t *pme, real *fftgrid, int grid_index)
 {
     ivec local_fft_ndata, local_fft_offset, local_fft_size;
     int  send_index0, send_nindex;
     int  recv_nindex;
-#if GMX_MPI
-    MPI_Status stat;
-#endif
     int  recv_size_y;
     int  size_yx;
     int  x, y, z, indg, indb;
@@ -728,7 +806,7 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
     if (pme->nnodes_minor > 1)
     {
         /* Major dimension */
-        const pme_overlap_t *overlap = &pme->overlap[1];
+        pme_overlap_t *overlap = &pme->overlap[1];
 
         if (pme->nnodes_major > 1)
         {
@@ -754,8 +832,8 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
             recv_nindex   = overlap->comm_data[ipulse].recv_nindex;
             recv_size_y   = overlap->comm_data[ipulse].recv_size;
 
-            auto *sendptr = const_cast<real *>(overlap->sendbuf.data()) + send_index0 * local_fft_ndata[ZZ];
-            auto *recvptr = const_cast<real *>(overlap->recvbuf.data());
+            auto *sendptr = overlap->sendbuf.data() + send_index0 * local_fft_ndata[ZZ];
+            auto *recvptr = overlap->recvbuf.data();
 
             if (debug != nullptr)
             {
@@ -766,11 +844,10 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
 #if GMX_MPI
             int send_id = overlap->comm_data[ipulse].send_id;
             int recv_id = overlap->comm_data[ipulse].recv_id;
-            MPI_Sendrecv(sendptr, send_size_y*datasize, GMX_MPI_REAL,
-                         send_id, ipulse,
-                         recvptr, recv_size_y*datasize, GMX_MPI_REAL,
-                         recv_id, ipulse,
-                         overlap->mpi_comm, &stat);
+            sendrecvGridData(overlap, pme->bReducedPrecisionComm,
+                             sendptr, send_size_y*datasize, send_id,
+                             recvptr, recv_size_y*datasize, recv_id,
+                             ipulse);
 #endif
 
             for (x = 0; x < local_fft_ndata[XX]; x++)
@@ -789,7 +866,7 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
             if (pme->nnodes_major > 1)
             {
                 /* Copy from the received buffer to the send buffer for dim 0 */
-                sendptr = const_cast<real *>(pme->overlap[0].sendbuf.data());
+                sendptr = pme->overlap[0].sendbuf.data();
                 for (x = 0; x < size_yx; x++)
                 {
                     for (y = 0; y < recv_nindex; y++)
@@ -813,7 +890,7 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
     if (pme->nnodes_major > 1)
     {
         /* Major dimension */
-        const pme_overlap_t *overlap = &pme->overlap[0];
+        pme_overlap_t *overlap = &pme->overlap[0];
 
         size_t ipulse = 0;
 
@@ -831,13 +908,12 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
         int datasize  = local_fft_ndata[YY]*local_fft_ndata[ZZ];
         int send_id   = overlap->comm_data[ipulse].send_id;
         int recv_id   = overlap->comm_data[ipulse].recv_id;
-        auto *sendptr = const_cast<real *>(overlap->sendbuf.data());
-        auto *recvptr = const_cast<real *>(overlap->recvbuf.data());
-        MPI_Sendrecv(sendptr, send_nindex*datasize, GMX_MPI_REAL,
-                     send_id, ipulse,
-                     recvptr, recv_nindex*datasize, GMX_MPI_REAL,
-                     recv_id, ipulse,
-                     overlap->mpi_comm, &stat);
+        auto *sendptr = overlap->sendbuf.data();
+        auto *recvptr = overlap->recvbuf.data();
+        sendrecvGridData(overlap, pme->bReducedPrecisionComm,
+                         sendptr, send_nindex*datasize, send_id,
+                         recvptr, recv_nindex*datasize, recv_id,
+                         ipulse);
 #endif
 
         for (x = 0; x < recv_nindex; x++)
@@ -855,7 +931,7 @@ static void sum_fftgrid_dd(const gmx_pme_t *pme, real *fftgrid, int grid_index)
     }
 }
 
-void spread_on_grid(const gmx_pme_t *pme,
+void spread_on_grid(gmx_pme_t *pme,
                     const pme_atomcomm_t *atc, const pmegrids_t *grids,
                     gmx_bool bCalcSplines, gmx_bool bSpread,
                     real *fftgrid, gmx_bool bDoSplines, int grid_index)
@@ -932,6 +1008,21 @@ void spread_on_grid(const gmx_pme_t *pme,
                 }
             }
 
+            if (pme->bSortAtoms && bCalcSplines && grids != nullptr)
+            {
+                if (spline->n == atc->n)
+                {
+                    /* Without thread-local indices ind should be
+                     * the identity, reset it as we might have sorted it.
+                     */
+                    for (int i = 0; i < spline->n; i++)
+                    {
+                        spline->ind[i] = i;
+                    }
+                }
+                sort_ind_on_grid_cell(atc, pme->bUseThreads ? &grids->grid_th[thread] : &grids->grid, spline);
+            }
+
             if (bCalcSplines)
             {
                 make_bsplines(spline->theta, spline->dtheta, pme->pme_order,
@@ -975,7 +1066,7 @@ void spread_on_grid(const gmx_pme_t *pme,
         {
             try
             {
-                reduce_threadgrid_overlap(pme, grids, thread,
+                reduce_threadgrid_overlap(pme, atc, grids, thread,
                                           fftgrid,
                                           const_cast<real *>(pme->overlap[0].sendbuf.data()),
                                           const_cast<real *>(pme->overlap[1].sendbuf.data()),
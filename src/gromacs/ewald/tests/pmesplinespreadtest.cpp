@@ -42,11 +42,16 @@
 
 #include "gmxpre.h"
 
+#include "config.h"
+
 #include <string>
 
 #include <gmock/gmock.h>
 
+#include "gromacs/ewald/pme_internal.h"
 #include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
 #include "gromacs/utility/stringutil.h"
 
 #include "testutils/refdata.h"
@@ -352,6 +357,109 @@ INSTANTIATE_TEST_CASE_P(SaneInput13, PmeSplineAndSpreadTest, ::testing::Combine(
                                                                                     ::testing::Values(c_sampleCoordinates13),
                                                                                     ::testing::Values(c_sampleCharges13)
                                                                                 ));
+
+//! Input parameters for the threading tests - unit cell box, PME interpolation order and grid dimensions
+typedef std::tuple<Matrix3x3, int, IVec> SpreadThreadingInputParameters;
+
+/*! \brief Test fixture for checking that spreading with threads and with
+ * atoms sorted on grid cell gives the same grid as serial spreading.
+ *
+ * With threads each thread spreads on its own grid, and only the part of
+ * it that was spread on is reduced into the FFT grid.
+ */
+class PmeSpreadThreadingTest : public ::testing::TestWithParam<SpreadThreadingInputParameters>
+{
+    public:
+        //! Spreads \p coordinates_ and \p charges_ and returns the non-zero grid values
+        SparseRealGridValuesOutput spread(int numThreads, bool sortAtoms)
+        {
+            const Matrix3x3 &box      = std::get<0>(GetParam());
+            const int        pmeOrder = std::get<1>(GetParam());
+            const IVec      &gridSize = std::get<2>(GetParam());
+
+            t_inputrec       inputRec;
+            inputRec.nkx         = gridSize[XX];
+            inputRec.nky         = gridSize[YY];
+            inputRec.nkz         = gridSize[ZZ];
+            inputRec.pme_order   = pmeOrder;
+            inputRec.coulombtype = eelPME;
+            inputRec.epsilon_r   = 1.0;
+
+            PmeSafePointer pmeSafe = pmeInitAtoms(&inputRec, CodePath::CPU, nullptr, nullptr,
+                                                  coordinates_, charges_, box, numThreads);
+            pmeSafe->bSortAtoms = sortAtoms;
+            pmePerformSplineAndSpread(pmeSafe.get(), CodePath::CPU, true, true);
+
+            return pmeGetRealGrid(pmeSafe.get(), CodePath::CPU);
+        }
+
+        //! Sets up \p numAtoms atoms at random positions, partly outside the unit cell
+        void generateAtoms(int numAtoms)
+        {
+            DefaultRandomEngine           rng(1234);
+            UniformRealDistribution<real> dist(-0.5, 1.5);
+            const Matrix3x3              &box = std::get<0>(GetParam());
+
+            coordinatesStorage_.resize(numAtoms);
+            chargesStorage_.resize(numAtoms);
+            for (int i = 0; i < numAtoms; i++)
+            {
+                const real fraction[DIM] = { dist(rng), dist(rng), dist(rng) };
+                for (int d = 0; d < DIM; d++)
+                {
+                    coordinatesStorage_[i][d] = 0;
+                    for (int e = d; e < DIM; e++)
+                    {
+                        coordinatesStorage_[i][d] += fraction[e]*box[e*DIM + d];
+                    }
+                }
+                chargesStorage_[i] = dist(rng) - 0.5;
+            }
+            coordinates_ = coordinatesStorage_;
+            charges_     = chargesStorage_;
+        }
+
+    private:
+        std::vector<RVec>  coordinatesStorage_;
+        std::vector<real>  chargesStorage_;
+        CoordinatesVector  coordinates_;
+        ChargesVector      charges_;
+};
+
+TEST_P(PmeSpreadThreadingTest, ThreadsAndSortingDoNotChangeTheGrid)
+{
+    generateAtoms(200);
+    const SparseRealGridValuesOutput reference = spread(1, false);
+    const int                        pmeOrder  = std::get<1>(GetParam());
+    /* Threads only change the order of the summation of the contributions */
+    FloatingPointTolerance           tolerance = relativeToleranceAsUlp(1.0, 40*pmeOrder);
+
+#if GMX_OPENMP
+    const std::vector<int>           threadCounts = { 1, 2, 3, 4 };
+#else
+    const std::vector<int>           threadCounts = { 1 };
+#endif
+    for (int numThreads : threadCounts)
+    {
+        for (bool sortAtoms : { false, true })
+        {
+            SCOPED_TRACE(formatString("Spreading with %d threads, %s", numThreads,
+                                      sortAtoms ? "atoms sorted on grid cell" : "atoms not sorted"));
+            const SparseRealGridValuesOutput grid = spread(numThreads, sortAtoms);
+
+            EXPECT_EQ(reference.size(), grid.size());
+            for (const auto &point : reference)
+            {
+                const auto value = grid.find(point.first);
+                ASSERT_NE(grid.end(), value) << "in " << point.first;
+                EXPECT_REAL_EQ_TOL(point.second, value->second, tolerance) << "in " << point.first;
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(SaneInput, PmeSpreadThreadingTest, ::testing::Combine(c_inputBoxes, c_inputPmeOrders, c_inputGridSizes));
+
 }  // namespace
 }  // namespace test
 }  // namespace gmx
@@ -113,7 +113,8 @@ static PmeSafePointer pmeInitInternal(const t_inputrec         *inputRec,
                                       size_t                    atomCount,
                                       const Matrix3x3          &box,
                                       real                      ewaldCoeff_q = 1.0f,
-                                      real                      ewaldCoeff_lj = 1.0f
+                                      real                      ewaldCoeff_lj = 1.0f,
+                                      int                       numThreads = 1
                                       )
 {
     const MDLogger dummyLogger;
@@ -121,7 +122,7 @@ static PmeSafePointer pmeInitInternal(const t_inputrec         *inputRec,
     t_commrec      dummyCommrec  = {0};
     NumPmeDomains  numPmeDomains = { 1, 1 };
     gmx_pme_t     *pmeDataRaw    = gmx_pme_init(&dummyCommrec, numPmeDomains, inputRec, atomCount, false, false, true,
-                                                ewaldCoeff_q, ewaldCoeff_lj, 1, runMode, nullptr, gpuInfo, pmeGpuProgram, dummyLogger);
+                                                ewaldCoeff_q, ewaldCoeff_lj, numThreads, runMode, nullptr, gpuInfo, pmeGpuProgram, dummyLogger);
     PmeSafePointer pme(pmeDataRaw); // taking ownership
 
     // TODO get rid of this with proper matrix type
@@ -175,12 +176,14 @@ PmeSafePointer pmeInitAtoms(const t_inputrec         *inputRec,
                             PmeGpuProgramHandle       pmeGpuProgram,
                             const CoordinatesVector  &coordinates,
                             const ChargesVector      &charges,
-                            const Matrix3x3          &box
+                            const Matrix3x3          &box,
+                            int                       numThreads
                             )
 {
     const index     atomCount = coordinates.size();
     GMX_RELEASE_ASSERT(atomCount == charges.ssize(), "Mismatch in atom data");
-    PmeSafePointer  pmeSafe = pmeInitInternal(inputRec, mode, gpuInfo, pmeGpuProgram, atomCount, box);
+    PmeSafePointer  pmeSafe = pmeInitInternal(inputRec, mode, gpuInfo, pmeGpuProgram, atomCount, box,
+                                              1.0f, 1.0f, numThreads);
     pme_atomcomm_t *atc     = nullptr;
 
     switch (mode)
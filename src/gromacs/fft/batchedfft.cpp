@@ -0,0 +1,524 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the batched 1D FFT.
+ *
+ * \ingroup module_fft
+ */
+#include "gmxpre.h"
+
+#include "batchedfft.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+
+#include "gromacs/math/units.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+#if GMX_SIMD_HAVE_REAL
+//! The lane type, each SIMD element holds one transform
+typedef SimdReal LaneReal;
+//! The number of transforms processed together
+constexpr int    c_w = GMX_SIMD_REAL_WIDTH;
+#else
+//! The lane type, each SIMD element holds one transform
+typedef real     LaneReal;
+//! The number of transforms processed together
+constexpr int    c_w = 1;
+#endif
+
+/*! \brief Multiplies (re,im) by the twiddle factor (wr,conj*wi) and stores in (yr,yi)
+ *
+ * All butterflies below operate on c_w transforms at once, stored in
+ * the SIMD lanes. The twiddle factors wr, wi are those of the forward
+ * transform, \p conj is -1 for backward transforms.
+ */
+inline void storeTwiddled(LaneReal re, LaneReal im, real wr, real wi, real conj,
+                          real *yr, real *yi)
+{
+    const LaneReal c(wr);
+    const LaneReal s(conj*wi);
+
+    store(yr, re*c - im*s);
+    store(yi, re*s + im*c);
+}
+
+//! Radix-2 butterfly
+void butterfly2(const real *xr, const real *xi, int inStep,
+                real *yr, real *yi, int outStep,
+                const real *wr, const real *wi, real conj)
+{
+    LaneReal a0r = load<LaneReal>(xr), a0i = load<LaneReal>(xi);
+    LaneReal a1r = load<LaneReal>(xr + inStep), a1i = load<LaneReal>(xi + inStep);
+
+    store(yr, a0r + a1r);
+    store(yi, a0i + a1i);
+    storeTwiddled(a0r - a1r, a0i - a1i, wr[0], wi[0], conj, yr + outStep, yi + outStep);
+}
+
+//! Radix-3 butterfly, \p sign is the sign of the exponent of the transform
+void butterfly3(const real *xr, const real *xi, int inStep,
+                real *yr, real *yi, int outStep,
+                const real *wr, const real *wi, real conj, real sign)
+{
+    const LaneReal c(-0.5);
+    const LaneReal s(sign*std::sqrt(3.0)*0.5);
+
+    LaneReal       a0r = load<LaneReal>(xr), a0i = load<LaneReal>(xi);
+    LaneReal       a1r = load<LaneReal>(xr + inStep), a1i = load<LaneReal>(xi + inStep);
+    LaneReal       a2r = load<LaneReal>(xr + 2*inStep), a2i = load<LaneReal>(xi + 2*inStep);
+
+    LaneReal       t1r = a1r + a2r, t1i = a1i + a2i;
+    LaneReal       t2r = a1r - a2r, t2i = a1i - a2i;
+    LaneReal       m1r = a0r + c*t1r, m1i = a0i + c*t1i;
+    /* i*s*t2 */
+    LaneReal       m2r = -s*t2i, m2i = s*t2r;
+
+    store(yr, a0r + t1r);
+    store(yi, a0i + t1i);
+    storeTwiddled(m1r + m2r, m1i + m2i, wr[0], wi[0], conj, yr + outStep, yi + outStep);
+    storeTwiddled(m1r - m2r, m1i - m2i, wr[1], wi[1], conj, yr + 2*outStep, yi + 2*outStep);
+}
+
+//! Radix-4 butterfly, \p sign is the sign of the exponent of the transform
+void butterfly4(const real *xr, const real *xi, int inStep,
+                real *yr, real *yi, int outStep,
+                const real *wr, const real *wi, real conj, real sign)
+{
+    const LaneReal sg(sign);
+
+    LaneReal       a0r = load<LaneReal>(xr), a0i = load<LaneReal>(xi);
+    LaneReal       a1r = load<LaneReal>(xr + inStep), a1i = load<LaneReal>(xi + inStep);
+    LaneReal       a2r = load<LaneReal>(xr + 2*inStep), a2i = load<LaneReal>(xi + 2*inStep);
+    LaneReal       a3r = load<LaneReal>(xr + 3*inStep), a3i = load<LaneReal>(xi + 3*inStep);
+
+    LaneReal       t0r = a0r + a2r, t0i = a0i + a2i;
+    LaneReal       t1r = a0r - a2r, t1i = a0i - a2i;
+    LaneReal       t2r = a1r + a3r, t2i = a1i + a3i;
+    /* i*sign*(a1 - a3) */
+    LaneReal       t3r = sg*(a3i - a1i), t3i = sg*(a1r - a3r);
+
+    store(yr, t0r + t2r);
+    store(yi, t0i + t2i);
+    storeTwiddled(t1r + t3r, t1i + t3i, wr[0], wi[0], conj, yr + outStep, yi + outStep);
+    storeTwiddled(t0r - t2r, t0i - t2i, wr[1], wi[1], conj, yr + 2*outStep, yi + 2*outStep);
+    storeTwiddled(t1r - t3r, t1i - t3i, wr[2], wi[2], conj, yr + 3*outStep, yi + 3*outStep);
+}
+
+//! Radix-5 butterfly, \p sign is the sign of the exponent of the transform
+void butterfly5(const real *xr, const real *xi, int inStep,
+                real *yr, real *yi, int outStep,
+                const real *wr, const real *wi, real conj, real sign)
+{
+    const LaneReal c1(std::cos(2*M_PI/5));
+    const LaneReal c2(std::cos(4*M_PI/5));
+    const LaneReal s1(sign*std::sin(2*M_PI/5));
+    const LaneReal s2(sign*std::sin(4*M_PI/5));
+
+    LaneReal       a0r = load<LaneReal>(xr), a0i = load<LaneReal>(xi);
+    LaneReal       a1r = load<LaneReal>(xr + inStep), a1i = load<LaneReal>(xi + inStep);
+    LaneReal       a2r = load<LaneReal>(xr + 2*inStep), a2i = load<LaneReal>(xi + 2*inStep);
+    LaneReal       a3r = load<LaneReal>(xr + 3*inStep), a3i = load<LaneReal>(xi + 3*inStep);
+    LaneReal       a4r = load<LaneReal>(xr + 4*inStep), a4i = load<LaneReal>(xi + 4*inStep);
+
+    LaneReal       t1r = a1r + a4r, t1i = a1i + a4i;
+    LaneReal       t2r = a2r + a3r, t2i = a2i + a3i;
+    LaneReal       t3r = a1r - a4r, t3i = a1i - a4i;
+    LaneReal       t4r = a2r - a3r, t4i = a2i - a3i;
+
+    LaneReal       m1r = a0r + c1*t1r + c2*t2r, m1i = a0i + c1*t1i + c2*t2i;
+    LaneReal       m2r = a0r + c2*t1r + c1*t2r, m2i = a0i + c2*t1i + c1*t2i;
+    /* i*(s1*t3 + s2*t4) and i*(s2*t3 - s1*t4) */
+    LaneReal       n1r = -(s1*t3i + s2*t4i), n1i = s1*t3r + s2*t4r;
+    LaneReal       n2r = s1*t4i - s2*t3i, n2i = s2*t3r - s1*t4r;
+
+    store(yr, a0r + t1r + t2r);
+    store(yi, a0i + t1i + t2i);
+    storeTwiddled(m1r + n1r, m1i + n1i, wr[0], wi[0], conj, yr + outStep, yi + outStep);
+    storeTwiddled(m2r + n2r, m2i + n2i, wr[1], wi[1], conj, yr + 2*outStep, yi + 2*outStep);
+    storeTwiddled(m2r - n2r, m2i - n2i, wr[2], wi[2], conj, yr + 3*outStep, yi + 3*outStep);
+    storeTwiddled(m1r - n1r, m1i - n1i, wr[3], wi[3], conj, yr + 4*outStep, yi + 4*outStep);
+}
+
+/*! \brief Butterfly for any radix, O(radix^2)
+ *
+ * \p rootRe and \p rootIm contain the forward roots of unity of order radix.
+ */
+void butterflyGeneric(int radix, const real *xr, const real *xi, int inStep,
+                      real *yr, real *yi, int outStep,
+                      const real *wr, const real *wi, real conj,
+                      const real *rootRe, const real *rootIm)
+{
+    for (int j = 0; j < radix; j++)
+    {
+        LaneReal accRe = load<LaneReal>(xr);
+        LaneReal accIm = load<LaneReal>(xi);
+        for (int k = 1; k < radix; k++)
+        {
+            const int      root = (j*k) % radix;
+            const LaneReal cr(rootRe[root]);
+            const LaneReal ci(conj*rootIm[root]);
+            const LaneReal ar = load<LaneReal>(xr + k*inStep);
+            const LaneReal ai = load<LaneReal>(xi + k*inStep);
+
+            accRe = accRe + ar*cr - ai*ci;
+            accIm = accIm + ar*ci + ai*cr;
+        }
+        if (j == 0)
+        {
+            store(yr, accRe);
+            store(yi, accIm);
+        }
+        else
+        {
+            storeTwiddled(accRe, accIm, wr[j - 1], wi[j - 1], conj,
+                          yr + j*outStep, yi + j*outStep);
+        }
+    }
+}
+
+}   // namespace
+
+BatchedFft1D::BatchedFft1D(int n, bool realData) :
+    n_(n), realData_(realData), nComplex_(realData ? n/2 : n)
+{
+    GMX_RELEASE_ASSERT(n >= 1, "Need a positive FFT length");
+    GMX_RELEASE_ASSERT(!realData || supportsRealLength(n),
+                       "Batched real FFTs require an even length");
+
+    /* Factorize, using radix 4 as much as possible */
+    std::vector<int> factors;
+    int              remainder = nComplex_;
+    for (int radix : { 4, 2, 3, 5 })
+    {
+        while (remainder % radix == 0)
+        {
+            factors.push_back(radix);
+            remainder /= radix;
+        }
+    }
+    for (int radix = 7; remainder > 1; radix += 2)
+    {
+        while (remainder % radix == 0)
+        {
+            factors.push_back(radix);
+            remainder /= radix;
+        }
+    }
+
+    int length = nComplex_;
+    int stride = 1;
+    for (int radix : factors)
+    {
+        Stage     stage;
+        const int m = length/radix;
+
+        stage.radix  = radix;
+        stage.stride = stride;
+        stage.length = length;
+        stage.twiddleRe.resize(m*(radix - 1));
+        stage.twiddleIm.resize(m*(radix - 1));
+        for (int p = 0; p < m; p++)
+        {
+            for (int j = 1; j < radix; j++)
+            {
+                /* Compute the angle in double for accuracy in mixed precision */
+                double angle = -2*M_PI*static_cast<double>(j*p)/length;
+                stage.twiddleRe[p*(radix - 1) + j - 1] = std::cos(angle);
+                stage.twiddleIm[p*(radix - 1) + j - 1] = std::sin(angle);
+            }
+        }
+        if (radix > 5)
+        {
+            stage.rootRe.resize(radix);
+            stage.rootIm.resize(radix);
+            for (int k = 0; k < radix; k++)
+            {
+                double angle = -2*M_PI*static_cast<double>(k)/radix;
+                stage.rootRe[k] = std::cos(angle);
+                stage.rootIm[k] = std::sin(angle);
+            }
+        }
+        stages_.push_back(stage);
+
+        length /= radix;
+        stride *= radix;
+    }
+
+    if (realData_)
+    {
+        splitRe_.resize(nComplex_ + 1);
+        splitIm_.resize(nComplex_ + 1);
+        for (int k = 0; k <= nComplex_; k++)
+        {
+            double angle = -M_PI*static_cast<double>(k)/nComplex_;
+            splitRe_[k] = std::cos(angle);
+            splitIm_[k] = std::sin(angle);
+        }
+    }
+
+    for (int b = 0; b < 2; b++)
+    {
+        bufRe_[b].resize(nComplex_*c_w);
+        bufIm_[b].resize(nComplex_*c_w);
+    }
+}
+
+void BatchedFft1D::runStage(const Stage &stage, bool forward,
+                            const real *xr, const real *xi, real *yr, real *yi)
+{
+    const int  radix   = stage.radix;
+    const int  s       = stage.stride;
+    const int  m       = stage.length/radix;
+    const real sign    = forward ? -1 : 1;
+    /* The stored factors are for forward transforms, conjugate for backward */
+    const real conj    = -sign;
+    const int  inStep  = s*m*c_w;
+    const int  outStep = s*c_w;
+
+    for (int p = 0; p < m; p++)
+    {
+        const real *wr = stage.twiddleRe.data() + p*(radix - 1);
+        const real *wi = stage.twiddleIm.data() + p*(radix - 1);
+        for (int q = 0; q < s; q++)
+        {
+            const real *inR  = xr + (q + s*p)*c_w;
+            const real *inI  = xi + (q + s*p)*c_w;
+            real       *outR = yr + (q + s*radix*p)*c_w;
+            real       *outI = yi + (q + s*radix*p)*c_w;
+            switch (radix)
+            {
+                case 2:
+                    butterfly2(inR, inI, inStep, outR, outI, outStep, wr, wi, conj);
+                    break;
+                case 3:
+                    butterfly3(inR, inI, inStep, outR, outI, outStep, wr, wi, conj, sign);
+                    break;
+                case 4:
+                    butterfly4(inR, inI, inStep, outR, outI, outStep, wr, wi, conj, sign);
+                    break;
+                case 5:
+                    butterfly5(inR, inI, inStep, outR, outI, outStep, wr, wi, conj, sign);
+                    break;
+                default:
+                    butterflyGeneric(radix, inR, inI, inStep, outR, outI, outStep, wr, wi, conj,
+                                     stage.rootRe.data(), stage.rootIm.data());
+            }
+        }
+    }
+}
+
+int BatchedFft1D::runComplex(bool forward)
+{
+    int cur = 0;
+    for (const Stage &stage : stages_)
+    {
+        runStage(stage, forward,
+                 bufRe_[cur].data(), bufIm_[cur].data(),
+                 bufRe_[1 - cur].data(), bufIm_[1 - cur].data());
+        cur = 1 - cur;
+    }
+    return cur;
+}
+
+void BatchedFft1D::gatherPairs(const real *src, int nLanes, int dist)
+{
+    real *re = bufRe_[0].data();
+    real *im = bufIm_[0].data();
+
+#if GMX_SIMD_HAVE_REAL
+    if (nLanes == c_w && dist % 2 == 0 &&
+        reinterpret_cast<std::size_t>(src) % (2*sizeof(real)) == 0)
+    {
+        alignas(GMX_SIMD_ALIGNMENT) std::int32_t offset[c_w];
+        for (int l = 0; l < c_w; l++)
+        {
+            offset[l] = l*dist/2;
+        }
+        for (int e = 0; e < nComplex_; e++)
+        {
+            SimdReal v0, v1;
+            gatherLoadTranspose<2>(src + 2*e, offset, &v0, &v1);
+            store(re + e*c_w, v0);
+            store(im + e*c_w, v1);
+        }
+        return;
+    }
+#endif
+
+    /* Read each transform contiguously, unused lanes are zeroed */
+    for (int l = 0; l < c_w; l++)
+    {
+        if (l < nLanes)
+        {
+            const real *line = src + l*dist;
+            for (int e = 0; e < nComplex_; e++)
+            {
+                re[e*c_w + l] = line[2*e];
+                im[e*c_w + l] = line[2*e + 1];
+            }
+        }
+        else
+        {
+            for (int e = 0; e < nComplex_; e++)
+            {
+                re[e*c_w + l] = 0;
+                im[e*c_w + l] = 0;
+            }
+        }
+    }
+}
+
+void BatchedFft1D::scatterPairs(int buffer, real *dst, int nLanes, int dist) const
+{
+    const real *re = bufRe_[buffer].data();
+    const real *im = bufIm_[buffer].data();
+
+    for (int l = 0; l < nLanes; l++)
+    {
+        real *line = dst + l*dist;
+        for (int e = 0; e < nComplex_; e++)
+        {
+            line[2*e]     = re[e*c_w + l];
+            line[2*e + 1] = im[e*c_w + l];
+        }
+    }
+}
+
+void BatchedFft1D::transform(gmx_fft_direction dir, const real *in, real *out,
+                             int howmany, int dist)
+{
+    const int nc = nComplex_;
+
+    if (realData_ ?
+        (dir != GMX_FFT_REAL_TO_COMPLEX && dir != GMX_FFT_COMPLEX_TO_REAL) :
+        (dir != GMX_FFT_FORWARD && dir != GMX_FFT_BACKWARD))
+    {
+        gmx_fatal(FARGS, "FFT plan mismatch - bad plan or direction.");
+    }
+
+    for (int t0 = 0; t0 < howmany; t0 += c_w)
+    {
+        const int   nLanes = std::min(c_w, howmany - t0);
+        const real *src    = in + t0*dist;
+        real       *dst    = out + t0*dist;
+
+        if (!realData_)
+        {
+            gatherPairs(src, nLanes, dist);
+            scatterPairs(runComplex(dir == GMX_FFT_FORWARD), dst, nLanes, dist);
+        }
+        else if (dir == GMX_FFT_REAL_TO_COMPLEX)
+        {
+            /* Pack even and odd elements as the real and imaginary parts
+             * of a complex sequence of half the length.
+             */
+            gatherPairs(src, nLanes, dist);
+
+            int         cur = runComplex(true);
+            const real *zr  = bufRe_[cur].data();
+            const real *zi  = bufIm_[cur].data();
+            /* Split into the transforms of the even (E) and odd (O) elements
+             * and combine: X_k = E_k + exp(-i pi k/nc) O_k.
+             */
+            for (int k = 0; k <= nc; k++)
+            {
+                const int  kp = (k == nc) ? 0 : k;
+                const int  km = (k == 0) ? 0 : nc - k;
+                const real wr = splitRe_[k];
+                const real wi = splitIm_[k];
+                for (int l = 0; l < nLanes; l++)
+                {
+                    real ar = zr[kp*c_w + l], ai = zi[kp*c_w + l];
+                    real br = zr[km*c_w + l], bi = -zi[km*c_w + l];
+                    real er = 0.5*(ar + br), ei = 0.5*(ai + bi);
+                    /* (a - b)/(2i) */
+                    real orr = 0.5*(ai - bi), oi = -0.5*(ar - br);
+
+                    dst[l*dist + 2*k    ] = er + orr*wr - oi*wi;
+                    dst[l*dist + 2*k + 1] = ei + orr*wi + oi*wr;
+                }
+            }
+        }
+        else
+        {
+            /* Reverse the split above. The imaginary parts of the zero and
+             * Nyquist frequencies are ignored, as in the other backends.
+             */
+            real *re = bufRe_[0].data();
+            real *im = bufIm_[0].data();
+            for (int k = 0; k < nc; k++)
+            {
+                const int  km = nc - k;
+                const real wr = splitRe_[k];
+                const real wi = -splitIm_[k];
+                for (int l = 0; l < c_w; l++)
+                {
+                    if (l >= nLanes)
+                    {
+                        re[k*c_w + l] = 0;
+                        im[k*c_w + l] = 0;
+                        continue;
+                    }
+                    real ar = src[l*dist + 2*k];
+                    real ai = (k == 0) ? 0 : src[l*dist + 2*k + 1];
+                    real br = src[l*dist + 2*km];
+                    real bi = (km == nc) ? 0 : -src[l*dist + 2*km + 1];
+                    real er = ar + br, ei = ai + bi;
+                    real dr = ar - br, di = ai - bi;
+                    real orr = dr*wr - di*wi, oi = dr*wi + di*wr;
+
+                    re[k*c_w + l] = er - oi;
+                    im[k*c_w + l] = ei + orr;
+                }
+            }
+
+            scatterPairs(runComplex(false), dst, nLanes, dist);
+        }
+    }
+}
+
+} // namespace gmx
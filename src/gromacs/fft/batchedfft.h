@@ -0,0 +1,140 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares a batched 1D FFT used for many-transform plans when
+ * no external FFT library is available.
+ *
+ * \ingroup module_fft
+ */
+#ifndef GMX_FFT_BATCHEDFFT_H
+#define GMX_FFT_BATCHEDFFT_H
+
+#include <vector>
+
+#include "gromacs/fft/fft.h"
+#include "gromacs/utility/alignedallocator.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief
+ * Performs many 1D FFTs of the same length at once.
+ *
+ * Transforms are processed in batches of the SIMD width. Each batch is
+ * gathered into split real/imaginary arrays with the transform index
+ * running fastest, so every butterfly operates on independent transforms
+ * in the SIMD lanes.
+ * The complex transform is a self-sorting (Stockham) mixed-radix FFT
+ * with radix 4, 2, 3 and 5 butterflies and a generic butterfly for other
+ * prime factors. Real transforms of even length are computed through
+ * a complex transform of half the length.
+ *
+ * The data layout and normalization match gmx_fft_many_1d() and
+ * gmx_fft_many_1d_real(): transforms are unnormalized and consecutive
+ * transforms are dist reals apart in memory.
+ */
+class BatchedFft1D
+{
+    public:
+        /*! \brief Sets up transforms of length \p n.
+         *
+         * With \p realData the transforms are real-to-complex and back,
+         * which requires \p n to be even, see supportsRealLength().
+         */
+        BatchedFft1D(int n, bool realData);
+
+        //! Returns whether a real transform of length \p n can be batched.
+        static bool supportsRealLength(int n) { return n % 2 == 0; }
+
+        /*! \brief Performs \p howmany transforms in direction \p dir.
+         *
+         * \p in and \p out may be identical.
+         */
+        void transform(gmx_fft_direction dir, const real *in, real *out,
+                       int howmany, int dist);
+
+    private:
+        //! One radix pass of the Stockham algorithm.
+        struct Stage
+        {
+            //! The radix of this pass
+            int               radix;
+            //! The number of interleaved sub-transforms at this pass
+            int               stride;
+            //! The length of the sub-transforms at this pass
+            int               length;
+            //! Forward twiddle factors, (radix - 1) per butterfly
+            std::vector<real> twiddleRe;
+            //! Imaginary parts of the twiddle factors
+            std::vector<real> twiddleIm;
+            //! Forward roots of unity of order radix, only for the generic butterfly
+            std::vector<real> rootRe;
+            //! Imaginary parts of the roots of unity
+            std::vector<real> rootIm;
+        };
+
+        //! Gathers interleaved complex pairs of \p nLanes transforms into bufRe_[0]/bufIm_[0]
+        void gatherPairs(const real *src, int nLanes, int dist);
+        //! Scatters the complex data in \p buffer back to interleaved pairs
+        void scatterPairs(int buffer, real *dst, int nLanes, int dist) const;
+        //! Runs the complex transform on bufRe_[0]/bufIm_[0], returns the buffer index holding the result
+        int runComplex(bool forward);
+        //! Performs one radix pass from (xr,xi) to (yr,yi)
+        void runStage(const Stage &stage, bool forward,
+                      const real *xr, const real *xi, real *yr, real *yi);
+
+        //! The length of the transforms seen by the user
+        int                n_;
+        //! Whether the transforms are real-to-complex
+        bool               realData_;
+        //! The length of the complex transform performed internally
+        int                nComplex_;
+        //! The radix passes
+        std::vector<Stage> stages_;
+        //! Twiddle factors exp(-i pi k/nComplex_) for splitting real transforms
+        std::vector<real>  splitRe_;
+        //! Imaginary parts of splitRe_
+        std::vector<real>  splitIm_;
+        //! Ping-pong buffers, real parts
+        std::vector<real, AlignedAllocator<real> > bufRe_[2];
+        //! Ping-pong buffers, imaginary parts
+        std::vector<real, AlignedAllocator<real> > bufIm_[2];
+};
+
+} // namespace gmx
+
+#endif
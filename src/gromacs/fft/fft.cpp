@@ -44,7 +44,9 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "gromacs/fft/batchedfft.h"
 #include "gromacs/math/gmxcomplex.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/real.h"
 
@@ -56,9 +58,11 @@
 #if !GMX_FFT_FFTW3 && !GMX_FFT_ARMPL_FFTW3
 
 struct gmx_many_fft {
-    int       howmany;
-    int       dist;
-    gmx_fft_t fft;
+    int                 howmany;
+    int                 dist;
+    gmx_fft_t           fft;
+    /* Transforms all lines at once, replacing fft when not nullptr */
+    gmx::BatchedFft1D  *batched;
 };
 
 typedef struct gmx_many_fft* gmx_many_fft_t;
@@ -82,9 +86,17 @@ gmx_fft_init_many_1d(gmx_fft_t *        pfft,
         return ENOMEM;
     }
 
-    gmx_fft_init_1d(&fft->fft, nx, flags);
     fft->howmany = howmany;
     fft->dist    = 2*nx;
+#if GMX_FFT_FFTPACK
+    /* FFTPACK only does one transform at a time, batch them ourselves */
+    fft->fft     = nullptr;
+    fft->batched = new gmx::BatchedFft1D(nx, false);
+    GMX_UNUSED_VALUE(flags);
+#else
+    gmx_fft_init_1d(&fft->fft, nx, flags);
+    fft->batched = nullptr;
+#endif
 
     *pfft = (gmx_fft_t)fft;
     return 0;
@@ -109,9 +121,20 @@ gmx_fft_init_many_1d_real(gmx_fft_t *        pfft,
         return ENOMEM;
     }
 
-    gmx_fft_init_1d_real(&fft->fft, nx, flags);
     fft->howmany = howmany;
     fft->dist    = 2*(nx/2+1);
+#if GMX_FFT_FFTPACK
+    if (gmx::BatchedFft1D::supportsRealLength(nx))
+    {
+        fft->fft     = nullptr;
+        fft->batched = new gmx::BatchedFft1D(nx, true);
+    }
+    else
+#endif
+    {
+        gmx_fft_init_1d_real(&fft->fft, nx, flags);
+        fft->batched = nullptr;
+    }
 
     *pfft = (gmx_fft_t)fft;
     return 0;
@@ -125,6 +148,12 @@ gmx_fft_many_1d     (gmx_fft_t                  fft,
 {
     gmx_many_fft_t mfft = (gmx_many_fft_t)fft;
     int            i, ret;
+    if (mfft->batched != nullptr)
+    {
+        mfft->batched->transform(dir, static_cast<real *>(in_data), static_cast<real *>(out_data),
+                                 mfft->howmany, mfft->dist);
+        return 0;
+    }
     for (i = 0; i < mfft->howmany; i++)
     {
         ret = gmx_fft_1d(mfft->fft, dir, in_data, out_data);
@@ -146,6 +175,12 @@ gmx_fft_many_1d_real     (gmx_fft_t                  fft,
 {
     gmx_many_fft_t mfft = (gmx_many_fft_t)fft;
     int            i, ret;
+    if (mfft->batched != nullptr)
+    {
+        mfft->batched->transform(dir, static_cast<real *>(in_data), static_cast<real *>(out_data),
+                                 mfft->howmany, mfft->dist);
+        return 0;
+    }
     for (i = 0; i < mfft->howmany; i++)
     {
         ret = gmx_fft_1d_real(mfft->fft, dir, in_data, out_data);
@@ -170,6 +205,7 @@ gmx_many_fft_destroy(gmx_fft_t    fft)
         {
             gmx_fft_destroy(mfft->fft);
         }
+        delete mfft->batched;
         free(mfft);
     }
 }
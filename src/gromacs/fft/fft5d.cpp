@@ -41,6 +41,7 @@
 #include <cassert>
 #include <cfloat>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -156,6 +157,9 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     t_complex *lin = nullptr, *lout = nullptr, *lout2 = nullptr, *lout3 = nullptr;
     fft5d_plan plan;
     int        s;
+    /* The overlapped transpose sends from lout2 while joining into lin,
+     * so it needs separate transpose buffers also with a single thread */
+    const bool bOverlapTranspose = ((flags & FFT5D_OVERLAP_TRANSPOSE) || getenv("GMX_FFT5D_OVERLAP") != nullptr);
 
     /* comm, prank and P are in the order of the decomposition (plan->cart is in the order of transposes) */
 #if GMX_MPI
@@ -402,7 +406,7 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
             snew_aligned(lin, lsize, 32);
         }
         snew_aligned(lout, lsize, 32);
-        if (nthreads > 1)
+        if (nthreads > 1 || bOverlapTranspose)
         {
             /* We need extra transpose buffers to avoid OpenMP barriers */
             snew_aligned(lout2, lsize, 32);
@@ -419,7 +423,7 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     {
         lin  = *rlin;
         lout = *rlout;
-        if (nthreads > 1)
+        if (nthreads > 1 || bOverlapTranspose)
         {
             lout2 = *rlout2;
             lout3 = *rlout3;
@@ -659,6 +663,20 @@ fft5d_plan fft5d_plan_3d(int NG, int MG, int KG, MPI_Comm comm[2], int flags, t_
     plan->flags         = flags;
     plan->nthreads      = nthreads;
     plan->pinningPolicy = realGridAllocationPinningPolicy;
+
+    /* Buffers passed in by the caller could still alias lin */
+    plan->bOverlapTranspose = (bOverlapTranspose && lout2 != nullptr && lout2 != lin);
+    if (plan->bOverlapTranspose)
+    {
+        snew(plan->req, 2*std::max(nP[0], nP[1]));
+    }
+    /* In mixed precision the transposes are already single precision */
+    plan->bReducedPrecisionComm = (GMX_DOUBLE && (flags & FFT5D_REDUCED_PRECISION_COMM));
+    if (plan->bReducedPrecisionComm)
+    {
+        snew_aligned(plan->commSendBuf, 2*lsize, 32);
+        snew_aligned(plan->commRecvBuf, 2*lsize, 32);
+    }
     *rlin               = lin;
     *rlout              = lout;
     *rlout2             = lout2;
@@ -836,6 +854,138 @@ static void joinAxesTrans12(t_complex* lout, const t_complex* lin, int maxN, int
 }
 
 
+#if GMX_MPI
+/*! \brief Converts the part of the n values in src assigned to this thread */
+template <typename DestType, typename SrcType>
+static void convertThreadPart(DestType *dest, const SrcType *src, int n, int thread, int nthreads)
+{
+    const int start = static_cast<int>((static_cast<std::int64_t>(n)*thread)/nthreads);
+    const int end   = static_cast<int>((static_cast<std::int64_t>(n)*(thread + 1))/nthreads);
+
+    for (int i = start; i < end; i++)
+    {
+        dest[i] = static_cast<DestType>(src[i]);
+    }
+}
+#endif
+
+#if GMX_MPI && !defined NOGMX
+/*! \brief Transposes with point-to-point messages and joins each block as soon as it arrives
+ *
+ * Replaces the MPI_Alltoall of transpose stage s plus the join that follows it.
+ * Has to be called by all threads after the split into lout2 has completed.
+ * Thread 0 posts all messages and waits for the blocks in order of increasing
+ * distance from this rank, so the join of one block overlaps with the
+ * communication of the next ones. The local block is joined directly from lout2.
+ *
+ * Only the join is overlapped, not the 1D FFT of the next dimension.
+ * Every line along that dimension contains data from all P blocks, so no
+ * line can be transformed before the last block has arrived. Overlapping
+ * with the FFT would need the transpose to be pipelined over chunks of lines.
+ */
+static void transposeAndJoinOverlapped(fft5d_plan plan, int s, int thread, fft5d_time times)
+{
+    t_complex  *lin   = plan->lin;
+    t_complex  *lout2 = plan->lout2;
+    t_complex  *lout3 = plan->lout3;
+    const int  *N     = plan->N, *M = plan->M, *K = plan->K, *pN = plan->pN, *pM = plan->pM, *pK = plan->pK, *C = plan->C;
+    const int   P     = plan->P[s];
+    /* plan->coor is in the order of the decomposition, cart in the order of the transposes */
+    const int   rank  = plan->coor[(plan->flags&FFT5D_ORDER_YZ) ? s : 1 - s];
+    const bool  bTrans13 = ((s == 0 && !(plan->flags&FFT5D_ORDER_YZ)) || (s == 1 && (plan->flags&FFT5D_ORDER_YZ)));
+    const int   blockSize = bTrans13 ? N[s]*pM[s]*K[s] : N[s]*M[s]*pK[s];
+    const int   count     = blockSize*sizeof(t_complex)/sizeof(real);
+    MPI_Request *recvReq  = plan->req;
+    MPI_Request *sendReq  = plan->req + P;
+    int          tstart, tend;
+
+    if (plan->bReducedPrecisionComm)
+    {
+        convertThreadPart(plan->commSendBuf, reinterpret_cast<const real *>(lout2), P*count, thread, plan->nthreads);
+#pragma omp barrier
+    }
+
+    if (thread == 0)
+    {
+        wallcycle_start(times, ewcPME_FFTCOMM);
+        for (int d = 1; d < P; d++)
+        {
+            int src = (rank - d + P) % P;
+            if (plan->bReducedPrecisionComm)
+            {
+                MPI_Irecv(plan->commRecvBuf + src*count, count, MPI_FLOAT, src, s, plan->cart[s], &recvReq[d - 1]);
+            }
+            else
+            {
+                MPI_Irecv(reinterpret_cast<real *>(lout3 + src*blockSize), count, GMX_MPI_REAL, src, s, plan->cart[s], &recvReq[d - 1]);
+            }
+        }
+        for (int d = 1; d < P; d++)
+        {
+            int dest = (rank + d) % P;
+            if (plan->bReducedPrecisionComm)
+            {
+                MPI_Isend(plan->commSendBuf + dest*count, count, MPI_FLOAT, dest, s, plan->cart[s], &sendReq[d - 1]);
+            }
+            else
+            {
+                MPI_Isend(reinterpret_cast<real *>(lout2 + dest*blockSize), count, GMX_MPI_REAL, dest, s, plan->cart[s], &sendReq[d - 1]);
+            }
+        }
+        wallcycle_stop(times, ewcPME_FFTCOMM);
+    }
+
+    for (int d = 0; d < P; d++)
+    {
+        const int        src    = (rank - d + P) % P;
+        const t_complex *joinin = (d == 0 ? lout2 : lout3) + src*blockSize;
+
+        if (d > 0)
+        {
+            if (thread == 0)
+            {
+                wallcycle_start(times, ewcPME_FFTCOMM);
+                MPI_Wait(&recvReq[d - 1], MPI_STATUS_IGNORE);
+                wallcycle_stop(times, ewcPME_FFTCOMM);
+            }
+#pragma omp barrier
+            if (plan->bReducedPrecisionComm)
+            {
+                convertThreadPart(reinterpret_cast<real *>(lout3 + src*blockSize), plan->commRecvBuf + src*count, count, thread, plan->nthreads);
+#pragma omp barrier
+            }
+        }
+        /* Join only block src, which is the single block at joinin */
+        if (bTrans13)
+        {
+            if (pM[s] > 0)
+            {
+                tstart = ( thread   *pM[s]*pN[s]/plan->nthreads);
+                tend   = ((thread+1)*pM[s]*pN[s]/plan->nthreads);
+                joinAxesTrans13(lin, joinin, N[s], pM[s], K[s], pM[s], 1, C[s+1], plan->iNin[s+1] + src, plan->oNin[s+1] + src, tstart%pM[s], tstart/pM[s], tend%pM[s], tend/pM[s]);
+            }
+        }
+        else
+        {
+            if (pN[s] > 0)
+            {
+                tstart = ( thread   *pK[s]*pN[s]/plan->nthreads);
+                tend   = ((thread+1)*pK[s]*pN[s]/plan->nthreads);
+                joinAxesTrans12(lin, joinin, N[s], M[s], pK[s], pN[s], 1, C[s+1], plan->iNin[s+1] + src, plan->oNin[s+1] + src, tstart%pN[s], tstart/pN[s], tend%pN[s], tend/pN[s]);
+            }
+        }
+    }
+
+    if (thread == 0)
+    {
+        /* lout2 is overwritten by the next split */
+        wallcycle_start(times, ewcPME_FFTCOMM);
+        MPI_Waitall(P - 1, sendReq, MPI_STATUSES_IGNORE);
+        wallcycle_stop(times, ewcPME_FFTCOMM);
+    }
+}
+#endif
+
 static void rotate_offsets(int x[])
 {
     int t = x[0];
@@ -1069,6 +1219,11 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
         }
         /* ---------- END FFT ------------ */
 
+#if GMX_MPI
+        /* The number of reals sent to each rank in the transpose */
+        const int commCount = (((s == 0 && !(plan->flags&FFT5D_ORDER_YZ)) || (s == 1 && (plan->flags&FFT5D_ORDER_YZ))) ? N[s]*pM[s]*K[s] : N[s]*M[s]*pK[s])*sizeof(t_complex)/sizeof(real);
+#endif
+
         /* ---------- START SPLIT + TRANSPOSE------------ (if parallel in in this dimension)*/
         if (bParallelDim)
         {
@@ -1098,6 +1253,25 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
 
             /* ---------- END SPLIT , START TRANSPOSE------------ */
 
+#if GMX_MPI && !defined NOGMX
+            if (plan->bOverlapTranspose)
+            {
+                transposeAndJoinOverlapped(plan, s, thread, times);
+#pragma omp barrier
+                if ((plan->flags&FFT5D_DEBUG) && thread == 0)
+                {
+                    print_localdata(lin, "%d %d: tranposed %d\n", s+1, plan);
+                }
+                continue;
+            }
+#endif
+#if GMX_MPI
+            if (plan->bReducedPrecisionComm)
+            {
+                convertThreadPart(plan->commSendBuf, reinterpret_cast<const real *>(lout2), P[s]*commCount, thread, plan->nthreads);
+#pragma omp barrier
+            }
+#endif
             if (thread == 0)
             {
 #ifdef NOGMX
@@ -1112,13 +1286,13 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
                 FFTW(execute)(mpip[s]);
 #else
 #if GMX_MPI
-                if ((s == 0 && !(plan->flags&FFT5D_ORDER_YZ)) || (s == 1 && (plan->flags&FFT5D_ORDER_YZ)))
+                if (plan->bReducedPrecisionComm)
                 {
-                    MPI_Alltoall(reinterpret_cast<real *>(lout2), N[s]*pM[s]*K[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, reinterpret_cast<real *>(lout3), N[s]*pM[s]*K[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, cart[s]);
+                    MPI_Alltoall(plan->commSendBuf, commCount, MPI_FLOAT, plan->commRecvBuf, commCount, MPI_FLOAT, cart[s]);
                 }
                 else
                 {
-                    MPI_Alltoall(reinterpret_cast<real *>(lout2), N[s]*M[s]*pK[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, reinterpret_cast<real *>(lout3), N[s]*M[s]*pK[s]*sizeof(t_complex)/sizeof(real), GMX_MPI_REAL, cart[s]);
+                    MPI_Alltoall(reinterpret_cast<real *>(lout2), commCount, GMX_MPI_REAL, reinterpret_cast<real *>(lout3), commCount, GMX_MPI_REAL, cart[s]);
                 }
 #else
                 gmx_incons("fft5d MPI call without MPI configuration");
@@ -1135,6 +1309,13 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
             } /*master*/
         }     /* bPrallelDim */
 #pragma omp barrier  /*both needed for parallel and non-parallel dimension (either have to wait on data from AlltoAll or from last FFT*/
+#if GMX_MPI
+        if (bParallelDim && plan->bReducedPrecisionComm)
+        {
+            convertThreadPart(reinterpret_cast<real *>(lout3), plan->commRecvBuf, P[s]*commCount, thread, plan->nthreads);
+#pragma omp barrier
+        }
+#endif
 
         /* ---------- END SPLIT + TRANSPOSE------------ */
 
@@ -1269,6 +1450,9 @@ void fft5d_destroy(fft5d_plan plan)
             plan->oNout[s] = nullptr;
         }
     }
+    sfree(plan->req);
+    sfree_aligned(plan->commSendBuf);
+    sfree_aligned(plan->commRecvBuf);
 #if GMX_FFT_FFTW3
     FFTW_LOCK;
 #ifdef FFT5D_MPI_TRANSPOS
@@ -1294,7 +1478,7 @@ void fft5d_destroy(fft5d_plan plan)
         }
         sfree_aligned(plan->lin);
         sfree_aligned(plan->lout);
-        if (plan->nthreads > 1)
+        if (plan->lout2 != plan->lin)
         {
             sfree_aligned(plan->lout2);
             sfree_aligned(plan->lout3);
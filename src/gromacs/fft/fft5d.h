@@ -86,7 +86,13 @@ typedef enum fft5d_flags_t {
     FFT5D_DEBUG       = 8,
     FFT5D_NOMEASURE   = 16,
     FFT5D_INPLACE     = 32,
-    FFT5D_NOMALLOC    = 64
+    FFT5D_NOMALLOC    = 64,
+    /* Send the transposes in single precision, only has an effect with GMX_DOUBLE */
+    FFT5D_REDUCED_PRECISION_COMM = 128,
+    /* Transpose with point-to-point messages overlapped with the join,
+       but not with the FFT of the next dimension,
+       also set by the environment variable GMX_FFT5D_OVERLAP */
+    FFT5D_OVERLAP_TRANSPOSE      = 256
 } fft5d_flags;
 
 struct fft5d_plan_t {
@@ -118,6 +124,14 @@ struct fft5d_plan_t {
     int                coor[2];
     int                nthreads;
     gmx::PinningPolicy pinningPolicy;
+    /* Use point-to-point messages for the transposes and join the blocks
+       as they arrive, instead of a blocking MPI_Alltoall */
+    bool               bOverlapTranspose;
+    MPI_Request       *req; /* 2*max(P) requests for the overlapped transposes */
+    /* With FFT5D_REDUCED_PRECISION_COMM in double precision the transposes
+       are converted to and from these single precision buffers */
+    bool               bReducedPrecisionComm;
+    float             *commSendBuf, *commRecvBuf;
 };
 
 typedef struct fft5d_plan_t *fft5d_plan;
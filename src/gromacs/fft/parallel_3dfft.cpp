@@ -60,7 +60,8 @@ gmx_parallel_3dfft_init   (gmx_parallel_3dfft_t           *    pfft_setup,
                            MPI_Comm                            comm[2],
                            gmx_bool                            bReproducible,
                            int                                 nthreads,
-                           gmx::PinningPolicy                  realGridAllocation)
+                           gmx::PinningPolicy                  realGridAllocation,
+                           gmx_bool                            bReducedPrecisionComm)
 {
     int        rN      = ndata[2], M = ndata[1], K = ndata[0];
     int        flags   = FFT5D_REALCOMPLEX | FFT5D_ORDER_YZ; /* FFT5D_DEBUG */
@@ -73,6 +74,10 @@ gmx_parallel_3dfft_init   (gmx_parallel_3dfft_t           *    pfft_setup,
     {
         flags |= FFT5D_NOMEASURE;
     }
+    if (bReducedPrecisionComm)
+    {
+        flags |= FFT5D_REDUCED_PRECISION_COMM;
+    }
 
     if (!(flags&FFT5D_ORDER_YZ))
     {
@@ -73,6 +73,8 @@ typedef struct gmx_parallel_3dfft *
  *  \param nthreads       Run in parallel using n threads
  *  \param realGridAllocation  Whether to make real grid use allocation pinned for GPU transfers.
  *                             Only used in PME mixed CPU+GPU mode.
+ *  \param bReducedPrecisionComm  Communicate the transposes in single precision.
+ *                             Only has an effect in double precision builds.
  *
  *  \return 0 or a standard error code.
  */
@@ -84,7 +86,8 @@ int
                                MPI_Comm                  comm[2],
                                gmx_bool                  bReproducible,
                                int                       nthreads,
-                               gmx::PinningPolicy realGridAllocation = gmx::PinningPolicy::CannotBePinned);
+                               gmx::PinningPolicy realGridAllocation = gmx::PinningPolicy::CannotBePinned,
+                               gmx_bool                  bReducedPrecisionComm = FALSE);
 
 
 
@@ -155,6 +155,29 @@ class FFTTest1D : public FFTTest, public ::testing::WithParamInterface<int>
 
 };
 
+/*! \brief Compares many-FFT results with single transforms
+ *
+ * As this does not use reference data, it does not derive from BaseFFTTest.
+ */
+class ManyFFTTest1D : public ::testing::Test, public ::testing::WithParamInterface<int>
+{
+    public:
+        ManyFFTTest1D() : fft_(nullptr), flags_(GMX_FFT_FLAG_CONSERVATIVE)
+        {
+        }
+        ~ManyFFTTest1D() override
+        {
+            if (fft_)
+            {
+                gmx_many_fft_destroy(fft_);
+            }
+            gmx_fft_cleanup();
+        }
+        gmx_fft_t         fft_;
+        std::vector<real> in_, out_;
+        int               flags_;
+};
+
 class FFFTest3D : public BaseFFTTest
 {
     public:
@@ -254,6 +277,87 @@ TEST_F(ManyFFTTest, Real1DLength48Multi5Test)
     checker_.checkSequenceArray(rx*N, out, "backward");
 }
 
+/* Checks many transforms against one-by-one transforms, using more
+ * transforms than fit in one batch of the batched implementation.
+ */
+TEST_P(ManyFFTTest1D, ComplexMatchesSingleTransforms)
+{
+    const int nx    = GetParam();
+    const int N     = 11;
+    const int ndata = sizeof(inputdata)/sizeof(inputdata[0]);
+
+    in_  = std::vector<real>(nx*2*N);
+    for (int i = 0; i < nx*2*N; i++)
+    {
+        in_[i] = inputdata[i % ndata];
+    }
+    out_ = std::vector<real>(nx*2*N);
+    std::vector<real> single(nx*2);
+    gmx_fft_t         fft1d;
+    const auto        tolerance = gmx::test::relativeToleranceAsPrecisionDependentUlp(10.0*nx, 64, 512);
+
+    gmx_fft_init_many_1d(&fft_, nx, N, flags_);
+    gmx_fft_init_1d(&fft1d, nx, flags_);
+
+    for (gmx_fft_direction dir : { GMX_FFT_FORWARD, GMX_FFT_BACKWARD })
+    {
+        gmx_fft_many_1d(fft_, dir, in_.data(), out_.data());
+        for (int t = 0; t < N; t++)
+        {
+            gmx_fft_1d(fft1d, dir, in_.data() + t*nx*2, single.data());
+            for (int i = 0; i < nx*2; i++)
+            {
+                EXPECT_REAL_EQ_TOL(single[i], out_[t*nx*2 + i], tolerance);
+            }
+        }
+    }
+    gmx_fft_destroy(fft1d);
+}
+
+TEST_P(ManyFFTTest1D, RealMatchesSingleTransforms)
+{
+    const int rx    = GetParam();
+    const int cx    = (rx/2+1);
+    const int N     = 11;
+    const int ndata = sizeof(inputdata)/sizeof(inputdata[0]);
+
+    in_  = std::vector<real>(cx*2*N);
+    for (int i = 0; i < cx*2*N; i++)
+    {
+        in_[i] = inputdata[i % ndata];
+    }
+    out_ = std::vector<real>(cx*2*N);
+    std::vector<real> single(cx*2);
+    gmx_fft_t         fft1d;
+    const auto        tolerance = gmx::test::relativeToleranceAsPrecisionDependentUlp(10.0*rx, 64, 512);
+
+    gmx_fft_init_many_1d_real(&fft_, rx, N, flags_);
+    gmx_fft_init_1d_real(&fft1d, rx, flags_);
+
+    gmx_fft_many_1d_real(fft_, GMX_FFT_REAL_TO_COMPLEX, in_.data(), out_.data());
+    for (int t = 0; t < N; t++)
+    {
+        gmx_fft_1d_real(fft1d, GMX_FFT_REAL_TO_COMPLEX, in_.data() + t*cx*2, single.data());
+        for (int i = 0; i < cx*2; i++)
+        {
+            EXPECT_REAL_EQ_TOL(single[i], out_[t*cx*2 + i], tolerance);
+        }
+    }
+    gmx_fft_many_1d_real(fft_, GMX_FFT_COMPLEX_TO_REAL, in_.data(), out_.data());
+    for (int t = 0; t < N; t++)
+    {
+        gmx_fft_1d_real(fft1d, GMX_FFT_COMPLEX_TO_REAL, in_.data() + t*cx*2, single.data());
+        for (int i = 0; i < rx; i++)
+        {
+            EXPECT_REAL_EQ_TOL(single[i], out_[t*cx*2 + i], tolerance);
+        }
+    }
+    gmx_fft_destroy(fft1d);
+}
+
+INSTANTIATE_TEST_CASE_P(7_9_20_30_49_60,
+                        ManyFFTTest1D, ::testing::Values(7, 9, 20, 30, 49, 60));
+
 TEST_F(FFTTest, Real2DLength18_15Test)
 {
     const int rx = 18;
@@ -0,0 +1,166 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the parallel transposes of fft5d.
+ *
+ * \ingroup module_fft
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fft/fft5d.h"
+
+#include "config.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/gmxomp.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+/*! \brief Returns the forward transform of a 3D grid on a 2x2 rank grid
+ *
+ * Each rank fills its local part of the input with values that depend on
+ * the rank, so the transposes move different data between all ranks.
+ */
+std::vector<t_complex> transformOnFourRanks(int flags, int nthreads)
+{
+    const int  gridSize[3] = { 9, 10, 11 };
+    t_complex *lin         = nullptr, *lout = nullptr, *lout2 = nullptr, *lout3 = nullptr;
+    int        rank;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    fft5d_plan plan = fft5d_plan_3d_cart(gridSize[0], gridSize[1], gridSize[2], MPI_COMM_WORLD, 2,
+                                         flags | FFT5D_NOMEASURE, &lin, &lout, &lout2, &lout3, nthreads);
+
+    const int  inputSize = plan->C[0]*plan->pM[0]*plan->pK[0];
+    for (int i = 0; i < inputSize; i++)
+    {
+        lin[i].re = (i*7 + rank*13) % 17 - 8;
+        lin[i].im = (i*5 + rank*3) % 11 - 5;
+    }
+#pragma omp parallel num_threads(nthreads)
+    {
+        fft5d_execute(plan, gmx_omp_get_thread_num(), nullptr);
+    }
+
+    std::vector<t_complex> output(lout, lout + plan->C[2]*plan->pM[2]*plan->pK[2]);
+    fft5d_destroy(plan);
+
+    return output;
+}
+
+//! Parameters for the tests: flags selecting the order of the transposes and the number of threads
+typedef std::tuple<int, int> Fft5dMpiTestParams;
+
+class Fft5dMpiTest : public ::testing::TestWithParam<Fft5dMpiTestParams>
+{
+};
+
+TEST_P(Fft5dMpiTest, OverlappedTransposeMatchesAllToAll)
+{
+    GMX_MPI_TEST(4);
+    const int              orderFlags = std::get<0>(GetParam());
+    const int              nthreads   = std::get<1>(GetParam());
+    std::vector<t_complex> reference  = transformOnFourRanks(orderFlags, nthreads);
+    std::vector<t_complex> overlapped = transformOnFourRanks(orderFlags | FFT5D_OVERLAP_TRANSPOSE, nthreads);
+
+    ASSERT_EQ(reference.size(), overlapped.size());
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        EXPECT_REAL_EQ(reference[i].re, overlapped[i].re) << "element " << i;
+        EXPECT_REAL_EQ(reference[i].im, overlapped[i].im) << "element " << i;
+    }
+}
+
+// In mixed precision the messages are already in single precision,
+// so the reduced-precision transposes are the normal ones
+#if GMX_DOUBLE
+TEST_P(Fft5dMpiTest, ReducedPrecisionCommIsAccurate)
+{
+    GMX_MPI_TEST(4);
+    const int orderFlags = std::get<0>(GetParam());
+    const int nthreads   = std::get<1>(GetParam());
+
+    for (int overlapFlags : { 0, static_cast<int>(FFT5D_OVERLAP_TRANSPOSE) })
+    {
+        std::vector<t_complex> reference = transformOnFourRanks(orderFlags | overlapFlags, nthreads);
+        std::vector<t_complex> reduced   = transformOnFourRanks(orderFlags | overlapFlags | FFT5D_REDUCED_PRECISION_COMM, nthreads);
+
+        ASSERT_EQ(reference.size(), reduced.size());
+        real maxAbs = 0;
+        for (const t_complex &value : reference)
+        {
+            maxAbs = std::max(maxAbs, std::max(std::abs(value.re), std::abs(value.im)));
+        }
+        /* Only the messages are rounded to single precision, so the error
+         * is of the order of the float epsilon times the largest value.
+         */
+        const gmx::test::FloatingPointTolerance tolerance = gmx::test::relativeToleranceAsFloatingPoint(maxAbs, 1e-5);
+        bool                                    rounded   = false;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            EXPECT_REAL_EQ_TOL(reference[i].re, reduced[i].re, tolerance) << "element " << i;
+            EXPECT_REAL_EQ_TOL(reference[i].im, reduced[i].im, tolerance) << "element " << i;
+            rounded = rounded || reference[i].re != reduced[i].re || reference[i].im != reduced[i].im;
+        }
+        // Check that the messages were actually sent in single precision
+        EXPECT_TRUE(rounded);
+    }
+}
+#endif
+
+// With a single thread the plan normally reuses the input and output
+// buffers for the transposes, which the overlapped transposes can not do
+#if GMX_OPENMP
+INSTANTIATE_TEST_CASE_P(WithThreads, Fft5dMpiTest,
+                        ::testing::Combine(::testing::Values(0, FFT5D_ORDER_YZ), ::testing::Values(1, 2)));
+#else
+INSTANTIATE_TEST_CASE_P(WithThreads, Fft5dMpiTest,
+                        ::testing::Combine(::testing::Values(0, FFT5D_ORDER_YZ), ::testing::Values(1)));
+#endif
+
+} // namespace
@@ -45,7 +45,7 @@
 
 enum
 {
-    eftASC, eftXDR, eftTNG, eftGEN, eftNR
+    eftASC, eftXDR, eftTNG, eftBIN, eftGEN, eftNR
 };
 
 /* To support multiple file types with one general (eg TRX) we have
@@ -155,6 +155,7 @@ static const t_deffile deffile[efNR] =
     { eftXDR, ".mtx", "hessian", "-m", "Hessian matrix"},
     { eftASC, ".edi", "sam",    nullptr, "ED sampling input"},
     { eftASC, ".cub", "pot",  nullptr, "Gaussian cube file" },
+    { eftBIN, ".mrc", "density", nullptr, "MRC/CCP4 density map" },
     { eftASC, ".xpm", "root", nullptr, "X PixMap compatible matrix file" },
     { eftASC, "", "rundir", nullptr, "Run directory" }
 };
@@ -56,6 +56,7 @@ enum GromacsFileType {
     efMTX,
     efEDI,
     efCUB,
+    efMRC,
     efXPM,
     efRND,
     efNR
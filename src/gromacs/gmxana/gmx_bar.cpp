@@ -41,12 +41,14 @@
 
 #include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/fileio/enxio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/linearalgebra/matrix.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/utilities.h"
 #include "gromacs/mdlib/energyoutput.h"
@@ -55,8 +57,10 @@
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/dir_separator.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/snprintf.h"
 
@@ -220,6 +224,17 @@ typedef struct {
     double         dg_stddev_err;    /* error in dg_stddev */
 } barres_t;
 
+/* The input for an MBAR estimate over all lambda states. */
+typedef struct mbar_data_t
+{
+    int              nstate; /* the number of lambda states */
+    lambda_data_t  **l;      /* the lambda states, in order */
+    sample_coll_t ***sc;     /* sc[i][k]: the samples of state i with the energy
+                                differences to state k. NULL for k == i when the
+                                (zero) difference to the own state was not stored */
+    double           temp;   /* the temperature */
+} mbar_data_t;
+
 
 /* Initialize a lambda_components structure */
 static void lambda_components_init(lambda_components_t *lc)
@@ -2201,6 +2216,467 @@ static double bar_err(int nbmin, int nbmax, const double *partsum)
 }
 
 
+/* Set up the MBAR input from the samples of all states, checking that
+   the energy differences of all samples to all states are available. */
+static void mbar_data_init(mbar_data_t *md, sim_data_t *sd)
+{
+    lambda_data_t *l;
+    int            i, k, j;
+
+    md->nstate = 0;
+    for (l = sd->lb->next; l != sd->lb; l = l->next)
+    {
+        md->nstate++;
+    }
+    snew(md->l, md->nstate);
+    snew(md->sc, md->nstate);
+    i = 0;
+    for (l = sd->lb->next; l != sd->lb; l = l->next)
+    {
+        md->l[i++] = l;
+    }
+    md->temp = md->l[0]->temp;
+
+    for (i = 0; i < md->nstate; i++)
+    {
+        sample_coll_t *ref = nullptr;
+
+        if (md->l[i]->temp != md->temp)
+        {
+            gmx_fatal(FARGS, "MBAR requires all states to be at the same temperature");
+        }
+        snew(md->sc[i], md->nstate);
+        for (k = 0; k < md->nstate; k++)
+        {
+            md->sc[i][k] = lambda_data_find_sample_coll(md->l[i], md->l[k]->lambda);
+            if (md->sc[i][k] == nullptr)
+            {
+                if (k == i)
+                {
+                    continue;
+                }
+                char descX[STRLEN], descY[STRLEN];
+                snprint_lambda_vec(descX, STRLEN, "X", md->l[k]->lambda);
+                snprint_lambda_vec(descY, STRLEN, "Y", md->l[i]->lambda);
+                gmx_fatal(FARGS, "MBAR needs the energy differences of the samples of every state to all other states,\nbut there is no set for foreign lambda (state X below)\nin the files for main lambda (state Y below).\nWrite the energy differences to all states with the mdp option calc-lambda-neighbors = -1.\n\n%s\n%s\n", descX, descY);
+            }
+            if (ref == nullptr)
+            {
+                ref = md->sc[i][k];
+            }
+            /* All sets of a state should contain the same samples */
+            sample_coll_t *sc = md->sc[i][k];
+            if (sc->nsamples != ref->nsamples || sc->ntot != ref->ntot)
+            {
+                gmx_fatal(FARGS, "The number of energy difference samples to different foreign lambdas is not the same for native lambda state %d, can not use MBAR", i);
+            }
+            for (j = 0; j < sc->nsamples; j++)
+            {
+                if (sc->s[j]->hist)
+                {
+                    gmx_fatal(FARGS, "MBAR can not be used with histogrammed energy differences");
+                }
+                if (sc->r[j].use != ref->r[j].use ||
+                    sc->r[j].start != ref->r[j].start || sc->r[j].end != ref->r[j].end)
+                {
+                    gmx_fatal(FARGS, "The samples of the energy differences to different foreign lambdas do not match for native lambda state %d, can not use MBAR", i);
+                }
+            }
+        }
+        if (ref == nullptr || ref->ntot == 0)
+        {
+            gmx_fatal(FARGS, "No samples for native lambda state %d, can not use MBAR", i);
+        }
+    }
+}
+
+/* Returns the first sample collection of state i, they all have the same samples */
+static sample_coll_t *mbar_ref_coll(sample_coll_t **sc_i, int nstate)
+{
+    int k = 0;
+    while (k < nstate && sc_i[k] == nullptr)
+    {
+        k++;
+    }
+    GMX_RELEASE_ASSERT(k < nstate, "Every state should have samples");
+    return sc_i[k];
+}
+
+/* Evaluate the convex MBAR objective function
+     F(f) = sum_n ln sum_k N_k exp(f_k - u_k(x_n)) - sum_k N_k f_k
+   for reduced free energies f, its gradient and, when hess != NULL, its
+   Hessian. The sum over all samples of all states, with a log-sum-exp
+   over the states for each sample, is split over OpenMP threads with
+   per-thread accumulation buffers that are reduced in thread order. */
+static double mbar_objective(sample_coll_t ***sc, int nstate, double beta,
+                             const double *f, double *grad, double *hess)
+{
+    const int           nthreads = gmx_omp_get_max_threads();
+    const int           nbuf     = 1 + nstate + (hess ? nstate*nstate : 0);
+    std::vector<double> buf(nthreads*nbuf, 0.0);
+    std::vector<double> lnN(nstate);
+    double              obj;
+    int                 i, k, l;
+
+    for (k = 0; k < nstate; k++)
+    {
+        lnN[k] = std::log(static_cast<double>(mbar_ref_coll(sc[k], nstate)->ntot));
+    }
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            const int           t       = gmx_omp_get_thread_num();
+            double             *objt    = buf.data() + t*nbuf;
+            double             *gradt   = objt + 1;
+            double             *hesst   = gradt + nstate;
+            std::vector<double> a(nstate);
+            std::vector<const double *> du(nstate);
+
+            for (int is = 0; is < nstate; is++)
+            {
+                const sample_coll_t *ref = mbar_ref_coll(sc[is], nstate);
+                for (int j = 0; j < ref->nsamples; j++)
+                {
+                    if (!ref->r[j].use)
+                    {
+                        continue;
+                    }
+                    for (int ks = 0; ks < nstate; ks++)
+                    {
+                        du[ks] = sc[is][ks] ? sc[is][ks]->s[j]->du : nullptr;
+                    }
+                    /* this thread's share of the samples in this range */
+                    const int len   = ref->r[j].end - ref->r[j].start;
+                    const int start = ref->r[j].start + static_cast<int>((static_cast<int64_t>(len)*t)/nthreads);
+                    const int end   = ref->r[j].start + static_cast<int>((static_cast<int64_t>(len)*(t + 1))/nthreads);
+                    for (int n = start; n < end; n++)
+                    {
+                        double amax = -std::numeric_limits<double>::max();
+                        for (int ks = 0; ks < nstate; ks++)
+                        {
+                            a[ks] = lnN[ks] + f[ks] - (du[ks] ? beta*du[ks][n] : 0.0);
+                            amax  = std::max(amax, a[ks]);
+                        }
+                        double sum = 0;
+                        for (int ks = 0; ks < nstate; ks++)
+                        {
+                            a[ks] = std::exp(a[ks] - amax);
+                            sum  += a[ks];
+                        }
+                        *objt += amax + std::log(sum);
+                        for (int ks = 0; ks < nstate; ks++)
+                        {
+                            /* the weight of state ks for this sample, summing to 1 */
+                            a[ks]      /= sum;
+                            gradt[ks]  += a[ks];
+                        }
+                        if (hess)
+                        {
+                            for (int ks = 0; ks < nstate; ks++)
+                            {
+                                hesst[ks*nstate + ks] += a[ks];
+                                for (int ls = 0; ls <= ks; ls++)
+                                {
+                                    hesst[ks*nstate + ls] -= a[ks]*a[ls];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    /* reduce over the threads */
+    obj = 0;
+    for (k = 0; k < nstate; k++)
+    {
+        grad[k] = 0;
+    }
+    if (hess)
+    {
+        for (k = 0; k < nstate*nstate; k++)
+        {
+            hess[k] = 0;
+        }
+    }
+    for (i = 0; i < nthreads; i++)
+    {
+        const double *objt = buf.data() + i*nbuf;
+        obj += objt[0];
+        for (k = 0; k < nstate; k++)
+        {
+            grad[k] += objt[1 + k];
+        }
+        if (hess)
+        {
+            for (k = 0; k < nstate*nstate; k++)
+            {
+                hess[k] += objt[1 + nstate + k];
+            }
+        }
+    }
+    for (k = 0; k < nstate; k++)
+    {
+        double N = std::exp(lnN[k]);
+        obj     -= N*f[k];
+        grad[k] -= N;
+        if (hess)
+        {
+            for (l = 0; l < k; l++)
+            {
+                hess[l*nstate + k] = hess[k*nstate + l];
+            }
+        }
+    }
+
+    return obj;
+}
+
+/* Solve the MBAR equations for the reduced free energies f of all states,
+   with f[0] = 0, using Newton's method with a backtracking line search.
+   f should contain the initial guess and tol is the tolerance in kT. */
+static void calc_mbar_lowlevel(sample_coll_t ***sc, int nstate, double temp,
+                               double tol, double *f)
+{
+    const int           maxiter = 1000;
+    const double        beta    = 1/(BOLTZ*temp);
+    std::vector<double> grad(nstate), hess(nstate*nstate), step(nstate), ftry(nstate), gtry(nstate);
+    double              obj;
+    double            **hinv = nullptr;
+    int                 iter, k, l;
+
+    if (nstate < 2)
+    {
+        return;
+    }
+    hinv = alloc_matrix(nstate - 1, nstate - 1);
+
+    obj = mbar_objective(sc, nstate, beta, f, grad.data(), hess.data());
+    for (iter = 0; iter < maxiter; iter++)
+    {
+        double maxstep = 0;
+
+        /* Newton step for the free energies relative to state 0 */
+        for (k = 1; k < nstate; k++)
+        {
+            for (l = 1; l < nstate; l++)
+            {
+                hinv[k - 1][l - 1] = hess[k*nstate + l];
+            }
+        }
+        step[0] = 0;
+        if (matrix_invert(debug, nstate - 1, hinv) == 0)
+        {
+            for (k = 1; k < nstate; k++)
+            {
+                step[k] = 0;
+                for (l = 1; l < nstate; l++)
+                {
+                    step[k] -= hinv[k - 1][l - 1]*grad[l];
+                }
+            }
+        }
+        else
+        {
+            /* Singular Hessian (poor overlap): use a self-consistent iteration step */
+            for (k = 1; k < nstate; k++)
+            {
+                double N = mbar_ref_coll(sc[k], nstate)->ntot;
+                step[k]  = -std::log((grad[k] + N)/N) + std::log((grad[0] + mbar_ref_coll(sc[0], nstate)->ntot)/mbar_ref_coll(sc[0], nstate)->ntot);
+            }
+        }
+        /* The directional derivative along the step, which should be
+           negative, otherwise fall back to steepest descent */
+        double slope = 0;
+        for (k = 1; k < nstate; k++)
+        {
+            slope += grad[k]*step[k];
+        }
+        if (!(slope < 0))
+        {
+            slope = 0;
+            for (k = 1; k < nstate; k++)
+            {
+                step[k] = -grad[k];
+                slope  -= grad[k]*grad[k];
+            }
+        }
+        for (k = 1; k < nstate; k++)
+        {
+            maxstep = std::max(maxstep, std::abs(step[k]));
+        }
+        if (debug)
+        {
+            fprintf(debug, "MBAR iteration %d objective %.10g max. step %g\n", iter, obj, maxstep);
+        }
+
+        /* backtrack until the objective function decreases sufficiently
+           (Armijo condition), a step that increases it is never taken */
+        const double armijo    = 1e-4;
+        double       scale     = 1;
+        gmx_bool     bDecrease = FALSE;
+        while (!bDecrease && scale*maxstep > 0.1*tol)
+        {
+            for (k = 0; k < nstate; k++)
+            {
+                ftry[k] = f[k] + scale*step[k];
+            }
+            double objtry = mbar_objective(sc, nstate, beta, ftry.data(), gtry.data(), nullptr);
+            bDecrease     = (objtry <= obj + armijo*scale*slope);
+            if (!bDecrease)
+            {
+                scale *= 0.5;
+            }
+        }
+        if (!bDecrease)
+        {
+            /* No decrease within the tolerance, we are at the minimum
+               up to the numerical precision of the objective function */
+            break;
+        }
+
+        for (k = 0; k < nstate; k++)
+        {
+            f[k] = ftry[k];
+        }
+        if (maxstep < tol)
+        {
+            break;
+        }
+        obj = mbar_objective(sc, nstate, beta, f, grad.data(), hess.data());
+    }
+    if (iter == maxiter)
+    {
+        printf("WARNING: MBAR did not converge in %d iterations\n", maxiter);
+    }
+    free_matrix(hinv);
+}
+
+/* Calculate the MBAR free energies f (in kT) of all states relative to the
+   first state, and the error estimates f_err of the differences between
+   consecutive states and f_tot_err of the total difference. bEE is set to
+   FALSE when there are too few samples for the block error estimate. */
+static void calc_mbar(mbar_data_t *md, double tol, int npee_min, int npee_max,
+                      gmx_bool *bEE, double *f, double *f_err, double *f_tot_err)
+{
+    const int      nstate = md->nstate;
+    sample_coll_t *sub, ***subsc;
+    double        *fb, *s, *s2;
+    double         tot, tot_s, tot_s2, tot_sig2 = 0;
+    int            i, k, npee, p;
+
+    for (k = 0; k < nstate; k++)
+    {
+        f[k]     = 0;
+        f_err[k] = 0;
+    }
+    *f_tot_err = 0;
+    calc_mbar_lowlevel(md->sc, nstate, md->temp, tol, f);
+
+    npee_min = std::max(npee_min, 2);
+    *bEE     = (npee_max >= npee_min);
+    for (i = 0; i < nstate && *bEE; i++)
+    {
+        /* every block should contain samples of every state */
+        if (mbar_ref_coll(md->sc[i], nstate)->ntot < npee_max)
+        {
+            *bEE = FALSE;
+        }
+    }
+    if (!*bEE)
+    {
+        return;
+    }
+
+    /* error estimate from the spread of the estimates over blocks */
+    snew(fb, nstate);
+    snew(s, nstate);
+    snew(s2, nstate);
+    snew(sub, nstate*nstate);
+    snew(subsc, nstate);
+    for (i = 0; i < nstate; i++)
+    {
+        snew(subsc[i], nstate);
+    }
+    for (npee = npee_min; npee <= npee_max; npee++)
+    {
+        for (k = 0; k < nstate; k++)
+        {
+            s[k]  = 0;
+            s2[k] = 0;
+        }
+        tot_s  = 0;
+        tot_s2 = 0;
+        for (p = 0; p < npee; p++)
+        {
+            for (i = 0; i < nstate; i++)
+            {
+                for (k = 0; k < nstate; k++)
+                {
+                    subsc[i][k] = nullptr;
+                    if (md->sc[i][k])
+                    {
+                        subsc[i][k] = &sub[i*nstate + k];
+                        sample_coll_create_subsample(subsc[i][k], md->sc[i][k], p, npee);
+                    }
+                }
+            }
+            for (k = 0; k < nstate; k++)
+            {
+                fb[k] = f[k];
+            }
+            calc_mbar_lowlevel(subsc, nstate, md->temp, tol, fb);
+            for (k = 0; k + 1 < nstate; k++)
+            {
+                double dg = fb[k + 1] - fb[k];
+                s[k]  += dg;
+                s2[k] += dg*dg;
+            }
+            tot     = fb[nstate - 1] - fb[0];
+            tot_s  += tot;
+            tot_s2 += tot*tot;
+            for (i = 0; i < nstate; i++)
+            {
+                for (k = 0; k < nstate; k++)
+                {
+                    if (subsc[i][k])
+                    {
+                        sample_coll_destroy(subsc[i][k]);
+                    }
+                }
+            }
+        }
+        for (k = 0; k + 1 < nstate; k++)
+        {
+            s[k]     /= npee;
+            s2[k]    /= npee;
+            f_err[k] += (s2[k] - s[k]*s[k])/(npee - 1);
+        }
+        tot_s    /= npee;
+        tot_s2   /= npee;
+        tot_sig2 += (tot_s2 - tot_s*tot_s)/(npee - 1);
+    }
+    for (k = 0; k + 1 < nstate; k++)
+    {
+        f_err[k] = std::sqrt(std::max(0.0, f_err[k])/(npee_max - npee_min + 1));
+    }
+    *f_tot_err = std::sqrt(std::max(0.0, tot_sig2)/(npee_max - npee_min + 1));
+
+    for (i = 0; i < nstate; i++)
+    {
+        sfree(subsc[i]);
+    }
+    sfree(subsc);
+    sfree(sub);
+    sfree(s2);
+    sfree(s);
+    sfree(fb);
+}
+
 /* Seek the end of an identifier (consecutive non-spaces), followed by
    an optional number of spaces or '='-signs. Returns a pointer to the
    first non-space value found after that. Returns NULL if the string
@@ -3479,12 +3955,25 @@ int gmx_bar(int argc, char *argv[])
 
         "To get a visual estimate of the phase space overlap, use the ",
         "[TT]-oh[tt] option to write series of histograms, together with the ",
-        "[TT]-nbin[tt] option.[PAR]"
+        "[TT]-nbin[tt] option.[PAR]",
+
+        "With [TT]-mbar[tt] the free energies of all states are additionally ",
+        "estimated simultaneously with the multistate Bennett acceptance ",
+        "ratio (MBAR), which uses the samples of each state for all other ",
+        "states instead of only for the neighboring states: ",
+        "Shirts & Chodera, J. Chem. Phys. 129, 124105 (2008). ",
+        "This requires the energy differences of the samples of every state ",
+        "to all other states, which are written when using ",
+        "[TT]calc-lambda-neighbors = -1[tt] in the [REF].mdp[ref] file. ",
+        "The error estimates are determined from blocks as for BAR. ",
+        "The MBAR free energy differences between neighboring states are ",
+        "written to [TT]-ombar[tt] in the same format as [TT]-o[tt].[PAR]"
     };
     static real        begin    = 0, end = -1, temp = -1;
     int                nd       = 2, nbmin = 5, nbmax = 5;
     int                nbin     = 100;
     gmx_bool           use_dhdl = FALSE;
+    gmx_bool           bMBAR    = FALSE;
     t_pargs            pa[]     = {
         { "-b",    FALSE, etREAL, {&begin},  "Begin time for BAR" },
         { "-e",    FALSE, etREAL, {&end},    "End time for BAR" },
@@ -3493,7 +3982,8 @@ int gmx_bar(int argc, char *argv[])
         { "-nbmin",  FALSE, etINT,  {&nbmin}, "Minimum number of blocks for error estimation" },
         { "-nbmax",  FALSE, etINT,  {&nbmax}, "Maximum number of blocks for error estimation" },
         { "-nbin",  FALSE, etINT, {&nbin}, "Number of bins for histogram output"},
-        { "-extp",  FALSE, etBOOL, {&use_dhdl}, "Whether to linearly extrapolate dH/dl values to use as energies"}
+        { "-extp",  FALSE, etBOOL, {&use_dhdl}, "Whether to linearly extrapolate dH/dl values to use as energies"},
+        { "-mbar",  FALSE, etBOOL, {&bMBAR}, "Also estimate the free energies of all states simultaneously with MBAR"}
     };
 
     t_filenm           fnm[] = {
@@ -3501,7 +3991,8 @@ int gmx_bar(int argc, char *argv[])
         { efEDR, "-g",  "ener",   ffOPTRDMULT },
         { efXVG, "-o",  "bar",    ffOPTWR },
         { efXVG, "-oi", "barint", ffOPTWR },
-        { efXVG, "-oh", "histogram", ffOPTWR }
+        { efXVG, "-oh", "histogram", ffOPTWR },
+        { efXVG, "-ombar", "mbar", ffOPTWR }
     };
 #define NFILE asize(fnm)
 
@@ -3843,6 +4334,73 @@ int gmx_bar(int argc, char *argv[])
     }
     printf("\n");
 
+    if (bMBAR)
+    {
+        mbar_data_t mbar;
+        double     *mbar_f, *mbar_f_err, mbar_tot_err;
+        gmx_bool    bEE_mbar;
+
+        mbar_data_init(&mbar, &sim_data);
+        snew(mbar_f, mbar.nstate);
+        snew(mbar_f_err, mbar.nstate);
+        calc_mbar(&mbar, 0.1*prec, nbmin, nbmax, &bEE_mbar,
+                  mbar_f, mbar_f_err, &mbar_tot_err);
+
+        if (opt2bSet("-ombar", NFILE, fnm))
+        {
+            FILE *fpm;
+
+            sprintf(buf, "%s (%s)", "\\DeltaG", "kT");
+            fpm = xvgropen_type(opt2fn("-ombar", NFILE, fnm), "MBAR free energy differences",
+                                "\\lambda", buf, exvggtXYDY, oenv);
+            for (f = 0; f + 1 < mbar.nstate; f++)
+            {
+                lambda_vec_print_intermediate(mbar.l[f]->lambda, mbar.l[f + 1]->lambda, buf);
+                fprintf(fpm, xvg3format, buf, mbar_f[f + 1] - mbar_f[f], mbar_f_err[f]);
+            }
+            xvgrclose(fpm);
+        }
+
+        printf("\nMBAR results in kJ/mol:\n\n");
+        for (f = 0; f + 1 < mbar.nstate; f++)
+        {
+            printf("point ");
+            lambda_vec_print_short(mbar.l[f]->lambda, buf);
+            lambda_vec_print_short(mbar.l[f + 1]->lambda, buf2);
+            printf("%s - %s", buf, buf2);
+            printf(",   DG ");
+            printf(dgformat, (mbar_f[f + 1] - mbar_f[f])*kT);
+            if (bEE_mbar)
+            {
+                printf(" +/- ");
+                printf(dgformat, mbar_f_err[f]*kT);
+            }
+            printf("\n");
+        }
+        printf("\n");
+        printf("total ");
+        lambda_vec_print_short(mbar.l[0]->lambda, buf);
+        lambda_vec_print_short(mbar.l[mbar.nstate - 1]->lambda, buf2);
+        printf("%s - %s", buf, buf2);
+        printf(",   DG ");
+        printf(dgformat, (mbar_f[mbar.nstate - 1] - mbar_f[0])*kT);
+        if (bEE_mbar)
+        {
+            printf(" +/- ");
+            printf(dgformat, mbar_tot_err*kT);
+        }
+        printf("\n\n");
+
+        for (f = 0; f < mbar.nstate; f++)
+        {
+            sfree(mbar.sc[f]);
+        }
+        sfree(mbar.sc);
+        sfree(mbar.l);
+        sfree(mbar_f_err);
+        sfree(mbar_f);
+    }
+
 
     if (fpi != nullptr)
     {
@@ -69,6 +69,7 @@
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/programcontext.h"
@@ -129,18 +130,28 @@ typedef struct {
 typedef int     t_icell[grNR];
 typedef int h_id[MAXHYDRO];
 
+/* Run-length encoded existence of a hydrogen bond or contact over the
+ * trajectory. The nrun runs are sorted, non-overlapping half-open frame
+ * ranges [run[2*i], run[2*i+1]). Frames are analyzed in increasing order,
+ * so marking the current frame only touches the last run and memory use
+ * scales with the number of (re)formation events, not with the number
+ * of frames.
+ */
+typedef struct {
+    int      nrun, maxrun;
+    int     *run;
+} t_hbexist;
+
 typedef struct {
     int      history[MAXHYDRO];
     /* Has this hbond existed ever? If so as hbDist or hbHB or both.
      * Result is stored as a bitmap (1 = hbDist) || (2 = hbHB)
      */
-    /* Bitmask array which tells whether a hbond is present
-     * at a given time. Either of these may be NULL
+    /* Existence of the hbond (h) and of the donor-acceptor pair within
+     * the distance cut-off (g) for each hydrogen, maxhydro entries long.
      */
-    int            n0;                 /* First frame a HB was found     */
-    int            nframes, maxframes; /* Amount of frames in this hbond */
-    unsigned int **h;
-    unsigned int **g;
+    t_hbexist *h;
+    t_hbexist *g;
     /* See Xu and Berne, JPCB 105 (2001), p. 11929. We define the
      * function g(t) = [1-h(t)] H(t) where H(t) is one when the donor-
      * acceptor distance is less than the user-specified distance (typically
@@ -167,7 +178,6 @@ typedef struct {
 
 typedef struct {
     gmx_bool        bHBmap, bDAnr;
-    int             wordlen;
     /* The following arrays are nframes long */
     int             nframes, max_frames, maxhydro;
     int            *nhb, *ndist;
@@ -194,7 +204,6 @@ static t_hbdata *mk_hbdata(gmx_bool bHBmap, gmx_bool bDAnr, gmx_bool oneHB)
     t_hbdata *hb;
 
     snew(hb, 1);
-    hb->wordlen = 8*sizeof(unsigned int);
     hb->bHBmap  = bHBmap;
     hb->bDAnr   = bDAnr;
     if (oneHB)
@@ -245,92 +254,104 @@ static void add_frames(t_hbdata *hb, int nframes)
     hb->nframes = nframes;
 }
 
-#define OFFSET(frame) ((frame) / 32)
-#define MASK(frame)   (1 << ((frame) % 32))
-
-static void _set_hb(unsigned int hbexist[], unsigned int frame, gmx_bool bValue)
+/* Adds frames [begin, end) to hbexist, begin should not be lower than
+ * the start of the last run.
+ */
+static void add_hb_run(t_hbexist *hbexist, int begin, int end)
 {
-    if (bValue)
+    if (hbexist->nrun > 0)
     {
-        hbexist[OFFSET(frame)] |= MASK(frame);
+        int *last = hbexist->run + 2*(hbexist->nrun - 1);
+
+        GMX_ASSERT(begin >= last[0], "Existence runs should be added in order");
+        if (begin <= last[1])
+        {
+            last[1] = std::max(last[1], end);
+            return;
+        }
     }
-    else
+    if (hbexist->nrun == hbexist->maxrun)
     {
-        hbexist[OFFSET(frame)] &= ~MASK(frame);
+        hbexist->maxrun = std::max(4, 2*hbexist->maxrun);
+        srenew(hbexist->run, 2*hbexist->maxrun);
     }
+    hbexist->run[2*hbexist->nrun]     = begin;
+    hbexist->run[2*hbexist->nrun + 1] = end;
+    hbexist->nrun++;
 }
 
-static gmx_bool is_hb(const unsigned int hbexist[], int frame)
+static void set_hb(t_hbexist *hbexist, int frame)
 {
-    return (hbexist[OFFSET(frame)] & MASK(frame)) != 0;
+    add_hb_run(hbexist, frame, frame + 1);
 }
 
-static void set_hb(t_hbdata *hb, int id, int ih, int ia, int frame, int ihb)
+static gmx_bool is_hb(const t_hbexist *hbexist, int frame)
 {
-    unsigned int *ghptr = nullptr;
-
-    if (ihb == hbHB)
+    /* Binary search for the first run that ends after frame */
+    int lo = 0;
+    int hi = hbexist->nrun;
+    while (lo < hi)
     {
-        ghptr = hb->hbmap[id][ia]->h[ih];
+        int mid = (lo + hi)/2;
+        if (hbexist->run[2*mid + 1] <= frame)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
     }
-    else if (ihb == hbDist)
+    return lo < hbexist->nrun && hbexist->run[2*lo] <= frame;
+}
+
+/* Sets buf[j] to 1 for frames j < nframes where hbexist is set, 0 otherwise */
+static void expand_hbexist(const t_hbexist *hbexist, int nframes, real buf[])
+{
+    int j;
+
+    for (j = 0; j < nframes; j++)
     {
-        ghptr = hb->hbmap[id][ia]->g[ih];
+        buf[j] = 0;
     }
-    else
+    for (int r = 0; r < hbexist->nrun; r++)
     {
-        gmx_fatal(FARGS, "Incomprehensible iValue %d in set_hb", ihb);
+        int end = std::min(hbexist->run[2*r + 1], nframes);
+        for (j = hbexist->run[2*r]; j < end; j++)
+        {
+            buf[j] = 1;
+        }
     }
+}
 
-    _set_hb(ghptr, frame-hb->hbmap[id][ia]->n0, TRUE);
+static void done_hbexist(t_hbexist *hbexist)
+{
+    sfree(hbexist->run);
+    hbexist->run    = nullptr;
+    hbexist->nrun   = 0;
+    hbexist->maxrun = 0;
 }
 
 static void add_ff(t_hbdata *hbd, int id, int h, int ia, int frame, int ihb)
 {
-    int         i, j, n;
-    t_hbond    *hb       = hbd->hbmap[id][ia];
-    int         maxhydro = std::min(hbd->maxhydro, hbd->d.nhydro[id]);
-    int         wlen     = hbd->wordlen;
-    int         delta    = 32*wlen;
+    t_hbond *hb = hbd->hbmap[id][ia];
 
-    if (!hb->h[0])
+    if (frame < 0)
     {
-        hb->n0        = frame;
-        hb->maxframes = delta;
-        for (i = 0; (i < maxhydro); i++)
-        {
-            snew(hb->h[i], hb->maxframes/wlen);
-            snew(hb->g[i], hb->maxframes/wlen);
-        }
+        return;
     }
-    else
+    if (ihb == hbHB)
     {
-        hb->nframes = frame-hb->n0;
-        /* We need a while loop here because hbonds may be returning
-         * after a long time.
-         */
-        while (hb->nframes >= hb->maxframes)
-        {
-            n = hb->maxframes + delta;
-            for (i = 0; (i < maxhydro); i++)
-            {
-                srenew(hb->h[i], n/wlen);
-                srenew(hb->g[i], n/wlen);
-                for (j = hb->maxframes/wlen; (j < n/wlen); j++)
-                {
-                    hb->h[i][j] = 0;
-                    hb->g[i][j] = 0;
-                }
-            }
-
-            hb->maxframes = n;
-        }
+        set_hb(&hb->h[h], frame);
     }
-    if (frame >= 0)
+    else if (ihb == hbDist)
     {
-        set_hb(hbd, id, h, ia, frame, ihb);
+        set_hb(&hb->g[h], frame);
+    }
+    else
+    {
+        gmx_fatal(FARGS, "Incomprehensible iValue %d in set_hb", ihb);
     }
-
 }
 
 static void inc_nhbonds(t_donors *ddd, int d, int h)
@@ -1353,74 +1374,41 @@ static int is_hbond(t_hbdata *hb, int grpd, int grpa, int d, int a,
     }
 }
 
-/* Merging is now done on the fly, so do_merge is most likely obsolete now.
- * Will do some more testing before removing the function entirely.
- * - Erik Marklund, MAY 10 2010 */
-static void do_merge(t_hbdata *hb, int ntmp,
-                     bool htmp[], bool gtmp[],
-                     t_hbond *hb0, t_hbond *hb1)
+static void merge_hbexist(t_hbexist *dest, const t_hbexist *src)
 {
-    /* Here we need to make sure we're treating periodicity in
-     * the right way for the geminate recombination kinetics. */
+    t_hbexist merged = { 0, 0, nullptr };
+    int       i      = 0;
+    int       j      = 0;
 
-    int       m, mm, n00, n01, nn0, nnframes;
-
-    /* Decide where to start from when merging */
-    n00      = hb0->n0;
-    n01      = hb1->n0;
-    nn0      = std::min(n00, n01);
-    nnframes = std::max(n00 + hb0->nframes, n01 + hb1->nframes) - nn0;
-    /* Initiate tmp arrays */
-    for (m = 0; (m < ntmp); m++)
-    {
-        htmp[m] = false;
-        gtmp[m] = false;
-    }
-    /* Fill tmp arrays with values due to first HB */
-    /* Once again '<' had to be replaced with '<='
-       to catch the last frame in which the hbond
-       appears.
-       - Erik Marklund, June 1, 2006 */
-    for (m = 0; (m <= hb0->nframes); m++)
-    {
-        mm       = m+n00-nn0;
-        htmp[mm] = is_hb(hb0->h[0], m);
-    }
-    for (m = 0; (m <= hb0->nframes); m++)
-    {
-        mm       = m+n00-nn0;
-        gtmp[mm] = is_hb(hb0->g[0], m);
-    }
-    /* Next HB */
-    for (m = 0; (m <= hb1->nframes); m++)
-    {
-        mm       = m+n01-nn0;
-        htmp[mm] = htmp[mm] || is_hb(hb1->h[0], m);
-        gtmp[mm] = gtmp[mm] || is_hb(hb1->g[0], m);
-    }
-    /* Reallocate target array */
-    if (nnframes > hb0->maxframes)
-    {
-        srenew(hb0->h[0], 4+nnframes/hb->wordlen);
-        srenew(hb0->g[0], 4+nnframes/hb->wordlen);
-    }
-
-    /* Copy temp array to target array */
-    for (m = 0; (m <= nnframes); m++)
+    /* Walk both sorted run lists and add the runs in order of their start */
+    while (i < dest->nrun || j < src->nrun)
     {
-        _set_hb(hb0->h[0], m, htmp[m]);
-        _set_hb(hb0->g[0], m, gtmp[m]);
+        const int *r;
+        if (j == src->nrun || (i < dest->nrun && dest->run[2*i] <= src->run[2*j]))
+        {
+            r = dest->run + 2*i++;
+        }
+        else
+        {
+            r = src->run + 2*j++;
+        }
+        add_hb_run(&merged, r[0], r[1]);
     }
+    done_hbexist(dest);
+    *dest = merged;
+}
 
-    /* Set scalar variables */
-    hb0->n0        = nn0;
-    hb0->maxframes = nnframes;
+static void do_merge(t_hbond *hb0, t_hbond *hb1)
+{
+    /* Here we need to make sure we're treating periodicity in
+     * the right way for the geminate recombination kinetics. */
+    merge_hbexist(&hb0->h[0], &hb1->h[0]);
+    merge_hbexist(&hb0->g[0], &hb1->g[0]);
 }
 
 static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
 {
-    int           i, inrnew, indnew, j, ii, jj, id, ia, ntmp;
-    bool         *htmp, *gtmp;
+    int           i, inrnew, indnew, j, ii, jj, id, ia;
     t_hbond      *hb0, *hb1;
 
     inrnew = hb->nrhb;
@@ -1429,9 +1417,6 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
     /* Check whether donors are also acceptors */
     printf("Merging hbonds with Acceptor and Donor swapped\n");
 
-    ntmp = 2*hb->max_frames;
-    snew(gtmp, ntmp);
-    snew(htmp, ntmp);
     for (i = 0; (i < hb->d.nrd); i++)
     {
         fprintf(stderr, "\r%d/%d", i+1, hb->d.nrd);
@@ -1449,7 +1434,7 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
                 hb1 = hb->hbmap[jj][ii];
                 if (hb0 && hb1 && ISHB(hb0->history[0]) && ISHB(hb1->history[0]))
                 {
-                    do_merge(hb, ntmp, htmp, gtmp, hb0, hb1);
+                    do_merge(hb0, hb1);
                     if (ISHB(hb1->history[0]))
                     {
                         inrnew--;
@@ -1467,10 +1452,8 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
                     {
                         gmx_incons("Neither hydrogen bond nor distance");
                     }
-                    sfree(hb1->h[0]);
-                    sfree(hb1->g[0]);
-                    hb1->h[0]       = nullptr;
-                    hb1->g[0]       = nullptr;
+                    done_hbexist(&hb1->h[0]);
+                    done_hbexist(&hb1->g[0]);
                     hb1->history[0] = hbNo;
                 }
             }
@@ -1481,8 +1464,6 @@ static void merge_hb(t_hbdata *hb, gmx_bool bTwo, gmx_bool bContact)
     printf("- Reduced number of distances from %d to %d\n", hb->nrdist, indnew);
     hb->nrhb   = inrnew;
     hb->nrdist = indnew;
-    sfree(gtmp);
-    sfree(htmp);
 }
 
 static void do_nhb_dist(FILE *fp, t_hbdata *hb, real t)
@@ -1515,15 +1496,15 @@ static void do_nhb_dist(FILE *fp, t_hbdata *hb, real t)
 static void do_hblife(const char *fn, t_hbdata *hb, gmx_bool bMerge, gmx_bool bContact,
                       const gmx_output_env_t *oenv)
 {
-    FILE          *fp;
-    const char    *leg[] = { "p(t)", "t p(t)" };
-    int           *histo;
-    int            i, j, j0, k, m, nh, ihb, ohb, nhydro, ndump = 0;
-    int            nframes = hb->nframes;
-    unsigned int **h;
-    real           t, x1, dt;
-    double         sum, integral;
-    t_hbond       *hbh;
+    FILE             *fp;
+    const char       *leg[] = { "p(t)", "t p(t)" };
+    int              *histo;
+    int               i, j0, k, m, nh, r, nhydro, ndump = 0;
+    int               nframes = hb->nframes;
+    const t_hbexist **h;
+    real              t, x1, dt;
+    double            sum, integral;
+    t_hbond          *hbh;
 
     snew(h, hb->maxhydro);
     snew(histo, nframes+1);
@@ -1537,50 +1518,33 @@ static void do_hblife(const char *fn, t_hbdata *hb, gmx_bool bMerge, gmx_bool bC
             {
                 if (bMerge)
                 {
-                    if (hbh->h[0])
-                    {
-                        h[0]   = hbh->h[0];
-                        nhydro = 1;
-                    }
-                    else
-                    {
-                        nhydro = 0;
-                    }
+                    h[0]   = &hbh->h[0];
+                    nhydro = 1;
                 }
                 else
                 {
                     nhydro = 0;
                     for (m = 0; (m < hb->maxhydro); m++)
                     {
-                        if (hbh->h[m])
-                        {
-                            h[nhydro++] = bContact ? hbh->g[m] : hbh->h[m];
-                        }
+                        h[nhydro++] = bContact ? &hbh->g[m] : &hbh->h[m];
                     }
                 }
                 for (nh = 0; (nh < nhydro); nh++)
                 {
-                    ohb = 0;
-                    j0  = 0;
-
-                    for (j = 0; (j <= hbh->nframes); j++)
+                    /* Each run that ends within the trajectory is one
+                     * uninterrupted lifetime.
+                     */
+                    for (r = 0; (r < h[nh]->nrun); r++)
                     {
-                        ihb      = static_cast<int>(is_hb(h[nh], j));
+                        const int begin = h[nh]->run[2*r];
+                        const int end   = h[nh]->run[2*r + 1];
                         if (debug && (ndump < 10))
                         {
-                            fprintf(debug, "%5d  %5d\n", j, ihb);
+                            fprintf(debug, "%5d  %5d\n", begin, end);
                         }
-                        if (ihb != ohb)
+                        if (end < nframes)
                         {
-                            if (ihb)
-                            {
-                                j0 = j;
-                            }
-                            else
-                            {
-                                histo[j-j0]++;
-                            }
-                            ohb = ihb;
+                            histo[end-begin]++;
                         }
                     }
                     ndump++;
@@ -1653,12 +1617,16 @@ static void dump_ac(t_hbdata *hb, gmx_bool oneHB, int nDump)
                 bPrint = FALSE;
                 ihb    = idist = 0;
                 hbh    = hb->hbmap[i][k];
+                if (hbh == nullptr)
+                {
+                    continue;
+                }
                 if (oneHB)
                 {
-                    if (hbh->h[0])
+                    if (hbh->h[0].nrun > 0)
                     {
-                        ihb    = static_cast<int>(is_hb(hbh->h[0], j));
-                        idist  = static_cast<int>(is_hb(hbh->g[0], j));
+                        ihb    = static_cast<int>(is_hb(&hbh->h[0], j));
+                        idist  = static_cast<int>(is_hb(&hbh->g[0], j));
                         bPrint = TRUE;
                     }
                 }
@@ -1666,8 +1634,8 @@ static void dump_ac(t_hbdata *hb, gmx_bool oneHB, int nDump)
                 {
                     for (m = 0; (m < hb->maxhydro) && !ihb; m++)
                     {
-                        ihb   = static_cast<int>((ihb != 0)   || (((hbh->h[m]) != nullptr) && is_hb(hbh->h[m], j)));
-                        idist = static_cast<int>((idist != 0) || (((hbh->g[m]) != nullptr) && is_hb(hbh->g[m], j)));
+                        ihb   = static_cast<int>((ihb != 0)   || is_hb(&hbh->h[m], j));
+                        idist = static_cast<int>((idist != 0) || is_hb(&hbh->g[m], j));
                     }
                     /* This is not correct! */
                     /* What isn't correct? -Erik M */
@@ -1927,7 +1895,7 @@ static void do_hbac(const char *fn, t_hbdata *hb,
     real          *ct, tail, tail2, dtail, *cct;
     const real     tol     = 1e-3;
     int            nframes = hb->nframes;
-    unsigned int **h       = nullptr, **g = nullptr;
+    const t_hbexist **h    = nullptr, **g = nullptr;
     int            nh, nhbonds, nhydro;
     t_hbond       *hbh;
     int            acType;
@@ -2017,8 +1985,8 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                 {
                     if (ISHB(hbh->history[0]))
                     {
-                        h[0]   = hbh->h[0];
-                        g[0]   = hbh->g[0];
+                        h[0]   = &hbh->h[0];
+                        g[0]   = &hbh->g[0];
                         nhydro = 1;
                     }
                 }
@@ -2028,14 +1996,13 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                     {
                         if (bContact ? ISDIST(hbh->history[m]) : ISHB(hbh->history[m]))
                         {
-                            g[nhydro] = hbh->g[m];
-                            h[nhydro] = hbh->h[m];
+                            g[nhydro] = &hbh->g[m];
+                            h[nhydro] = &hbh->h[m];
                             nhydro++;
                         }
                     }
                 }
 
-                int nf = hbh->nframes;
                 for (nh = 0; (nh < nhydro); nh++)
                 {
                     int nrint = bContact ? hb->nrdist : hb->nrhb;
@@ -2045,18 +2012,13 @@ static void do_hbac(const char *fn, t_hbdata *hb,
                         fflush(stderr);
                     }
                     nhbonds++;
+                    /* Expand the existence runs of this hbond, gt holds idist */
+                    expand_hbexist(h[nh], nframes, rhbex);
+                    expand_hbexist(g[nh], nframes, gt);
                     for (j = 0; (j < nframes); j++)
                     {
-                        if (j <= nf)
-                        {
-                            ihb   = static_cast<int>(is_hb(h[nh], j));
-                            idist = static_cast<int>(is_hb(g[nh], j));
-                        }
-                        else
-                        {
-                            ihb = idist = 0;
-                        }
-                        rhbex[j] = ihb;
+                        ihb   = static_cast<int>(rhbex[j]);
+                        idist = static_cast<int>(gt[j]);
                         /* For contacts: if a second cut-off is provided, use it,
                          * otherwise use g(t) = 1-h(t) */
                         if (!R2 && bContact)
@@ -2212,8 +2174,8 @@ static void analyse_donor_properties(FILE *fp, t_hbdata *hb, int nframes, real t
             nhtot++;
             for (j = 0; (j < hb->a.nra) && (nb == 0); j++)
             {
-                if (hb->hbmap[i][j] && hb->hbmap[i][j]->h[k] &&
-                    is_hb(hb->hbmap[i][j]->h[k], nframes))
+                if (hb->hbmap[i][j] && k < hb->maxhydro &&
+                    is_hb(&hb->hbmap[i][j]->h[k], nframes))
                 {
                     nb = 1;
                 }
@@ -2820,7 +2782,6 @@ int gmx_hbond(int argc, char *argv[])
 
             p_hb[i]->bHBmap     = hb->bHBmap;
             p_hb[i]->bDAnr      = hb->bDAnr;
-            p_hb[i]->wordlen    = hb->wordlen;
             p_hb[i]->nframes    = hb->nframes;
             p_hb[i]->maxhydro   = hb->maxhydro;
             p_hb[i]->danr       = hb->danr;
@@ -3343,11 +3304,14 @@ int gmx_hbond(int argc, char *argv[])
                             {
                                 if (ISHB(hb->hbmap[id][ia]->history[hh]))
                                 {
-                                    for (x = 0; (x <= hb->hbmap[id][ia]->nframes); x++)
+                                    const t_hbexist *hbexist = &hb->hbmap[id][ia]->h[hh];
+                                    range_check(y, 0, mat.ny);
+                                    for (int r = 0; (r < hbexist->nrun); r++)
                                     {
-                                        int nn0 = hb->hbmap[id][ia]->n0;
-                                        range_check(y, 0, mat.ny);
-                                        mat.matrix[x+nn0][y] = static_cast<t_matelmt>(is_hb(hb->hbmap[id][ia]->h[hh], x));
+                                        for (x = hbexist->run[2*r]; (x < hbexist->run[2*r + 1]); x++)
+                                        {
+                                            mat.matrix[x][y] = 1;
+                                        }
                                     }
                                     y++;
                                 }
@@ -67,7 +67,8 @@ int gmx_sans(int argc, char *argv[])
         "[PAR]",
         "Parameters:[PAR]",
         "[TT]-pr[tt] Computes normalized g(r) function averaged over trajectory[PAR]",
-        "[TT]-prframe[tt] Computes normalized g(r) function for each frame[PAR]",
+        "[TT]-prframe[tt] Computes normalized g(r) function for each frame, ",
+        "with Monte-Carlo mode the third column contains the statistical error[PAR]",
         "[TT]-sq[tt] Computes SANS intensity curve averaged over trajectory[PAR]",
         "[TT]-sqframe[tt] Computes SANS intensity curve for each frame[PAR]",
         "[TT]-startq[tt] Starting q value in nm[PAR]",
@@ -136,6 +137,7 @@ int gmx_sans(int argc, char *argv[])
     int                                  *index   = nullptr;
     int                                   isize;
     int                                   i;
+    double                                grnorm;
     char                                 *hdr            = nullptr;
     char                                 *suffix         = nullptr;
     gmx_radial_distribution_histogram_t  *prframecurrent = nullptr, *pr = nullptr;
@@ -286,8 +288,15 @@ int gmx_sans(int argc, char *argv[])
             pr->gr[i] += prframecurrent->gr[i];
             pr->r[i]   = prframecurrent->r[i];
         }
-        /* normalize histo */
-        normalize_probability(prframecurrent->grn, prframecurrent->gr);
+        /* normalize histo, together with the Monte-Carlo error estimate */
+        grnorm = normalize_probability(prframecurrent->grn, prframecurrent->gr);
+        if (prframecurrent->grerr != nullptr)
+        {
+            for (i = 0; i < prframecurrent->grn; i++)
+            {
+                prframecurrent->grerr[i] /= grnorm;
+            }
+        }
         /* convert p(r) to sq */
         sqframecurrent = convert_histogram_to_intensity_curve(prframecurrent, start_q, end_q, q_step);
         /* print frame data if needed */
@@ -304,7 +313,14 @@ int gmx_sans(int argc, char *argv[])
             fp = xvgropen(opt2fn_null("-prframe", NFILE, fnmdup.data()), hdr, "Distance (nm)", "Probability", oenv);
             for (i = 0; i < prframecurrent->grn; i++)
             {
-                fprintf(fp, "%10.6f%10.6f\n", prframecurrent->r[i], prframecurrent->gr[i]);
+                if (prframecurrent->grerr != nullptr)
+                {
+                    fprintf(fp, "%10.6f%10.6f%10.6f\n", prframecurrent->r[i], prframecurrent->gr[i], prframecurrent->grerr[i]);
+                }
+                else
+                {
+                    fprintf(fp, "%10.6f%10.6f\n", prframecurrent->r[i], prframecurrent->gr[i]);
+                }
             }
             xvgrclose(fp);
             sfree(hdr);
@@ -331,6 +347,7 @@ int gmx_sans(int argc, char *argv[])
         }
         /* free pr structure */
         sfree(prframecurrent->gr);
+        sfree(prframecurrent->grerr);
         sfree(prframecurrent->r);
         sfree(prframecurrent);
         /* free sq structure */
@@ -35,12 +35,22 @@
 #include "gmxpre.h"
 
 #include <cmath>
-#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
+#include "gromacs/fileio/mrcdensitymapheader.h"
+#include "gromacs/fileio/mrcserializer.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/math/invertmatrix.h"
+#include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pbcutil/rmpbc.h"
@@ -49,11 +59,185 @@
 #include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/inmemoryserializer.h"
 #include "gromacs/utility/smalloc.h"
 
 static const double bohr = 0.529177249;  /* conversion factor to compensate for VMD plugin conversion... */
 
+namespace
+{
+
+//! The number of bins along each dimension of a block of the sparse grid
+constexpr int c_blockSize = 8;
+
+/*! \brief Bin counts on an unbounded grid
+ *
+ * The counts are stored in blocks of c_blockSize^3 bins that are allocated
+ * when a bin in the block is first used, so the occupied region does not
+ * need to be known in advance.
+ */
+class SparseBinGrid
+{
+    public:
+        SparseBinGrid()
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                min_[d] = std::numeric_limits<int>::max();
+                max_[d] = std::numeric_limits<int>::min();
+            }
+        }
+
+        //! Adds one count to bin \p bin
+        void add(const ivec bin)
+        {
+            ivec block, local;
+
+            for (int d = 0; d < DIM; d++)
+            {
+                block[d] = (bin[d] >= 0 ? bin[d]/c_blockSize : -((-bin[d] - 1)/c_blockSize) - 1);
+                local[d] = bin[d] - block[d]*c_blockSize;
+                min_[d]  = std::min(min_[d], bin[d]);
+                max_[d]  = std::max(max_[d], bin[d]);
+            }
+            std::vector<int> &counts = blocks_[blockKey(block)];
+            if (counts.empty())
+            {
+                counts.resize(c_blockSize*c_blockSize*c_blockSize, 0);
+            }
+            counts[(local[XX]*c_blockSize + local[YY])*c_blockSize + local[ZZ]]++;
+        }
+
+        //! Returns the count in bin \p bin
+        int count(const ivec bin) const
+        {
+            ivec block, local;
+
+            for (int d = 0; d < DIM; d++)
+            {
+                block[d] = (bin[d] >= 0 ? bin[d]/c_blockSize : -((-bin[d] - 1)/c_blockSize) - 1);
+                local[d] = bin[d] - block[d]*c_blockSize;
+            }
+            const auto it = blocks_.find(blockKey(block));
+            if (it == blocks_.end())
+            {
+                return 0;
+            }
+            return it->second[(local[XX]*c_blockSize + local[YY])*c_blockSize + local[ZZ]];
+        }
+
+        //! Adds all counts of \p other to this grid
+        void merge(const SparseBinGrid &other)
+        {
+            for (const auto &otherBlock : other.blocks_)
+            {
+                std::vector<int> &counts = blocks_[otherBlock.first];
+                if (counts.empty())
+                {
+                    counts = otherBlock.second;
+                }
+                else
+                {
+                    for (size_t i = 0; i < counts.size(); i++)
+                    {
+                        counts[i] += otherBlock.second[i];
+                    }
+                }
+            }
+            for (int d = 0; d < DIM; d++)
+            {
+                min_[d] = std::min(min_[d], other.min_[d]);
+                max_[d] = std::max(max_[d], other.max_[d]);
+            }
+        }
+
+        //! Whether no counts have been added
+        bool empty() const { return blocks_.empty(); }
+        //! The lowest occupied bin index along dimension \p d
+        int min(int d) const { return min_[d]; }
+        //! The highest occupied bin index along dimension \p d
+        int max(int d) const { return max_[d]; }
+
+    private:
+        //! Returns the hash key for block indices, which should fit in 21 bits each
+        static int64_t blockKey(const ivec block)
+        {
+            const int64_t offset = 1 << 20;
+
+            return (((block[XX] + offset) << 42) | ((block[YY] + offset) << 21) | (block[ZZ] + offset));
+        }
+
+        std::unordered_map<int64_t, std::vector<int> > blocks_;
+        ivec                                          min_;
+        ivec                                          max_;
+};
+
+/*! \brief Writes the bins \p lo to \p hi of \p grid, times \p scale, as an MRC/CCP4 map
+ *
+ * The map uses a grid with origin at zero and spacing \p binwidth,
+ * the bins are written starting at index \p lo.
+ */
+void writeMrcMap(const char *fn, const SparseBinGrid &grid, const ivec lo, const ivec hi,
+                 real binwidth, double scale)
+{
+    gmx::MrcDensityMapHeader header;
+    std::vector<float>       data;
+    double                   sum = 0, sum2 = 0;
+
+    for (int d = 0; d < DIM; d++)
+    {
+        header.numColumnRowSection_[d]  = hi[d] - lo[d] + 1;
+        header.columnRowSectionStart_[d] = lo[d];
+        header.extent_[d]               = hi[d] - lo[d] + 1;
+        /* MRC lengths are in Ångström */
+        header.cellLength_[d]           = header.extent_[d]*binwidth*NM2A;
+    }
+    /* The columns, varying fastest, are along x */
+    data.reserve(header.extent_[XX]*header.extent_[YY]*header.extent_[ZZ]);
+    header.dataStatistics_.min_ = std::numeric_limits<float>::max();
+    header.dataStatistics_.max_ = std::numeric_limits<float>::lowest();
+    for (int z = lo[ZZ]; z <= hi[ZZ]; z++)
+    {
+        for (int y = lo[YY]; y <= hi[YY]; y++)
+        {
+            for (int x = lo[XX]; x <= hi[XX]; x++)
+            {
+                const ivec  bin   = { x, y, z };
+                const float value = scale*grid.count(bin);
+
+                data.push_back(value);
+                header.dataStatistics_.min_ = std::min(header.dataStatistics_.min_, value);
+                header.dataStatistics_.max_ = std::max(header.dataStatistics_.max_, value);
+                sum                        += value;
+                sum2                       += value*value;
+            }
+        }
+    }
+    header.dataStatistics_.mean_ = sum/data.size();
+    header.dataStatistics_.rms_  = std::sqrt(std::max(0.0, sum2/data.size() - gmx::square(sum/data.size())));
+
+    gmx::InMemorySerializer serializer;
+    gmx::serializeMrcDensityMapHeader(&serializer, header);
+    for (float &value : data)
+    {
+        serializer.doFloat(&value);
+    }
+    const std::vector<char> buffer = serializer.finishAndGetBuffer();
+
+    FILE *fp = gmx_ffopen(fn, "wb");
+    if (fwrite(buffer.data(), sizeof(char), buffer.size(), fp) != buffer.size())
+    {
+        gmx_file(fn);
+    }
+    gmx_ffclose(fp);
+}
+
+}   // namespace
+
 int gmx_spatial(int argc, char *argv[])
 {
     const char       *desc[] = {
@@ -76,7 +260,7 @@ int gmx_spatial(int argc, char *argv[])
         "2. [TT]gmx trjconv -s a.tpr -f a.tng -o b.tng -boxcenter tric -ur compact -pbc none[tt]",
         "3. [TT]gmx trjconv -s a.tpr -f b.tng -o c.tng -fit rot+trans[tt]",
         "4. run [THISMODULE] on the [TT]c.tng[tt] output of step #3.",
-        "5. Load [TT]grid.cube[tt] into VMD and view as an isosurface.",
+        "5. Load the [TT]-o[tt] output, [TT]grid.cub[tt], into VMD and view as an isosurface.",
         "",
         "[BB]Note[bb] that systems such as micelles will require [TT]gmx trjconv -pbc cluster[tt] between steps 1 and 2.",
         "",
@@ -90,28 +274,24 @@ int gmx_spatial(int argc, char *argv[])
         "with system volume throughout the entire translated/rotated system over the course of the trajectory.",
         "It is up to the user to ensure that this is the case.",
         "",
-        "Risky options",
-        "^^^^^^^^^^^^^",
+        "Output",
+        "^^^^^^",
         "",
-        "To reduce the amount of space and time required, you can output only the coords",
-        "that are going to be used in the first and subsequent run through [gmx-trjconv].",
-        "However, be sure to set the [TT]-nab[tt] option to a sufficiently high value since",
-        "memory is allocated for cube bins based on the initial coordinates and the [TT]-nab[tt]",
-        "option value."
-    };
-    const char       *bugs[] = {
-        "When the allocated memory is not large enough, a segmentation fault may occur. This is usually detected "
-        "and the program is halted prior to the fault while displaying a warning message suggesting the use of the [TT]-nab[tt] (Number of Additional Bins) "
-        "option. However, the program does not detect all such events. If you encounter a segmentation fault, run it again "
-        "with an increased [TT]-nab[tt] value."
+        "The SDF is always written to the Gaussian cube file [TT]-o[tt]. With [TT]-mrc[tt] it",
+        "is also written as an MRC/CCP4 density map, which can be read by most visualization",
+        "programs. Only the bins that are occupied are stored during the analysis, so the SDF",
+        "can extend over any region of space, and the binning is distributed over threads.",
+        "",
+        "With [TT]-scale[tt] the coordinates of each frame are scaled from the box of the frame",
+        "to the box of the first frame before binning. For a constant-pressure trajectory",
+        "this bins on fractional coordinates, so the bins follow the box fluctuations."
     };
-
     static gmx_bool   bPBC         = FALSE;
     static int        iIGNOREOUTER = -1;   /*Positive values may help if the surface is spikey */
-    static gmx_bool   bCUTDOWN     = TRUE;
     static real       rBINWIDTH    = 0.05; /* nm */
     static gmx_bool   bCALCDIV     = TRUE;
     static int        iNAB         = 4;
+    static gmx_bool   bScale       = FALSE;
 
     t_pargs           pa[] = {
         { "-pbc",      FALSE, etBOOL, {&bPBC},
@@ -120,24 +300,21 @@ int gmx_spatial(int argc, char *argv[])
           "Calculate and apply the divisor for bin occupancies based on atoms/minimal cube size. Set as TRUE for visualization and as FALSE ([TT]-nodiv[tt]) to get accurate counts per frame" },
         { "-ign",      FALSE, etINT, {&iIGNOREOUTER},
           "Do not display this number of outer cubes (positive values may reduce boundary speckles; -1 ensures outer surface is visible)" },
-        /*    { "-cut",      bCUTDOWN, etBOOL, {&bCUTDOWN},*/
-        /*      "Display a total cube that is of minimal size" }, */
         { "-bin",      FALSE, etREAL, {&rBINWIDTH},
           "Width of the bins (nm)" },
+        { "-scale",    FALSE, etBOOL, {&bScale},
+          "Scale the coordinates of each frame to the box of the first frame" },
         { "-nab",      FALSE, etINT, {&iNAB},
-          "Number of additional bins to ensure proper memory allocation" }
+          "[HIDDEN]Number of additional bins, no longer used since memory for bins is allocated as needed" }
     };
 
-    double            MINBIN[3];
-    double            MAXBIN[3];
     t_topology        top;
     int               ePBC;
     t_trxframe        fr;
     rvec             *xtop;
-    matrix            box, box_pbc;
+    matrix            box;
     t_trxstatus      *status;
     int               flags = TRX_READ_X;
-    t_pbc             pbc;
     t_atoms          *atoms;
     int               natoms;
     char             *grpnm, *grpnmp;
@@ -145,12 +322,14 @@ int gmx_spatial(int argc, char *argv[])
     int               i, nidx, nidxp;
     int               v;
     int               j, k;
-    int            ***bin = nullptr;
-    int               nbin[3];
+    int               nthreads;
+    gmx_bool          bHaveFrame;
+    matrix            boxRef, invBox, scaling;
+    ivec              lo, hi;
     FILE             *flp;
-    int               x, y, z, minx, miny, minz, maxx, maxy, maxz;
     int               numfr, numcu;
-    int               tot, maxval, minval;
+    int64_t           tot;
+    int               maxval, minval;
     double            norm;
     gmx_output_env_t *oenv;
     gmx_rmpbc_t       gpbc = nullptr;
@@ -158,7 +337,9 @@ int gmx_spatial(int argc, char *argv[])
     t_filenm          fnm[] = {
         { efTPS,  nullptr,  nullptr, ffREAD }, /* this is for the topology */
         { efTRX, "-f", nullptr, ffREAD },      /* and this for the trajectory */
-        { efNDX, nullptr, nullptr, ffOPTRD }
+        { efNDX, nullptr, nullptr, ffOPTRD },
+        { efCUB, "-o", "grid", ffWRITE },
+        { efMRC, "-mrc", "grid", ffOPTWR }
     };
 
 #define NFILE asize(fnm)
@@ -166,7 +347,7 @@ int gmx_spatial(int argc, char *argv[])
     /* This is the routine responsible for adding default options,
      * calling the X/motif interface, etc. */
     if (!parse_common_args(&argc, argv, PCA_CAN_TIME | PCA_CAN_VIEW,
-                           NFILE, fnm, asize(pa), pa, asize(desc), desc, asize(bugs), bugs, &oenv))
+                           NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, nullptr, &oenv))
     {
         return 0;
     }
@@ -184,140 +365,124 @@ int gmx_spatial(int argc, char *argv[])
     read_first_frame(oenv, &status, ftp2fn(efTRX, NFILE, fnm), &fr, flags);
     natoms = fr.natoms;
 
-    /* Memory Allocation */
-    MINBIN[XX] = MAXBIN[XX] = fr.x[0][XX];
-    MINBIN[YY] = MAXBIN[YY] = fr.x[0][YY];
-    MINBIN[ZZ] = MAXBIN[ZZ] = fr.x[0][ZZ];
-    for (i = 1; i < top.atoms.nr; ++i)
-    {
-        if (fr.x[i][XX] < MINBIN[XX])
-        {
-            MINBIN[XX] = fr.x[i][XX];
-        }
-        if (fr.x[i][XX] > MAXBIN[XX])
-        {
-            MAXBIN[XX] = fr.x[i][XX];
-        }
-        if (fr.x[i][YY] < MINBIN[YY])
-        {
-            MINBIN[YY] = fr.x[i][YY];
-        }
-        if (fr.x[i][YY] > MAXBIN[YY])
-        {
-            MAXBIN[YY] = fr.x[i][YY];
-        }
-        if (fr.x[i][ZZ] < MINBIN[ZZ])
-        {
-            MINBIN[ZZ] = fr.x[i][ZZ];
-        }
-        if (fr.x[i][ZZ] > MAXBIN[ZZ])
-        {
-            MAXBIN[ZZ] = fr.x[i][ZZ];
-        }
-    }
-    for (i = ZZ; i >= XX; --i)
-    {
-        MAXBIN[i]  = (std::ceil((MAXBIN[i]-MINBIN[i])/rBINWIDTH)+iNAB)*rBINWIDTH+MINBIN[i];
-        MINBIN[i] -= iNAB*rBINWIDTH;
-        nbin[i]    = static_cast<int>(std::ceil((MAXBIN[i]-MINBIN[i])/rBINWIDTH));
-    }
-    snew(bin, nbin[XX]);
-    for (i = 0; i < nbin[XX]; ++i)
+    /* Each thread bins its share of the atoms in its own grid,
+     * the grids are only merged at the end.
+     */
+    nthreads = gmx_omp_get_max_threads();
+    std::vector<SparseBinGrid> threadGrid(nthreads);
+    numfr = 0;
+
+    if (bScale)
     {
-        snew(bin[i], nbin[YY]);
-        for (j = 0; j < nbin[YY]; ++j)
+        if (det(fr.box) == 0)
         {
-            snew(bin[i][j], nbin[ZZ]);
+            gmx_fatal(FARGS, "Scaling the coordinates with -scale requires a box in the trajectory");
         }
+        copy_mat(fr.box, boxRef);
     }
-    copy_mat(box, box_pbc);
-    numfr = 0;
-    minx  = miny = minz = 999;
-    maxx  = maxy = maxz = 0;
-
     if (bPBC)
     {
         gpbc = gmx_rmpbc_init(&top.idef, ePBC, natoms);
     }
-    /* This is the main loop over frames */
-    do
-    {
-        /* Must init pbc every step because of pressure coupling */
-
-        copy_mat(box, box_pbc);
-        if (bPBC)
-        {
-            gmx_rmpbc_trxfr(gpbc, &fr);
-            set_pbc(&pbc, ePBC, box_pbc);
-        }
-
-        for (i = 0; i < nidx; i++)
+    /* Prepares the coordinates of the frame that was just read for binning */
+    auto prepareFrame = [&]()
         {
-            if (fr.x[index[i]][XX] < MINBIN[XX] || fr.x[index[i]][XX] > MAXBIN[XX] ||
-                fr.x[index[i]][YY] < MINBIN[YY] || fr.x[index[i]][YY] > MAXBIN[YY] ||
-                fr.x[index[i]][ZZ] < MINBIN[ZZ] || fr.x[index[i]][ZZ] > MAXBIN[ZZ])
+            if (bPBC)
             {
-                printf("There was an item outside of the allocated memory. Increase the value given with the -nab option.\n");
-                printf("Memory was allocated for [%f,%f,%f]\tto\t[%f,%f,%f]\n", MINBIN[XX], MINBIN[YY], MINBIN[ZZ], MAXBIN[XX], MAXBIN[YY], MAXBIN[ZZ]);
-                printf("Memory was required for [%f,%f,%f]\n", fr.x[index[i]][XX], fr.x[index[i]][YY], fr.x[index[i]][ZZ]);
-                exit(1);
+                gmx_rmpbc_trxfr(gpbc, &fr);
             }
-            x = static_cast<int>(std::ceil((fr.x[index[i]][XX]-MINBIN[XX])/rBINWIDTH));
-            y = static_cast<int>(std::ceil((fr.x[index[i]][YY]-MINBIN[YY])/rBINWIDTH));
-            z = static_cast<int>(std::ceil((fr.x[index[i]][ZZ]-MINBIN[ZZ])/rBINWIDTH));
-            ++bin[x][y][z];
-            if (x < minx)
+            if (bScale)
             {
-                minx = x;
+                /* Transform to fractional coordinates and back with the reference box */
+                gmx::invertBoxMatrix(fr.box, invBox);
+                mmul_ur0(invBox, boxRef, scaling);
             }
-            if (x > maxx)
-            {
-                maxx = x;
-            }
-            if (y < miny)
-            {
-                miny = y;
-            }
-            if (y > maxy)
-            {
-                maxy = y;
-            }
-            if (z < minz)
-            {
-                minz = z;
-            }
-            if (z > maxz)
+        };
+    prepareFrame();
+
+    /* This is the main loop over frames. It runs in a single parallel
+     * region, the master thread reads the frames and all threads bin
+     * their share of the atoms of each frame.
+     */
+    bHaveFrame = TRUE;
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            const int th    = gmx_omp_get_thread_num();
+            const int start = static_cast<int>((static_cast<int64_t>(nidx)*th)/nthreads);
+            const int end   = static_cast<int>((static_cast<int64_t>(nidx)*(th + 1))/nthreads);
+
+            while (bHaveFrame)
             {
-                maxz = z;
+                for (int a = start; a < end; a++)
+                {
+                    rvec x;
+                    ivec bin;
+
+                    if (bScale)
+                    {
+                        tmvmul_ur0(scaling, fr.x[index[a]], x);
+                    }
+                    else
+                    {
+                        copy_rvec(fr.x[index[a]], x);
+                    }
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        bin[d] = static_cast<int>(std::floor(x[d]/rBINWIDTH));
+                    }
+                    threadGrid[th].add(bin);
+                }
+#pragma omp barrier
+#pragma omp master
+                {
+                    numfr++;
+                    bHaveFrame = read_next_frame(oenv, status, &fr);
+                    if (bHaveFrame)
+                    {
+                        prepareFrame();
+                    }
+                }
+#pragma omp barrier
             }
         }
-        numfr++;
-        /* printf("%f\t%f\t%f\n",box[XX][XX],box[YY][YY],box[ZZ][ZZ]); */
-
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
-    while (read_next_frame(oenv, status, &fr));
 
     if (bPBC)
     {
         gmx_rmpbc_done(gpbc);
     }
 
-    if (!bCUTDOWN)
+    SparseBinGrid &grid = threadGrid[0];
+    for (i = 1; i < nthreads; i++)
     {
-        minx = miny = minz = 0;
-        maxx = nbin[XX];
-        maxy = nbin[YY];
-        maxz = nbin[ZZ];
+        grid.merge(threadGrid[i]);
+    }
+    if (grid.empty())
+    {
+        gmx_fatal(FARGS, "No positions were binned, the SDF group is empty");
+    }
+    /* The range of bins that is written */
+    for (i = 0; i < DIM; i++)
+    {
+        lo[i] = grid.min(i) + iIGNOREOUTER;
+        hi[i] = grid.max(i) - iIGNOREOUTER;
+        if (hi[i] < lo[i])
+        {
+            gmx_fatal(FARGS, "Ignoring %d outer cubes leaves no cubes to output", iIGNOREOUTER);
+        }
     }
 
     /* OUTPUT */
-    flp = gmx_ffopen("grid.cube", "w");
+    flp = gmx_ffopen(opt2fn("-o", NFILE, fnm), "w");
     fprintf(flp, "Spatial Distribution Function\n");
     fprintf(flp, "test\n");
-    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", nidxp, (MINBIN[XX]+(minx+iIGNOREOUTER)*rBINWIDTH)*10./bohr, (MINBIN[YY]+(miny+iIGNOREOUTER)*rBINWIDTH)*10./bohr, (MINBIN[ZZ]+(minz+iIGNOREOUTER)*rBINWIDTH)*10./bohr);
-    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", maxx-minx+1-(2*iIGNOREOUTER), rBINWIDTH*10./bohr, 0., 0.);
-    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", maxy-miny+1-(2*iIGNOREOUTER), 0., rBINWIDTH*10./bohr, 0.);
-    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", maxz-minz+1-(2*iIGNOREOUTER), 0., 0., rBINWIDTH*10./bohr);
+    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", nidxp, lo[XX]*rBINWIDTH*10./bohr, lo[YY]*rBINWIDTH*10./bohr, lo[ZZ]*rBINWIDTH*10./bohr);
+    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", hi[XX]-lo[XX]+1, rBINWIDTH*10./bohr, 0., 0.);
+    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", hi[YY]-lo[YY]+1, 0., rBINWIDTH*10./bohr, 0.);
+    fprintf(flp, "%5d%12.6f%12.6f%12.6f\n", hi[ZZ]-lo[ZZ]+1, 0., 0., rBINWIDTH*10./bohr);
     for (i = 0; i < nidxp; i++)
     {
         v = 2;
@@ -344,97 +509,44 @@ int gmx_spatial(int argc, char *argv[])
         fprintf(flp, "%5d%12.6f%12.6f%12.6f%12.6f\n", v, 0., fr.x[indexp[i]][XX]*10.0/bohr, fr.x[indexp[i]][YY]*10.0/bohr, fr.x[indexp[i]][ZZ]*10.0/bohr);
     }
 
-    tot = 0;
-    for (k = 0; k < nbin[XX]; k++)
-    {
-        if (!(k < minx || k > maxx))
-        {
-            continue;
-        }
-        for (j = 0; j < nbin[YY]; j++)
-        {
-            if (!(j < miny || j > maxy))
-            {
-                continue;
-            }
-            for (i = 0; i < nbin[ZZ]; i++)
-            {
-                if (!(i < minz || i > maxz))
-                {
-                    continue;
-                }
-                if (bin[k][j][i] != 0)
-                {
-                    printf("A bin was not empty when it should have been empty. Programming error.\n");
-                    printf("bin[%d][%d][%d] was = %d\n", k, j, i, bin[k][j][i]);
-                    exit(1);
-                }
-            }
-        }
-    }
-
-    minval = 999;
+    tot    = 0;
+    minval = std::numeric_limits<int>::max();
     maxval = 0;
-    for (k = 0; k < nbin[XX]; k++)
+    for (k = lo[XX]; k <= hi[XX]; k++)
     {
-        if (k < minx+iIGNOREOUTER || k > maxx-iIGNOREOUTER)
-        {
-            continue;
-        }
-        for (j = 0; j < nbin[YY]; j++)
+        for (j = lo[YY]; j <= hi[YY]; j++)
         {
-            if (j < miny+iIGNOREOUTER || j > maxy-iIGNOREOUTER)
+            for (i = lo[ZZ]; i <= hi[ZZ]; i++)
             {
-                continue;
-            }
-            for (i = 0; i < nbin[ZZ]; i++)
-            {
-                if (i < minz+iIGNOREOUTER || i > maxz-iIGNOREOUTER)
-                {
-                    continue;
-                }
-                tot += bin[k][j][i];
-                if (bin[k][j][i] > maxval)
-                {
-                    maxval = bin[k][j][i];
-                }
-                if (bin[k][j][i] < minval)
-                {
-                    minval = bin[k][j][i];
-                }
+                const ivec bin   = { k, j, i };
+                const int  count = grid.count(bin);
+
+                tot   += count;
+                maxval = std::max(maxval, count);
+                minval = std::min(minval, count);
             }
         }
     }
 
-    numcu = (maxx-minx+1-(2*iIGNOREOUTER))*(maxy-miny+1-(2*iIGNOREOUTER))*(maxz-minz+1-(2*iIGNOREOUTER));
+    numcu = (hi[XX]-lo[XX]+1)*(hi[YY]-lo[YY]+1)*(hi[ZZ]-lo[ZZ]+1);
     if (bCALCDIV)
     {
-        norm = static_cast<double>(numcu*numfr)/tot;
+        norm = static_cast<double>(numcu)*numfr/tot;
     }
     else
     {
         norm = 1.0;
     }
 
-    for (k = 0; k < nbin[XX]; k++)
+    for (k = lo[XX]; k <= hi[XX]; k++)
     {
-        if (k < minx+iIGNOREOUTER || k > maxx-iIGNOREOUTER)
+        for (j = lo[YY]; j <= hi[YY]; j++)
         {
-            continue;
-        }
-        for (j = 0; j < nbin[YY]; j++)
-        {
-            if (j < miny+iIGNOREOUTER || j > maxy-iIGNOREOUTER)
-            {
-                continue;
-            }
-            for (i = 0; i < nbin[ZZ]; i++)
+            for (i = lo[ZZ]; i <= hi[ZZ]; i++)
             {
-                if (i < minz+iIGNOREOUTER || i > maxz-iIGNOREOUTER)
-                {
-                    continue;
-                }
-                fprintf(flp, "%12.6f ", static_cast<double>(norm*bin[k][j][i])/numfr);
+                const ivec bin = { k, j, i };
+
+                fprintf(flp, "%12.6f ", static_cast<double>(norm*grid.count(bin))/numfr);
             }
             fprintf(flp, "\n");
         }
@@ -442,6 +554,11 @@ int gmx_spatial(int argc, char *argv[])
     }
     gmx_ffclose(flp);
 
+    if (opt2bSet("-mrc", NFILE, fnm))
+    {
+        writeMrcMap(opt2fn("-mrc", NFILE, fnm), grid, lo, hi, rBINWIDTH, norm/numfr);
+    }
+
     if (bCALCDIV)
     {
         printf("Counts per frame in all %d cubes divided by %le\n", numcu, 1.0/norm);
@@ -449,7 +566,7 @@ int gmx_spatial(int argc, char *argv[])
     }
     else
     {
-        printf("grid.cube contains counts per frame in all %d cubes\n", numcu);
+        printf("%s contains counts per frame in all %d cubes\n", opt2fn("-o", NFILE, fnm), numcu);
         printf("Raw data: average %le, min %le, max %le\n", 1.0/norm, static_cast<double>(minval)/numfr, static_cast<double>(maxval)/numfr);
     }
 
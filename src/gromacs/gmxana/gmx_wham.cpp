@@ -53,6 +53,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/tpxio.h"
@@ -189,6 +190,13 @@ typedef struct
 
     /*! \brief TRUE, if any data point of the histogram is within min and max, otherwise FALSE */
     gmx_bool **bContrib;
+    /*! \brief Boltzmann factor exp(-U/kT) of the umbrella potential U in each bin
+     *
+     * Only depends on the umbrella positions and force constants, so it is
+     * constant during the WHAM iterations. Far from the umbrella center it
+     * underflows to zero, use boltzmannWeight() to multiply it with exp(z).
+     */
+    double   **boltz;
     real     **ztime;     //!< input data z(t) as a function of time. Required to compute ACTs
 
     /*! \brief average force estimated from average displacement, fAv=dzAv*k
@@ -223,6 +231,7 @@ typedef struct // NOLINT(clang-analyzer-optin.performance.Padding)
 
     gmx_bool          bInitPotByIntegration;      //!< before WHAM, guess potential by force integration. Yields 1.5 to 2 times faster convergence
     int               stepUpdateContrib;          //!< update contribution table every ... iterations. Accelerates WHAM.
+    int               nDiis;                      //!< nr of previous iterations used for DIIS extrapolation of z, 0 turns it off
     int               nCoordsel;                  //!< if >0: use only certain group in WHAM, if ==0: use all groups
     t_coordselection *coordsel;                   //!< for each tpr file: which pull coordinates to use in WHAM?
     /*!\}*/
@@ -336,6 +345,7 @@ static t_UmbrellaWindow * initUmbrellaWindows(int nwin)
         win[i].N        = win[i].Ntot = nullptr;
         win[i].g        = win[i].tau  = win[i].tausmooth = nullptr;
         win[i].bContrib = nullptr;
+        win[i].boltz    = nullptr;
         win[i].ztime    = nullptr;
         win[i].forceAv  = nullptr;
         win[i].aver     = win[i].sigma = nullptr;
@@ -371,6 +381,13 @@ static void freeUmbrellaWindows(t_UmbrellaWindow *win, int nwin)
                 sfree(win[i].bContrib[j]);
             }
         }
+        if (win[i].boltz)
+        {
+            for (j = 0; j < win[i].nPull; j++)
+            {
+                sfree(win[i].boltz[j]);
+            }
+        }
         sfree(win[i].Histo);
         sfree(win[i].cum);
         sfree(win[i].k);
@@ -382,6 +399,7 @@ static void freeUmbrellaWindows(t_UmbrellaWindow *win, int nwin)
         sfree(win[i].tau);
         sfree(win[i].tausmooth);
         sfree(win[i].bContrib);
+        sfree(win[i].boltz);
         sfree(win[i].ztime);
         sfree(win[i].forceAv);
         sfree(win[i].aver);
@@ -827,6 +845,72 @@ static double tabulated_pot(double dist, t_UmbrellaOptions *opt)
 }
 
 
+/*! \brief Returns the WHAM weight exp(-U/kT + z) from the Boltzmann factor and exp(z)
+ *
+ * A Boltzmann factor that underflowed to zero gives zero, also when exp(z)
+ * overflowed, so the product is never NaN.
+ */
+static inline double boltzmannWeight(double boltz, double expZ)
+{
+    return boltz > 0 ? boltz*expZ : 0;
+}
+
+/*! \brief
+ * Compute the Boltzmann factors of the umbrella potentials in all bins
+ *
+ * These do not change during the WHAM iterations, so computing them once
+ * saves evaluating the umbrella potential and an exponential for every
+ * window and bin in each iteration.
+ */
+static void setup_boltzmann_factors(t_UmbrellaWindow * window, int nWindows,
+                                    t_UmbrellaOptions *opt)
+{
+    double ztot      = opt->max-opt->min;
+    double ztot_half = ztot/2;
+
+    for (int i = 0; i < nWindows; ++i)
+    {
+        if (!window[i].boltz)
+        {
+            snew(window[i].boltz, window[i].nPull);
+        }
+        for (int j = 0; j < window[i].nPull; ++j)
+        {
+            if (!window[i].boltz[j])
+            {
+                snew(window[i].boltz[j], opt->bins);
+            }
+            for (int k = 0; k < opt->bins; ++k)
+            {
+                double U;
+                double temp     = (1.0*k+0.5)*opt->dz+opt->min;
+                double distance = temp - window[i].pos[j];   /* distance to umbrella center */
+                if (opt->bCycl)
+                {                                            /* in cyclic wham:             */
+                    if (distance > ztot_half)                /*    |distance| < ztot_half   */
+                    {
+                        distance -= ztot;
+                    }
+                    else if (distance < -ztot_half)
+                    {
+                        distance += ztot;
+                    }
+                }
+
+                if (!opt->bTab)
+                {
+                    U = 0.5*window[i].k[j]*gmx::square(distance);       /* harmonic potential assumed. */
+                }
+                else
+                {
+                    U = tabulated_pot(distance, opt);            /* Use tabulated potential     */
+                }
+                window[i].boltz[j][k] = std::exp(-U/(BOLTZ*opt->Temperature));
+            }
+        }
+    }
+}
+
 /*! \brief
  * Check which bins substiantially contribute (accelerates WHAM)
  *
@@ -838,7 +922,7 @@ static void setup_acc_wham(const double *profile, t_UmbrellaWindow * window, int
                            t_UmbrellaOptions *opt)
 {
     int           i, j, k, nGrptot = 0, nContrib = 0, nTot = 0;
-    double        U, min = opt->min, dz = opt->dz, temp, ztot_half, distance, ztot, contrib1, contrib2;
+    double        contrib1, contrib2, expZ;
     gmx_bool      bAnyContrib;
     static int    bFirst = 1;
     static double wham_contrib_lim;
@@ -852,9 +936,6 @@ static void setup_acc_wham(const double *profile, t_UmbrellaWindow * window, int
         wham_contrib_lim = opt->Tolerance/nGrptot;
     }
 
-    ztot      = opt->max-opt->min;
-    ztot_half = ztot/2;
-
     for (i = 0; i < nWindows; ++i)
     {
         if (!window[i].bContrib)
@@ -868,38 +949,17 @@ static void setup_acc_wham(const double *profile, t_UmbrellaWindow * window, int
                 snew(window[i].bContrib[j], opt->bins);
             }
             bAnyContrib = FALSE;
+            expZ        = std::exp(window[i].z[j]);
             for (k = 0; k < opt->bins; ++k)
             {
-                temp     = (1.0*k+0.5)*dz+min;
-                distance = temp - window[i].pos[j];   /* distance to umbrella center */
-                if (opt->bCycl)
-                {                                     /* in cyclic wham:             */
-                    if (distance > ztot_half)         /*    |distance| < ztot_half   */
-                    {
-                        distance -= ztot;
-                    }
-                    else if (distance < -ztot_half)
-                    {
-                        distance += ztot;
-                    }
-                }
                 /* Note: there are two contributions to bin k in the wham equations:
                    i)  N[j]*exp(- U/(BOLTZ*opt->Temperature) + window[i].z[j])
                    ii) exp(- U/(BOLTZ*opt->Temperature))
                    where U is the umbrella potential
                    If any of these number is larger wham_contrib_lim, I set contrib=TRUE
                  */
-
-                if (!opt->bTab)
-                {
-                    U = 0.5*window[i].k[j]*gmx::square(distance);       /* harmonic potential assumed. */
-                }
-                else
-                {
-                    U = tabulated_pot(distance, opt);            /* Use tabulated potential     */
-                }
-                contrib1                 = profile[k]*std::exp(-U/(BOLTZ*opt->Temperature));
-                contrib2                 = window[i].N[j]*std::exp(-U/(BOLTZ*opt->Temperature) + window[i].z[j]);
+                contrib1                 = profile[k]*window[i].boltz[j][k];
+                contrib2                 = window[i].N[j]*boltzmannWeight(window[i].boltz[j][k], expZ);
                 window[i].bContrib[j][k] = (contrib1 > wham_contrib_lim || contrib2 > wham_contrib_lim);
                 bAnyContrib              = bAnyContrib || window[i].bContrib[j][k];
                 if (window[i].bContrib[j][k])
@@ -938,10 +998,17 @@ static void setup_acc_wham(const double *profile, t_UmbrellaWindow * window, int
 static void calc_profile(double *profile, t_UmbrellaWindow * window, int nWindows,
                          t_UmbrellaOptions *opt, gmx_bool bExact)
 {
-    double ztot_half, ztot, min = opt->min, dz = opt->dz;
-
-    ztot      = opt->max-opt->min;
-    ztot_half = ztot/2;
+    /* z only changes between iterations, so take its exponential once per
+     * window instead of once per bin and window */
+    std::vector<double> expZ;
+    for (int j = 0; j < nWindows; ++j)
+    {
+        expZ.insert(expZ.end(), window[j].z, window[j].z + window[j].nPull);
+    }
+    for (double &e : expZ)
+    {
+        e = std::exp(e);
+    }
 
 #pragma omp parallel
     {
@@ -955,43 +1022,21 @@ static void calc_profile(double *profile, t_UmbrellaWindow * window, int nWindow
 
             for (i = i0; i < i1; ++i)
             {
-                int    j, k;
-                double num, denom, invg, temp = 0, distance, U = 0;
+                int    j, k, n = 0;
+                double num, denom, invg;
                 num = denom = 0.;
                 for (j = 0; j < nWindows; ++j)
                 {
-                    for (k = 0; k < window[j].nPull; ++k)
+                    for (k = 0; k < window[j].nPull; ++k, ++n)
                     {
                         invg = 1.0/window[j].g[k] * window[j].bsWeight[k];
-                        temp = (1.0*i+0.5)*dz+min;
                         num += invg*window[j].Histo[k][i];
 
                         if (!(bExact || window[j].bContrib[k][i]))
                         {
                             continue;
                         }
-                        distance = temp - window[j].pos[k];   /* distance to umbrella center */
-                        if (opt->bCycl)
-                        {                                     /* in cyclic wham:             */
-                            if (distance > ztot_half)         /*    |distance| < ztot_half   */
-                            {
-                                distance -= ztot;
-                            }
-                            else if (distance < -ztot_half)
-                            {
-                                distance += ztot;
-                            }
-                        }
-
-                        if (!opt->bTab)
-                        {
-                            U = 0.5*window[j].k[k]*gmx::square(distance);       /* harmonic potential assumed. */
-                        }
-                        else
-                        {
-                            U = tabulated_pot(distance, opt);            /* Use tabulated potential     */
-                        }
-                        denom += invg*window[j].N[k]*std::exp(-U/(BOLTZ*opt->Temperature) + window[j].z[k]);
+                        denom += invg*window[j].N[k]*boltzmannWeight(window[j].boltz[k][i], expZ[n]);
                     }
                 }
                 profile[i] = num/denom;
@@ -1003,14 +1048,10 @@ static void calc_profile(double *profile, t_UmbrellaWindow * window, int nWindow
 
 //! Compute the free energy offsets z (one of the two main WHAM routines)
 static double calc_z(const double * profile, t_UmbrellaWindow * window, int nWindows,
-                     t_UmbrellaOptions *opt, gmx_bool bExact)
+                     gmx_bool bExact)
 {
-    double min     = opt->min, dz = opt->dz, ztot_half, ztot;
     double maxglob = -1e20;
 
-    ztot      = opt->max-opt->min;
-    ztot_half = ztot/2;
-
 #pragma omp parallel
     {
         try
@@ -1024,7 +1065,7 @@ static double calc_z(const double * profile, t_UmbrellaWindow * window, int nWin
 
             for (i = i0; i < i1; ++i)
             {
-                double total     = 0, temp, distance, U = 0;
+                double total     = 0, temp;
                 int    j, k;
 
                 for (j = 0; j < window[i].nPull; ++j)
@@ -1036,29 +1077,7 @@ static double calc_z(const double * profile, t_UmbrellaWindow * window, int nWin
                         {
                             continue;
                         }
-                        temp     = (1.0*k+0.5)*dz+min;
-                        distance = temp - window[i].pos[j];   /* distance to umbrella center */
-                        if (opt->bCycl)
-                        {                                     /* in cyclic wham:             */
-                            if (distance > ztot_half)         /*    |distance| < ztot_half   */
-                            {
-                                distance -= ztot;
-                            }
-                            else if (distance < -ztot_half)
-                            {
-                                distance += ztot;
-                            }
-                        }
-
-                        if (!opt->bTab)
-                        {
-                            U = 0.5*window[i].k[j]*gmx::square(distance);       /* harmonic potential assumed. */
-                        }
-                        else
-                        {
-                            U = tabulated_pot(distance, opt);            /* Use tabulated potential     */
-                        }
-                        total += profile[k]*std::exp(-U/(BOLTZ*opt->Temperature));
+                        total += profile[k]*window[i].boltz[j][k];
                     }
                     /* Avoid floating point exception if window is far outside min and max */
                     if (total != 0.0)
@@ -1095,6 +1114,195 @@ static double calc_z(const double * profile, t_UmbrellaWindow * window, int nWin
     return maxglob;
 }
 
+/*! \brief
+ * DIIS (Pulay) extrapolation of the free energy offsets z
+ *
+ * The WHAM equations are solved by the fixed-point iteration z -> calc_z(calc_profile(z)),
+ * which converges slowly when neighboring umbrella windows overlap strongly.
+ * From the last few iterates and their residuals, the next offsets are extrapolated
+ * as the combination of previous iterates that minimizes the residual in the
+ * least-squares sense. This typically reduces the number of iterations by an
+ * order of magnitude, while the converged result is unchanged.
+ */
+class WhamDiis
+{
+    public:
+        //! Constructor, keeps at most \p historySize previous iterations
+        explicit WhamDiis(int historySize) : historySize_(historySize) {}
+
+        //! Forget all previous iterations, required when the WHAM equations change
+        void reset()
+        {
+            iterates_.clear();
+            residuals_.clear();
+        }
+
+        /*! \brief Replaces the offsets of \p window by the DIIS extrapolation
+         *
+         * \param[in] zOld     The offsets before the last call to calc_z()
+         * \param[in,out] window The windows with the offsets computed by calc_z()
+         * \param[in] nWindows Number of windows
+         */
+        void extrapolate(const std::vector<double> &zOld, t_UmbrellaWindow *window, int nWindows)
+        {
+            if (historySize_ <= 0)
+            {
+                return;
+            }
+
+            std::vector<double> zNew;
+            getOffsets(window, nWindows, &zNew);
+            std::vector<double> residual(zNew.size());
+            for (size_t i = 0; i < zNew.size(); i++)
+            {
+                residual[i] = zNew[i] - zOld[i];
+            }
+            iterates_.push_back(zNew);
+            residuals_.push_back(residual);
+            if (static_cast<int>(iterates_.size()) > historySize_ + 1)
+            {
+                iterates_.erase(iterates_.begin());
+                residuals_.erase(residuals_.begin());
+            }
+
+            /* Least-squares fit of the current residual by the differences of
+             * consecutive residuals, using the normal equations.
+             */
+            const int           m = static_cast<int>(residuals_.size()) - 1;
+            std::vector<double> a(m*m), b(m), gamma(m);
+            for (int i = 0; i < m; i++)
+            {
+                for (int j = 0; j <= i; j++)
+                {
+                    double dot = 0;
+                    for (size_t n = 0; n < residual.size(); n++)
+                    {
+                        dot += (residuals_[i + 1][n] - residuals_[i][n])*(residuals_[j + 1][n] - residuals_[j][n]);
+                    }
+                    a[i*m + j] = dot;
+                    a[j*m + i] = dot;
+                }
+                double dot = 0;
+                for (size_t n = 0; n < residual.size(); n++)
+                {
+                    dot += (residuals_[i + 1][n] - residuals_[i][n])*residual[n];
+                }
+                b[i] = dot;
+            }
+            if (m == 0 || !solveLinearSystem(m, a, b, &gamma))
+            {
+                /* Nothing to extrapolate from (yet), use the plain WHAM update */
+                if (m > 0)
+                {
+                    reset();
+                }
+                return;
+            }
+            for (int i = 0; i < m; i++)
+            {
+                for (size_t n = 0; n < zNew.size(); n++)
+                {
+                    zNew[n] -= gamma[i]*(iterates_[i + 1][n] - iterates_[i][n]);
+                }
+            }
+            setOffsets(zNew, window, nWindows);
+        }
+
+        //! Store the offsets of all pull coordinates of all windows in \p z
+        static void getOffsets(const t_UmbrellaWindow *window, int nWindows, std::vector<double> *z)
+        {
+            z->clear();
+            for (int i = 0; i < nWindows; ++i)
+            {
+                z->insert(z->end(), window[i].z, window[i].z + window[i].nPull);
+            }
+        }
+
+    private:
+        //! Set the offsets of all pull coordinates of all windows from \p z
+        static void setOffsets(const std::vector<double> &z, t_UmbrellaWindow *window, int nWindows)
+        {
+            int n = 0;
+            for (int i = 0; i < nWindows; ++i)
+            {
+                for (int j = 0; j < window[i].nPull; ++j)
+                {
+                    window[i].z[j] = z[n++];
+                }
+            }
+        }
+
+        /*! \brief Solves the m x m system a x = b with Gaussian elimination
+         *
+         * A small relative shift is added to the diagonal, since the residual
+         * differences become nearly linearly dependent close to convergence.
+         * Returns FALSE when the system is singular.
+         */
+        static gmx_bool solveLinearSystem(int m, std::vector<double> a, std::vector<double> b,
+                                          std::vector<double> *x)
+        {
+            double trace = 0;
+            for (int i = 0; i < m; i++)
+            {
+                trace += a[i*m + i];
+            }
+            if (!(trace > 0))
+            {
+                return FALSE;
+            }
+            for (int i = 0; i < m; i++)
+            {
+                a[i*m + i] += 1e-12*trace;
+            }
+            for (int col = 0; col < m; col++)
+            {
+                int pivot = col;
+                for (int row = col + 1; row < m; row++)
+                {
+                    if (std::abs(a[row*m + col]) > std::abs(a[pivot*m + col]))
+                    {
+                        pivot = row;
+                    }
+                }
+                if (a[pivot*m + col] == 0)
+                {
+                    return FALSE;
+                }
+                for (int j = 0; j < m; j++)
+                {
+                    std::swap(a[col*m + j], a[pivot*m + j]);
+                }
+                std::swap(b[col], b[pivot]);
+                for (int row = col + 1; row < m; row++)
+                {
+                    double f = a[row*m + col]/a[col*m + col];
+                    for (int j = col; j < m; j++)
+                    {
+                        a[row*m + j] -= f*a[col*m + j];
+                    }
+                    b[row] -= f*b[col];
+                }
+            }
+            for (int row = m - 1; row >= 0; row--)
+            {
+                double sum = b[row];
+                for (int j = row + 1; j < m; j++)
+                {
+                    sum -= a[row*m + j]*(*x)[j];
+                }
+                (*x)[row] = sum/a[row*m + row];
+            }
+            return TRUE;
+        }
+
+        //! Maximum number of previous iterations used
+        int                               historySize_;
+        //! The offsets returned by calc_z() in the previous iterations
+        std::vector<std::vector<double> > iterates_;
+        //! The changes of the offsets in calc_z() in the previous iterations
+        std::vector<std::vector<double> > residuals_;
+};
+
 //! Make PMF symmetric around 0 (useful e.g. for membranes)
 static void symmetrizeProfile(double* profile, t_UmbrellaOptions *opt)
 {
@@ -1250,6 +1458,7 @@ static void copy_pullgrp_to_synthwindow(t_UmbrellaWindow *synthWindow,
     synthWindow->z       [0] = thisWindow->z        [pullid];
     synthWindow->k       [0] = thisWindow->k        [pullid];
     synthWindow->bContrib[0] = thisWindow->bContrib [pullid];
+    synthWindow->boltz   [0] = thisWindow->boltz    [pullid];
     synthWindow->g       [0] = thisWindow->g        [pullid];
     synthWindow->bsWeight[0] = thisWindow->bsWeight [pullid];
 }
@@ -1397,6 +1606,7 @@ static void create_synthetic_histo(t_UmbrellaWindow *synthWindow, t_UmbrellaWind
     synthWindow->z       [0] = thisWindow->z[pullid];
     synthWindow->k       [0] = thisWindow->k[pullid];
     synthWindow->bContrib[0] = thisWindow->bContrib[pullid];
+    synthWindow->boltz   [0] = thisWindow->boltz[pullid];
     synthWindow->g       [0] = thisWindow->g       [pullid];
     synthWindow->bsWeight[0] = thisWindow->bsWeight[pullid];
 
@@ -1578,12 +1788,14 @@ static void do_bootstrapping(const char *fnres, const char* fnprof, const char *
                              const char *xlabel, char* ylabel, double *profile,
                              t_UmbrellaWindow * window, int nWindows, t_UmbrellaOptions *opt)
 {
-    t_UmbrellaWindow * synthWindow;
-    double            *bsProfile, *bsProfiles_av, *bsProfiles_av2, maxchange = 1e20, tmp, stddev;
-    int                i, j, *randomArray = nullptr, winid, pullid, ib;
-    int                iAllPull, nAllPull, *allPull_winId, *allPull_pullId;
-    FILE              *fp;
-    gmx_bool           bExact = FALSE;
+    t_UmbrellaWindow   * synthWindow;
+    double              *bsProfile, *bsProfiles_av, *bsProfiles_av2, maxchange = 1e20, tmp, stddev;
+    int                  i, j, *randomArray = nullptr, winid, pullid, ib;
+    int                  iAllPull, nAllPull, *allPull_winId, *allPull_pullId;
+    FILE                *fp;
+    gmx_bool             bExact = FALSE;
+    WhamDiis             diis(opt->nDiis);
+    std::vector<double> zOld;
 
     /* init random generator */
     if (opt->bsSeed == 0)
@@ -1634,6 +1846,7 @@ static void do_bootstrapping(const char *fnres, const char* fnprof, const char *
         snew(synthWindow[i].z, 1);
         snew(synthWindow[i].k, 1);
         snew(synthWindow[i].bContrib, 1);
+        snew(synthWindow[i].boltz, 1);
         snew(synthWindow[i].g, 1);
         snew(synthWindow[i].bsWeight, 1);
     }
@@ -1709,25 +1922,33 @@ static void do_bootstrapping(const char *fnres, const char* fnprof, const char *
         i         = 0;
         bExact    = FALSE;
         maxchange = 1e20;
+        diis.reset();
         std::memcpy(bsProfile, profile, opt->bins*sizeof(double)); /* use profile as guess */
         do
         {
+            if (i > 0 && maxchange >= opt->Tolerance)
+            {
+                diis.extrapolate(zOld, synthWindow, nAllPull);
+            }
             if ( (i%opt->stepUpdateContrib) == 0)
             {
                 setup_acc_wham(bsProfile, synthWindow, nAllPull, opt);
+                diis.reset();
             }
             if (maxchange < opt->Tolerance)
             {
                 bExact = TRUE;
+                diis.reset();
             }
             if (((i%opt->stepchange) == 0 || i == 1) && i != 0)
             {
                 printf("\t%4d) Maximum change %e\n", i, maxchange);
             }
             calc_profile(bsProfile, synthWindow, nAllPull, opt, bExact);
+            WhamDiis::getOffsets(synthWindow, nAllPull, &zOld);
             i++;
         }
-        while ( (maxchange = calc_z(bsProfile, synthWindow, nAllPull, opt, bExact)) > opt->Tolerance || !bExact);
+        while ( (maxchange = calc_z(bsProfile, synthWindow, nAllPull, bExact)) > opt->Tolerance || !bExact);
         printf("\tConverged in %d iterations. Final maximum change %g\n", i, maxchange);
 
         if (opt->bLog)
@@ -3089,7 +3310,7 @@ static void guessPotByIntegration(t_UmbrellaWindow *window, int nWindows, t_Umbr
     {
         pot[j] = std::exp(-pot[j]/(BOLTZ*opt->Temperature));
     }
-    calc_z(pot, window, nWindows, opt, TRUE);
+    calc_z(pot, window, nWindows, TRUE);
 
     sfree(pot);
     sfree(f);
@@ -3431,6 +3652,8 @@ int gmx_wham(int argc, char *argv[])
           "HIDDENWrite maximum change every ... (set to 1 with [TT]-v[tt])"},
         { "-updateContr", FALSE, etINT, {&opt.stepUpdateContrib},
           "HIDDENUpdate table with significan contributions to WHAM every ... iterations"},
+        { "-diis", FALSE, etINT, {&opt.nDiis},
+          "Accelerate the WHAM iterations by DIIS extrapolation from this many previous iterations (0: off)"},
     };
 
     t_filenm                 fnm[] = {
@@ -3457,6 +3680,7 @@ int gmx_wham(int argc, char *argv[])
     const char              *fnPull;
     FILE                    *histout, *profout;
     char                     xlabel[STRLEN], ylabel[256], title[256];
+    std::vector<double>      zOld;
 
     opt.bins      = 200;
     opt.verbose   = FALSE;
@@ -3493,6 +3717,7 @@ int gmx_wham(int argc, char *argv[])
     opt.acTrestart            = 1.0;
     opt.stepchange            = 100;
     opt.stepUpdateContrib     = 100;
+    opt.nDiis                 = 0;
 
     if (!parse_common_args(&argc, argv, 0,
                            NFILE, fnm, asize(pa), pa, asize(desc), desc, 0, nullptr, &opt.oenv))
@@ -3602,13 +3827,15 @@ int gmx_wham(int argc, char *argv[])
         }
         read_wham_in(opt.fnPdo, &fninPdo, &nfiles, &opt);
         printf("Found %d pdo files in %s\n", nfiles, opt.fnPdo);
-        window = initUmbrellaWindows(nfiles);
+        window      = initUmbrellaWindows(nfiles);
+        header.pcrd = nullptr;
         read_pdo_files(fninPdo, nfiles, &header, window, &opt);
     }
 
     /* It is currently assumed that all pull coordinates have the same geometry, so they also have the same coordinate units.
-       We can therefore get the units for the xlabel from the first coordinate. */
-    sprintf(xlabel, "\\xx\\f{} (%s)", header.pcrd[0].coord_unit);
+       We can therefore get the units for the xlabel from the first coordinate.
+       PDO files carry no pull coordinate information, they only contain distances. */
+    sprintf(xlabel, "\\xx\\f{} (%s)", header.pcrd != nullptr ? header.pcrd[0].coord_unit : "nm");
 
     nwins = nfiles;
 
@@ -3666,6 +3893,9 @@ int gmx_wham(int argc, char *argv[])
         averageSigma(window, nwins);
     }
 
+    /* The umbrella Boltzmann factors are used by all calc_z calls below */
+    setup_boltzmann_factors(window, nwins, &opt);
+
     /* Get initial potential by simple integration */
     if (opt.bInitPotByIntegration)
     {
@@ -3681,27 +3911,36 @@ int gmx_wham(int argc, char *argv[])
     {
         opt.stepchange = 1;
     }
+    WhamDiis diis(opt.nDiis);
     i = 0;
     do
     {
+        /* Accelerate convergence, the map changes when switching to exact or updating the contributions */
+        if (i > 0 && maxchange >= opt.Tolerance)
+        {
+            diis.extrapolate(zOld, window, nwins);
+        }
         if ( (i%opt.stepUpdateContrib) == 0)
         {
             setup_acc_wham(profile, window, nwins, &opt);
+            diis.reset();
         }
         if (maxchange < opt.Tolerance)
         {
             bExact = TRUE;
+            diis.reset();
             /* if (opt.verbose) */
             printf("Switched to exact iteration in iteration %d\n", i);
         }
         calc_profile(profile, window, nwins, &opt, bExact);
+        WhamDiis::getOffsets(window, nwins, &zOld);
         if (((i%opt.stepchange) == 0 || i == 1) && i != 0)
         {
             printf("\t%4d) Maximum change %e\n", i, maxchange);
         }
         i++;
     }
-    while ( (maxchange = calc_z(profile, window, nwins, &opt, bExact)) > opt.Tolerance || !bExact);
+    while ( (maxchange = calc_z(profile, window, nwins, bExact)) > opt.Tolerance || !bExact);
     printf("Converged in %d iterations. Final maximum change %g\n", i, maxchange);
 
     /* calc error from Kumar's formula */
@@ -39,12 +39,19 @@
 #include "config.h"
 
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/math/vec.h"
 #include "gromacs/random/threefry.h"
 #include "gromacs/random/uniformintdistribution.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
@@ -53,6 +60,18 @@
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strdb.h"
 
+using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
+
+//! Number of independent blocks for the Monte-Carlo sampling and its error estimate
+static const int c_mcNumBlocks = 16;
+
+#if GMX_SIMD_HAVE_REAL
+//! The padding of the coordinate arrays for the SIMD histogram kernel
+static const int c_simdWidth = GMX_SIMD_REAL_WIDTH;
+#else
+static const int c_simdWidth = 1;
+#endif
+
 void check_binwidth(real binwidth)
 {
     real smallest_bin = 0.1;
@@ -78,7 +97,7 @@ void check_mcover(real mcover)
     }
 }
 
-void normalize_probability(int n, double *a)
+double normalize_probability(int n, double *a)
 {
     int    i;
     double norm = 0.0;
@@ -90,6 +109,8 @@ void normalize_probability(int n, double *a)
     {
         a[i] /= norm;
     }
+
+    return norm;
 }
 
 gmx_neutron_atomic_structurefactors_t *gmx_neutronstructurefactors_init(const char *datfn)
@@ -186,6 +207,58 @@ gmx_sans_t *gmx_sans_init (const t_topology *top, gmx_neutron_atomic_structurefa
     return gsans;
 }
 
+/* Adds the contributions of the pairs of atom i with atoms 0 to i-1 to
+ * the histogram gr with maxbin+1 bins. The coordinates are stored separately
+ * per dimension, SIMD aligned, so the distances and bin indices of
+ * GMX_SIMD_REAL_WIDTH pairs are computed at once and only the histogram
+ * update is scalar. The histogram covers all pair distances, only a
+ * distance at the end of the histogram that is rounded up to the next bin
+ * is put in the last bin.
+ */
+static void add_pair_histogram_row(int           i,
+                                   const real   *xs,
+                                   const real   *ys,
+                                   const real   *zs,
+                                   const double *slength,
+                                   real          invbinwidth,
+                                   int           maxbin,
+                                   double       *gr)
+{
+    int j = 0;
+
+#if GMX_SIMD_HAVE_REAL
+    const SimdReal ix(xs[i]);
+    const SimdReal iy(ys[i]);
+    const SimdReal iz(zs[i]);
+    const SimdReal invbw(invbinwidth);
+    const SimdReal maxbinS(maxbin);
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t bin[GMX_SIMD_REAL_WIDTH];
+
+    for (; j + GMX_SIMD_REAL_WIDTH <= i; j += GMX_SIMD_REAL_WIDTH)
+    {
+        SimdReal dx  = ix - load<SimdReal>(xs + j);
+        SimdReal dy  = iy - load<SimdReal>(ys + j);
+        SimdReal dz  = iz - load<SimdReal>(zs + j);
+        SimdReal rsq = fma(dx, dx, fma(dy, dy, dz*dz));
+
+        store(bin, cvttR2I(min(sqrt(rsq)*invbw, maxbinS)));
+        for (int l = 0; l < GMX_SIMD_REAL_WIDTH; l++)
+        {
+            gr[bin[l]] += slength[i]*slength[j + l];
+        }
+    }
+#endif
+    for (; j < i; j++)
+    {
+        real dx  = xs[i] - xs[j];
+        real dy  = ys[i] - ys[j];
+        real dz  = zs[i] - zs[j];
+        real rsq = dx*dx + dy*dy + dz*dz;
+
+        gr[std::min(static_cast<int>(std::sqrt(rsq)*invbinwidth), maxbin)] += slength[i]*slength[j];
+    }
+}
+
 gmx_radial_distribution_histogram_t *calc_radial_distribution_histogram (
         gmx_sans_t        *gsans,
         rvec              *x,
@@ -201,14 +274,10 @@ gmx_radial_distribution_histogram_t *calc_radial_distribution_histogram (
     gmx_radial_distribution_histogram_t    *pr = nullptr;
     rvec                                    dist;
     double                                  rmax;
-    int                                     i, j;
-#if GMX_OPENMP
+    int                                     i, j, b;
     double                                **tgr;
-    int                                     tid;
     int                                     nthreads;
-    gmx::DefaultRandomEngine               *trng = nullptr;
-#endif
-    int64_t                                 mc  = 0, mc_max;
+    int64_t                                 mc_max;
     gmx::DefaultRandomEngine                rng(seed);
 
     /* allocate memory for pr */
@@ -225,12 +294,35 @@ gmx_radial_distribution_histogram_t *calc_radial_distribution_histogram (
 
     rmax = norm(dist);
 
+    /* Coordinates are not necessarily put in the box, so also cover the
+     * largest distance within their bounding box. Then no pair is beyond
+     * the end of the histogram and the tail of g(r) is not biased.
+     */
+    if (isize > 0)
+    {
+        rvec lo, hi;
+        copy_rvec(x[index[0]], lo);
+        copy_rvec(x[index[0]], hi);
+        for (i = 1; i < isize; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                lo[d] = std::min(lo[d], x[index[i]][d]);
+                hi[d] = std::max(hi[d], x[index[i]][d]);
+            }
+        }
+        rvec_sub(hi, lo, dist);
+        rmax = std::max(rmax, static_cast<double>(norm(dist)));
+    }
+
     pr->grn = static_cast<int>(std::floor(rmax/pr->binwidth)+1);
 
     snew(pr->gr, pr->grn);
 
     if (bMC)
     {
+        std::vector<uint64_t> blockSeed(c_mcNumBlocks);
+
         /* Special case for setting automaticaly number of mc iterations to 1% of total number of direct iterations */
         if (mcover == -1)
         {
@@ -240,66 +332,78 @@ gmx_radial_distribution_histogram_t *calc_radial_distribution_histogram (
         {
             mc_max = static_cast<int64_t>(std::floor(0.5*mcover*isize*(isize-1)));
         }
-#if GMX_OPENMP
-        nthreads = gmx_omp_get_max_threads();
-        snew(tgr, nthreads);
-        trng = new gmx::DefaultRandomEngine[nthreads];
-        for (i = 0; i < nthreads; i++)
+        /* The samples are divided over a fixed number of blocks, each with
+         * its own random stream and histogram. This makes the result
+         * independent of the number of threads and the spread over the
+         * blocks gives an estimate of the statistical error.
+         */
+        snew(tgr, c_mcNumBlocks);
+        for (b = 0; b < c_mcNumBlocks; b++)
         {
-            snew(tgr[i], pr->grn);
-            trng[i].seed(rng());
+            snew(tgr[b], pr->grn);
+            blockSeed[b] = rng();
         }
-        #pragma omp parallel shared(tgr,trng,mc) private(tid,i,j)
+        #pragma omp parallel for schedule(dynamic) private(i,j)
+        for (b = 0; b < c_mcNumBlocks; b++)
         {
-            gmx::UniformIntDistribution<int> tdist(0, isize-1);
-            tid = gmx_omp_get_thread_num();
-            /* now starting parallel threads */
-            #pragma omp for
-            for (mc = 0; mc < mc_max; mc++)
+            try
             {
-                try
+                gmx::DefaultRandomEngine         brng(blockSeed[b]);
+                gmx::UniformIntDistribution<int> bdist(0, isize-1);
+                int64_t                          nblock = (mc_max*(b + 1))/c_mcNumBlocks - (mc_max*b)/c_mcNumBlocks;
+
+                for (int64_t mc = 0; mc < nblock; mc++)
                 {
-                    i = tdist(trng[tid]); // [0,isize-1]
-                    j = tdist(trng[tid]); // [0,isize-1]
+                    i = bdist(brng); // [0,isize-1]
+                    j = bdist(brng); // [0,isize-1]
                     if (i != j)
                     {
-                        tgr[tid][static_cast<int>(std::floor(std::sqrt(distance2(x[index[i]], x[index[j]]))/binwidth))] += gsans->slength[index[i]]*gsans->slength[index[j]];
+                        /* Only rounding can give a bin beyond the end */
+                        int bin = static_cast<int>(std::floor(std::sqrt(distance2(x[index[i]], x[index[j]]))/binwidth));
+                        tgr[b][std::min(bin, pr->grn - 1)] += gsans->slength[index[i]]*gsans->slength[index[j]];
                     }
                 }
-                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
             }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
-        /* collecting data from threads */
+        /* collecting data from blocks, the error of the sum is the standard
+         * deviation over the blocks times the square root of the block count
+         */
+        snew(pr->grerr, pr->grn);
         for (i = 0; i < pr->grn; i++)
         {
-            for (j = 0; j < nthreads; j++)
+            double sum = 0, sum2 = 0;
+            for (b = 0; b < c_mcNumBlocks; b++)
             {
-                pr->gr[i] += tgr[j][i];
+                sum  += tgr[b][i];
+                sum2 += tgr[b][i]*tgr[b][i];
             }
+            pr->gr[i]    = sum;
+            pr->grerr[i] = std::sqrt(std::max(0.0, sum2 - sum*sum/c_mcNumBlocks)*c_mcNumBlocks/(c_mcNumBlocks - 1));
         }
-        /* freeing memory for tgr and destroying trng */
-        for (i = 0; i < nthreads; i++)
+        /* freeing memory for tgr */
+        for (b = 0; b < c_mcNumBlocks; b++)
         {
-            sfree(tgr[i]);
+            sfree(tgr[b]);
         }
         sfree(tgr);
-        delete[] trng;
-#else
-        gmx::UniformIntDistribution<int> dist(0, isize-1);
-        for (mc = 0; mc < mc_max; mc++)
-        {
-            i = dist(rng); // [0,isize-1]
-            j = dist(rng); // [0,isize-1]
-            if (i != j)
-            {
-                pr->gr[static_cast<int>(std::floor(std::sqrt(distance2(x[index[i]], x[index[j]]))/binwidth))] += gsans->slength[index[i]]*gsans->slength[index[j]];
-            }
-        }
-#endif
     }
     else
     {
-#if GMX_OPENMP
+        const int                                    npadded = ((isize + c_simdWidth - 1)/c_simdWidth)*c_simdWidth;
+        std::vector<real, gmx::AlignedAllocator<real> > xs(npadded), ys(npadded), zs(npadded);
+        std::vector<double>                          slength(isize);
+        const real                                   invbinwidth = 1/binwidth;
+
+        /* gather the coordinates of the group in SIMD friendly layout */
+        for (i = 0; i < isize; i++)
+        {
+            xs[i]      = x[index[i]][XX];
+            ys[i]      = x[index[i]][YY];
+            zs[i]      = x[index[i]][ZZ];
+            slength[i] = gsans->slength[index[i]];
+        }
+
         nthreads = gmx_omp_get_max_threads();
         /* Allocating memory for tgr arrays */
         snew(tgr, nthreads);
@@ -307,19 +411,16 @@ gmx_radial_distribution_histogram_t *calc_radial_distribution_histogram (
         {
             snew(tgr[i], pr->grn);
         }
-        #pragma omp parallel shared(tgr) private(tid,i,j)
+        #pragma omp parallel shared(tgr) private(i)
         {
-            tid = gmx_omp_get_thread_num();
-            /* starting parallel threads */
-            #pragma omp for
+            int tid = gmx_omp_get_thread_num();
+            /* The cost of row i is proportional to i, so we balance the load dynamically */
+            #pragma omp for schedule(dynamic, 64)
             for (i = 0; i < isize; i++)
             {
                 try
                 {
-                    for (j = 0; j < i; j++)
-                    {
-                        tgr[tid][static_cast<int>(std::floor(std::sqrt(distance2(x[index[i]], x[index[j]]))/binwidth))] += gsans->slength[index[i]]*gsans->slength[index[j]];
-                    }
+                    add_pair_histogram_row(i, xs.data(), ys.data(), zs.data(), slength.data(), invbinwidth, pr->grn - 1, tgr[tid]);
                 }
                 GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
             }
@@ -338,21 +439,19 @@ gmx_radial_distribution_histogram_t *calc_radial_distribution_histogram (
             sfree(tgr[i]);
         }
         sfree(tgr);
-#else
-        for (i = 0; i < isize; i++)
-        {
-            for (j = 0; j < i; j++)
-            {
-                pr->gr[static_cast<int>(std::floor(std::sqrt(distance2(x[index[i]], x[index[j]]))/binwidth))] += gsans->slength[index[i]]*gsans->slength[index[j]];
-            }
-        }
-#endif
     }
 
     /* normalize if needed */
     if (bNORM)
     {
-        normalize_probability(pr->grn, pr->gr);
+        double norm = normalize_probability(pr->grn, pr->gr);
+        if (pr->grerr != nullptr)
+        {
+            for (i = 0; i < pr->grn; i++)
+            {
+                pr->grerr[i] /= norm;
+            }
+        }
     }
 
     snew(pr->r, pr->grn);
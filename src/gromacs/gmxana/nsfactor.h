@@ -59,6 +59,7 @@ typedef struct gmx_radial_distribution_histogram_t {
     double  binwidth; /* bin size */
     double *r;        /* Distances */
     double *gr;       /* Probability */
+    double *grerr;    /* Statistical error of gr, only for Monte-Carlo */
 } gmx_radial_distribution_histogram_t;
 
 typedef struct gmx_static_structurefactor_t {
@@ -72,7 +73,8 @@ void check_binwidth(real binwidth);
 
 void check_mcover(real mcover);
 
-void normalize_probability(int n, double *a);
+/* Normalizes a to unit sum, returns the original sum */
+double normalize_probability(int n, double *a);
 
 gmx_neutron_atomic_structurefactors_t *gmx_neutronstructurefactors_init(const char *datfn);
 
@@ -42,6 +42,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
@@ -50,16 +51,30 @@
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strdb.h"
 
+using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
+
+#if GMX_SIMD_HAVE_REAL
+//! The padding of the per atom type coordinate arrays for SIMD
+static const int c_simdWidth = GMX_SIMD_REAL_WIDTH;
+#else
+static const int c_simdWidth = 1;
+#endif
+
 
 typedef struct gmx_structurefactors {
     int    nratoms;
@@ -159,6 +174,48 @@ extern t_complex *** rc_tensor_allocation(int x, int y, int z)
 }
 
 
+/* Returns in sumCos and sumSin the weighted sums of cos(k.x) and sin(k.x)
+ * over the atoms start to end of the coordinate arrays, which are SIMD
+ * aligned and padded with zero weight atoms.
+ */
+static void sum_phase_factors(real kx, real ky, real kz,
+                              const real *xs, const real *ys, const real *zs,
+                              const real *ws, int start, int end,
+                              real *sumCos, real *sumSin)
+{
+#if GMX_SIMD_HAVE_REAL
+    const SimdReal kxS(kx);
+    const SimdReal kyS(ky);
+    const SimdReal kzS(kz);
+    SimdReal       sumCosS = setZero();
+    SimdReal       sumSinS = setZero();
+
+    for (int p = start; p < end; p += GMX_SIMD_REAL_WIDTH)
+    {
+        SimdReal kdotx = fma(kxS, load<SimdReal>(xs + p),
+                             fma(kyS, load<SimdReal>(ys + p), kzS*load<SimdReal>(zs + p)));
+        SimdReal w     = load<SimdReal>(ws + p);
+        SimdReal sinv, cosv;
+
+        sincos(kdotx, &sinv, &cosv);
+        sumCosS = fma(w, cosv, sumCosS);
+        sumSinS = fma(w, sinv, sumSinS);
+    }
+    *sumCos = reduce(sumCosS);
+    *sumSin = reduce(sumSinS);
+#else
+    *sumCos = 0;
+    *sumSin = 0;
+    for (int p = start; p < end; p++)
+    {
+        real kdotx = kx*xs[p] + ky*ys[p] + kz*zs[p];
+
+        *sumCos += ws[p]*std::cos(kdotx);
+        *sumSin += ws[p]*std::sin(kdotx);
+    }
+#endif
+}
+
 extern void compute_structure_factor (structure_factor_t * sft, matrix box,
                                       reduced_atom_t * red, int isize, real start_q,
                                       real end_q, int group, real **sf_table)
@@ -168,8 +225,9 @@ extern void compute_structure_factor (structure_factor_t * sft, matrix box,
 
     t_complex      ***tmpSF;
     rvec              k_factor;
-    real              kdotx, asf, kx, ky, kz, krr;
-    int               kr, maxkx, maxky, maxkz, i, j, k, p, *counter;
+    real              kx, ky, kz, krr;
+    int               kr, maxkx, maxky, maxkz, i, j, k, p, t, *counter;
+    int               nDone;
 
 
     k_factor[XX] = 2 * M_PI / box[XX][XX];
@@ -183,16 +241,43 @@ extern void compute_structure_factor (structure_factor_t * sft, matrix box,
     snew (counter, sf->n_angles);
 
     tmpSF = rc_tensor_allocation(maxkx, maxky, maxkz);
+
 /*
- * The big loop...
- * compute real and imaginary part of the structure factor for every
- * (kx,ky,kz))
+ * The atomic scattering factor only depends on the atom type and |k|,
+ * so we sum the phase factors per atom type and apply the scattering
+ * factor once per type. The atoms of each type are stored starting at
+ * a SIMD aligned offset, padded with zero weight atoms.
  */
-    fprintf(stderr, "\n");
+    std::vector<int> types;
+    std::vector<int> typeStart;
+    for (p = 0; p < isize; p++)
+    {
+        if (std::find(types.begin(), types.end(), redt[p].t) == types.end())
+        {
+            types.push_back(redt[p].t);
+        }
+    }
+    typeStart.resize(types.size() + 1, 0);
+    for (t = 0; t < static_cast<int>(types.size()); t++)
+    {
+        int n = std::count_if(redt, redt + isize, [&](const reduced_atom &atom) { return atom.t == types[t]; });
+        typeStart[t + 1] = typeStart[t] + ((n + c_simdWidth - 1)/c_simdWidth)*c_simdWidth;
+    }
+    std::vector<real, gmx::AlignedAllocator<real> > xs(typeStart.back()), ys(typeStart.back()), zs(typeStart.back()), ws(typeStart.back());
+    std::vector<int> fill(typeStart.begin(), typeStart.end() - 1);
+    for (p = 0; p < isize; p++)
+    {
+        t      = std::find(types.begin(), types.end(), redt[p].t) - types.begin();
+        i      = fill[t]++;
+        xs[i]  = redt[p].x[XX];
+        ys[i]  = redt[p].x[YY];
+        zs[i]  = redt[p].x[ZZ];
+        ws[i]  = 1;
+    }
+
+/* count the k-vectors per bin, will be used for the computation of the average */
     for (i = 0; i < maxkx; i++)
     {
-        fprintf (stderr, "\rdone %3.1f%%     ", (100.0*(i+1))/maxkx);
-        fflush(stderr);
         kx = i * k_factor[XX];
         for (j = 0; j < maxky; j++)
         {
@@ -208,23 +293,70 @@ extern void compute_structure_factor (structure_factor_t * sft, matrix box,
                         kr = gmx::roundToInt(krr/sf->ref_k);
                         if (kr < sf->n_angles)
                         {
-                            counter[kr]++; /* will be used for the copmutation
-                                              of the average*/
-                            for (p = 0; p < isize; p++)
-                            {
-                                asf = sf_table[redt[p].t][kr];
-
-                                kdotx = kx * redt[p].x[XX] +
-                                    ky * redt[p].x[YY] + kz * redt[p].x[ZZ];
+                            counter[kr]++;
+                        }
+                    }
+                }
+            }
+        }
+    }
 
-                                tmpSF[i][j][k].re += std::cos(kdotx) * asf;
-                                tmpSF[i][j][k].im += std::sin(kdotx) * asf;
+/*
+ * The big loop...
+ * compute real and imaginary part of the structure factor for every
+ * (kx,ky,kz)), the planes of constant kx are independent and are
+ * distributed over the threads
+ */
+    fprintf(stderr, "\n");
+    nDone = 0;
+#pragma omp parallel for schedule(dynamic) private(j, k, t, kx, ky, kz, krr, kr)
+    for (i = 0; i < maxkx; i++)
+    {
+        try
+        {
+            kx = i * k_factor[XX];
+            for (j = 0; j < maxky; j++)
+            {
+                ky = j * k_factor[YY];
+                for (k = 0; k < maxkz; k++)
+                {
+                    if (i != 0 || j != 0 || k != 0)
+                    {
+                        kz  = k * k_factor[ZZ];
+                        krr = std::sqrt (gmx::square(kx) + gmx::square(ky) + gmx::square(kz));
+                        if (krr >= start_q && krr <= end_q)
+                        {
+                            kr = gmx::roundToInt(krr/sf->ref_k);
+                            if (kr < sf->n_angles)
+                            {
+                                for (t = 0; t < static_cast<int>(types.size()); t++)
+                                {
+                                    real asf = sf_table[types[t]][kr];
+                                    real sumCos, sumSin;
+
+                                    sum_phase_factors(kx, ky, kz, xs.data(), ys.data(), zs.data(), ws.data(),
+                                                      typeStart[t], typeStart[t + 1], &sumCos, &sumSin);
+                                    tmpSF[i][j][k].re += sumCos * asf;
+                                    tmpSF[i][j][k].im += sumSin * asf;
+                                }
                             }
                         }
                     }
                 }
             }
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+
+#pragma omp atomic
+        nDone++;
+        if (gmx_omp_get_thread_num() == 0)
+        {
+            int nDoneNow;
+#pragma omp atomic read
+            nDoneNow = nDone;
+            fprintf (stderr, "\rdone %3.1f%%     ", (100.0*nDoneNow)/maxkx);
+            fflush(stderr);
+        }
     }               /* end loop on i */
 /*
  *  compute the square modulus of the structure factor, averaging on the surface
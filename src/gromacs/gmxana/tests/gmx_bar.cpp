@@ -0,0 +1,156 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019 by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx bar.
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/random/normaldistribution.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::XvgMatch;
+
+class BarTest : public gmx::test::CommandLineTestBase
+{
+    public:
+        /*! \brief Writes dhdl.xvg files for a harmonic oscillator
+         *
+         * The force constant changes linearly from 100 to 400 kJ/mol/nm^2
+         * over the lambda states, so the exact free-energy difference is
+         * kT/2 ln 4. All files contain the energy differences to all states,
+         * as written with calc-lambda-neighbors = -1. Returns the file names.
+         */
+        std::vector<std::string> writeDhdlFiles(const std::vector<double> &lambdas)
+        {
+            const double                    kT          = 2.494339;
+            const double                    forceConst0 = 100;
+            const double                    forceConst1 = 400;
+            const int                       numSamples  = 5000;
+            std::vector<std::string>        fileNames;
+            gmx::DefaultRandomEngine        rng(1234);
+            gmx::NormalDistribution<double> normalDist;
+
+            for (size_t i = 0; i < lambdas.size(); i++)
+            {
+                const double forceConst = forceConst0 + lambdas[i]*(forceConst1 - forceConst0);
+                std::string  fileName   =
+                    fileManager().getTemporaryFilePath(gmx::formatString("dhdl%zu.xvg", i));
+                FILE        *fp = fopen(fileName.c_str(), "w");
+                fprintf(fp, "@ subtitle \"T = 300 (K) \\xl\\f{} state %zu: fep-lambda = %.4f\"\n",
+                        i, lambdas[i]);
+                fprintf(fp, "@ s0 legend \"dH/d\\xl\\f{} fep-lambda = %.4f\"\n", lambdas[i]);
+                for (size_t j = 0; j < lambdas.size(); j++)
+                {
+                    fprintf(fp, "@ s%zu legend \"\\xD\\f{}H \\xl\\f{} to %.4f\"\n", j + 1, lambdas[j]);
+                }
+                for (int n = 0; n < numSamples; n++)
+                {
+                    const double x2 = kT/forceConst*gmx::square(normalDist(rng));
+                    fprintf(fp, "%.4f %.5f", 0.01*n, 0.5*(forceConst1 - forceConst0)*x2);
+                    for (size_t j = 0; j < lambdas.size(); j++)
+                    {
+                        const double otherForceConst =
+                            forceConst0 + lambdas[j]*(forceConst1 - forceConst0);
+                        fprintf(fp, " %.5f", 0.5*(otherForceConst - forceConst)*x2);
+                    }
+                    fprintf(fp, "\n");
+                }
+                fclose(fp);
+                fileNames.push_back(fileName);
+            }
+
+            return fileNames;
+        }
+};
+
+TEST_F(BarTest, MbarAgreesWithBar)
+{
+    std::vector<std::string> dhdlFiles = writeDhdlFiles({ 0.0, 0.25, 0.5, 0.75, 1.0 });
+    std::string              barFile   = fileManager().getTemporaryFilePath("bar.xvg");
+    const char *const        cmdline[] = {
+        "bar", "-mbar", "-prec", "4"
+    };
+    CommandLine              caller(cmdline);
+    caller.append("-f");
+    for (const auto &fileName : dhdlFiles)
+    {
+        caller.append(fileName);
+    }
+    caller.addOption("-o", barFile);
+    setOutputFile("-ombar", "mbar.xvg",
+                  XvgMatch().tolerance(gmx::test::absoluteTolerance(1e-3)));
+    CommandLine             &args = commandLine();
+    args.merge(caller);
+    ASSERT_EQ(0, gmx_bar(args.argc(), args.argv()));
+    checkOutputFiles();
+
+    std::vector<double> bar  = gmx::test::readXvgColumn(barFile, 1);
+    std::vector<double> mbar =
+        gmx::test::readXvgColumn(fileManager().getTemporaryFilePath("mbar.xvg"), 1);
+    ASSERT_EQ(bar.size(), mbar.size());
+    double              barTotal  = 0;
+    double              mbarTotal = 0;
+    for (size_t i = 0; i < bar.size(); i++)
+    {
+        EXPECT_NEAR(bar[i], mbar[i], 0.01) << "for interval " << i;
+        barTotal  += bar[i];
+        mbarTotal += mbar[i];
+    }
+    // The exact result is ln(4)/2 = 0.693 kT
+    EXPECT_NEAR(0.5*std::log(4.0), mbarTotal, 0.02);
+    EXPECT_NEAR(barTotal, mbarTotal, 0.01);
+}
+
+} // namespace
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019 by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests for gmx hbond.
+ */
+
+#include "gmxpre.h"
+
+#include <cstdio>
+
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/gmxpreprocess/grompp.h"
+#include "gromacs/utility/path.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::StdioTestHelper;
+using gmx::test::XvgMatch;
+
+class HbondTest : public gmx::test::CommandLineTestBase
+{
+    public:
+        void runTest(const CommandLine &args)
+        {
+            std::string tpr    = fileManager().getTemporaryFilePath(".tpr");
+            std::string mdp    = fileManager().getTemporaryFilePath(".mdp");
+            std::string mdpOut = fileManager().getTemporaryFilePath("mdout.mdp");
+            FILE       *fp     = fopen(mdp.c_str(), "w");
+            fprintf(fp, "cutoff-scheme = verlet\n");
+            fprintf(fp, "rcoulomb      = 0.85\n");
+            fprintf(fp, "rvdw          = 0.85\n");
+            fprintf(fp, "rlist         = 0.85\n");
+            fclose(fp);
+
+            // Prepare a .tpr file
+            {
+                CommandLine caller;
+                auto        simDB = gmx::test::TestFileManager::getTestSimulationDatabaseDirectory();
+                auto        base  = gmx::Path::join(simDB, "spc2");
+                caller.append("grompp");
+                caller.addOption("-maxwarn", 0);
+                caller.addOption("-f", mdp.c_str());
+                std::string gro = (base + ".gro");
+                caller.addOption("-c", gro.c_str());
+                std::string top = (base + ".top");
+                caller.addOption("-p", top.c_str());
+                caller.addOption("-o", tpr.c_str());
+                caller.addOption("-po", mdpOut.c_str());
+                ASSERT_EQ(0, gmx_grompp(caller.argc(), caller.argv()));
+            }
+            // Run the hydrogen bond analysis
+            {
+                StdioTestHelper stdioHelper(&fileManager());
+                stdioHelper.redirectStringToStdin("0 0\n");
+
+                setInputFile("-f", "hbond_life.gro");
+                setOutputFile("-num", "hbnum.xvg", XvgMatch());
+                CommandLine &cmdline = commandLine();
+                cmdline.merge(args);
+                cmdline.addOption("-s", tpr.c_str());
+                ASSERT_EQ(0, gmx_hbond(cmdline.argc(), cmdline.argv()));
+                checkOutputFiles();
+            }
+        }
+};
+
+/* hbond_life.gro has two waters with one hydrogen bond in frames 0-2
+ * and 4, and none in frame 3. Only the first lifetime, of three frames,
+ * ends within the trajectory, the bond still present in the last frame
+ * should not contribute to the lifetime distribution.
+ */
+TEST_F(HbondTest, LifetimeIgnoresBondsPresentAtTheEnd)
+{
+    setOutputFile("-life", "hblife.xvg", XvgMatch());
+    const char *const cmdline[] = {
+        "hbond"
+    };
+    runTest(CommandLine(cmdline));
+}
+
+} // namespace
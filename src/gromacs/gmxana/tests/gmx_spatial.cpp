@@ -0,0 +1,183 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019 by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx spatial.
+ */
+
+#include "gmxpre.h"
+
+#include <cstdio>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "gromacs/fileio/mrcdensitymapheader.h"
+#include "gromacs/fileio/mrcserializer.h"
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/utility/inmemoryserializer.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/textblockmatchers.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::ExactTextMatch;
+using gmx::test::StdioTestHelper;
+
+//! Returns the densities in the MRC map file \p fileName, and its header in \p header
+std::vector<float> readMrcMap(const std::string &fileName, gmx::MrcDensityMapHeader *header)
+{
+    std::ifstream             stream(fileName, std::ios::binary);
+    std::vector<char>         buffer((std::istreambuf_iterator<char>(stream)),
+                                     std::istreambuf_iterator<char>());
+    gmx::InMemoryDeserializer deserializer(buffer);
+    *header = gmx::deserializeMrcDensityMapHeader(&deserializer);
+    std::vector<float>        values(header->numColumnRowSection_[XX]*
+                                     header->numColumnRowSection_[YY]*
+                                     header->numColumnRowSection_[ZZ]);
+    for (float &value : values)
+    {
+        deserializer.doFloat(&value);
+    }
+
+    return values;
+}
+
+class SpatialTest : public gmx::test::CommandLineTestBase
+{
+    public:
+        //! Runs gmx spatial with the first group for both the SDF and the output coordinates
+        void runSpatial(CommandLine *args)
+        {
+            StdioTestHelper stdioHelper(&fileManager());
+            stdioHelper.redirectStringToStdin("0\n0\n");
+            ASSERT_EQ(0, gmx_spatial(args->argc(), args->argv()));
+        }
+
+        /*! \brief Writes a .gro trajectory of two atoms in a cubic box
+         *
+         * The atoms are at the same fractional coordinates in every frame,
+         * the box edges are given by \p boxSizes. Returns the file name.
+         */
+        std::string writeScaledTrajectory(const std::string        &name,
+                                          const std::vector<double> &boxSizes)
+        {
+            const double fractions[2][DIM] = { { 0.27, 0.29, 0.31 }, { 0.72, 0.66, 0.79 } };
+            std::string  fileName          = fileManager().getTemporaryFilePath(name);
+            FILE        *fp                = fopen(fileName.c_str(), "w");
+            for (double boxSize : boxSizes)
+            {
+                fprintf(fp, "Two water oxygens in box %.3f\n", boxSize);
+                fprintf(fp, "    2\n");
+                for (int a = 0; a < 2; a++)
+                {
+                    fprintf(fp, "%5d%-5s%5s%5d%8.3f%8.3f%8.3f\n", a + 1, "SOL", "OW", a + 1,
+                            fractions[a][XX]*boxSize, fractions[a][YY]*boxSize,
+                            fractions[a][ZZ]*boxSize);
+                }
+                fprintf(fp, "%10.5f%10.5f%10.5f\n", boxSize, boxSize, boxSize);
+            }
+            fclose(fp);
+
+            return fileName;
+        }
+};
+
+TEST_F(SpatialTest, DensityOfWater)
+{
+    const char *const cmdline[] = {
+        "spatial", "-bin", "0.5"
+    };
+    CommandLine       caller(cmdline);
+    std::string       mrcFile = fileManager().getTemporaryFilePath("grid.mrc");
+    setInputFile("-s", "spc2.gro");
+    setInputFile("-f", "spc2-traj.gro");
+    setOutputFile("-o", "grid.cub", ExactTextMatch());
+    caller.addOption("-mrc", mrcFile);
+    CommandLine      &args = commandLine();
+    args.merge(caller);
+    runSpatial(&args);
+    checkOutputFiles();
+
+    gmx::MrcDensityMapHeader       header;
+    std::vector<float>             values  = readMrcMap(mrcFile, &header);
+    gmx::test::TestReferenceChecker checker = rootChecker();
+    checker.checkSequenceArray(DIM, header.columnRowSectionStart_.data(), "MapStart");
+    checker.checkSequenceArray(DIM, header.numColumnRowSection_.data(), "MapSize");
+    checker.checkSequence(values.begin(), values.end(), "MapValues");
+}
+
+TEST_F(SpatialTest, ScalingBinsFractionalCoordinates)
+{
+    // With -scale, a trajectory with a fluctuating box and fixed
+    // fractional coordinates should give the same map as its first frame.
+    std::string              trajectory = writeScaledTrajectory("npt.gro", { 2.0, 2.3, 1.8 });
+    std::string              firstFrame = writeScaledTrajectory("first.gro", { 2.0 });
+    std::vector<std::string> mrcFiles;
+    for (const std::string &frames : { trajectory, firstFrame })
+    {
+        const char *const cmdline[] = {
+            "spatial", "-bin", "0.25", "-scale", "-nodiv", "-ign", "0"
+        };
+        CommandLine       caller(cmdline);
+        mrcFiles.push_back(fileManager().getTemporaryFilePath(gmx::formatString("map%zu.mrc", mrcFiles.size())));
+        caller.addOption("-s", firstFrame);
+        caller.addOption("-f", frames);
+        caller.addOption("-o", fileManager().getTemporaryFilePath("grid.cub"));
+        caller.addOption("-mrc", mrcFiles.back());
+        runSpatial(&caller);
+    }
+
+    gmx::MrcDensityMapHeader header[2];
+    std::vector<float>       scaled    = readMrcMap(mrcFiles[0], &header[0]);
+    std::vector<float>       reference = readMrcMap(mrcFiles[1], &header[1]);
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_EQ(header[1].columnRowSectionStart_[d], header[0].columnRowSectionStart_[d]);
+        EXPECT_EQ(header[1].numColumnRowSection_[d], header[0].numColumnRowSection_[d]);
+    }
+    EXPECT_EQ(reference, scaled);
+}
+
+} // namespace
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019 by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx wham.
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/random/normaldistribution.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::XvgMatch;
+
+class WhamTest : public gmx::test::CommandLineTestBase
+{
+    public:
+        /*! \brief Writes GROMACS 3.3 style umbrella files for \p numWindows windows
+         *
+         * The windows have harmonic umbrellas with spacing 0.1 nm on top of
+         * a linear free-energy profile with a slope of 20 kJ/mol/nm at 300 K,
+         * so the sampled displacements are normally distributed around a
+         * shifted window center. Returns the name of the file listing the
+         * umbrella files, for use with -ip.
+         */
+        std::string writePdoFiles(int numWindows)
+        {
+            const double          kT          = 2.494339;
+            const double          forceConst  = 1000;
+            const double          slope       = 20;
+            const int             numSamples  = 2000;
+            std::string           listName    = fileManager().getTemporaryFilePath("pdo-files.dat");
+            FILE                 *listFile    = fopen(listName.c_str(), "w");
+            gmx::DefaultRandomEngine             rng(1234);
+            gmx::NormalDistribution<double>      normalDist(-slope/forceConst, std::sqrt(kT/forceConst));
+
+            for (int w = 0; w < numWindows; w++)
+            {
+                std::string pdoName =
+                    fileManager().getTemporaryFilePath(gmx::formatString("umbrella%d.pdo", w));
+                FILE       *fp = fopen(pdoName.c_str(), "w");
+                fprintf(fp, "# UMBRELLA      3.0\n");
+                fprintf(fp, "# Component selection: 0 0 1\n");
+                fprintf(fp, "# nSkip 1\n");
+                fprintf(fp, "# Ref. Group 'TestAtom'\n");
+                fprintf(fp, "# Nr. of pull groups 1\n");
+                fprintf(fp, "# Group 1 'GR1'  Umb. Pos. %.1f Umb. Cons. %.1f\n", 0.1*w, forceConst);
+                fprintf(fp, "#####\n");
+                for (int i = 0; i < numSamples; i++)
+                {
+                    fprintf(fp, "%.3f\t%.5f\n", 0.01*i, normalDist(rng));
+                }
+                fclose(fp);
+                fprintf(listFile, "%s\n", pdoName.c_str());
+            }
+            fclose(listFile);
+
+            return listName;
+        }
+};
+
+TEST_F(WhamTest, ProfileFromPdoFiles)
+{
+    const char *const cmdline[] = {
+        "wham", "-b", "0", "-temp", "300", "-bins", "50", "-tol", "1e-8"
+    };
+    CommandLine       caller(cmdline);
+    caller.addOption("-ip", writePdoFiles(10));
+    setOutputFile("-o", "profile.xvg",
+                  XvgMatch().tolerance(gmx::test::absoluteTolerance(1e-3)));
+    setOutputFile("-hist", "histo.xvg", XvgMatch());
+    CommandLine      &args = commandLine();
+    args.merge(caller);
+    ASSERT_EQ(0, gmx_wham(args.argc(), args.argv()));
+    checkOutputFiles();
+}
+
+TEST_F(WhamTest, DiisGivesSameProfileAsFixedPointIteration)
+{
+    std::string       pdoList = writePdoFiles(10);
+    std::string       profileNames[2];
+    for (int nDiis = 0; nDiis <= 5; nDiis += 5)
+    {
+        const char *const cmdline[] = {
+            "wham", "-b", "0", "-temp", "300", "-bins", "50", "-tol", "1e-8"
+        };
+        CommandLine       caller(cmdline);
+        std::string       suffix = gmx::formatString("diis%d", nDiis);
+        profileNames[nDiis/5]    = fileManager().getTemporaryFilePath(suffix + "-profile.xvg");
+        caller.addOption("-ip", pdoList);
+        caller.addOption("-diis", nDiis);
+        caller.addOption("-o", profileNames[nDiis/5]);
+        caller.addOption("-hist", fileManager().getTemporaryFilePath(suffix + "-histo.xvg"));
+        ASSERT_EQ(0, gmx_wham(caller.argc(), caller.argv()));
+    }
+
+    std::vector<double> fixedPoint = gmx::test::readXvgColumn(profileNames[0], 1);
+    std::vector<double> diis       = gmx::test::readXvgColumn(profileNames[1], 1);
+    ASSERT_EQ(fixedPoint.size(), diis.size());
+    for (size_t i = 0; i < fixedPoint.size(); i++)
+    {
+        EXPECT_NEAR(fixedPoint[i], diis[i], 1e-3) << "in bin " << i;
+    }
+}
+
+} // namespace
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019 by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the radial distribution histogram of gmx sans.
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/nsfactor.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+/*! \brief Frees a histogram returned by calc_radial_distribution_histogram */
+void freeHistogram(gmx_radial_distribution_histogram_t *pr)
+{
+    sfree(pr->r);
+    sfree(pr->gr);
+    sfree(pr->grerr);
+    sfree(pr);
+}
+
+class RadialDistributionHistogramTest : public ::testing::Test
+{
+    public:
+        RadialDistributionHistogramTest()
+        {
+            clear_mat(box_);
+            box_[XX][XX] = 2.0;
+            box_[YY][YY] = 2.5;
+            box_[ZZ][ZZ] = 3.0;
+            gsans_.top   = nullptr;
+        }
+
+        //! Sets up \p numAtoms atoms at random positions in the box
+        void generateAtoms(int numAtoms)
+        {
+            gmx::DefaultRandomEngine           rng(1234);
+            gmx::UniformRealDistribution<real> dist;
+
+            x_.resize(numAtoms);
+            slength_.resize(numAtoms);
+            index_.resize(numAtoms);
+            for (int i = 0; i < numAtoms; i++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    x_[i][d] = dist(rng)*box_[d][d];
+                }
+                slength_[i] = 1 + i % 3;
+                index_[i]   = i;
+            }
+            gsans_.slength = slength_.data();
+        }
+
+        matrix                 box_;
+        std::vector<gmx::RVec> x_;
+        std::vector<double>    slength_;
+        std::vector<int>       index_;
+        gmx_sans_t             gsans_;
+};
+
+TEST_F(RadialDistributionHistogramTest, DirectSumMatchesPairLoop)
+{
+    const double binwidth = 0.1;
+    generateAtoms(101);
+
+    gmx_radial_distribution_histogram_t *pr =
+        calc_radial_distribution_histogram(&gsans_, as_rvec_array(x_.data()), box_,
+                                           index_.data(), x_.size(), binwidth,
+                                           FALSE, FALSE, 0, 0);
+
+    std::vector<double> reference(pr->grn, 0.0);
+    for (size_t i = 0; i < x_.size(); i++)
+    {
+        for (size_t j = 0; j < i; j++)
+        {
+            int bin = static_cast<int>(std::sqrt(distance2(x_[i], x_[j]))/binwidth);
+            reference[bin] += slength_[i]*slength_[j];
+        }
+    }
+    for (int bin = 0; bin < pr->grn; bin++)
+    {
+        EXPECT_DOUBLE_EQ(reference[bin], pr->gr[bin]) << "in bin " << bin;
+    }
+    freeHistogram(pr);
+}
+
+TEST_F(RadialDistributionHistogramTest, PairsBeyondTheBoxDiagonalGrowTheHistogram)
+{
+    // The box diagonal is 2 nm, which would give 5 bins of 0.5 nm.
+    // Coordinates are not necessarily put in the box, here half the atoms
+    // are at 2.66 nm from the other half, so the histogram should get
+    // a sixth bin for these pairs. Use enough atoms for the SIMD code path
+    // to be used for these pairs with any SIMD width.
+    const int numAtoms = 33;
+    box_[XX][XX]       = 1.2;
+    box_[YY][YY]       = 1.6;
+    box_[ZZ][ZZ]       = 0.0;
+    x_.assign(numAtoms, {0, 0, 0});
+    slength_.assign(numAtoms, 1);
+    index_.resize(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+    {
+        if (i % 2 == 1)
+        {
+            x_[i] = {1.5, 2.2, 0};
+        }
+        index_[i] = i;
+    }
+    gsans_.slength = slength_.data();
+
+    for (gmx_bool bMC : { FALSE, TRUE })
+    {
+        gmx_radial_distribution_histogram_t *pr =
+            calc_radial_distribution_histogram(&gsans_, as_rvec_array(x_.data()), box_,
+                                               index_.data(), numAtoms, 0.5,
+                                               bMC, FALSE, 1, 1234);
+
+        ASSERT_EQ(6, pr->grn);
+        if (bMC)
+        {
+            EXPECT_LT(0, pr->gr[5]);
+        }
+        else
+        {
+            // 17 atoms at the origin and 16 away from it
+            EXPECT_EQ(17*16, pr->gr[5]);
+            EXPECT_EQ(17*16/2 + 16*15/2, pr->gr[0]);
+        }
+        for (int bin = 1; bin < 5; bin++)
+        {
+            EXPECT_EQ(0, pr->gr[bin]) << "in bin " << bin;
+        }
+        freeHistogram(pr);
+    }
+}
+
+} // namespace
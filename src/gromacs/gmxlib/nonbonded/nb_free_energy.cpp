@@ -41,8 +41,10 @@
 #include <cmath>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_free_energy_pair.h"
 #include "gromacs/gmxlib/nonbonded/nb_kernel.h"
 #include "gromacs/gmxlib/nonbonded/nonbonded.h"
 #include "gromacs/math/functions.h"
@@ -50,6 +52,7 @@
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 
 void
 gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
@@ -73,16 +76,16 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
     real          iqA, iqB;
     real          qq[NSTATES], vctot;
     int           ntiA, ntiB, tj[NSTATES];
-    real          Vvdw6, Vvdw12, vvtot;
+    real          vvtot;
     real          ix, iy, iz, fix, fiy, fiz;
     real          dx, dy, dz, rsq, rinv;
     real          c6[NSTATES], c12[NSTATES], c6grid;
     real          LFC[NSTATES], LFV[NSTATES], DLF[NSTATES];
     double        dvdl_coul, dvdl_vdw;
     real          lfac_coul[NSTATES], dlfac_coul[NSTATES], lfac_vdw[NSTATES], dlfac_vdw[NSTATES];
-    real          sigma6[NSTATES], alpha_vdw_eff, alpha_coul_eff, sigma2_def, sigma2_min;
+    real          alpha_vdw_eff, alpha_coul_eff, sigma2_def, sigma2_min;
     double        rp, rpm2, rC, rV, rinvC, rpinvC, rinvV, rpinvV; /* Needs double for sc_power==48 */
-    real          sigma2[NSTATES], sigma_pow[NSTATES];
+    real          sigma_pow[NSTATES];
     int           do_tab, tab_elemsize = 0;
     int           n0, n1C, n1V, nnn;
     real          Y, F, Fp, Geps, Heps2, epsC, eps2C, epsV, eps2V, VV, FF;
@@ -120,9 +123,8 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
     real          rcutoff_max2;
     const real *  tab_ewald_F_lj = nullptr;
     const real *  tab_ewald_V_lj = nullptr;
-    real          d, d2, sw, dsw, rinvcorr;
-    real          elec_swV3, elec_swV4, elec_swV5, elec_swF2, elec_swF3, elec_swF4;
-    real          vdw_swV3, vdw_swV4, vdw_swV5, vdw_swF2, vdw_swF3, vdw_swF4;
+    real          rinvcorr;
+    FepPotentialSwitch elecSwitch, vdwSwitch;
     gmx_bool      bConvertEwaldToCoulomb, bConvertLJEwaldToLJ6;
     gmx_bool      bComputeVdwInteraction, bComputeElecInteraction;
     const real *  ewtab = nullptr;
@@ -136,7 +138,6 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
     const real    one         = 1.0;
     const real    two         = 2.0;
     const real    six         = 6.0;
-    const real    fourtyeight = 48.0;
 
     /* Extract pointer to non-bonded interaction constants */
     const interaction_const_t *ic = fr->ic;
@@ -191,34 +192,11 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
 
     if (ic->coulomb_modifier == eintmodPOTSWITCH)
     {
-        d               = ic->rcoulomb - ic->rcoulomb_switch;
-        elec_swV3       = -10.0/(d*d*d);
-        elec_swV4       =  15.0/(d*d*d*d);
-        elec_swV5       =  -6.0/(d*d*d*d*d);
-        elec_swF2       = -30.0/(d*d*d);
-        elec_swF3       =  60.0/(d*d*d*d);
-        elec_swF4       = -30.0/(d*d*d*d*d);
+        elecSwitch      = FepPotentialSwitch(ic->rcoulomb, ic->rcoulomb_switch);
     }
-    else
-    {
-        /* Avoid warnings from stupid compilers (looking at you, Clang!) */
-        elec_swV3 = elec_swV4 = elec_swV5 = elec_swF2 = elec_swF3 = elec_swF4 = 0.0;
-    }
-
     if (ic->vdw_modifier == eintmodPOTSWITCH)
     {
-        d               = ic->rvdw - ic->rvdw_switch;
-        vdw_swV3        = -10.0/(d*d*d);
-        vdw_swV4        =  15.0/(d*d*d*d);
-        vdw_swV5        =  -6.0/(d*d*d*d*d);
-        vdw_swF2        = -30.0/(d*d*d);
-        vdw_swF3        =  60.0/(d*d*d*d);
-        vdw_swF4        = -30.0/(d*d*d*d*d);
-    }
-    else
-    {
-        /* Avoid warnings from stupid compilers (looking at you, Clang!) */
-        vdw_swV3 = vdw_swV4 = vdw_swV5 = vdw_swF2 = vdw_swF3 = vdw_swF4 = 0.0;
+        vdwSwitch       = FepPotentialSwitch(ic->rvdw, ic->rvdw_switch);
     }
 
     if (fr->cutoff_scheme == ecutsVERLET)
@@ -411,24 +389,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                 r            = 0;
             }
 
-            if (sc_r_power == six)
-            {
-                rpm2             = rsq*rsq;  /* r4 */
-                rp               = rpm2*rsq; /* r6 */
-            }
-            else if (sc_r_power == fourtyeight)
-            {
-                rp               = rsq*rsq*rsq; /* r6 */
-                rp               = rp*rp;       /* r12 */
-                rp               = rp*rp;       /* r24 */
-                rp               = rp*rp;       /* r48 */
-                rpm2             = rp/rsq;      /* r46 */
-            }
-            else
-            {
-                rp             = std::pow(r, sc_r_power);  /* not currently supported as input, but can handle it */
-                rpm2           = rp/rsq;
-            }
+            rp               = softcoreRPower(rsq, r, sc_r_power, &rpm2);
 
             Fscal = 0;
 
@@ -446,38 +407,10 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                 for (i = 0; i < NSTATES; i++)
                 {
                     c12[i]             = nbfp[tj[i]+1];
-                    if ((c6[i] > 0) && (c12[i] > 0))
-                    {
-                        /* c12 is stored scaled with 12.0 and c6 is scaled with 6.0 - correct for this */
-                        sigma6[i]       = half*c12[i]/c6[i];
-                        sigma2[i]       = std::cbrt(sigma6[i]);
-                        /* should be able to get rid of cbrt call eventually.  Will require agreement on
-                           what data to store externally.  Can't be fixed without larger scale changes, so not 4.6 */
-                        if (sigma6[i] < sigma6_min)   /* for disappearing coul and vdw with soft core at the same time */
-                        {
-                            sigma6[i] = sigma6_min;
-                            sigma2[i] = sigma2_min;
-                        }
-                    }
-                    else
-                    {
-                        sigma6[i]       = sigma6_def;
-                        sigma2[i]       = sigma2_def;
-                    }
-                    if (sc_r_power == six)
-                    {
-                        sigma_pow[i]    = sigma6[i];
-                    }
-                    else if (sc_r_power == fourtyeight)
-                    {
-                        sigma_pow[i]    = sigma6[i]*sigma6[i];       /* sigma^12 */
-                        sigma_pow[i]    = sigma_pow[i]*sigma_pow[i]; /* sigma^24 */
-                        sigma_pow[i]    = sigma_pow[i]*sigma_pow[i]; /* sigma^48 */
-                    }
-                    else
-                    {    /* not really supported as input, but in here for testing the general case*/
-                        sigma_pow[i]    = std::pow(sigma2[i], sc_r_power/2);
-                    }
+                    sigma_pow[i]       = softcoreSigmaPow(c6[i], c12[i],
+                                                          sigma6_def, sigma2_def,
+                                                          sigma6_min, sigma2_min,
+                                                          sc_r_power);
                 }
 
                 /* only use softcore if one of the states has a zero endstate - softcore is for avoiding infinities!*/
@@ -539,19 +472,15 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                             switch (icoul)
                             {
                                 case GMX_NBKERNEL_ELEC_COULOMB:
-                                    /* simple cutoff */
-                                    Vcoul[i]   = qq[i]*rinvC;
-                                    FscalC[i]  = Vcoul[i];
-                                    /* The shift for the Coulomb potential is stored in
-                                     * the RF parameter c_rf, which is 0 without shift.
+                                    /* simple cutoff, the shift for the Coulomb potential
+                                     * is stored in the RF parameter c_rf, which is 0 without shift.
                                      */
-                                    Vcoul[i]  -= qq[i]*ic->c_rf;
+                                    reactionFieldCoulomb(qq[i], rinvC, rC, zero, ic->c_rf, &Vcoul[i], &FscalC[i]);
                                     break;
 
                                 case GMX_NBKERNEL_ELEC_REACTIONFIELD:
                                     /* reaction-field */
-                                    Vcoul[i]   = qq[i]*(rinvC + krf*rC*rC-crf);
-                                    FscalC[i]  = qq[i]*(rinvC - two*krf*rC*rC);
+                                    reactionFieldCoulomb(qq[i], rinvC, rC, krf, crf, &Vcoul[i], &FscalC[i]);
                                     break;
 
                                 case GMX_NBKERNEL_ELEC_CUBICSPLINETABLE:
@@ -572,8 +501,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                                     if (bConvertEwaldToCoulomb)
                                     {
                                         /* Ewald FEP is done only on the 1/r part */
-                                        Vcoul[i]   = qq[i]*(rinvC-sh_ewald);
-                                        FscalC[i]  = qq[i]*rinvC;
+                                        ewaldCoulomb(qq[i], rinvC, sh_ewald, &Vcoul[i], &FscalC[i]);
                                     }
                                     else
                                     {
@@ -599,14 +527,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
 
                             if (ic->coulomb_modifier == eintmodPOTSWITCH)
                             {
-                                d                = rC - ic->rcoulomb_switch;
-                                d                = (d > zero) ? d : zero;
-                                d2               = d*d;
-                                sw               = one+d2*d*(elec_swV3+d*(elec_swV4+d*elec_swV5));
-                                dsw              = d2*(elec_swF2+d*(elec_swF3+d*elec_swF4));
-
-                                FscalC[i]        = FscalC[i]*sw - rC*Vcoul[i]*dsw;
-                                Vcoul[i]        *= sw;
+                                applyPotentialSwitch(elecSwitch, rC, &Vcoul[i], &FscalC[i]);
 
                                 FscalC[i]        = (rC < rcoulomb) ? FscalC[i] : zero;
                                 Vcoul[i]         = (rC < rcoulomb) ? Vcoul[i] : zero;
@@ -636,12 +557,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                                         rinv6            = rinvV*rinvV;
                                         rinv6            = rinv6*rinv6*rinv6;
                                     }
-                                    Vvdw6            = c6[i]*rinv6;
-                                    Vvdw12           = c12[i]*rinv6*rinv6;
-
-                                    Vvdw[i]          = ( (Vvdw12 - c12[i]*sh_invrc6*sh_invrc6)*onetwelfth
-                                                         - (Vvdw6 - c6[i]*sh_invrc6)*onesixth);
-                                    FscalV[i]        = Vvdw12 - Vvdw6;
+                                    lennardJones(c6[i], c12[i], zero, rinv6, sh_invrc6, zero, &Vvdw[i], &FscalV[i]);
                                     break;
 
                                 case GMX_NBKERNEL_VDW_BUCKINGHAM:
@@ -687,12 +603,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                                     if (bConvertLJEwaldToLJ6)
                                     {
                                         /* cutoff LJ */
-                                        Vvdw6            = c6[i]*rinv6;
-                                        Vvdw12           = c12[i]*rinv6*rinv6;
-
-                                        Vvdw[i]          = ( (Vvdw12 - c12[i]*sh_invrc6*sh_invrc6)*onetwelfth
-                                                             - (Vvdw6 - c6[i]*sh_invrc6 - c6grid*sh_lj_ewald)*onesixth);
-                                        FscalV[i]        = Vvdw12 - Vvdw6;
+                                        lennardJones(c6[i], c12[i], c6grid, rinv6, sh_invrc6, sh_lj_ewald, &Vvdw[i], &FscalV[i]);
                                     }
                                     else
                                     {
@@ -718,14 +629,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
 
                             if (ic->vdw_modifier == eintmodPOTSWITCH)
                             {
-                                d                = rV - ic->rvdw_switch;
-                                d                = (d > zero) ? d : zero;
-                                d2               = d*d;
-                                sw               = one+d2*d*(vdw_swV3+d*(vdw_swV4+d*vdw_swV5));
-                                dsw              = d2*(vdw_swF2+d*(vdw_swF3+d*vdw_swF4));
-
-                                FscalV[i]        = FscalV[i]*sw - rV*Vvdw[i]*dsw;
-                                Vvdw[i]         *= sw;
+                                applyPotentialSwitch(vdwSwitch, rV, &Vvdw[i], &FscalV[i]);
 
                                 FscalV[i]  = (rV < rvdw) ? FscalV[i] : zero;
                                 Vvdw[i]    = (rV < rvdw) ? Vvdw[i] : zero;
@@ -762,8 +666,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                  * The group scheme also doesn't soft-core for these.
                  * As there is no singularity, there is no need for soft-core.
                  */
-                VV = krf*rsq - crf;
-                FF = -two*krf;
+                reactionFieldExclusionCorrection(krf, crf, rsq, &VV, &FF);
 
                 if (ii == jnr)
                 {
@@ -790,13 +693,7 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                  */
                 real v_lr, f_lr;
 
-                ewrt      = r*ewtabscale;
-                ewitab    = static_cast<int>(ewrt);
-                eweps     = ewrt-ewitab;
-                ewitab    = 4*ewitab;
-                f_lr      = ewtab[ewitab]+eweps*ewtab[ewitab+1];
-                v_lr      = (ewtab[ewitab+2]-ewtabhalfspace*eweps*(ewtab[ewitab]+f_lr));
-                f_lr     *= rinv;
+                ewaldReciprocalCorrection(ewtab, ewtabscale, ewtabhalfspace, r, rinv, &v_lr, &f_lr);
 
                 /* Note that any possible Ewald shift has already been applied in
                  * the normal interaction part above.
@@ -830,22 +727,8 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
                  * the softcore to the entire VdW interaction,
                  * including the reciprocal-space component.
                  */
-                /* We could also use the analytical form here
-                 * iso a table, but that can cause issues for
-                 * r close to 0 for non-interacting pairs.
-                 */
-                real rs, frac, f_lr;
-                int  ri;
-
-                rs     = rsq*rinv*ewtabscale;
-                ri     = static_cast<int>(rs);
-                frac   = rs - ri;
-                f_lr   = (1 - frac)*tab_ewald_F_lj[ri] + frac*tab_ewald_F_lj[ri+1];
-                /* TODO: Currently the Ewald LJ table does not contain
-                 * the factor 1/6, we should add this.
-                 */
-                FF     = f_lr*rinv/six;
-                VV     = (tab_ewald_V_lj[ri] - ewtabhalfspace*frac*(tab_ewald_F_lj[ri] + f_lr))/six;
+                ljEwaldReciprocalCorrection(tab_ewald_F_lj, tab_ewald_V_lj, ewtabscale, ewtabhalfspace,
+                                            r, rinv, &VV, &FF);
 
                 if (ii == jnr)
                 {
@@ -938,3 +821,407 @@ gmx_nb_free_energy_kernel(const t_nblist * gmx_restrict    nlist,
 #pragma omp atomic
     inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri*12 + nlist->jindex[n]*150);
 }
+
+namespace
+{
+
+//! Lambda independent constants for the energy only free-energy kernel
+struct FepEnergyConstants
+{
+    bool ewaldCoulomb;    //!< Whether we use Ewald, applied to 1/r with a reciprocal-space correction
+    bool ljEwald;         //!< Whether we use LJ-PME, applied to r^-6 with a reciprocal-space correction
+    real krf;             //!< Reaction-field constant
+    real crf;             //!< Reaction-field potential shift
+    real shEwald;         //!< Ewald potential shift
+    real shInvrc6;        //!< LJ potential shift
+    real shLJEwald;       //!< LJ-PME potential shift
+    real rcoulomb;        //!< Coulomb cut-off distance
+    real rvdw;            //!< VdW cut-off distance
+    bool elecPotSwitch;   //!< Whether the Coulomb potential is switched
+    FepPotentialSwitch elecSwitch; //!< The Coulomb potential switch
+    bool vdwPotSwitch;    //!< Whether the VdW potential is switched
+    FepPotentialSwitch vdwSwitch;  //!< The VdW potential switch
+    real scRPower;        //!< The soft-core r-power
+};
+
+/*! \brief Computes the Coulomb and VdW energy of one state of a perturbed pair
+ *
+ * \p rpinvC and \p rpinvV are the inverse of the Coulomb and VdW soft-core
+ * distances to the power sc-r-power, \p r is the actual pair distance.
+ * This evaluates the same energy expressions as gmx_nb_free_energy_kernel()
+ * for the setups supported with the Verlet scheme.
+ */
+inline void
+fepStateEnergies(const FepEnergyConstants &c,
+                 real r, double rpinvC, double rpinvV,
+                 real qq, real c6, real c12, real c6grid,
+                 double *Vcoul, double *Vvdw)
+{
+    const real one = 1.0;
+    const real six = 6.0;
+    double     rF;
+
+    *Vcoul = 0;
+    *Vvdw  = 0;
+
+    if (qq != 0)
+    {
+        double rinvC = std::pow(rpinvC, one/c.scRPower);
+        double rC    = one/rinvC;
+
+        if (( c.ewaldCoulomb && r  < c.rcoulomb) ||
+            (!c.ewaldCoulomb && rC < c.rcoulomb))
+        {
+            if (c.ewaldCoulomb)
+            {
+                /* Ewald FEP is done only on the 1/r part */
+                ewaldCoulomb(qq, rinvC, c.shEwald, Vcoul, &rF);
+            }
+            else
+            {
+                reactionFieldCoulomb(qq, rinvC, rC, c.krf, c.crf, Vcoul, &rF);
+            }
+
+            if (c.elecPotSwitch)
+            {
+                applyPotentialSwitch(c.elecSwitch, rC, Vcoul, &rF);
+                *Vcoul = (rC < c.rcoulomb) ? *Vcoul : 0;
+            }
+        }
+    }
+
+    if (c6 != 0 || c12 != 0)
+    {
+        double rinvV = std::pow(rpinvV, one/c.scRPower);
+        double rV    = one/rinvV;
+
+        if (( c.ljEwald && r  < c.rvdw) ||
+            (!c.ljEwald && rV < c.rvdw))
+        {
+            real rinv6;
+            if (c.scRPower == six)
+            {
+                rinv6 = rpinvV;
+            }
+            else
+            {
+                rinv6 = rinvV*rinvV;
+                rinv6 = rinv6*rinv6*rinv6;
+            }
+            lennardJones(c6, c12, c6grid, rinv6, c.shInvrc6, c.shLJEwald, Vvdw, &rF);
+
+            if (c.vdwPotSwitch)
+            {
+                applyPotentialSwitch(c.vdwSwitch, rV, Vvdw, &rF);
+                *Vvdw = (rV < c.rvdw) ? *Vvdw : 0;
+            }
+        }
+    }
+}
+
+}   // namespace
+
+void
+gmx_nb_free_energy_foreign_lambda_kernel(const t_nblist * gmx_restrict    nlist,
+                                         const rvec * gmx_restrict        xx,
+                                         const t_forcerec * gmx_restrict  fr,
+                                         const t_mdatoms * gmx_restrict   mdatoms,
+                                         int                              numLambdas,
+                                         const real * gmx_restrict        lambdaCoul,
+                                         const real * gmx_restrict        lambdaVdw,
+                                         double * gmx_restrict            energy,
+                                         t_nrnb * gmx_restrict            nrnb)
+{
+#define  STATE_A  0
+#define  STATE_B  1
+#define  NSTATES  2
+
+    const real                 half        = 0.5;
+    const real                 one         = 1.0;
+
+    const interaction_const_t *ic = fr->ic;
+
+    GMX_RELEASE_ASSERT(fr->cutoff_scheme == ecutsVERLET, "The foreign lambda free-energy kernel only supports the Verlet scheme");
+
+    FepEnergyConstants c;
+    c.ewaldCoulomb   = EEL_PME_EWALD(ic->eeltype);
+    c.ljEwald        = EVDW_PME(ic->vdwtype);
+    if (!(ic->eeltype == eelCUT || EEL_RF(ic->eeltype) || c.ewaldCoulomb))
+    {
+        gmx_incons("Unsupported eeltype with Verlet and free-energy");
+    }
+    /* As in gmx_nb_free_energy_kernel, we need to convert Ewald to plain
+     * interactions with reciprocal-space correction, which is not
+     * implemented with potential switching.
+     */
+    if ((c.ewaldCoulomb && ic->coulomb_modifier == eintmodPOTSWITCH) ||
+        (c.ljEwald      && ic->vdw_modifier     == eintmodPOTSWITCH))
+    {
+        gmx_incons("Unimplemented non-bonded setup");
+    }
+    c.krf            = ic->k_rf;
+    c.crf            = ic->c_rf;
+    c.shEwald        = ic->sh_ewald;
+    c.shInvrc6       = ic->sh_invrc6;
+    c.shLJEwald      = c.ljEwald ? ic->sh_lj_ewald : 0;
+    c.rcoulomb       = ic->rcoulomb;
+    c.rvdw           = ic->rvdw;
+    c.elecPotSwitch  = (ic->coulomb_modifier == eintmodPOTSWITCH);
+    if (c.elecPotSwitch)
+    {
+        c.elecSwitch = FepPotentialSwitch(ic->rcoulomb, ic->rcoulomb_switch);
+    }
+    c.vdwPotSwitch   = (ic->vdw_modifier == eintmodPOTSWITCH);
+    if (c.vdwPotSwitch)
+    {
+        c.vdwSwitch  = FepPotentialSwitch(ic->rvdw, ic->rvdw_switch);
+    }
+    c.scRPower       = fr->sc_r_power;
+
+    const real  *x              = xx[0];
+    const real  *shiftvec       = fr->shift_vec[0];
+    const real  *chargeA        = mdatoms->chargeA;
+    const real  *chargeB        = mdatoms->chargeB;
+    const int   *typeA          = mdatoms->typeA;
+    const int   *typeB          = mdatoms->typeB;
+    const real  *nbfp           = fr->nbfp;
+    const real  *nbfp_grid      = fr->ljpme_c6grid;
+    const real   facel          = ic->epsfac;
+    const int    ntype          = fr->ntype;
+    const real   alpha_coul     = fr->sc_alphacoul;
+    const real   alpha_vdw      = fr->sc_alphavdw;
+    const real   lam_power      = fr->sc_power;
+    const real   sc_r_power     = fr->sc_r_power;
+    const real   sigma6_def     = fr->sc_sigma6_def;
+    const real   sigma6_min     = fr->sc_sigma6_min;
+    const real   sigma2_def     = std::cbrt(sigma6_def);
+    const real   sigma2_min     = std::cbrt(sigma6_min);
+    const real  *ewtab          = ic->tabq_coul_FDV0;
+    const real   ewtabscale     = ic->tabq_scale;
+    const real   ewtabhalfspace = half/ewtabscale;
+    const real  *tab_ewald_F_lj = ic->tabq_vdw_F;
+    const real  *tab_ewald_V_lj = ic->tabq_vdw_V;
+    real         rcutoff_max2   = std::max(ic->rcoulomb, ic->rvdw);
+    rcutoff_max2                = rcutoff_max2*rcutoff_max2;
+
+    /* The lambda factors of the states and the soft-core lambda factors,
+     * stored per state contiguously for all lambda values.
+     */
+    std::vector<real> LFC(NSTATES*numLambdas), LFV(NSTATES*numLambdas);
+    std::vector<real> lfac_coul(NSTATES*numLambdas), lfac_vdw(NSTATES*numLambdas);
+    for (int l = 0; l < numLambdas; l++)
+    {
+        LFC[STATE_A*numLambdas + l] = one - lambdaCoul[l];
+        LFV[STATE_A*numLambdas + l] = one - lambdaVdw[l];
+        LFC[STATE_B*numLambdas + l] = lambdaCoul[l];
+        LFV[STATE_B*numLambdas + l] = lambdaVdw[l];
+    }
+    for (int i = 0; i < NSTATES*numLambdas; i++)
+    {
+        lfac_coul[i] = (lam_power == 2 ? (1 - LFC[i])*(1 - LFC[i]) : (1 - LFC[i]));
+        lfac_vdw[i]  = (lam_power == 2 ? (1 - LFV[i])*(1 - LFV[i]) : (1 - LFV[i]));
+    }
+
+    /* Energies linear in lambda are summed per state over the whole list,
+     * soft-core pair energies are summed per lambda value.
+     */
+    double              linearCoul[NSTATES] = { 0 };
+    double              linearVdw[NSTATES]  = { 0 };
+    std::vector<double> softcoreEnergy(numLambdas, 0.0);
+    int                 numSoftcorePairs    = 0;
+
+    const int           nri    = nlist->nri;
+    const int          *iinr   = nlist->iinr;
+    const int          *jindex = nlist->jindex;
+    const int          *jjnr   = nlist->jjnr;
+    const int          *shift  = nlist->shift;
+
+    for (int n = 0; n < nri; n++)
+    {
+        const int  is3  = 3*shift[n];
+        const int  ii   = iinr[n];
+        const int  ii3  = 3*ii;
+        const real ix   = shiftvec[is3  ] + x[ii3  ];
+        const real iy   = shiftvec[is3+1] + x[ii3+1];
+        const real iz   = shiftvec[is3+2] + x[ii3+2];
+        const real iqA  = facel*chargeA[ii];
+        const real iqB  = facel*chargeB[ii];
+        const int  ntiA = 2*ntype*typeA[ii];
+        const int  ntiB = 2*ntype*typeB[ii];
+
+        for (int k = jindex[n]; k < jindex[n+1]; k++)
+        {
+            const int  jnr = jjnr[k];
+            const int  j3  = 3*jnr;
+            const real dx  = ix - x[j3];
+            const real dy  = iy - x[j3+1];
+            const real dz  = iz - x[j3+2];
+            const real rsq = dx*dx + dy*dy + dz*dz;
+
+            if (rsq >= rcutoff_max2)
+            {
+                continue;
+            }
+
+            real rinv, r;
+            if (rsq > 0)
+            {
+                rinv = gmx::invsqrt(rsq);
+                r    = rsq*rinv;
+            }
+            else
+            {
+                rinv = 0;
+                r    = 0;
+            }
+
+            real qq[NSTATES], c6grid[NSTATES];
+            int  tj[NSTATES];
+            qq[STATE_A] = iqA*chargeA[jnr];
+            qq[STATE_B] = iqB*chargeB[jnr];
+            tj[STATE_A] = ntiA + 2*typeA[jnr];
+            tj[STATE_B] = ntiB + 2*typeB[jnr];
+            for (int i = 0; i < NSTATES; i++)
+            {
+                c6grid[i] = (c.ljEwald ? nbfp_grid[tj[i]] : 0);
+            }
+
+            if (nlist->excl_fep == nullptr || nlist->excl_fep[k])
+            {
+                double rpm2;
+                double rp = softcoreRPower(rsq, r, sc_r_power, &rpm2);
+
+                real   c6[NSTATES], c12[NSTATES], sigma_pow[NSTATES];
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    c6[i]        = nbfp[tj[i]];
+                    c12[i]       = nbfp[tj[i]+1];
+                    sigma_pow[i] = softcoreSigmaPow(c6[i], c12[i],
+                                                    sigma6_def, sigma2_def,
+                                                    sigma6_min, sigma2_min,
+                                                    sc_r_power);
+                }
+
+                /* Soft-core is only used when one of the states has a zero endstate */
+                const bool useSoftcore = (!((c12[STATE_A] > 0) && (c12[STATE_B] > 0)) &&
+                                          (alpha_coul != 0 || alpha_vdw != 0));
+
+                if (!useSoftcore)
+                {
+                    /* The state energies do not depend on lambda */
+                    for (int i = 0; i < NSTATES; i++)
+                    {
+                        if ((qq[i] != 0) || (c6[i] != 0) || (c12[i] != 0))
+                        {
+                            double Vcoul, Vvdw;
+                            fepStateEnergies(c, r, one/rp, one/rp,
+                                             qq[i], c6[i], c12[i], c6grid[i],
+                                             &Vcoul, &Vvdw);
+                            linearCoul[i] += Vcoul;
+                            linearVdw[i]  += Vvdw;
+                        }
+                    }
+                }
+                else
+                {
+                    numSoftcorePairs++;
+
+                    for (int i = 0; i < NSTATES; i++)
+                    {
+                        if ((qq[i] != 0) || (c6[i] != 0) || (c12[i] != 0))
+                        {
+                            const real *LFCi       = LFC.data()       + i*numLambdas;
+                            const real *LFVi       = LFV.data()       + i*numLambdas;
+                            const real *lfac_couli = lfac_coul.data() + i*numLambdas;
+                            const real *lfac_vdwi  = lfac_vdw.data()  + i*numLambdas;
+
+                            /* This loop is kept scalar: the soft-core distances need
+                             * a pow() with a generic r-power, for which we have no SIMD
+                             * implementation, and sc-r-power=48 requires double precision.
+                             * The per-lambda cut-off checks would also need masking.
+                             */
+                            for (int l = 0; l < numLambdas; l++)
+                            {
+                                double rpinvC = one/(alpha_coul*lfac_couli[l]*sigma_pow[i] + rp);
+                                double rpinvV = one/(alpha_vdw*lfac_vdwi[l]*sigma_pow[i] + rp);
+                                double Vcoul, Vvdw;
+                                fepStateEnergies(c, r, rpinvC, rpinvV,
+                                                 qq[i], c6[i], c12[i], c6grid[i],
+                                                 &Vcoul, &Vvdw);
+                                softcoreEnergy[l] += LFCi[l]*Vcoul + LFVi[l]*Vvdw;
+                            }
+                        }
+                    }
+                }
+            }
+            else if (!c.ewaldCoulomb)
+            {
+                /* Excluded pairs with reaction-field, no soft-core */
+                real VV, FF;
+                reactionFieldExclusionCorrection(ic->k_rf, ic->c_rf, rsq, &VV, &FF);
+                if (ii == jnr)
+                {
+                    VV *= half;
+                }
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    linearCoul[i] += qq[i]*VV;
+                }
+            }
+
+            if (c.ewaldCoulomb && r < ic->rcoulomb)
+            {
+                /* Subtract the reciprocal-space Ewald component,
+                 * see gmx_nb_free_energy_kernel.
+                 */
+                real v_lr, f_lr;
+                ewaldReciprocalCorrection(ewtab, ewtabscale, ewtabhalfspace, r, rinv, &v_lr, &f_lr);
+                if (ii == jnr)
+                {
+                    v_lr *= half;
+                }
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    linearCoul[i] -= qq[i]*v_lr;
+                }
+            }
+
+            if (c.ljEwald && r < ic->rvdw)
+            {
+                /* Add the reciprocal-space LJ-PME component,
+                 * see gmx_nb_free_energy_kernel.
+                 */
+                real VV, f_lr;
+                ljEwaldReciprocalCorrection(tab_ewald_F_lj, tab_ewald_V_lj, ewtabscale, ewtabhalfspace,
+                                            r, rinv, &VV, &f_lr);
+                if (ii == jnr)
+                {
+                    VV *= half;
+                }
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    linearVdw[i] += c6grid[i]*VV;
+                }
+            }
+        }
+    }
+
+    for (int l = 0; l < numLambdas; l++)
+    {
+        energy[l] += softcoreEnergy[l];
+        for (int i = 0; i < NSTATES; i++)
+        {
+            energy[l] += LFC[i*numLambdas + l]*linearCoul[i] + LFV[i*numLambdas + l]*linearVdw[i];
+        }
+    }
+
+    /* Estimate flops: 12 per outer iteration, 50 per inner iteration
+     * and 100 per soft-core pair per lambda value.
+     */
+#pragma omp atomic
+    inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nri*12 + jindex[nri]*50 + numSoftcorePairs*numLambdas*100);
+
+#undef STATE_A
+#undef STATE_B
+#undef NSTATES
+}
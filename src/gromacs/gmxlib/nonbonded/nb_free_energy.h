@@ -55,4 +55,24 @@ void
                               nb_kernel_data_t * gmx_restrict  kernel_data,
                               t_nrnb * gmx_restrict            nrnb);
 
+/*! \brief Adds the energies of the perturbed pairs in \p nlist at multiple lambda values to \p energy
+ *
+ * The pair distances and all lambda independent quantities are computed
+ * only once per pair. Contributions that are linear in lambda are summed
+ * per state over the whole list, so only pairs with soft-core interactions
+ * are evaluated at each of the \p numLambdas lambda values.
+ * Only energies, summed over all energy groups, are computed.
+ * Only supports the Verlet cut-off scheme.
+ */
+void
+    gmx_nb_free_energy_foreign_lambda_kernel(const t_nblist * gmx_restrict    nlist,
+                                             const rvec * gmx_restrict        xx,
+                                             const t_forcerec * gmx_restrict  fr,
+                                             const t_mdatoms * gmx_restrict   mdatoms,
+                                             int                              numLambdas,
+                                             const real * gmx_restrict        lambdaCoul,
+                                             const real * gmx_restrict        lambdaVdw,
+                                             double * gmx_restrict            energy,
+                                             t_nrnb * gmx_restrict            nrnb);
+
 #endif
@@ -0,0 +1,274 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief
+ * Inline pair interaction functions shared by the free-energy kernels.
+ *
+ * These are used by gmx_nb_free_energy_kernel(), the foreign lambda
+ * energy kernel and the nbnxm cluster-pair free-energy kernel, so all
+ * evaluate the same expressions. The Coulomb and VdW functions
+ * return the potential and r times the scalar force, i.e. -dV/dr*r.
+ * They take the distance as a template type, so the soft-core kernels
+ * can evaluate them in double precision.
+ */
+
+#ifndef GMX_GMXLIB_NONBONDED_NB_FREE_ENERGY_PAIR_H
+#define GMX_GMXLIB_NONBONDED_NB_FREE_ENERGY_PAIR_H
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "gromacs/utility/real.h"
+
+//! The coefficients of a potential-switch modifier
+struct FepPotentialSwitch
+{
+    //! Constructs a switch with all coefficients zero, for use without switching
+    FepPotentialSwitch() :
+        rSwitch(0), swV3(0), swV4(0), swV5(0), swF2(0), swF3(0), swF4(0)
+    {
+    }
+
+    //! Sets up the switch from \p rSwitchIn to \p rCutoff
+    FepPotentialSwitch(real rCutoff, real rSwitchIn) :
+        rSwitch(rSwitchIn)
+    {
+        const real d = rCutoff - rSwitch;
+
+        swV3 = -10.0/(d*d*d);
+        swV4 =  15.0/(d*d*d*d);
+        swV5 =  -6.0/(d*d*d*d*d);
+        swF2 = -30.0/(d*d*d);
+        swF3 =  60.0/(d*d*d*d);
+        swF4 = -30.0/(d*d*d*d*d);
+    }
+
+    real rSwitch; //!< The distance where switching starts
+    real swV3;    //!< Potential switch third order coefficient
+    real swV4;    //!< Potential switch fourth order coefficient
+    real swV5;    //!< Potential switch fifth order coefficient
+    real swF2;    //!< Force switch second order coefficient
+    real swF3;    //!< Force switch third order coefficient
+    real swF4;    //!< Force switch fourth order coefficient
+};
+
+//! Applies the potential switch \p sw at distance \p r to potential \p v and r times force \p rF
+template <typename T>
+static inline void applyPotentialSwitch(const FepPotentialSwitch &sw, T r, T *v, T *rF)
+{
+    const real d   = std::max(static_cast<real>(r - sw.rSwitch), static_cast<real>(0));
+    const real d2  = d*d;
+    const real s   = 1 + d2*d*(sw.swV3 + d*(sw.swV4 + d*sw.swV5));
+    const real ds  = d2*(sw.swF2 + d*(sw.swF3 + d*sw.swF4));
+
+    *rF = *rF*s - r*(*v)*ds;
+    *v *= s;
+}
+
+/*! \brief Reaction-field, or plain cut-off, Coulomb for charge product \p qq
+ *
+ * With plain cut-off \p krf is zero and \p crf is the potential shift.
+ */
+template <typename T>
+static inline void reactionFieldCoulomb(real qq, T rInv, T r, real krf, real crf, T *v, T *rF)
+{
+    *v  = qq*(rInv + krf*r*r - crf);
+    *rF = qq*(rInv - 2*krf*r*r);
+}
+
+/*! \brief The reaction-field correction for an excluded pair, for unit charge product
+ *
+ * Returns the potential in \p v and the force/r in \p fOverR.
+ */
+static inline void reactionFieldExclusionCorrection(real krf, real crf, real rsq,
+                                                    real *v, real *fOverR)
+{
+    *v      = krf*rsq - crf;
+    *fOverR = -2*krf;
+}
+
+/*! \brief The 1/r part of Ewald Coulomb for charge product \p qq
+ *
+ * The reciprocal-space part is subtracted separately with
+ * ewaldReciprocalCorrection(), so soft-core can be applied to 1/r only.
+ */
+template <typename T>
+static inline void ewaldCoulomb(real qq, T rInv, real shEwald, T *v, T *rF)
+{
+    *v  = qq*(rInv - shEwald);
+    *rF = qq*rInv;
+}
+
+/*! \brief Shifted Lennard-Jones for parameters \p c6 and \p c12 at r^-6 = \p rInv6
+ *
+ * The parameters are stored scaled by 6 and 12. \p c6grid and \p shLJEwald
+ * add the potential shift of the LJ-PME grid part, pass zero without LJ-PME.
+ */
+template <typename T>
+static inline void lennardJones(real c6, real c12, real c6grid, real rInv6,
+                                real shInvrc6, real shLJEwald, T *v, T *rF)
+{
+    const real onetwelfth = 1.0/12.0;
+    const real onesixth   = 1.0/6.0;
+    const real v6         = c6*rInv6;
+    const real v12        = c12*rInv6*rInv6;
+
+    *v  = ((v12 - c12*shInvrc6*shInvrc6)*onetwelfth
+           - (v6 - c6*shInvrc6 - c6grid*shLJEwald)*onesixth);
+    *rF = v12 - v6;
+}
+
+/*! \brief The reciprocal-space Ewald potential and force/r for unit charges
+ *
+ * Interpolates the FDV0 table \p tab with spacing 1/\p tabScale at distance \p r.
+ * \p tabHalfSpace is 0.5/\p tabScale.
+ */
+static inline void ewaldReciprocalCorrection(const real *tab, real tabScale, real tabHalfSpace,
+                                             real r, real rInv, real *v, real *fOverR)
+{
+    const real ewrt   = r*tabScale;
+    int        ewitab = static_cast<int>(ewrt);
+    const real eweps  = ewrt - ewitab;
+    ewitab            = 4*ewitab;
+    const real f      = tab[ewitab] + eweps*tab[ewitab + 1];
+
+    *v      = tab[ewitab + 2] - tabHalfSpace*eweps*(tab[ewitab] + f);
+    *fOverR = f*rInv;
+}
+
+/*! \brief The reciprocal-space LJ-PME potential and force/r for unit grid C6
+ *
+ * Interpolates the force and potential tables \p tabF and \p tabV at distance \p r.
+ * We could also use the analytical form here instead of a table,
+ * but that can cause issues for r close to 0 for non-interacting pairs.
+ */
+static inline void ljEwaldReciprocalCorrection(const real *tabF, const real *tabV,
+                                               real tabScale, real tabHalfSpace,
+                                               real r, real rInv, real *v, real *fOverR)
+{
+    /* TODO: Currently the Ewald LJ table does not contain
+     * the factor 1/6, we should add this.
+     */
+    const real six  = 6.0;
+    const real rs   = r*tabScale;
+    const int  ri   = static_cast<int>(rs);
+    const real frac = rs - ri;
+    const real f    = (1 - frac)*tabF[ri] + frac*tabF[ri + 1];
+
+    *v      = (tabV[ri] - tabHalfSpace*frac*(tabF[ri] + f))/six;
+    *fOverR = f*rInv/six;
+}
+
+/*! \brief Returns r^p for the soft-core r-power p, sets \p rpm2 to r^(p-2)
+ *
+ * Needs double for p=48.
+ */
+static inline double softcoreRPower(real rsq, real r, real scRPower, double *rpm2)
+{
+    double rp;
+
+    if (scRPower == 6)
+    {
+        *rpm2 = rsq*rsq;      /* r4 */
+        rp    = *rpm2*rsq;    /* r6 */
+    }
+    else if (scRPower == 48)
+    {
+        rp    = rsq*rsq*rsq;  /* r6 */
+        rp    = rp*rp;        /* r12 */
+        rp    = rp*rp;        /* r24 */
+        rp    = rp*rp;        /* r48 */
+        *rpm2 = rp/rsq;       /* r46 */
+    }
+    else
+    {
+        rp    = std::pow(r, scRPower);  /* not currently supported as input, but can handle it */
+        *rpm2 = rp/rsq;
+    }
+
+    return rp;
+}
+
+/*! \brief Returns sigma^p for the soft-core r-power p of a pair with parameters \p c6 and \p c12
+ *
+ * Pairs without LJ parameters use \p sigma6Def, small sigma values are raised to \p sigma6Min.
+ * \p sigma2Def and \p sigma2Min should be the cube roots of these.
+ */
+static inline real softcoreSigmaPow(real c6, real c12,
+                                    real sigma6Def, real sigma2Def,
+                                    real sigma6Min, real sigma2Min,
+                                    real scRPower)
+{
+    real sigma6, sigma2;
+
+    if ((c6 > 0) && (c12 > 0))
+    {
+        /* c12 is stored scaled with 12.0 and c6 is scaled with 6.0 - correct for this */
+        sigma6 = 0.5*c12/c6;
+        sigma2 = std::cbrt(sigma6);
+        /* should be able to get rid of cbrt call eventually.  Will require agreement on
+           what data to store externally.  Can't be fixed without larger scale changes, so not 4.6 */
+        if (sigma6 < sigma6Min)   /* for disappearing coul and vdw with soft core at the same time */
+        {
+            sigma6 = sigma6Min;
+            sigma2 = sigma2Min;
+        }
+    }
+    else
+    {
+        sigma6 = sigma6Def;
+        sigma2 = sigma2Def;
+    }
+
+    if (scRPower == 6)
+    {
+        return sigma6;
+    }
+    else if (scRPower == 48)
+    {
+        real sigmaPow = sigma6*sigma6;  /* sigma^12 */
+        sigmaPow      = sigmaPow*sigmaPow; /* sigma^24 */
+        return sigmaPow*sigmaPow;          /* sigma^48 */
+    }
+    else
+    {
+        /* not really supported as input, but in here for testing the general case*/
+        return std::pow(sigma2, scRPower/2);
+    }
+}
+
+#endif
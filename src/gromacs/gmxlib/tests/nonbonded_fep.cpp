@@ -0,0 +1,294 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the free-energy non-bonded kernels.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxlib/nonbonded/nb_free_energy.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The Coulomb type, the VdW type, the VdW modifier and the soft-core r-power
+typedef std::tuple<int, int, int, real> FepKernelTestParams;
+
+//! Number of atoms in the test system
+constexpr int c_numAtoms = 5;
+//! Number of atom types
+constexpr int c_numTypes = 3;
+//! The pair-list and interaction cut-off
+constexpr real c_cutoff  = 1.0;
+
+/*! \brief Test fixture setting up a small system with perturbed atoms
+ *
+ * Atom 0 disappears, both its charge and LJ parameters are turned off,
+ * so its pairs use soft-core. Atom 1 only changes charge, so its pairs
+ * with the unperturbed atoms do not use soft-core.
+ * Atom 0 excludes itself and atom 1.
+ */
+class FreeEnergyKernelTest : public ::testing::TestWithParam<FepKernelTestParams>
+{
+    public:
+        FreeEnergyKernelTest() :
+            x_({ { 0.0, 0.0, 0.0 }, { 0.3, 0.1, 0.0 }, { 0.0, 0.45, 0.1 },
+                 { 0.6, 0.5, 0.2 }, { 0.2, 0.1, 0.93 } }),
+            f_(c_numAtoms, { 0, 0, 0 }),
+            shiftVec_(SHIFTS, { 0, 0, 0 }),
+            fshift_(SHIFTS, { 0, 0, 0 }),
+            chargeA_({ 0.5, -0.3, 0.4, -0.6, 0.2 }),
+            chargeB_({ 0.0,  0.2, 0.4, -0.6, 0.2 }),
+            typeA_({ 0, 1, 0, 1, 1 }),
+            typeB_({ 2, 1, 0, 1, 1 }),
+            nbfp_(2*c_numTypes*c_numTypes, 0),
+            c6grid_(2*c_numTypes*c_numTypes, 0)
+        {
+            int  eeltype, vdwtype, vdwModifier;
+            real scRPower;
+            std::tie(eeltype, vdwtype, vdwModifier, scRPower) = GetParam();
+
+            /* Geometric combination of C6 and C12, stored scaled by 6 and 12 */
+            const real c6[c_numTypes]  = { 2.6e-3, 1.7e-3, 0 };
+            const real c12[c_numTypes] = { 2.6e-6, 1.1e-6, 0 };
+            for (int i = 0; i < c_numTypes; i++)
+            {
+                for (int j = 0; j < c_numTypes; j++)
+                {
+                    nbfp_[2*(i*c_numTypes + j)]     = 6*std::sqrt(c6[i]*c6[j]);
+                    nbfp_[2*(i*c_numTypes + j) + 1] = 12*std::sqrt(c12[i]*c12[j]);
+                    c6grid_[2*(i*c_numTypes + j)]   = nbfp_[2*(i*c_numTypes + j)];
+                }
+            }
+
+            ic_.cutoff_scheme    = ecutsVERLET;
+            ic_.eeltype          = eeltype;
+            ic_.coulomb_modifier = eintmodPOTSHIFT;
+            ic_.rcoulomb         = c_cutoff;
+            ic_.epsfac           = ONE_4PI_EPS0;
+            if (EEL_PME_EWALD(eeltype))
+            {
+                ic_.ewaldcoeff_q = calc_ewaldcoeff_q(c_cutoff, 1e-5);
+                ic_.sh_ewald     = std::erfc(ic_.ewaldcoeff_q*c_cutoff)/c_cutoff;
+            }
+            else
+            {
+                ic_.k_rf         = 0.48;
+                ic_.c_rf         = 1/c_cutoff + ic_.k_rf*c_cutoff*c_cutoff;
+            }
+            ic_.vdwtype          = vdwtype;
+            ic_.vdw_modifier     = vdwModifier;
+            ic_.rvdw             = c_cutoff;
+            ic_.rvdw_switch      = 0.8;
+            if (vdwModifier == eintmodPOTSHIFT)
+            {
+                ic_.sh_invrc6    = 1/std::pow(c_cutoff, 6);
+            }
+            if (EVDW_PME(vdwtype))
+            {
+                ic_.ewaldcoeff_lj = calc_ewaldcoeff_lj(c_cutoff, 1e-3);
+                const real br2    = gmx::square(ic_.ewaldcoeff_lj*c_cutoff);
+                ic_.sh_lj_ewald   = (std::exp(-br2)*(1 + br2 + 0.5*br2*br2) - 1)/std::pow(c_cutoff, 6);
+            }
+            init_interaction_const_tables(nullptr, &ic_, 0);
+
+            fr_.ic            = &ic_;
+            fr_.cutoff_scheme = ecutsVERLET;
+            fr_.ntype         = c_numTypes;
+            fr_.nbfp          = nbfp_.data();
+            fr_.ljpme_c6grid  = c6grid_.data();
+            fr_.shift_vec     = as_rvec_array(shiftVec_.data());
+            fr_.fshift        = as_rvec_array(fshift_.data());
+            fr_.sc_alphacoul  = 0.5;
+            fr_.sc_alphavdw   = 0.5;
+            fr_.sc_power      = 1;
+            fr_.sc_r_power    = scRPower;
+            fr_.sc_sigma6_def = std::pow(0.3, 6);
+            fr_.sc_sigma6_min = 0;
+
+            mdatoms_.chargeA  = chargeA_.data();
+            mdatoms_.chargeB  = chargeB_.data();
+            mdatoms_.typeA    = typeA_.data();
+            mdatoms_.typeB    = typeB_.data();
+
+            /* Atom 0 interacts with all atoms, atom 1 with atoms 2 to 4 */
+            iinr_             = { 0, 1 };
+            gid_              = { 0, 0 };
+            shift_            = { CENTRAL, CENTRAL };
+            jindex_           = { 0, 5, 8 };
+            jjnr_             = { 0, 1, 2, 3, 4, 2, 3, 4 };
+            exclFep_          = { 0, 0, 1, 1, 1, 1, 1, 1 };
+            nlist_.nri        = iinr_.size();
+            nlist_.nrj        = jjnr_.size();
+            nlist_.iinr       = iinr_.data();
+            nlist_.gid        = gid_.data();
+            nlist_.shift      = shift_.data();
+            nlist_.jindex     = jindex_.data();
+            nlist_.jjnr       = jjnr_.data();
+            nlist_.excl_fep   = exclFep_.data();
+
+            init_nrnb(&nrnb_);
+        }
+
+        ~FreeEnergyKernelTest() override
+        {
+            sfree_aligned(ic_.tabq_coul_FDV0);
+            sfree_aligned(ic_.tabq_coul_F);
+            sfree_aligned(ic_.tabq_coul_V);
+            sfree_aligned(ic_.tabq_vdw_FDV0);
+            sfree_aligned(ic_.tabq_vdw_F);
+            sfree_aligned(ic_.tabq_vdw_V);
+        }
+
+        //! Returns the total energy computed by gmx_nb_free_energy_kernel() at one lambda value
+        double kernelEnergy(real lambdaCoul, real lambdaVdw)
+        {
+            real             lambda[efptNR] = { 0 };
+            real             dvdl[efptNR]   = { 0 };
+            real             Vc             = 0;
+            real             Vv             = 0;
+            nb_kernel_data_t kernelData     = {};
+
+            lambda[efptCOUL]          = lambdaCoul;
+            lambda[efptVDW]           = lambdaVdw;
+            kernelData.flags          = GMX_NONBONDED_DO_POTENTIAL;
+            kernelData.lambda         = lambda;
+            kernelData.dvdl           = dvdl;
+            kernelData.energygrp_elec = &Vc;
+            kernelData.energygrp_vdw  = &Vv;
+
+            gmx_nb_free_energy_kernel(&nlist_, as_rvec_array(x_.data()), as_rvec_array(f_.data()),
+                                      &fr_, &mdatoms_, &kernelData, &nrnb_);
+
+            return Vc + Vv;
+        }
+
+        std::vector<RVec>   x_;
+        std::vector<RVec>   f_;
+        std::vector<RVec>   shiftVec_;
+        std::vector<RVec>   fshift_;
+        std::vector<real>   chargeA_;
+        std::vector<real>   chargeB_;
+        std::vector<int>    typeA_;
+        std::vector<int>    typeB_;
+        std::vector<real>   nbfp_;
+        std::vector<real>   c6grid_;
+        std::vector<int>    iinr_;
+        std::vector<int>    gid_;
+        std::vector<int>    shift_;
+        std::vector<int>    jindex_;
+        std::vector<int>    jjnr_;
+        std::vector<char>   exclFep_;
+        interaction_const_t ic_      = {};
+        t_forcerec          fr_;
+        t_mdatoms           mdatoms_ = {};
+        t_nblist            nlist_   = {};
+        t_nrnb              nrnb_;
+};
+
+TEST_P(FreeEnergyKernelTest, ForeignLambdaEnergiesMatchPerLambdaKernel)
+{
+    const std::vector<real> lambdaCoul = { 0.0, 0.2, 0.5, 0.5, 1.0 };
+    const std::vector<real> lambdaVdw  = { 0.0, 0.1, 0.3, 0.9, 1.0 };
+    const int               numLambdas = lambdaCoul.size();
+
+    std::vector<double>     energy(numLambdas, 0.0);
+    gmx_nb_free_energy_foreign_lambda_kernel(&nlist_, as_rvec_array(x_.data()), &fr_, &mdatoms_,
+                                             numLambdas, lambdaCoul.data(), lambdaVdw.data(),
+                                             energy.data(), &nrnb_);
+
+    std::vector<double> reference(numLambdas);
+    double              maxAbsEnergy = 0;
+    for (int l = 0; l < numLambdas; l++)
+    {
+        reference[l] = kernelEnergy(lambdaCoul[l], lambdaVdw[l]);
+        maxAbsEnergy = std::max(maxAbsEnergy, std::abs(reference[l]));
+    }
+    /* Check that the soft-core pairs contribute non-linearly in lambda */
+    EXPECT_NE(reference[2], reference[3]);
+
+    const FloatingPointTolerance tolerance = relativeToleranceAsFloatingPoint(maxAbsEnergy, 1e-5);
+    for (int l = 0; l < numLambdas; l++)
+    {
+        EXPECT_REAL_EQ_TOL(reference[l], energy[l], tolerance) << "for lambda index " << l;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ReactionField, FreeEnergyKernelTest,
+                            ::testing::Combine(::testing::Values(eelRF),
+                                                   ::testing::Values(evdwCUT),
+                                                   ::testing::Values(eintmodPOTSHIFT, eintmodPOTSWITCH),
+                                                   ::testing::Values(6.0, 48.0)));
+
+INSTANTIATE_TEST_CASE_P(Ewald, FreeEnergyKernelTest,
+                            ::testing::Combine(::testing::Values(eelPME),
+                                                   ::testing::Values(evdwCUT, evdwPME),
+                                                   ::testing::Values(eintmodPOTSHIFT),
+                                                   ::testing::Values(6.0, 48.0)));
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
@@ -327,7 +327,7 @@ void check_ir(const char *mdparin, t_inputrec *ir, t_gromppopts *opts,
             // Since we have PME coulomb + LJ cut-off kernels with rcoulomb>rvdw
             // for PME load balancing, we can support this exception.
             bool bUsesPmeTwinRangeKernel = (EEL_PME_EWALD(ir->coulombtype) &&
-                                            ir->vdwtype == evdwCUT &&
+                                            (ir->vdwtype == evdwCUT || ir->vdwtype == evdwUSER) &&
                                             ir->rcoulomb > ir->rvdw);
             if (!bUsesPmeTwinRangeKernel)
             {
@@ -354,9 +354,27 @@ void check_ir(const char *mdparin, t_inputrec *ir, t_gromppopts *opts,
             }
         }
 
-        if (!(ir->vdwtype == evdwCUT || ir->vdwtype == evdwPME))
+        if (!(ir->vdwtype == evdwCUT || ir->vdwtype == evdwPME || ir->vdwtype == evdwUSER))
         {
-            warning_error(wi, "With Verlet lists only cut-off and PME LJ interactions are supported");
+            warning_error(wi, "With Verlet lists only cut-off, PME and user tabulated VdW interactions are supported");
+        }
+        if (ir->vdwtype == evdwUSER)
+        {
+            /* The kernels apply the table as is, so a potential shift,
+             * which is the default with the Verlet scheme, would be ignored.
+             */
+            if (ir->vdw_modifier != eintmodNONE)
+            {
+                sprintf(warn_buf, "vdw_modifier=%s is not supported with vdwtype=%s and the Verlet cut-off scheme, use vdw_modifier=%s and let the tabulated functions go to zero at rvdw", eintmod_names[ir->vdw_modifier], evdw_names[ir->vdwtype], eintmod_names[eintmodNONE]);
+                warning_error(wi, warn_buf);
+            }
+            if (ir->efep != efepNO)
+            {
+                sprintf(warn_buf, "With the Verlet cut-off scheme vdwtype=%s is not supported with free-energy calculations", evdw_names[ir->vdwtype]);
+                warning_error(wi, warn_buf);
+            }
+            sprintf(warn_buf, "With the Verlet cut-off scheme the user table for vdwtype=%s is used with an exact cut-off at rvdw. The pair-list buffer is determined assuming the table behaves as the Lennard-Jones potential at the cut-off.", evdw_names[ir->vdwtype]);
+            warning_note(wi, warn_buf);
         }
         if (!(ir->coulombtype == eelCUT || EEL_RF(ir->coulombtype) ||
               EEL_PME(ir->coulombtype) || ir->coulombtype == eelEWALD))
@@ -3676,6 +3694,10 @@ void do_index(const char* mdparin, const char *ndx,
     {
         gmx_fatal(FARGS, "Can only have energy group pair tables in combination with user tables for VdW and/or Coulomb");
     }
+    if (bTable && ir->cutoff_scheme == ecutsVERLET)
+    {
+        warning_error(wi, "Energy group pair tables are not (yet) implemented for the Verlet scheme");
+    }
 
     /* final check before going out of scope if simulated tempering variables
      * need to be set to default values.
@@ -2200,6 +2200,121 @@ real idihs(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As idihs above, but without calculating energies and shift forces
+ * and using SIMD to calculate many dihedrals at once.
+ */
+void
+idihs_noener_simd(int nbonds,
+                  const t_iatom forceatoms[], const t_iparams forceparams[],
+                  const rvec x[], rvec4 f[],
+                  const t_pbc *pbc, const t_graph gmx_unused *g,
+                  real gmx_unused lambda,
+                  const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                  int gmx_unused *global_atom_index)
+{
+    const int             nfa1 = 5;
+    int                   i, iu, s;
+    int                   type;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            buf[2*GMX_SIMD_REAL_WIDTH];
+    real                 *kk, *phi0;
+    SimdReal              deg2rad_S(DEG2RAD);
+    SimdReal              two_pi_S(2*M_PI);
+    SimdReal              inv_two_pi_S(1/(2*M_PI));
+    SimdReal              p_S, q_S;
+    SimdReal              phi0_S, phi_S;
+    SimdReal              mx_S, my_S, mz_S;
+    SimdReal              nx_S, ny_S, nz_S;
+    SimdReal              nrkj_m2_S, nrkj_n2_S;
+    SimdReal              kk_S, dp_S;
+    SimdReal              mddphi_S;
+    SimdReal              sf_i_S, msf_l_S;
+    alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    /* Extract aligned pointer for parameters and variables */
+    kk    = buf + 0*GMX_SIMD_REAL_WIDTH;
+    phi0  = buf + 1*GMX_SIMD_REAL_WIDTH;
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of dihedrals times nfa1, here we step GMX_SIMD_REAL_WIDTH dihs */
+    for (i = 0; (i < nbonds); i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect atoms quadruplets for GMX_SIMD_REAL_WIDTH dihedrals.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        iu = i;
+        for (s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            type  = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+            ak[s] = forceatoms[iu+3];
+            al[s] = forceatoms[iu+4];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s*nfa1 < nbonds)
+            {
+                kk[s]   = forceparams[type].harmonic.krA;
+                phi0[s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                kk[s]   = 0;
+                phi0[s] = 0;
+            }
+        }
+
+        /* Caclulate GMX_SIMD_REAL_WIDTH dihedral angles at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd,
+                       &phi_S,
+                       &mx_S, &my_S, &mz_S,
+                       &nx_S, &ny_S, &nz_S,
+                       &nrkj_m2_S,
+                       &nrkj_n2_S,
+                       &p_S, &q_S);
+
+        kk_S     = load<SimdReal>(kk);
+        phi0_S   = load<SimdReal>(phi0) * deg2rad_S;
+
+        /* As make_dp_periodic(), put phi-phi0 in the range (-pi,pi) */
+        dp_S     = phi_S - phi0_S;
+        dp_S     = dp_S - two_pi_S * round(dp_S * inv_two_pi_S);
+
+        mddphi_S = -(kk_S * dp_S);
+        sf_i_S   = mddphi_S * nrkj_m2_S;
+        msf_l_S  = mddphi_S * nrkj_n2_S;
+
+        /* After this m?_S will contain f[i] */
+        mx_S     = sf_i_S * mx_S;
+        my_S     = sf_i_S * my_S;
+        mz_S     = sf_i_S * mz_S;
+
+        /* After this m?_S will contain -f[l] */
+        nx_S     = msf_l_S * nx_S;
+        ny_S     = msf_l_S * ny_S;
+        nz_S     = msf_l_S * nz_S;
+
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al,
+                                 p_S, q_S,
+                                 mx_S, my_S, mz_S,
+                                 nx_S, ny_S, nz_S,
+                                 f);
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 static real low_angres(int nbonds,
                        const t_iatom forceatoms[], const t_iparams forceparams[],
                        const rvec x[], rvec4 f[], rvec fshift[],
@@ -3275,6 +3390,238 @@ cmap_dihs(int nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As cmap_dihs above, but without calculating energies and shift forces
+ * and using SIMD to calculate many CMAP interactions at once.
+ * The grid lookup is done per interaction, the bicubic interpolation
+ * and the force distribution use SIMD.
+ */
+void
+cmap_dihs_noener_simd(int nbonds,
+                      const t_iatom forceatoms[], const t_iparams forceparams[],
+                      const gmx_cmap_t *cmap_grid,
+                      const rvec x[], rvec4 f[],
+                      const struct t_pbc *pbc, const struct t_graph gmx_unused *g,
+                      real gmx_unused lambda,
+                      const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                      int gmx_unused *global_atom_index)
+{
+    const int             nfa1 = 6;
+    int                   i, iu, s;
+    int                   type;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t    am[GMX_SIMD_REAL_WIDTH];
+    int                   cmapIndex[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            phi1[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            phi2[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            tt[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            tu[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real            tx[16*GMX_SIMD_REAL_WIDTH];
+    SimdReal              p1_S, q1_S, p2_S, q2_S;
+    SimdReal              phi1_S, phi2_S;
+    SimdReal              m1x_S, m1y_S, m1z_S, n1x_S, n1y_S, n1z_S;
+    SimdReal              m2x_S, m2y_S, m2z_S, n2x_S, n2y_S, n2z_S;
+    SimdReal              nrkj_m2_1_S, nrkj_n2_1_S, nrkj_m2_2_S, nrkj_n2_2_S;
+    SimdReal              tx_S[16], tc_S[16];
+    SimdReal              tt_S, tu_S;
+    SimdReal              df1_S, df2_S;
+    SimdReal              sf_i_S, msf_l_S;
+    SimdReal              two_S(2.0);
+    SimdReal              three_S(3.0);
+    alignas(GMX_SIMD_ALIGNMENT) real            pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+
+    const int             grid_spacing = cmap_grid->grid_spacing;
+    /* The grid spacing in radians and in degrees */
+    const real            dx_rad       = 2*M_PI/grid_spacing;
+    const real            dx           = 360.0/grid_spacing;
+    const SimdReal        fac_S(RAD2DEG/dx);
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of CMAPs times nfa1, here we step GMX_SIMD_REAL_WIDTH CMAPs */
+    for (i = 0; (i < nbonds); i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        /* Collect the five atoms for GMX_SIMD_REAL_WIDTH CMAPs.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        iu = i;
+        for (s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            type  = forceatoms[iu];
+            ai[s] = forceatoms[iu+1];
+            aj[s] = forceatoms[iu+2];
+            ak[s] = forceatoms[iu+3];
+            al[s] = forceatoms[iu+4];
+            am[s] = forceatoms[iu+5];
+
+            /* At the end fill the arrays with the last atoms and no grid */
+            if (i + s*nfa1 < nbonds)
+            {
+                cmapIndex[s] = forceparams[type].cmap.cmapA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                cmapIndex[s] = -1;
+            }
+        }
+
+        /* Calculate GMX_SIMD_REAL_WIDTH angles of both torsions at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd,
+                       &phi1_S,
+                       &m1x_S, &m1y_S, &m1z_S,
+                       &n1x_S, &n1y_S, &n1z_S,
+                       &nrkj_m2_1_S,
+                       &nrkj_n2_1_S,
+                       &p1_S, &q1_S);
+        dih_angle_simd(x, aj, ak, al, am, pbc_simd,
+                       &phi2_S,
+                       &m2x_S, &m2y_S, &m2z_S,
+                       &n2x_S, &n2y_S, &n2z_S,
+                       &nrkj_m2_2_S,
+                       &nrkj_n2_2_S,
+                       &p2_S, &q2_S);
+        store(phi1, phi1_S);
+        store(phi2, phi2_S);
+
+        /* Look up the grid values around each pair of angles */
+        for (s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            if (cmapIndex[s] < 0)
+            {
+                /* Zero values give zero forces */
+                for (int k = 0; k < 16; k++)
+                {
+                    tx[k*GMX_SIMD_REAL_WIDTH + s] = 0;
+                }
+                tt[s] = 0;
+                tu[s] = 0;
+                continue;
+            }
+
+            const real *cmapd = cmap_grid->cmapdata[cmapIndex[s]].cmap.data();
+            int         iphi1, ip1m1, ip1p1, ip1p2;
+            int         iphi2, ip2m1, ip2p1, ip2p2;
+
+            /* Range mangling */
+            real xphi1 = phi1[s] + M_PI;
+            real xphi2 = phi2[s] + M_PI;
+            if (xphi1 < 0)
+            {
+                xphi1 = xphi1 + 2*M_PI;
+            }
+            else if (xphi1 >= 2*M_PI)
+            {
+                xphi1 = xphi1 - 2*M_PI;
+            }
+            if (xphi2 < 0)
+            {
+                xphi2 = xphi2 + 2*M_PI;
+            }
+            else if (xphi2 >= 2*M_PI)
+            {
+                xphi2 = xphi2 - 2*M_PI;
+            }
+
+            /* Where on the grid are we */
+            iphi1 = static_cast<int>(xphi1/dx_rad);
+            iphi2 = static_cast<int>(xphi2/dx_rad);
+
+            iphi1 = cmap_setup_grid_index(iphi1, grid_spacing, &ip1m1, &ip1p1, &ip1p2);
+            iphi2 = cmap_setup_grid_index(iphi2, grid_spacing, &ip2m1, &ip2p1, &ip2p2);
+
+            const int pos[4] = {
+                iphi1*grid_spacing + iphi2,
+                ip1p1*grid_spacing + iphi2,
+                ip1p1*grid_spacing + ip2p1,
+                iphi1*grid_spacing + ip2p1
+            };
+
+            for (int c = 0; c < 4; c++)
+            {
+                tx[(c     )*GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c]*4];
+                tx[(c +  4)*GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c]*4+1]*dx;
+                tx[(c +  8)*GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c]*4+2]*dx;
+                tx[(c + 12)*GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c]*4+3]*dx*dx;
+            }
+
+            tt[s] = (xphi1*RAD2DEG - iphi1*dx)/dx;
+            tu[s] = (xphi2*RAD2DEG - iphi2*dx)/dx;
+        }
+
+        /* The bicubic interpolation coefficients */
+        for (int k = 0; k < 16; k++)
+        {
+            tx_S[k] = load<SimdReal>(tx + k*GMX_SIMD_REAL_WIDTH);
+        }
+        for (int idx = 0; idx < 16; idx++)
+        {
+            tc_S[idx] = setZero();
+            for (int k = 0; k < 16; k++)
+            {
+                if (cmap_coeff_matrix[k*16+idx] != 0)
+                {
+                    tc_S[idx] = fma(SimdReal(cmap_coeff_matrix[k*16+idx]), tx_S[k], tc_S[idx]);
+                }
+            }
+        }
+
+        tt_S  = load<SimdReal>(tt);
+        tu_S  = load<SimdReal>(tu);
+
+        df1_S = setZero();
+        df2_S = setZero();
+        for (int c = 3; c >= 0; c--)
+        {
+            df1_S = fma(tu_S, df1_S, fma(fma(three_S*tc_S[c+12], tt_S, two_S*tc_S[c+8]), tt_S, tc_S[c+4]));
+            df2_S = fma(tt_S, df2_S, fma(fma(three_S*tc_S[c*4+3], tu_S, two_S*tc_S[c*4+2]), tu_S, tc_S[c*4+1]));
+        }
+        df1_S = df1_S * fac_S;
+        df2_S = df2_S * fac_S;
+
+        /* The forces of each torsion are those of a dihedral with
+         * derivative df, as in pdihs_noener_simd.
+         */
+        sf_i_S   = -(df1_S * nrkj_m2_1_S);
+        msf_l_S  = -(df1_S * nrkj_n2_1_S);
+        m1x_S    = sf_i_S * m1x_S;
+        m1y_S    = sf_i_S * m1y_S;
+        m1z_S    = sf_i_S * m1z_S;
+        n1x_S    = msf_l_S * n1x_S;
+        n1y_S    = msf_l_S * n1y_S;
+        n1z_S    = msf_l_S * n1z_S;
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al,
+                                 p1_S, q1_S,
+                                 m1x_S, m1y_S, m1z_S,
+                                 n1x_S, n1y_S, n1z_S,
+                                 f);
+
+        sf_i_S   = -(df2_S * nrkj_m2_2_S);
+        msf_l_S  = -(df2_S * nrkj_n2_2_S);
+        m2x_S    = sf_i_S * m2x_S;
+        m2y_S    = sf_i_S * m2y_S;
+        m2z_S    = sf_i_S * m2z_S;
+        n2x_S    = msf_l_S * n2x_S;
+        n2y_S    = msf_l_S * n2y_S;
+        n2z_S    = msf_l_S * n2z_S;
+        do_dih_fup_noshiftf_simd(aj, ak, al, am,
+                                 p2_S, q2_S,
+                                 m2x_S, m2y_S, m2z_S,
+                                 n2x_S, n2y_S, n2z_S,
+                                 f);
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 
 //! \cond
 /***********************************************************
@@ -367,6 +367,29 @@ void
                        const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
                        int gmx_unused *global_atom_index);
 
+/* As idihs(), when not needing energy or shift force, using SIMD to calculate many dihedrals at once. */
+void
+    idihs_noener_simd(int nbonds,
+                      const t_iatom forceatoms[], const t_iparams forceparams[],
+                      const rvec x[], rvec4 f[],
+                      const struct t_pbc *pbc,
+                      const struct t_graph gmx_unused *g,
+                      real gmx_unused lambda,
+                      const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                      int gmx_unused *global_atom_index);
+
+/* As cmap_dihs(), when not needing energy or shift force, using SIMD to calculate many CMAPs at once. */
+void
+    cmap_dihs_noener_simd(int nbonds,
+                          const t_iatom forceatoms[], const t_iparams forceparams[],
+                          const gmx_cmap_t *cmap_grid,
+                          const rvec x[], rvec4 f[],
+                          const struct t_pbc *pbc,
+                          const struct t_graph gmx_unused *g,
+                          real gmx_unused lambda,
+                          const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                          int gmx_unused *global_atom_index);
+
 //! \endcond
 
 #endif
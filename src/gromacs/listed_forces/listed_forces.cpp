@@ -49,6 +49,7 @@
 
 #include <algorithm>
 #include <array>
+#include <vector>
 
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/gmxlib/nrnb.h"
@@ -426,11 +427,26 @@ calc_one_bond(int thread,
                nice to account to its own subtimer, but first
                wallcycle needs to be extended to support calling from
                multiple threads. */
-            v = cmap_dihs(nbn, iatoms+nb0,
-                          idef->iparams, idef->cmap_grid,
-                          x, f, fshift,
-                          pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
-                          md, fcd, global_atom_index);
+#if GMX_SIMD_HAVE_REAL
+            if (bUseSIMD && computeForcesOnly)
+            {
+                /* No energies, shift forces, dvdl */
+                cmap_dihs_noener_simd(nbn, iatoms+nb0,
+                                      idef->iparams, idef->cmap_grid,
+                                      x, f,
+                                      pbc, g, lambda[efptFTYPE], md, fcd,
+                                      global_atom_index);
+                v = 0;
+            }
+            else
+#endif
+            {
+                v = cmap_dihs(nbn, iatoms+nb0,
+                              idef->iparams, idef->cmap_grid,
+                              x, f, fshift,
+                              pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                              md, fcd, global_atom_index);
+            }
         }
 #if GMX_SIMD_HAVE_REAL
         else if (ftype == F_ANGLES && bUseSIMD && computeForcesOnly)
@@ -489,6 +505,16 @@ calc_one_bond(int thread,
                                global_atom_index);
             v = 0;
         }
+        else if (ftype == F_IDIHS && bUseSIMD && computeForcesOnly)
+        {
+            /* No energies, shift forces, dvdl */
+            idihs_noener_simd(nbn, idef->il[ftype].iatoms+nb0,
+                              idef->iparams,
+                              x, f,
+                              pbc, g, lambda[efptFTYPE], md, fcd,
+                              global_atom_index);
+            v = 0;
+        }
 #endif
         else
         {
@@ -520,6 +546,65 @@ calc_one_bond(int thread,
 
 } // namespace
 
+void calcBondedForcesTask(int               task,
+                          const t_idef     *idef,
+                          const rvec        x[],
+                          const t_forcerec *fr,
+                          const t_pbc      *pbc_null,
+                          const t_graph    *g,
+                          gmx_enerdata_t   *enerd,
+                          t_nrnb           *nrnb,
+                          const real       *lambda,
+                          real             *dvdl,
+                          const t_mdatoms  *md,
+                          t_fcdata         *fcd,
+                          gmx_bool          bCalcEnerVir,
+                          int              *global_atom_index)
+{
+    bonded_threading_t *bt = fr->bondedThreading;
+
+    int                 ftype;
+    real               *epot, v;
+    /* thread stuff */
+    rvec4              *ft;
+    rvec               *fshift;
+    real               *dvdlt;
+    gmx_grppairener_t  *grpp;
+
+    zero_thread_output(bt, task);
+
+    ft = bt->f_t[task].f;
+
+    if (task == 0)
+    {
+        fshift = fr->fshift;
+        epot   = enerd->term;
+        grpp   = &enerd->grpp;
+        dvdlt  = dvdl;
+    }
+    else
+    {
+        fshift = bt->f_t[task].fshift;
+        epot   = bt->f_t[task].ener;
+        grpp   = &bt->f_t[task].grpp;
+        dvdlt  = bt->f_t[task].dvdl;
+    }
+    /* Loop over all bonded force types to calculate the bonded forces */
+    for (ftype = 0; (ftype < F_NRE); ftype++)
+    {
+        if (idef->il[ftype].nr > 0 && ftype_is_bonded_potential(ftype))
+        {
+            v = calc_one_bond(task, ftype, idef,
+                              *fr->bondedThreading, x,
+                              ft, fshift, fr, pbc_null, g, grpp,
+                              nrnb, lambda, dvdlt,
+                              md, fcd, bCalcEnerVir,
+                              global_atom_index);
+            epot[ftype] += v;
+        }
+    }
+}
+
 /*! \brief Compute the bonded part of the listed forces, parallelized over threads
  */
 static void
@@ -544,51 +629,44 @@ calcBondedForces(const t_idef     *idef,
     {
         try
         {
-            int                ftype;
-            real              *epot, v;
-            /* thread stuff */
-            rvec4             *ft;
-            rvec              *fshift;
-            real              *dvdlt;
-            gmx_grppairener_t *grpp;
+            calcBondedForcesTask(thread, idef, x, fr, pbc_null, g, enerd,
+                                 nrnb, lambda, dvdl, md, fcd, bCalcEnerVir,
+                                 global_atom_index);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
 
-            zero_thread_output(bt, thread);
+void reduceBondedForces(int               natoms,
+                        rvec              f[],
+                        const t_forcerec *fr,
+                        gmx_enerdata_t   *enerd,
+                        real             *dvdl,
+                        int               force_flags)
+{
+    const gmx_bool bCalcEnerVir = ((force_flags & (GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY)) != 0);
 
-            ft = bt->f_t[thread].f;
+    reduce_thread_output(natoms, f, fr->fshift,
+                         enerd->term, &enerd->grpp, dvdl,
+                         fr->bondedThreading,
+                         bCalcEnerVir,
+                         (force_flags & GMX_FORCE_DHDL) != 0);
 
-            if (thread == 0)
-            {
-                fshift = fr->fshift;
-                epot   = enerd->term;
-                grpp   = &enerd->grpp;
-                dvdlt  = dvdl;
-            }
-            else
-            {
-                fshift = bt->f_t[thread].fshift;
-                epot   = bt->f_t[thread].ener;
-                grpp   = &bt->f_t[thread].grpp;
-                dvdlt  = bt->f_t[thread].dvdl;
-            }
-            /* Loop over all bonded force types to calculate the bonded forces */
-            for (ftype = 0; (ftype < F_NRE); ftype++)
-            {
-                if (idef->il[ftype].nr > 0 && ftype_is_bonded_potential(ftype))
-                {
-                    v = calc_one_bond(thread, ftype, idef,
-                                      *fr->bondedThreading, x,
-                                      ft, fshift, fr, pbc_null, g, grpp,
-                                      nrnb, lambda, dvdlt,
-                                      md, fcd, bCalcEnerVir,
-                                      global_atom_index);
-                    epot[ftype] += v;
-                }
-            }
+    if (force_flags & GMX_FORCE_DHDL)
+    {
+        for (int i = 0; i < efptNR; i++)
+        {
+            enerd->dvdl_nonlin[i] += dvdl[i];
         }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
 }
 
+bool canComputeBondedsAsTasks(const t_fcdata &fcd,
+                              const t_graph  *graph)
+{
+    return fcd.orires.nr == 0 && fcd.disres.nres == 0 && graph == nullptr;
+}
+
 bool havePositionRestraints(const t_idef   &idef,
                             const t_fcdata &fcd)
 {
@@ -604,6 +682,11 @@ bool haveCpuBondeds(const t_forcerec &fr)
     return fr.bondedThreading->haveBondeds;
 }
 
+int numBondedTasks(const t_forcerec &fr)
+{
+    return fr.bondedThreading->nthreads;
+}
+
 bool haveCpuListedForces(const t_forcerec &fr,
                          const t_idef     &idef,
                          const t_fcdata   &fcd)
@@ -630,7 +713,6 @@ void calc_listed(const t_commrec             *cr,
 {
     gmx_bool                   bCalcEnerVir;
     const  t_pbc              *pbc_null;
-    bonded_threading_t        *bt  = fr->bondedThreading;
 
     bCalcEnerVir = ((force_flags & (GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY)) != 0);
 
@@ -692,7 +774,9 @@ void calc_listed(const t_commrec             *cr,
         wallcycle_sub_stop(wcycle, ewcsRESTRAINTS);
     }
 
-    if (haveCpuBondeds(*fr))
+    /* With GMX_FORCE_BONDEDS_COMPUTED the bondeds have already been
+     * computed and reduced in tasks together with the non-bondeds */
+    if (haveCpuBondeds(*fr) && !(force_flags & GMX_FORCE_BONDEDS_COMPUTED))
     {
         wallcycle_sub_start(wcycle, ewcsLISTED);
         /* The dummy array is to have a place to store the dhdl at other values
@@ -703,19 +787,7 @@ void calc_listed(const t_commrec             *cr,
         wallcycle_sub_stop(wcycle, ewcsLISTED);
 
         wallcycle_sub_start(wcycle, ewcsLISTED_BUF_OPS);
-        reduce_thread_output(fr->natoms_force, f, fr->fshift,
-                             enerd->term, &enerd->grpp, dvdl,
-                             bt,
-                             bCalcEnerVir,
-                             (force_flags & GMX_FORCE_DHDL) != 0);
-
-        if (force_flags & GMX_FORCE_DHDL)
-        {
-            for (int i = 0; i < efptNR; i++)
-            {
-                enerd->dvdl_nonlin[i] += dvdl[i];
-            }
-        }
+        reduceBondedForces(fr->natoms_force, f, fr, enerd, dvdl, force_flags);
         wallcycle_sub_stop(wcycle, ewcsLISTED_BUF_OPS);
     }
 
@@ -730,8 +802,8 @@ void calc_listed_lambda(const t_idef *idef,
                         const rvec x[],
                         const t_forcerec *fr,
                         const struct t_pbc *pbc, const struct t_graph *g,
-                        gmx_grppairener_t *grpp, real *epot, t_nrnb *nrnb,
-                        const real *lambda,
+                        const t_lambda *fepvals, const real *lambda,
+                        gmx_enerdata_t *enerd, t_nrnb *nrnb,
                         const t_mdatoms *md,
                         t_fcdata *fcd,
                         int *global_atom_index)
@@ -758,17 +830,19 @@ void calc_listed_lambda(const t_idef *idef,
     bondedThreading.nthreads = 1;
     snew(bondedThreading.il_thread_division, F_NRE*(bondedThreading.nthreads+1));
 
-    /* We already have the forces, so we use temp buffers here */
+    /* We already have the forces, so we use temp buffers here.
+     * These are shared by all lambda values, as we ignore their contents.
+     */
     snew(f, fr->natoms_force);
     snew(fshift, SHIFTS);
 
-    /* Loop over all bonded force types to calculate the bonded energies */
+    /* Set up temporary t_ilists with only perturbed interactions, once */
+    std::vector<int> perturbedFtypes;
     for (int ftype = 0; (ftype < F_NRE); ftype++)
     {
         if (ftype_is_bonded_potential(ftype))
         {
             const t_ilist &ilist     = idef->il[ftype];
-            /* Create a temporary t_ilist with only perturbed interactions */
             t_ilist       &ilist_fe  = idef_fe.il[ftype];
             ilist_fe.iatoms          = ilist.iatoms + ilist.nr_nonperturbed;
             ilist_fe.nr_nonperturbed = 0;
@@ -779,16 +853,36 @@ void calc_listed_lambda(const t_idef *idef,
 
             if (ilist_fe.nr > 0)
             {
-                v = calc_one_bond(0, ftype, &idef_fe, bondedThreading,
-                                  x, f, fshift, fr, pbc_null, g,
-                                  grpp, nrnb, lambda, dvdl_dum,
-                                  md, fcd, TRUE,
-                                  global_atom_index);
-                epot[ftype] += v;
+                perturbedFtypes.push_back(ftype);
             }
         }
     }
 
+    for (int i = 0; i < enerd->n_lambda; i++)
+    {
+        real lam_i[efptNR];
+
+        reset_foreign_enerdata(enerd);
+        for (int j = 0; j < efptNR; j++)
+        {
+            lam_i[j] = (i == 0 ? lambda[j] : fepvals->all_lambda[j][i-1]);
+        }
+
+        /* Loop over the perturbed bonded force types to calculate the bonded energies */
+        for (int ftype : perturbedFtypes)
+        {
+            v = calc_one_bond(0, ftype, &idef_fe, bondedThreading,
+                              x, f, fshift, fr, pbc_null, g,
+                              &(enerd->foreign_grpp), nrnb, lam_i, dvdl_dum,
+                              md, fcd, TRUE,
+                              global_atom_index);
+            enerd->foreign_term[ftype] += v;
+        }
+
+        sum_epot(&(enerd->foreign_grpp), enerd->foreign_term);
+        enerd->enerpart_lambda[i] += enerd->foreign_term[F_EPOT];
+    }
+
     sfree(fshift);
     sfree(f);
 
@@ -850,20 +944,8 @@ do_force_listed(struct gmx_wallcycle        *wcycle,
             {
                 gmx_incons("The bonded interactions are not sorted for free energy");
             }
-            for (int i = 0; i < enerd->n_lambda; i++)
-            {
-                real lam_i[efptNR];
-
-                reset_foreign_enerdata(enerd);
-                for (int j = 0; j < efptNR; j++)
-                {
-                    lam_i[j] = (i == 0 ? lambda[j] : fepvals->all_lambda[j][i-1]);
-                }
-                calc_listed_lambda(idef, x, fr, pbc, graph, &(enerd->foreign_grpp), enerd->foreign_term, nrnb, lam_i, md,
-                                   fcd, global_atom_index);
-                sum_epot(&(enerd->foreign_grpp), enerd->foreign_term);
-                enerd->enerpart_lambda[i] += enerd->foreign_term[F_EPOT];
-            }
+            calc_listed_lambda(idef, x, fr, pbc, graph, fepvals, lambda,
+                               enerd, nrnb, md, fcd, global_atom_index);
             wallcycle_sub_stop(wcycle, ewcsLISTED_FEP);
         }
     }
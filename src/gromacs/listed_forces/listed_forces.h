@@ -120,16 +120,60 @@ void calc_listed(const t_commrec *cr,
                  struct t_fcdata *fcd, int *ddgatindex,
                  int force_flags);
 
+/*! \brief Returns whether the CPU bonded interactions can be computed
+ * outside calc_listed(), using calcBondedForcesTask()
+ *
+ * This is not possible with orientation or distance restraints, which
+ * need to be computed before the bondeds, nor with a graph, since then
+ * the molecules are only made whole in do_force_lowlevel().
+ */
+bool canComputeBondedsAsTasks(const t_fcdata &fcd,
+                              const t_graph  *graph);
+
+/*! \brief Computes the CPU bonded interactions of one thread task
+ *
+ * The bonded interactions are divided over numBondedTasks() tasks. Task \p task writes to the thread output buffers with the same
+ * index, except that task 0 adds shift forces, energies and dV/dlambda
+ * directly to fr->fshift, \p enerd and \p dvdl. So different tasks can
+ * be computed concurrently by any thread, in any order. Afterwards
+ * the output of all tasks should be reduced with reduceBondedForces().
+ */
+void calcBondedForcesTask(int               task,
+                          const t_idef     *idef,
+                          const rvec        x[],
+                          const t_forcerec *fr,
+                          const t_pbc      *pbc_null,
+                          const t_graph    *g,
+                          gmx_enerdata_t   *enerd,
+                          t_nrnb           *nrnb,
+                          const real       *lambda,
+                          real             *dvdl,
+                          const t_mdatoms  *md,
+                          t_fcdata         *fcd,
+                          gmx_bool          bCalcEnerVir,
+                          int              *global_atom_index);
+
+/*! \brief Reduces the thread output of all bonded tasks to \p f,
+ * fr->fshift and \p enerd and adds \p dvdl to the dV/dlambda terms */
+void reduceBondedForces(int               natoms,
+                        rvec              f[],
+                        const t_forcerec *fr,
+                        gmx_enerdata_t   *enerd,
+                        real             *dvdl,
+                        int               force_flags);
+
 /*! \brief As calc_listed(), but only determines the potential energy
- * for the perturbed interactions.
+ * for the perturbed interactions, at the current and all foreign lambda
+ * values, and adds these to enerd->enerpart_lambda.
  *
+ * The setup and work buffers are shared by all lambda values.
  * The shift forces in fr are not affected. */
 void calc_listed_lambda(const t_idef *idef,
                         const rvec x[],
                         const t_forcerec *fr,
                         const struct t_pbc *pbc, const struct t_graph *g,
-                        gmx_grppairener_t *grpp, real *epot, t_nrnb *nrnb,
-                        const real *lambda,
+                        const t_lambda *fepvals, const real *lambda,
+                        gmx_enerdata_t *enerd, t_nrnb *nrnb,
                         const t_mdatoms *md,
                         struct t_fcdata *fcd, int *global_atom_index);
 
@@ -164,6 +208,9 @@ bool havePositionRestraints(const t_idef   &idef,
 /*! \brief Returns true if there are CPU (i.e. not GPU-offloaded) bonded interactions to compute. */
 bool haveCpuBondeds(const t_forcerec &fr);
 
+/*! \brief Returns the number of tasks the CPU bonded interactions are divided over, see calcBondedForcesTask() */
+int numBondedTasks(const t_forcerec &fr);
+
 /*! \brief Returns true if there are listed interactions to compute.
  *
  * NOTE: the current implementation returns true if there are position restraints
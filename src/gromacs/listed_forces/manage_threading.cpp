@@ -54,6 +54,8 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "gromacs/listed_forces/gpubonded.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
@@ -74,6 +76,22 @@ typedef struct {
     int            nat;   /**< nr of atoms involved in a single ftype interaction */
 } ilist_data_t;
 
+/*! \brief Returns the lowest atom index of an interaction with \p nral atoms \p atoms
+ *
+ * This is the index we sort and divide the interactions on.
+ */
+static inline int lowestAtomIndex(const t_iatom *atoms,
+                                  int            nral)
+{
+    int a = atoms[0];
+    for (int i = 1; i < nral; i++)
+    {
+        a = std::min(a, atoms[i]);
+    }
+
+    return a;
+}
+
 /*! \brief Divides listed interactions over threads
  *
  * This routine attempts to divide all interactions of the ntype bondeds
@@ -101,7 +119,7 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
         ind[f]    = 0;
         /* Initialize the next atom index array */
         assert(ild[f].il->nr > 0);
-        at_ind[f] = ild[f].il->iatoms[1];
+        at_ind[f] = lowestAtomIndex(ild[f].il->iatoms + 1, ild[f].nat);
     }
 
     nat_sum = 0;
@@ -132,15 +150,12 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
         while (nat_sum < nat_thread)
         {
             /* To divide bonds based on atom order, we compare
-             * the index of the first atom in the bonded interaction.
-             * This works well, since the domain decomposition generates
-             * bondeds in order of the atoms by looking up interactions
-             * which are linked to the first atom in each interaction.
-             * It usually also works well without DD, since than the atoms
-             * in bonded interactions are usually in increasing order.
-             * If they are not assigned in increasing order, the balancing
-             * is still good, but the memory access and reduction cost will
-             * be higher.
+             * the lowest atom index in the bonded interaction.
+             * This works well, since sortBondedsOnAtomIndex() has
+             * sorted the interactions of each type on this index.
+             * With domain decomposition the local atom order follows
+             * the spatial order of the pair search grid, so each thread
+             * gets interactions in a compact region of space.
              */
             int f_min;
 
@@ -164,7 +179,7 @@ static void divide_bondeds_by_locality(bonded_threading_t *bt,
             /* Update the first unassigned atom index for this type */
             if (ind[f_min] < ild[f_min].il->nr)
             {
-                at_ind[f_min] = ild[f_min].il->iatoms[ind[f_min] + 1];
+                at_ind[f_min] = lowestAtomIndex(ild[f_min].il->iatoms + ind[f_min] + 1, ild[f_min].nat);
             }
             else
             {
@@ -201,6 +216,102 @@ static bool ftypeHasPerturbedEntries(const t_idef  &idef,
     return (idef.ilsort != ilsortNO_FE && ilist.nr_nonperturbed != ilist.nr);
 }
 
+//! Return whether the interactions of type \p ftype can be reordered
+static bool ftypeCanBeReordered(int ftype)
+{
+    /* Distance and orientation restraints with the same label
+     * need to be consecutive and in order.
+     */
+    return (ftype_is_bonded_potential(ftype) &&
+            ftype != F_DISRES && ftype != F_ORIRES);
+}
+
+/*! \brief Sorts the interactions in \p iatoms between \p start and \p end on their lowest atom index
+ *
+ * Interactions with the same lowest atom index keep their order,
+ * so multiple dihedrals acting on the same atoms stay consecutive.
+ *
+ * \param[in,out] iatoms  The interaction list
+ * \param[in]     start   Start index in \p iatoms
+ * \param[in]     end     End index in \p iatoms
+ * \param[in]     nral    The number of atoms per interaction
+ * \param[in,out] keys    Work buffer for the sort keys
+ * \param[in,out] buffer  Work buffer for a copy of the interactions
+ */
+static void sortInteractionsOnLowestAtom(t_iatom                          *iatoms,
+                                         int                               start,
+                                         int                               end,
+                                         int                               nral,
+                                         std::vector<std::pair<int, int> > *keys,
+                                         std::vector<t_iatom>             *buffer)
+{
+    const int stride = 1 + nral;
+
+    /* Usually the interactions are nearly sorted, without DD often fully */
+    bool      isSorted = true;
+    int       prevKey  = -1;
+    for (int i = start; i < end && isSorted; i += stride)
+    {
+        const int key = lowestAtomIndex(iatoms + i + 1, nral);
+        isSorted      = (key >= prevKey);
+        prevKey       = key;
+    }
+    if (isSorted)
+    {
+        return;
+    }
+
+    /* Sorting on (key, index) gives the same result as a stable sort on key */
+    keys->clear();
+    for (int i = start; i < end; i += stride)
+    {
+        keys->emplace_back(lowestAtomIndex(iatoms + i + 1, nral), i);
+    }
+    std::sort(keys->begin(), keys->end());
+
+    buffer->assign(iatoms + start, iatoms + end);
+    int dest = start;
+    for (const auto &key : *keys)
+    {
+        const t_iatom *src = buffer->data() + key.second - start;
+        std::copy(src, src + stride, iatoms + dest);
+        dest += stride;
+    }
+}
+
+/*! \brief Sorts the bonded interactions of each type on atom index
+ *
+ * This improves the memory access locality of the bonded kernels
+ * and lets divide_bondeds_by_locality() give each thread a compact
+ * atom range, which reduces the number of force buffer blocks that
+ * need to be reduced over threads. With free-energy perturbation
+ * the perturbed interactions are kept at the end of the lists.
+ */
+static void sortBondedsOnAtomIndex(t_idef *idef)
+{
+    std::vector<std::pair<int, int> > keys;
+    std::vector<t_iatom>              buffer;
+
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        t_ilist *il = &idef->il[ftype];
+
+        if (!ftypeCanBeReordered(ftype) || il->nr == 0)
+        {
+            continue;
+        }
+
+        const int nral            = NRAL(ftype);
+        const int numNonperturbed =
+            (idef->ilsort == ilsortFE_SORTED ? il->nr_nonperturbed : il->nr);
+
+        sortInteractionsOnLowestAtom(il->iatoms, 0, numNonperturbed, nral,
+                                     &keys, &buffer);
+        sortInteractionsOnLowestAtom(il->iatoms, numNonperturbed, il->nr, nral,
+                                     &keys, &buffer);
+    }
+}
+
 //! Divides bonded interactions over threads and GPU
 static void divide_bondeds_over_threads(bonded_threading_t *bt,
                                         bool                useGpuForBondeds,
@@ -409,12 +520,17 @@ calc_bonded_reduction_mask(int                       natoms,
 void setup_bonded_threading(bonded_threading_t *bt,
                             int                 numAtoms,
                             bool                useGpuForBondeds,
-                            const t_idef       &idef)
+                            t_idef             *idef_ptr)
 {
     int                 ctot = 0;
 
     assert(bt->nthreads >= 1);
 
+    /* Sort the bondeds on atom index for locality */
+    sortBondedsOnAtomIndex(idef_ptr);
+
+    const t_idef &idef = *idef_ptr;
+
     /* Divide the bonded interaction over the threads */
     divide_bondeds_over_threads(bt, useGpuForBondeds, idef);
 
@@ -53,13 +53,15 @@ struct t_idef;
  *
  * Uses fr->nthreads for the number of threads, and sets up the
  * thread-force buffer reduction.
+ * Before dividing, the bonded interactions in \p idef are sorted
+ * on local atom index, except for distance and orientation restraints.
  * This should be called each time the bonded setup changes;
  * i.e. at start-up without domain decomposition and at DD.
  */
 void setup_bonded_threading(bonded_threading_t *bt,
                             int                 numAtoms,
                             bool                useGpuForBondes,
-                            const t_idef       &idef);
+                            t_idef             *idef);
 
 //! Destructor.
 void tear_down_bonded_threading(bonded_threading_t *bt);
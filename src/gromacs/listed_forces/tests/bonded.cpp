@@ -51,12 +51,14 @@
 #include <gtest/gtest.h>
 
 #include "gromacs/listed_forces/listed_forces.h"
+#include "gromacs/math/paddedvector.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/topology/idef.h"
 #include "gromacs/utility/strconvert.h"
 
@@ -685,6 +687,147 @@ INSTANTIATE_TEST_CASE_P(Polarize, ListedForcesTest, ::testing::Combine(::testing
 
 INSTANTIATE_TEST_CASE_P(Restraints, ListedForcesTest, ::testing::Combine(::testing::ValuesIn(c_InputRestraints), ::testing::ValuesIn(c_coordinatesForTests), ::testing::ValuesIn(c_pbcForTests)));
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief Returns the coordinates of an irregular helical chain of atoms
+ *
+ * This gives many different dihedral angles, so the SIMD kernels
+ * are tested on more interactions than the SIMD width.
+ * The coordinates are padded, since the SIMD kernels load
+ * the coordinates with gatherLoadUTranspose, which reads
+ * beyond the last coordinate.
+ */
+gmx::PaddedVector<gmx::RVec> chainCoordinates(int numAtoms)
+{
+    gmx::PaddedVector<gmx::RVec> x(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const real radius = 0.15 + 0.03*std::sin(3.1*i);
+        x[i] = gmx::RVec(radius*std::cos(1.9*i), radius*std::sin(1.9*i), 0.12*i);
+    }
+    return x;
+}
+
+/*! \brief Checks that the forces of a SIMD kernel match the reference forces
+ *
+ * \param[in] fRef   Forces of the reference kernel
+ * \param[in] fSimd  Forces of the SIMD kernel
+ */
+void checkSimdForces(const std::vector<gmx::RVec> &fRef,
+                     const std::vector<gmx::RVec> &fSimd)
+{
+    real fMax = 0;
+    for (const auto &f : fRef)
+    {
+        fMax = std::max(fMax, norm(f));
+    }
+    for (size_t i = 0; i < fRef.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(fRef[i][d], fSimd[i][d], test::relativeToleranceAsFloatingPoint(fMax, 1e-4));
+        }
+    }
+}
+
+//! Returns the forces in the first \p numAtoms elements of \p f4 as a vector of RVec
+std::vector<gmx::RVec> toRVecs(const rvec4 f4[], int numAtoms)
+{
+    std::vector<gmx::RVec> f;
+    for (int i = 0; i < numAtoms; i++)
+    {
+        f.emplace_back(f4[i][XX], f4[i][YY], f4[i][ZZ]);
+    }
+    return f;
+}
+
+TEST(ListedForcesSimdTest, ImproperDihedralsNoEnergyMatchReference)
+{
+    constexpr int                numAtoms = 15;
+    gmx::PaddedVector<gmx::RVec> x        = chainCoordinates(numAtoms);
+
+    t_iparams                    iparams[2];
+    iparams[0].harmonic.rA  = -170.0;
+    iparams[0].harmonic.krA = 50.0;
+    iparams[0].harmonic.rB  = iparams[0].harmonic.rA;
+    iparams[0].harmonic.krB = iparams[0].harmonic.krA;
+    iparams[1].harmonic.rA  = 170.0;
+    iparams[1].harmonic.krA = 80.0;
+    iparams[1].harmonic.rB  = iparams[1].harmonic.rA;
+    iparams[1].harmonic.krB = iparams[1].harmonic.krA;
+
+    std::vector<t_iatom> iatoms;
+    for (int i = 0; i + 3 < numAtoms; i++)
+    {
+        iatoms.insert(iatoms.end(), { i % 2, i, i + 1, i + 2, i + 3 });
+    }
+
+    matrix box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+    t_pbc  pbc;
+    set_pbc(&pbc, epbcXYZ, box);
+
+    rvec4  fRef[numAtoms]  = {{0}};
+    rvec4  fSimd[numAtoms] = {{0}};
+    rvec   fshift[N_IVEC]  = {{0}};
+    real   dvdlambda       = 0;
+
+    idihs(iatoms.size(), iatoms.data(), iparams, as_rvec_array(x.data()),
+          fRef, fshift, &pbc, nullptr, 0, &dvdlambda, nullptr, nullptr, nullptr);
+    idihs_noener_simd(iatoms.size(), iatoms.data(), iparams, as_rvec_array(x.data()),
+                      fSimd, &pbc, nullptr, 0, nullptr, nullptr, nullptr);
+
+    checkSimdForces(toRVecs(fRef, numAtoms), toRVecs(fSimd, numAtoms));
+}
+
+TEST(ListedForcesSimdTest, CmapNoEnergyMatchReference)
+{
+    constexpr int                numAtoms = 16;
+    gmx::PaddedVector<gmx::RVec> x        = chainCoordinates(numAtoms);
+
+    /* Two grids with smoothly varying, but otherwise arbitrary, data */
+    gmx_cmap_t cmapGrid;
+    cmapGrid.grid_spacing = 24;
+    cmapGrid.cmapdata.resize(2);
+    for (int g = 0; g < 2; g++)
+    {
+        cmapGrid.cmapdata[g].cmap.resize(4*cmapGrid.grid_spacing*cmapGrid.grid_spacing);
+        for (size_t k = 0; k < cmapGrid.cmapdata[g].cmap.size(); k++)
+        {
+            cmapGrid.cmapdata[g].cmap[k] = (g + 1)*std::sin(0.37*k + g);
+        }
+    }
+
+    t_iparams iparams[2];
+    iparams[0].cmap.cmapA = 0;
+    iparams[0].cmap.cmapB = 0;
+    iparams[1].cmap.cmapA = 1;
+    iparams[1].cmap.cmapB = 1;
+
+    std::vector<t_iatom> iatoms;
+    for (int i = 0; i + 4 < numAtoms; i++)
+    {
+        iatoms.insert(iatoms.end(), { i % 2, i, i + 1, i + 2, i + 3, i + 4 });
+    }
+
+    matrix box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+    t_pbc  pbc;
+    set_pbc(&pbc, epbcXYZ, box);
+
+    rvec4  fRef[numAtoms]  = {{0}};
+    rvec4  fSimd[numAtoms] = {{0}};
+    rvec   fshift[N_IVEC]  = {{0}};
+    real   dvdlambda       = 0;
+
+    cmap_dihs(iatoms.size(), iatoms.data(), iparams, &cmapGrid, as_rvec_array(x.data()),
+              fRef, fshift, &pbc, nullptr, 0, &dvdlambda, nullptr, nullptr, nullptr);
+    cmap_dihs_noener_simd(iatoms.size(), iatoms.data(), iparams, &cmapGrid, as_rvec_array(x.data()),
+                          fSimd, &pbc, nullptr, 0, nullptr, nullptr, nullptr);
+
+    checkSimdForces(toRVecs(fRef, numAtoms), toRVecs(fSimd, numAtoms));
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 }  // namespace
 
 }  // namespace gmx
@@ -0,0 +1,485 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the sorting and the thread division of the bonded interactions.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/listed_forces/listed_forces.h"
+#include "gromacs/listed_forces/manage_threading.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/force.h"
+#include "gromacs/mdlib/force_flags.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/fcdata.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of atoms in the chain
+constexpr int  c_numAtoms     = 200;
+//! The bond length of the chain
+constexpr real c_bondLength   = 0.15;
+//! The edge of the cubic periodic box
+constexpr real c_boxSize      = 2.5;
+//! Every this many interactions is perturbed, when there are perturbed interactions
+constexpr int  c_perturbEvery = 5;
+//! The interaction types we compute, with a normal and a perturbed parameter type for each
+const std::array<int, 3> c_ftypes = {{ F_BONDS, F_ANGLES, F_PDIHS }};
+
+//! The forces, shift forces and energies of the bonded interactions
+struct BondedOutput
+{
+    //! The forces
+    std::vector<RVec>    f;
+    //! The shift forces
+    std::vector<RVec>    fshift;
+    //! The energy for each type in c_ftypes
+    std::array<real, 3>  energy;
+    //! dV/dlambda
+    real                 dvdl;
+};
+
+/*! \brief A chain of atoms with bonds, angles and proper dihedrals
+ *
+ * The coordinates are put in a periodic box, so interactions across
+ * the boundaries contribute to the shift forces.
+ * The interactions are shuffled and the atom order within half of them
+ * is reversed, so sorting is required to obtain atom order. With
+ * perturbed interactions, these are at the end of the lists, as after
+ * the free-energy sorting done at domain decomposition.
+ */
+class BondedChain
+{
+    public:
+        //! Sets up the chain, with perturbed interactions when \p havePerturbed
+        explicit BondedChain(bool havePerturbed) :
+            lambda_(efptNR, 0.3)
+        {
+            DefaultRandomEngine           rng(123456);
+            UniformRealDistribution<real> uniform(-1, 1);
+
+            clear_mat(box_);
+            for (int d = 0; d < DIM; d++)
+            {
+                box_[d][d] = c_boxSize;
+            }
+            set_pbc(&pbc_, epbcXYZ, box_);
+
+            /* A random walk with fixed step length, put in the box */
+            RVec                          x = { 0, 0, 0 };
+            for (int i = 0; i < c_numAtoms; i++)
+            {
+                RVec xInBox;
+                for (int d = 0; d < DIM; d++)
+                {
+                    xInBox[d] = x[d] - c_boxSize*std::floor(x[d]/c_boxSize);
+                }
+                x_.push_back(xInBox);
+                RVec step;
+                do
+                {
+                    step = { uniform(rng), uniform(rng), uniform(rng) };
+                }
+                while (norm2(step) > 1 || norm2(step) < 0.1);
+                svmul(c_bondLength/norm(step), step, step);
+                x += step;
+            }
+
+            for (int p = 0; p < 2; p++)
+            {
+                /* The B-state differs for the perturbed parameter types */
+                const real scaleB = (p == 0 ? 1 : 1.2);
+
+                t_iparams  bond   = {{ 0 }};
+                bond.harmonic.rA  = 1.02*c_bondLength;
+                bond.harmonic.krA = 2e5;
+                bond.harmonic.rB  = scaleB*bond.harmonic.rA;
+                bond.harmonic.krB = scaleB*bond.harmonic.krA;
+                iparams_.push_back(bond);
+                functype_.push_back(F_BONDS);
+
+                t_iparams  angle   = {{ 0 }};
+                angle.harmonic.rA  = 109.5;
+                angle.harmonic.krA = 400;
+                angle.harmonic.rB  = scaleB*angle.harmonic.rA;
+                angle.harmonic.krB = scaleB*angle.harmonic.krA;
+                iparams_.push_back(angle);
+                functype_.push_back(F_ANGLES);
+
+                t_iparams  dihedral = {{ 0 }};
+                dihedral.pdihs.phiA = 0;
+                dihedral.pdihs.cpA  = 5;
+                dihedral.pdihs.mult = 3;
+                dihedral.pdihs.phiB = scaleB*30;
+                dihedral.pdihs.cpB  = scaleB*dihedral.pdihs.cpA;
+                iparams_.push_back(dihedral);
+                functype_.push_back(F_PDIHS);
+            }
+
+            for (size_t t = 0; t < c_ftypes.size(); t++)
+            {
+                const int                         ftype = c_ftypes[t];
+                const int                         nral  = NRAL(ftype);
+
+                std::vector< std::vector<t_iatom> > interactions;
+                for (int i = 0; i + nral <= c_numAtoms; i++)
+                {
+                    const bool           perturbed = (havePerturbed && i % c_perturbEvery == 0);
+                    std::vector<t_iatom> interaction;
+                    interaction.push_back(perturbed ? c_ftypes.size() + t : t);
+                    for (int a = 0; a < nral; a++)
+                    {
+                        interaction.push_back(i % 2 == 0 ? i + a : i + nral - 1 - a);
+                    }
+                    interactions.push_back(interaction);
+                }
+                std::shuffle(interactions.begin(), interactions.end(), rng);
+                const auto isNotPerturbed = [](const std::vector<t_iatom> &interaction)
+                    {
+                        return interaction[0] < static_cast<t_iatom>(c_ftypes.size());
+                    };
+                const auto firstPerturbed =
+                    std::stable_partition(interactions.begin(), interactions.end(), isNotPerturbed);
+
+                numNonperturbed_[t] = (firstPerturbed - interactions.begin())*(1 + nral);
+                for (const auto &interaction : interactions)
+                {
+                    iatoms_[t].insert(iatoms_[t].end(), interaction.begin(), interaction.end());
+                }
+            }
+            havePerturbed_ = havePerturbed;
+        }
+
+        /*! \brief Returns a t_idef with our, unsorted, interactions
+         *
+         * The returned object refers to data owned by this object.
+         */
+        t_idef makeIdef()
+        {
+            for (size_t t = 0; t < c_ftypes.size(); t++)
+            {
+                iatomsWork_[t] = iatoms_[t];
+            }
+
+            t_idef idef = {};
+            idef.ntypes   = iparams_.size();
+            idef.functype = functype_.data();
+            idef.iparams  = iparams_.data();
+            idef.ilsort   = (havePerturbed_ ? ilsortFE_SORTED : ilsortNO_FE);
+            for (size_t t = 0; t < c_ftypes.size(); t++)
+            {
+                t_ilist &il        = idef.il[c_ftypes[t]];
+                il.nr              = iatomsWork_[t].size();
+                il.nr_nonperturbed = numNonperturbed_[t];
+                il.iatoms          = iatomsWork_[t].data();
+                il.nalloc          = iatomsWork_[t].size();
+            }
+
+            return idef;
+        }
+
+        //! Computes the interactions serially, in the original order
+        BondedOutput computeSerially()
+        {
+            const t_idef       idef = makeIdef();
+
+            BondedOutput       output;
+            output.fshift.resize(SHIFTS, { 0, 0, 0 });
+            output.dvdl = 0;
+
+            std::vector<real>  f4(4*c_numAtoms, 0);
+            for (size_t t = 0; t < c_ftypes.size(); t++)
+            {
+                const t_ilist &il = idef.il[c_ftypes[t]];
+                output.energy[t]  =
+                    bondedFunction(c_ftypes[t])(il.nr, il.iatoms, idef.iparams,
+                                                as_rvec_array(x_.data()),
+                                                reinterpret_cast<rvec4 *>(f4.data()),
+                                                as_rvec_array(output.fshift.data()),
+                                                &pbc_, nullptr,
+                                                lambda_[efptBONDED], &output.dvdl,
+                                                nullptr, nullptr, nullptr);
+            }
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                output.f.push_back({ f4[4*a], f4[4*a + 1], f4[4*a + 2] });
+            }
+
+            return output;
+        }
+
+        /*! \brief Computes the interactions after sorting and dividing them over \p numThreads threads
+         *
+         * Without \p useTasks, calc_listed() computes the interactions.
+         * With \p useTasks, the thread tasks are computed one by one in
+         * reverse order with calcBondedForcesTask(), then reduced with
+         * reduceBondedForces(). As in do_force(), calc_listed() is then
+         * called with GMX_FORCE_BONDEDS_COMPUTED, which should not add
+         * anything.
+         */
+        BondedOutput computeWithThreads(int  numThreads,
+                                        bool useTasks)
+        {
+            t_idef       idef = makeIdef();
+
+            BondedOutput output;
+            output.f.resize(c_numAtoms, { 0, 0, 0 });
+            output.fshift.resize(SHIFTS, { 0, 0, 0 });
+
+            t_forcerec   fr;
+            fr.natoms_force = c_numAtoms;
+            fr.bMolPBC      = TRUE;
+            fr.efep         = (havePerturbed_ ? efepYES : efepNO);
+            fr.fshift       = as_rvec_array(output.fshift.data());
+
+            gmx_omp_nthreads_set(emntBonded, numThreads);
+            init_bonded_threading(nullptr, 1, &fr.bondedThreading);
+            setup_bonded_threading(fr.bondedThreading, c_numAtoms, false, &idef);
+            checkSorting(idef);
+
+            gmx_enerdata_t enerd;
+            init_enerdata(1, 0, &enerd);
+            t_nrnb         nrnb;
+            init_nrnb(&nrnb);
+            t_fcdata       fcd {};
+
+            int            forceFlags = (GMX_FORCE_FORCES | GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY | GMX_FORCE_DHDL);
+            if (useTasks)
+            {
+                EXPECT_TRUE(canComputeBondedsAsTasks(fcd, nullptr));
+                EXPECT_EQ(numThreads, numBondedTasks(fr));
+
+                real dvdl[efptNR] = { 0 };
+                for (int task = numBondedTasks(fr) - 1; task >= 0; task--)
+                {
+                    calcBondedForcesTask(task, &idef, as_rvec_array(x_.data()), &fr,
+                                         &pbc_, nullptr, &enerd, &nrnb, lambda_.data(), dvdl,
+                                         nullptr, &fcd, TRUE, nullptr);
+                }
+                reduceBondedForces(c_numAtoms, as_rvec_array(output.f.data()), &fr,
+                                   &enerd, dvdl, forceFlags);
+
+                forceFlags |= GMX_FORCE_BONDEDS_COMPUTED;
+            }
+            calc_listed(nullptr, nullptr, nullptr, &idef, as_rvec_array(x_.data()), nullptr,
+                        as_rvec_array(output.f.data()), nullptr, &fr,
+                        &pbc_, &pbc_, nullptr, &enerd, &nrnb, lambda_.data(),
+                        nullptr, &fcd, nullptr, forceFlags);
+
+            for (size_t t = 0; t < c_ftypes.size(); t++)
+            {
+                output.energy[t] = enerd.term[c_ftypes[t]];
+            }
+            output.dvdl = enerd.dvdl_nonlin[efptBONDED];
+
+            destroy_enerdata(&enerd);
+            tear_down_bonded_threading(fr.bondedThreading);
+
+            return output;
+        }
+
+    private:
+        /*! \brief Checks that the interactions in \p idef are sorted on lowest atom index
+         *
+         * With perturbed interactions, the perturbed and non-perturbed
+         * parts should each be sorted and the perturbed interactions
+         * should still be at the end.
+         */
+        void checkSorting(const t_idef &idef) const
+        {
+            for (size_t t = 0; t < c_ftypes.size(); t++)
+            {
+                const t_ilist &il     = idef.il[c_ftypes[t]];
+                const int      stride = 1 + NRAL(c_ftypes[t]);
+
+                EXPECT_EQ(numNonperturbed_[t], il.nr_nonperturbed);
+                int            prevLowestAtom = -1;
+                for (int i = 0; i < il.nr; i += stride)
+                {
+                    const bool perturbed = (il.iatoms[i] >= static_cast<t_iatom>(c_ftypes.size()));
+                    EXPECT_EQ(i >= il.nr_nonperturbed, perturbed) << "for " << interaction_function[c_ftypes[t]].name;
+                    if (i == il.nr_nonperturbed)
+                    {
+                        prevLowestAtom = -1;
+                    }
+                    const int  lowestAtom = *std::min_element(il.iatoms + i + 1, il.iatoms + i + stride);
+                    EXPECT_LT(prevLowestAtom, lowestAtom) << "for " << interaction_function[c_ftypes[t]].name;
+                    prevLowestAtom = lowestAtom;
+                }
+            }
+        }
+
+        //! The box
+        matrix                              box_;
+        //! The periodic boundary setup
+        t_pbc                               pbc_;
+        //! The coordinates
+        std::vector<RVec>                   x_;
+        //! The lambda values
+        std::vector<real>                   lambda_;
+        //! The interaction parameters, normal ones first, then perturbed ones
+        std::vector<t_iparams>              iparams_;
+        //! The function type for each parameter entry
+        std::vector<t_functype>             functype_;
+        //! The interactions for each type in c_ftypes
+        std::array<std::vector<t_iatom>, 3> iatoms_;
+        //! Copies of the interactions for sorting
+        std::array<std::vector<t_iatom>, 3> iatomsWork_;
+        //! The number of iatoms entries of non-perturbed interactions
+        std::array<int, 3>                  numNonperturbed_;
+        //! Whether there are perturbed interactions
+        bool                                havePerturbed_;
+};
+
+//! Checks that \p output matches \p reference, relative to the largest force and the total energy
+void compareOutput(const BondedOutput &reference,
+                   const BondedOutput &output)
+{
+    real maxAbsForce = 0;
+    for (const RVec &f : reference.f)
+    {
+        maxAbsForce = std::max(maxAbsForce, norm(f));
+    }
+    const FloatingPointTolerance forceTolerance =
+        relativeToleranceAsFloatingPoint(maxAbsForce, 1e-5);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], forceTolerance)
+            << "for atom " << a << " dimension " << d;
+        }
+    }
+    for (int s = 0; s < SHIFTS; s++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.fshift[s][d], output.fshift[s][d], forceTolerance)
+            << "for shift " << s << " dimension " << d;
+        }
+    }
+
+    real totalEnergy = 0;
+    for (size_t t = 0; t < c_ftypes.size(); t++)
+    {
+        totalEnergy += reference.energy[t];
+    }
+    const FloatingPointTolerance energyTolerance =
+        relativeToleranceAsFloatingPoint(totalEnergy, 1e-5);
+    for (size_t t = 0; t < c_ftypes.size(); t++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.energy[t], output.energy[t], energyTolerance)
+        << "for " << interaction_function[c_ftypes[t]].name;
+    }
+    EXPECT_REAL_EQ_TOL(reference.dvdl, output.dvdl, energyTolerance);
+}
+
+//! The number of threads and whether there are perturbed interactions
+using BondedThreadingTestParameters = std::tuple<int, bool>;
+
+//! Test fixture for the sorted and threaded bonded interactions
+class BondedThreadingTest : public ::testing::TestWithParam<BondedThreadingTestParameters>
+{
+};
+
+TEST_P(BondedThreadingTest, SortedThreadedForcesMatchSerial)
+{
+    const int          numThreads    = std::get<0>(GetParam());
+    const bool         havePerturbed = std::get<1>(GetParam());
+    BondedChain        chain(havePerturbed);
+
+    const BondedOutput reference = chain.computeSerially();
+    if (havePerturbed)
+    {
+        EXPECT_NE(reference.dvdl, 0);
+    }
+
+    compareOutput(reference, chain.computeWithThreads(numThreads, false));
+}
+
+TEST_P(BondedThreadingTest, TasksInReverseOrderMatchSerial)
+{
+    const int          numThreads    = std::get<0>(GetParam());
+    const bool         havePerturbed = std::get<1>(GetParam());
+    BondedChain        chain(havePerturbed);
+
+    const BondedOutput reference = chain.computeSerially();
+
+    compareOutput(reference, chain.computeWithThreads(numThreads, true));
+}
+
+/* Up to 4 threads the bondeds are divided uniformly over the threads,
+ * with more threads they are divided on atom locality.
+ */
+INSTANTIATE_TEST_CASE_P(ThreadCounts, BondedThreadingTest,
+                            ::testing::Combine(::testing::Values(1, 3, 8),
+                                                   ::testing::Bool()));
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
@@ -940,11 +940,14 @@ calcVerletBufferSize(const gmx_mtop_t         &mtop,
     pot_derivatives_t ljRep  = { 0, 0, 0 };
     real              repPow = mtop.ffparams.reppow;
 
-    if (ir.vdwtype == evdwCUT)
+    if (ir.vdwtype == evdwCUT || ir.vdwtype == evdwUSER)
     {
         real sw_range, md3_pswf;
 
-        switch (ir.vdw_modifier)
+        /* For user tables, which are not modified at the cut-off,
+         * we assume the Lennard-Jones form of the potential
+         */
+        switch (ir.vdwtype == evdwUSER ? eintmodNONE : ir.vdw_modifier)
         {
             case eintmodNONE:
             case eintmodPOTSHIFT:
@@ -150,6 +150,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                        history_t                    *hist,
                        rvec                         *forceForUseWithShiftForces,
                        gmx::ForceWithVirial         *forceWithVirial,
+                       gmx::ForceWithVirial         *forceWithVirialLongRange,
                        gmx_enerdata_t               *enerd,
                        t_fcdata                     *fcd,
                        matrix                        box,
@@ -342,10 +343,15 @@ void do_force_lowlevel(t_forcerec                   *fr,
                     flags);
 
 
+    /* With multiple time stepping the long-range part is only computed
+     * at slow steps.
+     */
+    const bool computeLongRange = (!(flags & GMX_FORCE_MTS) || (flags & GMX_FORCE_MTS_SLOW));
+
     /* Do long-range electrostatics and/or LJ-PME, including related short-range
      * corrections.
      */
-    if (EEL_FULL(fr->ic->eeltype) || EVDW_PME(fr->ic->vdwtype))
+    if ((EEL_FULL(fr->ic->eeltype) || EVDW_PME(fr->ic->vdwtype)) && computeLongRange)
     {
         int  status            = 0;
         real Vlr_q             = 0, Vlr_lj = 0;
@@ -394,7 +400,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                         /* Threading is only supported with the Verlet cut-off
                          * scheme and then only single particle forces (no
                          * exclusion forces) are calculated, so we can store
-                         * the forces in the normal, single forceWithVirial->force_ array.
+                         * the forces in the normal, single forceWithVirialLongRange->force_ array.
                          */
                         ewald_LRcorrection(md->homenr, cr, nthreads, t, fr, ir,
                                            md->chargeA, md->chargeB,
@@ -406,7 +412,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                                            excl, x, box, mu_tot,
                                            ir->ewald_geometry,
                                            ir->epsilon_surface,
-                                           as_rvec_array(forceWithVirial->force_.data()),
+                                           as_rvec_array(forceWithVirialLongRange->force_.data()),
                                            ewc_t.vir_q, ewc_t.vir_lj,
                                            &ewc_t.Vcorr_q, &ewc_t.Vcorr_lj,
                                            lambda[efptCOUL], lambda[efptVDW],
@@ -464,7 +470,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
                     status = gmx_pme_do(fr->pmedata,
                                         0, md->homenr - fr->n_tpi,
                                         x,
-                                        as_rvec_array(forceWithVirial->force_.data()),
+                                        as_rvec_array(forceWithVirialLongRange->force_.data()),
                                         md->chargeA, md->chargeB,
                                         md->sqrt_c6A, md->sqrt_c6B,
                                         md->sigmaA, md->sigmaB,
@@ -512,7 +518,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
 
         if (!EEL_PME(fr->ic->eeltype) && EEL_PME_EWALD(fr->ic->eeltype))
         {
-            Vlr_q = do_ewald(ir, x, as_rvec_array(forceWithVirial->force_.data()),
+            Vlr_q = do_ewald(ir, x, as_rvec_array(forceWithVirialLongRange->force_.data()),
                              md->chargeA, md->chargeB,
                              box, cr, md->homenr,
                              ewaldOutput.vir_q, fr->ic->ewaldcoeff_q,
@@ -523,8 +529,8 @@ void do_force_lowlevel(t_forcerec                   *fr,
         /* Note that with separate PME nodes we get the real energies later */
         // TODO it would be simpler if we just accumulated a single
         // long-range virial contribution.
-        forceWithVirial->addVirialContribution(ewaldOutput.vir_q);
-        forceWithVirial->addVirialContribution(ewaldOutput.vir_lj);
+        forceWithVirialLongRange->addVirialContribution(ewaldOutput.vir_q);
+        forceWithVirialLongRange->addVirialContribution(ewaldOutput.vir_lj);
         enerd->dvdl_lin[efptCOUL] += ewaldOutput.dvdl[efptCOUL];
         enerd->dvdl_lin[efptVDW]  += ewaldOutput.dvdl[efptVDW];
         enerd->term[F_COUL_RECIP]  = Vlr_q + ewaldOutput.Vcorr_q;
@@ -541,7 +547,7 @@ void do_force_lowlevel(t_forcerec                   *fr,
             pr_rvecs(debug, 0, "vir_lj_recip after corr", ewaldOutput.vir_lj, DIM);
         }
     }
-    else
+    else if (!(EEL_FULL(fr->ic->eeltype) || EVDW_PME(fr->ic->vdwtype)))
     {
         /* Is there a reaction-field exclusion correction needed?
          * With the Verlet scheme, exclusion forces are calculated
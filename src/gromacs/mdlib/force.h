@@ -154,6 +154,7 @@ void do_force_lowlevel(t_forcerec   *fr,
                        history_t    *hist,
                        rvec         f_shortrange[],
                        gmx::ForceWithVirial *forceWithVirial,
+                       gmx::ForceWithVirial *forceWithVirialLongRange,
                        gmx_enerdata_t *enerd,
                        t_fcdata     *fcd,
                        matrix       box,
@@ -164,6 +165,10 @@ void do_force_lowlevel(t_forcerec   *fr,
                        rvec         mu_tot[2],
                        int          flags,
                        const DDBalanceRegionHandler &ddBalanceRegionHandler);
-/* Call all the force routines */
+/* Call all the force routines.
+ * The long-range Ewald/PME forces and virial go to forceWithVirialLongRange,
+ * which can be the same object as forceWithVirial. With GMX_FORCE_MTS in
+ * flags they are only computed when GMX_FORCE_MTS_SLOW is also set.
+ */
 
 #endif
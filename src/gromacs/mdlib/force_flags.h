@@ -57,6 +57,16 @@
 #define GMX_FORCE_ENERGY       (1<<9)
 /* Calculate dHdl */
 #define GMX_FORCE_DHDL         (1<<10)
+/* Multiple time stepping: store the slow (PME mesh) forces separately
+ * in fr->forceMtsSlow, in addition to adding them to the normal forces
+ */
+#define GMX_FORCE_MTS          (1<<11)
+/* With GMX_FORCE_MTS, compute the slow forces at this step */
+#define GMX_FORCE_MTS_SLOW     (1<<12)
+/* The CPU bonded interactions have already been computed and reduced,
+ * as tasks together with the non-bonded interactions in do_force()
+ */
+#define GMX_FORCE_BONDEDS_COMPUTED (1<<13)
 
 /* Normally one want all energy terms and forces */
 #define GMX_FORCE_ALLFORCES    (GMX_FORCE_LISTED | GMX_FORCE_NONBONDED | GMX_FORCE_FORCES)
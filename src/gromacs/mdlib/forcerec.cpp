@@ -86,6 +86,7 @@
 #include "gromacs/nbnxm/nbnxm_geometry.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/tables/cubicsplinetable.h"
 #include "gromacs/tables/forcetable.h"
 #include "gromacs/topology/mtop_util.h"
 #include "gromacs/trajectory/trajectoryframe.h"
@@ -1218,6 +1219,11 @@ void forcerec_set_ranges(t_forcerec *fr,
     {
         fr->forceBufferForDirectVirialContributions->resize(natoms_f_novirsum);
     }
+
+    if (fr->forceMtsSlow != nullptr)
+    {
+        fr->forceMtsSlow->resize(natoms_f_novirsum);
+    }
 }
 
 static real cutoff_inf(real cutoff)
@@ -1359,16 +1365,15 @@ static void init_ewald_f_table(interaction_const_t *ic,
     }
     ic->tabq_size  = static_cast<int>(maxr*ic->tabq_scale) + 2;
 
-    sfree_aligned(ic->tabq_coul_FDV0);
-    sfree_aligned(ic->tabq_coul_F);
-    sfree_aligned(ic->tabq_coul_V);
-
-    sfree_aligned(ic->tabq_vdw_FDV0);
-    sfree_aligned(ic->tabq_vdw_F);
-    sfree_aligned(ic->tabq_vdw_V);
-
+    /* Only free the tables we replace, since done_interaction_const
+     * frees the Coulomb tables, also without Ewald electrostatics.
+     */
     if (EEL_PME_EWALD(ic->eeltype))
     {
+        sfree_aligned(ic->tabq_coul_FDV0);
+        sfree_aligned(ic->tabq_coul_F);
+        sfree_aligned(ic->tabq_coul_V);
+
         /* Create the original table data in FDV0 */
         snew_aligned(ic->tabq_coul_FDV0, ic->tabq_size*4, 32);
         snew_aligned(ic->tabq_coul_F, ic->tabq_size, 32);
@@ -1379,6 +1384,10 @@ static void init_ewald_f_table(interaction_const_t *ic,
 
     if (EVDW_PME(ic->vdwtype))
     {
+        sfree_aligned(ic->tabq_vdw_FDV0);
+        sfree_aligned(ic->tabq_vdw_F);
+        sfree_aligned(ic->tabq_vdw_V);
+
         snew_aligned(ic->tabq_vdw_FDV0, ic->tabq_size*4, 32);
         snew_aligned(ic->tabq_vdw_F, ic->tabq_size, 32);
         snew_aligned(ic->tabq_vdw_V, ic->tabq_size, 32);
@@ -1599,6 +1608,7 @@ done_interaction_const(interaction_const_t *interaction_const)
     sfree_aligned(interaction_const->tabq_coul_FDV0);
     sfree_aligned(interaction_const->tabq_coul_F);
     sfree_aligned(interaction_const->tabq_coul_V);
+    delete interaction_const->vdwUserTable;
     sfree(interaction_const);
 }
 
@@ -2053,6 +2063,40 @@ void init_forcerec(FILE                             *fp,
         fr->forceBufferForDirectVirialContributions = new std::vector<gmx::RVec>;
     }
 
+    /* With multiple time stepping the PME mesh forces are only computed
+     * every mtsFactor steps and then applied as an impulse of mtsFactor
+     * times the mesh force (RESPA). This is only supported with the md
+     * integrator, further checks are done there.
+     */
+    fr->mtsFactor = 1;
+    env           = getenv("GMX_MTS_FACTOR");
+    if (env != nullptr)
+    {
+        int mtsFactor = 0;
+        if (sscanf(env, "%d", &mtsFactor) != 1 || mtsFactor < 1)
+        {
+            gmx_fatal(FARGS, "GMX_MTS_FACTOR should be a positive integer, not '%s'", env);
+        }
+        if (ir->eI != eiMD || ir->cutoff_scheme != ecutsVERLET ||
+            !(EEL_PME(ir->coulombtype) || EVDW_PME(ir->vdwtype)))
+        {
+            GMX_LOG(mdlog.warning).asParagraph().appendText(
+                    "Multiple time stepping is only supported with the md integrator,\n"
+                    "the Verlet cut-off scheme and PME, ignoring GMX_MTS_FACTOR.");
+        }
+        else if (mtsFactor > 1)
+        {
+            fr->mtsFactor = mtsFactor;
+            GMX_LOG(mdlog.info).asParagraph().appendTextFormatted(
+                    "Using multiple time stepping: the PME mesh forces are computed every %d steps.",
+                    fr->mtsFactor);
+        }
+    }
+    if (fr->mtsFactor > 1)
+    {
+        fr->forceMtsSlow = new std::vector<gmx::RVec>;
+    }
+
     if (fr->cutoff_scheme == ecutsGROUP &&
         ncg_mtop(mtop) > fr->cg_nalloc && !DOMAINDECOMP(cr))
     {
@@ -2232,6 +2276,14 @@ void init_forcerec(FILE                             *fp,
         }
     }
 
+    if (ir->cutoff_scheme == ecutsVERLET && ic->vdwtype == evdwUSER)
+    {
+        /* The nbnxm kernels evaluate the user dispersion and repulsion
+         * with a cubic spline table, Coulomb is handled analytically.
+         */
+        fr->ic->vdwUserTable = makeUserVdwSplineTable(fp, tabfn, rtab).release();
+    }
+
     /* Tables might not be used for the potential modifier
      * interactions per se, but we still need them to evaluate
      * switch/shift dispersion corrections in this case. */
@@ -2346,8 +2398,8 @@ void init_forcerec(FILE                             *fp,
     if (fr->cutoff_scheme == ecutsVERLET)
     {
         // We checked the cut-offs in grompp, but double-check here.
-        // We have PME+LJcutoff kernels for rcoulomb>rvdw.
-        if (EEL_PME_EWALD(ir->coulombtype) && ir->vdwtype == eelCUT)
+        // We have PME+LJcutoff and PME+LJuser kernels for rcoulomb>rvdw.
+        if (EEL_PME_EWALD(ir->coulombtype) && (ir->vdwtype == eelCUT || ir->vdwtype == evdwUSER))
         {
             GMX_RELEASE_ASSERT(ir->rcoulomb >= ir->rvdw, "With Verlet lists and PME we should have rcoulomb>=rvdw");
         }
@@ -137,7 +137,7 @@ void mdAlgorithmsSetupAtomData(const t_commrec  *cr,
     setup_bonded_threading(fr->bondedThreading,
                            fr->natoms_force,
                            fr->gpuBonded != nullptr,
-                           top->idef);
+                           &top->idef);
 
     gmx_pme_reinit_atoms(fr->pmedata, numHomeAtoms, mdatoms->chargeA);
     /* This handles the PP+PME rank case where fr->pmedata is valid.
@@ -45,6 +45,7 @@
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
 #include <array>
 
 #include "gromacs/awh/awh.h"
@@ -121,6 +122,9 @@
 // PME-first ordering would suffice).
 static const bool c_disableAlternatingWait = (getenv("GMX_DISABLE_ALTERNATING_GPU_WAIT") != nullptr);
 
+//! Whether to disable computing the CPU non-bonded and bonded forces as tasks in one OpenMP region
+static const bool c_disableCpuForceTasks = (getenv("GMX_DISABLE_CPU_FORCE_TASKS") != nullptr);
+
 
 static void sum_forces(rvec f[], gmx::ArrayRef<const gmx::RVec> forceToAdd)
 {
@@ -302,6 +306,45 @@ static void post_process_forces(const t_commrec           *cr,
     }
 }
 
+/*! \brief Post-processes the separate slow forces with multiple time stepping
+ *
+ * Spreads the slow forces on virtual sites, adds their virial contribution
+ * and adds them to the normal force buffer, so \p f contains the total force.
+ * The spread slow forces are kept in \p forceWithVirialMtsSlow for the
+ * integrator.
+ */
+static void post_process_mts_slow_forces(const t_commrec           *cr,
+                                         t_nrnb                    *nrnb,
+                                         gmx_wallcycle_t            wcycle,
+                                         const gmx_localtop_t      *top,
+                                         const matrix               box,
+                                         const rvec                 x[],
+                                         rvec                       f[],
+                                         gmx::ForceWithVirial      *forceWithVirialMtsSlow,
+                                         tensor                     vir_force,
+                                         const t_graph             *graph,
+                                         const t_forcerec          *fr,
+                                         const gmx_vsite_t         *vsite,
+                                         int                        flags)
+{
+    if (vsite)
+    {
+        matrix virial = { { 0 } };
+        spread_vsite_f(vsite, x, as_rvec_array(forceWithVirialMtsSlow->force_.data()), nullptr,
+                       (flags & GMX_FORCE_VIRIAL) != 0, virial,
+                       nrnb,
+                       &top->idef, fr->ePBC, fr->bMolPBC, graph, box, cr, wcycle);
+        forceWithVirialMtsSlow->addVirialContribution(virial);
+    }
+
+    sum_forces(f, forceWithVirialMtsSlow->force_);
+
+    if (flags & GMX_FORCE_VIRIAL)
+    {
+        m_add(vir_force, forceWithVirialMtsSlow->getVirial(), vir_force);
+    }
+}
+
 static void do_nb_verlet(t_forcerec                       *fr,
                          const interaction_const_t        *ic,
                          gmx_enerdata_t                   *enerd,
@@ -352,6 +395,109 @@ static void do_nb_verlet(t_forcerec                       *fr,
     }
 }
 
+/*! \brief Computes the CPU non-bonded and bonded forces as tasks in one OpenMP region
+ *
+ * The pairlists and the thread divisions of the bonded interactions
+ * form independent tasks, each with their own output buffers.
+ * The tasks are assigned dynamically to the threads, non-bonded first,
+ * so threads that finish their non-bonded work early pick up the bonded
+ * work, instead of idling at the end of two separate regions.
+ * The busy time of both kinds of tasks, averaged over the threads, is
+ * accounted to the non-bonded and bonded subcounters and the remaining
+ * time of the region, spent waiting for the last task, to the task wait
+ * subcounter.
+ *
+ * The bonded thread output is reduced here, so do_force_lowlevel()
+ * should be called with GMX_FORCE_BONDEDS_COMPUTED.
+ */
+static void do_nb_and_bonded_tasks(t_forcerec                       *fr,
+                                   const interaction_const_t        *ic,
+                                   const t_commrec                  *cr,
+                                   const t_idef                     *idef,
+                                   const t_mdatoms                  *mdatoms,
+                                   const rvec                        x[],
+                                   rvec                             *f,
+                                   const matrix                      box,
+                                   t_fcdata                         *fcd,
+                                   const real                       *lambda,
+                                   gmx_enerdata_t                   *enerd,
+                                   const int                         flags,
+                                   const Nbnxm::InteractionLocality  ilocality,
+                                   const int                         clearF,
+                                   const int64_t                     step,
+                                   t_nrnb                           *nrnb,
+                                   gmx_wallcycle_t                   wcycle)
+{
+    nonbonded_verlet_t *nbv = fr->nbv.get();
+
+    if (nbv->pairlistSets().isDynamicPruningStepCpu(step))
+    {
+        wallcycle_sub_start(wcycle, ewcsNONBONDED_PRUNING);
+        nbv->dispatchPruneKernelCpu(ilocality, fr->shift_vec);
+        wallcycle_sub_stop(wcycle, ewcsNONBONDED_PRUNING);
+    }
+
+    /* As in do_force_lowlevel(), only single box vector shifts are required */
+    t_pbc        pbc;
+    const t_pbc *pbc_null = nullptr;
+    if (fr->bMolPBC)
+    {
+        set_pbc_dd(&pbc, fr->ePBC, DOMAINDECOMP(cr) ? cr->dd->nc : nullptr,
+                   TRUE, box);
+        pbc_null = &pbc;
+    }
+
+    const gmx_bool bCalcEnerVir      = ((flags & (GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY)) != 0);
+    int           *globalAtomIndex   = DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr;
+    const int      numNonbondedTasks = nbv->numCpuKernelTasks(ilocality);
+    const int      numTasks          = numNonbondedTasks + numBondedTasks(*fr);
+    const int      nthreads          = gmx_omp_nthreads_get(emntNonbonded);
+
+    /* dV/dlambda of bonded task 0, the other tasks use thread buffers */
+    real           dvdl[efptNR]      = { 0 };
+
+    gmx_cycles_t   cyclesNonbonded   = 0;
+    gmx_cycles_t   cyclesBonded      = 0;
+    gmx_cycles_t   cyclesStart       = gmx_cycles_read();
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) reduction(+:cyclesNonbonded, cyclesBonded)
+    for (int task = 0; task < numTasks; task++)
+    {
+        try
+        {
+            gmx_cycles_t cyclesTask = gmx_cycles_read();
+
+            if (task < numNonbondedTasks)
+            {
+                nbv->dispatchCpuKernelTask(ilocality, *ic, flags, clearF, fr, task);
+
+                cyclesNonbonded += gmx_cycles_read() - cyclesTask;
+            }
+            else
+            {
+                calcBondedForcesTask(task - numNonbondedTasks, idef, x, fr,
+                                     pbc_null, nullptr, enerd, nrnb, lambda, dvdl,
+                                     mdatoms, fcd, bCalcEnerVir, globalAtomIndex);
+
+                cyclesBonded += gmx_cycles_read() - cyclesTask;
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    const double cyclesRegion = gmx_cycles_read() - cyclesStart;
+    const double cyclesBusy   = static_cast<double>(cyclesNonbonded + cyclesBonded)/nthreads;
+    wallcycle_sub_add(wcycle, ewcsNONBONDED, static_cast<double>(cyclesNonbonded)/nthreads);
+    wallcycle_sub_add(wcycle, ewcsLISTED, static_cast<double>(cyclesBonded)/nthreads);
+    wallcycle_sub_add(wcycle, ewcsFORCE_TASKS_WAIT, std::max(cyclesRegion - cyclesBusy, 0.0));
+
+    nbv->finishCpuKernelTasks(ilocality, *ic, flags, fr, enerd, nrnb);
+
+    wallcycle_sub_start(wcycle, ewcsLISTED_BUF_OPS);
+    reduceBondedForces(fr->natoms_force, f, fr, enerd, dvdl, flags);
+    wallcycle_sub_stop(wcycle, ewcsLISTED_BUF_OPS);
+}
+
 gmx_bool use_GPU(const nonbonded_verlet_t *nbv)
 {
     return nbv != nullptr && nbv->useGpu();
@@ -706,14 +852,27 @@ static void alternatePmeNbGpuWaitReduce(nonbonded_verlet_t                  *nbv
 struct ForceOutputs
 {
     //! Constructor
-    ForceOutputs(rvec *f, gmx::ForceWithVirial const forceWithVirial) :
+    ForceOutputs(rvec *f, gmx::ForceWithVirial const forceWithVirial,
+                 gmx::ForceWithVirial const forceWithVirialMtsSlow, bool haveMtsSlow) :
         f(f),
-        forceWithVirial(forceWithVirial) {}
+        forceWithVirial(forceWithVirial),
+        forceWithVirialMtsSlow(forceWithVirialMtsSlow),
+        haveMtsSlow(haveMtsSlow) {}
+
+    //! Returns the force and virial output for the long-range (PME mesh) contributions
+    gmx::ForceWithVirial &forceWithVirialLongRange()
+    {
+        return haveMtsSlow ? forceWithVirialMtsSlow : forceWithVirial;
+    }
 
     //! Force output buffer used by legacy modules (without SIMD padding)
     rvec                 *const f;
     //! Force with direct virial contribution (if there are any; without SIMD padding)
     gmx::ForceWithVirial        forceWithVirial;
+    //! With multiple time stepping, the separate slow forces with their virial contribution
+    gmx::ForceWithVirial        forceWithVirialMtsSlow;
+    //! Whether forceWithVirialMtsSlow is in use at this step
+    const bool                  haveMtsSlow;
 };
 
 /*! \brief Set up the different force buffers; also does clearing.
@@ -723,6 +882,7 @@ struct ForceOutputs
  * \param[in] force     force array
  * \param[in] bDoForces True if force are computed this step
  * \param[in] doVirial  True if virial is computed this step
+ * \param[in] doMtsSlow True if the slow forces are computed separately this step
  * \param[out] wcycle   wallcycle recording structure
  *
  * \returns             Cleared force output structure
@@ -733,6 +893,7 @@ setupForceOutputs(const t_forcerec                    *fr,
                   gmx::ArrayRefWithPadding<gmx::RVec>  force,
                   const bool                           bDoForces,
                   const bool                           doVirial,
+                  const bool                           doMtsSlow,
                   gmx_wallcycle_t                      wcycle)
 {
     wallcycle_sub_start(wcycle, ewcsCLEAR_FORCE_BUFFER);
@@ -768,6 +929,18 @@ setupForceOutputs(const t_forcerec                    *fr,
         clear_rvecs_omp(forceWithVirial.force_.size(), as_rvec_array(forceWithVirial.force_.data()));
     }
 
+    /* With multiple time stepping the slow forces are kept apart,
+     * as the integrator applies them with a different weight.
+     */
+    const bool           haveMtsSlow = (bDoForces && doMtsSlow);
+    gmx::ForceWithVirial forceWithVirialMtsSlow(haveMtsSlow ?
+                                                *fr->forceMtsSlow : gmx::ArrayRef<gmx::RVec>(),
+                                                doVirial);
+    if (haveMtsSlow)
+    {
+        clear_rvecs_omp(forceWithVirialMtsSlow.force_.size(), as_rvec_array(forceWithVirialMtsSlow.force_.data()));
+    }
+
     if (inputrec.bPull && pull_have_constraint(inputrec.pull_work))
     {
         clear_pull_forces(inputrec.pull_work);
@@ -775,7 +948,7 @@ setupForceOutputs(const t_forcerec                    *fr,
 
     wallcycle_sub_stop(wcycle, ewcsCLEAR_FORCE_BUFFER);
 
-    return ForceOutputs(f, forceWithVirial);
+    return ForceOutputs(f, forceWithVirial, forceWithVirialMtsSlow, haveMtsSlow);
 }
 
 
@@ -847,6 +1020,9 @@ static void do_force_cutsVERLET(FILE *fplog,
     bUseGPU       = fr->nbv->useGpu();
     bUseOrEmulGPU = bUseGPU || fr->nbv->emulateGpu();
 
+    /* Whether the halo coordinate communication is in flight */
+    bool haloXInFlight = false;
+
     const auto pmeRunMode = fr->pmedata ? pme_run_mode(fr->pmedata) : PmeRunMode::CPU;
     // TODO slim this conditional down - inputrec and duty checks should mean the same in proper code!
     const bool useGpuPme  = EEL_PME(fr->ic->eeltype) && thisRankHasDuty(cr, DUTY_PME) &&
@@ -855,6 +1031,13 @@ static void do_force_cutsVERLET(FILE *fplog,
         ((flags & GMX_FORCE_VIRIAL) ? GMX_PME_CALC_ENER_VIR : 0) |
         ((flags & GMX_FORCE_ENERGY) ? GMX_PME_CALC_ENER_VIR : 0) |
         ((flags & GMX_FORCE_FORCES) ? GMX_PME_CALC_F : 0);
+    /* With multiple time stepping we only compute the PME mesh part
+     * at slow steps, and then store it separately.
+     */
+    const bool useMts         = ((flags & GMX_FORCE_MTS) != 0);
+    const bool computePmeMesh = (!useMts || (flags & GMX_FORCE_MTS_SLOW));
+    const bool doMtsSlow      = (useMts && computePmeMesh);
+    GMX_RELEASE_ASSERT(!useMts || !useGpuPme, "Multiple time stepping is not supported with PME on a GPU");
 
     /* At a search step we need to start the first balancing region
      * somewhere early inside the step after communication during domain
@@ -910,7 +1093,7 @@ static void do_force_cutsVERLET(FILE *fplog,
                                  fr->shift_vec, nbv->nbat.get());
 
 #if GMX_MPI
-    if (!thisRankHasDuty(cr, DUTY_PME))
+    if (!thisRankHasDuty(cr, DUTY_PME) && computePmeMesh)
     {
         /* Send particle coordinates to the pme nodes.
          * Since this is only implemented for domain decomposition
@@ -1086,10 +1269,23 @@ static void do_force_cutsVERLET(FILE *fplog,
         }
         else
         {
-            dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+            if (!bUseOrEmulGPU)
+            {
+                /* With the non-bonded work on the CPU, we can overlap
+                 * the halo communication with the local non-bonded kernel.
+                 */
+                haloXInFlight = dd_move_x_start(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+            }
+            else
+            {
+                dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+            }
 
-            nbv->setCoordinates(Nbnxm::AtomLocality::NonLocal, false,
-                                x.unpaddedArrayRef(), wcycle);
+            if (!haloXInFlight)
+            {
+                nbv->setCoordinates(Nbnxm::AtomLocality::NonLocal, false,
+                                    x.unpaddedArrayRef(), wcycle);
+            }
         }
 
         if (bUseGPU)
@@ -1196,7 +1392,8 @@ static void do_force_cutsVERLET(FILE *fplog,
     wallcycle_start(wcycle, ewcFORCE);
 
     // set up and clear force outputs
-    struct ForceOutputs forceOut = setupForceOutputs(fr, *inputrec, force, bDoForces, ((flags & GMX_FORCE_VIRIAL) != 0), wcycle);
+    struct ForceOutputs forceOut = setupForceOutputs(fr, *inputrec, force, bDoForces, ((flags & GMX_FORCE_VIRIAL) != 0),
+                                                     doMtsSlow, wcycle);
 
     /* We calculate the non-bonded forces, when done on the CPU, here.
      * We do this before calling do_force_lowlevel, because in that
@@ -1206,10 +1403,46 @@ static void do_force_cutsVERLET(FILE *fplog,
      * decomposition load balancing.
      */
 
+    /* Without GPU, the CPU non-bonded and bonded forces can be computed
+     * in one OpenMP region with dynamic task assignment. With domain
+     * decomposition the bondeds need the halo coordinates, so they are
+     * then combined with the non-local instead of the local non-bondeds.
+     */
+    const bool computeBondedsInTasks = (!bUseOrEmulGPU && !c_disableCpuForceTasks &&
+                                        (flags & GMX_FORCE_NONBONDED) &&
+                                        (flags & GMX_FORCE_LISTED) &&
+                                        haveCpuBondeds(*fr) &&
+                                        canComputeBondedsAsTasks(*fcd, graph) &&
+                                        gmx_omp_nthreads_get(emntNonbonded) > 1);
+
     if (!bUseOrEmulGPU)
     {
-        do_nb_verlet(fr, ic, enerd, flags, Nbnxm::InteractionLocality::Local, enbvClearFYes,
-                     step, nrnb, wcycle);
+        if (computeBondedsInTasks && !havePPDomainDecomposition(cr))
+        {
+            do_nb_and_bonded_tasks(fr, ic, cr, &top->idef, mdatoms,
+                                   as_rvec_array(x.unpaddedArrayRef().data()), forceOut.f,
+                                   box, fcd, lambda, enerd, flags,
+                                   Nbnxm::InteractionLocality::Local, enbvClearFYes,
+                                   step, nrnb, wcycle);
+        }
+        else
+        {
+            do_nb_verlet(fr, ic, enerd, flags, Nbnxm::InteractionLocality::Local, enbvClearFYes,
+                         step, nrnb, wcycle);
+        }
+    }
+
+    if (haloXInFlight)
+    {
+        /* All further work needs the non-local coordinates */
+        wallcycle_stop(wcycle, ewcFORCE);
+
+        dd_move_x_wait(cr->dd, wcycle);
+
+        nbv->setCoordinates(Nbnxm::AtomLocality::NonLocal, false,
+                            x.unpaddedArrayRef(), wcycle);
+
+        wallcycle_start_nocount(wcycle, ewcFORCE);
     }
 
     if (fr->efep != efepNO)
@@ -1235,7 +1468,15 @@ static void do_force_cutsVERLET(FILE *fplog,
 
     if (!bUseOrEmulGPU)
     {
-        if (havePPDomainDecomposition(cr))
+        if (computeBondedsInTasks && havePPDomainDecomposition(cr))
+        {
+            do_nb_and_bonded_tasks(fr, ic, cr, &top->idef, mdatoms,
+                                   as_rvec_array(x.unpaddedArrayRef().data()), forceOut.f,
+                                   box, fcd, lambda, enerd, flags,
+                                   Nbnxm::InteractionLocality::NonLocal, enbvClearFNo,
+                                   step, nrnb, wcycle);
+        }
+        else if (havePPDomainDecomposition(cr))
         {
             do_nb_verlet(fr, ic, enerd, flags, Nbnxm::InteractionLocality::NonLocal, enbvClearFNo,
                          step, nrnb, wcycle);
@@ -1270,9 +1511,10 @@ static void do_force_cutsVERLET(FILE *fplog,
     /* Compute the bonded and non-bonded energies and optionally forces */
     do_force_lowlevel(fr, inputrec, &(top->idef),
                       cr, ms, nrnb, wcycle, mdatoms,
-                      as_rvec_array(x.unpaddedArrayRef().data()), hist, forceOut.f, &forceOut.forceWithVirial, enerd, fcd,
+                      as_rvec_array(x.unpaddedArrayRef().data()), hist, forceOut.f, &forceOut.forceWithVirial,
+                      &forceOut.forceWithVirialLongRange(), enerd, fcd,
                       box, inputrec->fepvals, lambda, graph, &(top->excls), fr->mu_tot,
-                      flags,
+                      flags | (computeBondedsInTasks ? GMX_FORCE_BONDEDS_COMPUTED : 0),
                       ddBalanceRegionHandler);
 
     wallcycle_stop(wcycle, ewcFORCE);
@@ -1455,12 +1697,12 @@ static void do_force_cutsVERLET(FILE *fplog,
         }
     }
 
-    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME))
+    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME) && computePmeMesh)
     {
         /* In case of node-splitting, the PP nodes receive the long-range
          * forces, virial and energy from the PME nodes here.
          */
-        pme_receive_force_ener(cr, &forceOut.forceWithVirial, enerd, wcycle);
+        pme_receive_force_ener(cr, &forceOut.forceWithVirialLongRange(), enerd, wcycle);
     }
 
     if (bDoForces)
@@ -1471,6 +1713,15 @@ static void do_force_cutsVERLET(FILE *fplog,
                             flags);
     }
 
+    if (forceOut.haveMtsSlow)
+    {
+        post_process_mts_slow_forces(cr, nrnb, wcycle,
+                                     top, box, as_rvec_array(x.unpaddedArrayRef().data()), forceOut.f,
+                                     &forceOut.forceWithVirialMtsSlow,
+                                     vir_force, graph, fr, vsite,
+                                     flags);
+    }
+
     if (flags & GMX_FORCE_ENERGY)
     {
         /* Sum the potential energy terms from group contributions */
@@ -1688,7 +1939,8 @@ static void do_force_cutsGROUP(FILE *fplog,
     wallcycle_start(wcycle, ewcFORCE);
 
     // set up and clear force outputs
-    struct ForceOutputs forceOut = setupForceOutputs(fr, *inputrec, force, bDoForces, ((flags & GMX_FORCE_VIRIAL) != 0), wcycle);
+    struct ForceOutputs forceOut = setupForceOutputs(fr, *inputrec, force, bDoForces, ((flags & GMX_FORCE_VIRIAL) != 0),
+                                                     false, wcycle);
 
     if (inputrec->bPull && pull_have_constraint(inputrec->pull_work))
     {
@@ -1704,7 +1956,8 @@ static void do_force_cutsGROUP(FILE *fplog,
     /* Compute the bonded and non-bonded energies and optionally forces */
     do_force_lowlevel(fr, inputrec, &(top->idef),
                       cr, ms, nrnb, wcycle, mdatoms,
-                      as_rvec_array(x.unpaddedArrayRef().data()), hist, forceOut.f, &forceOut.forceWithVirial, enerd, fcd,
+                      as_rvec_array(x.unpaddedArrayRef().data()), hist, forceOut.f, &forceOut.forceWithVirial,
+                      &forceOut.forceWithVirial, enerd, fcd,
                       box, inputrec->fepvals, lambda,
                       graph, &(top->excls), fr->mu_tot,
                       flags,
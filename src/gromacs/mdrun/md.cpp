@@ -81,6 +81,7 @@
 #include "gromacs/mdlib/force.h"
 #include "gromacs/mdlib/force_flags.h"
 #include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/md_support.h"
 #include "gromacs/mdlib/mdatoms.h"
 #include "gromacs/mdlib/mdoutf.h"
@@ -115,6 +116,7 @@
 #include "gromacs/mdtypes/observableshistory.h"
 #include "gromacs/mdtypes/pullhistory.h"
 #include "gromacs/mdtypes/state.h"
+#include "gromacs/nbnxm/kernel_tuning.h"
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/pbcutil/mshift.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -404,10 +406,25 @@ void gmx::Integrator::do_md()
         repl_ex = init_replica_exchange(fplog, ms, top_global->natoms, ir,
                                         replExParams);
     }
+    if (fr->mtsFactor > 1)
+    {
+        if (shellfc)
+        {
+            gmx_fatal(FARGS, "Multiple time stepping is not supported with shells or flexible constraints");
+        }
+        if (fr->pmedata && pme_run_mode(fr->pmedata) != PmeRunMode::CPU)
+        {
+            gmx_fatal(FARGS, "Multiple time stepping is not supported with PME on a GPU");
+        }
+    }
+
     /* PME tuning is only supported in the Verlet scheme, with PME for
-     * Coulomb. It is not supported with only LJ PME. */
+     * Coulomb. It is not supported with only LJ PME. With multiple
+     * time stepping the PME timings are not measured every step.
+     */
     bPMETune = (mdrunOptions.tunePme && EEL_PME(fr->ic->eeltype) &&
-                !mdrunOptions.reproducible && ir->cutoff_scheme != ecutsGROUP);
+                !mdrunOptions.reproducible && ir->cutoff_scheme != ecutsGROUP &&
+                fr->mtsFactor == 1);
 
     pme_load_balancing_t *pme_loadbal      = nullptr;
     if (bPMETune)
@@ -417,6 +434,15 @@ void gmx::Integrator::do_md()
                          &bPMETunePrinting);
     }
 
+    /* Timing the CPU non-bonded kernel setups requires stable step timings,
+     * so we can not tune while PME load balancing changes the cut-off.
+     */
+    std::unique_ptr<Nbnxm::KernelSetupTuner> kernelSetupTuner =
+        Nbnxm::makeKernelSetupTuner(mdlog, *ir, cr, *top_global, *fr, state->box,
+                                    mdrunOptions.reproducible,
+                                    !(bPMETune && pme_loadbal_is_active(pme_loadbal)) &&
+                                    wallcycle_have_counter());
+
     if (!ir->bContinuation)
     {
         if (state->flags & (1 << estV))
@@ -703,6 +729,11 @@ void gmx::Integrator::do_md()
                            &bPMETunePrinting);
         }
 
+        if (kernelSetupTuner && kernelSetupTuner->isActive() && bNStList)
+        {
+            kernelSetupTuner->tune(fr, state->box, wcycle, step);
+        }
+
         wallcycle_start(wcycle, ewcSTEP);
 
         bLastStep = (step_rel == ir->nsteps);
@@ -836,12 +867,25 @@ void gmx::Integrator::do_md()
                   do_per_step(step, nstglobalcomm) ||
                   (EI_VV(ir->eI) && inputrecNvtTrotter(ir) && do_per_step(step-1, nstglobalcomm)));
 
+        /* With multiple time stepping the slow forces are applied as
+         * an impulse every mtsFactor steps. We also compute them when we
+         * need the total force for energies, virial, dH/dl or output,
+         * but then we do not integrate with them.
+         */
+        const bool useMts            = (fr->mtsFactor > 1);
+        const bool mtsImpulseStep    = (useMts && do_per_step(step, fr->mtsFactor));
+        const bool computeSlowForces = (!useMts || mtsImpulseStep ||
+                                        bCalcVir || bCalcEner || bDoFEP ||
+                                        do_per_step(step, ir->nstfout));
+
         force_flags = (GMX_FORCE_STATECHANGED |
                        ((inputrecDynamicBox(ir)) ? GMX_FORCE_DYNAMICBOX : 0) |
                        GMX_FORCE_ALLFORCES |
                        (bCalcVir ? GMX_FORCE_VIRIAL : 0) |
                        (bCalcEner ? GMX_FORCE_ENERGY : 0) |
-                       (bDoFEP ? GMX_FORCE_DHDL : 0)
+                       (bDoFEP ? GMX_FORCE_DHDL : 0) |
+                       (useMts ? GMX_FORCE_MTS : 0) |
+                       (useMts && computeSlowForces ? GMX_FORCE_MTS_SLOW : 0)
                        );
 
         if (shellfc)
@@ -1083,6 +1127,28 @@ void gmx::Integrator::do_md()
             checkpointHandler->setSignal(walltime_accounting);
         }
 
+        if (useMts && computeSlowForces)
+        {
+            /* f contains the total force, which we have used for output.
+             * Now convert it to the force to integrate with: the fast
+             * forces plus mtsFactor times the slow forces at impulse steps
+             * and only the fast forces at other steps.
+             */
+            const real  slowForceScale = (mtsImpulseStep ? fr->mtsFactor : 0) - 1;
+            const rvec *fSlow          = as_rvec_array(fr->forceMtsSlow->data());
+            rvec       *fIntegrate     = f.rvec_array();
+            const int   nth            = gmx_omp_nthreads_get(emntUpdate);
+
+#pragma omp parallel for num_threads(nth) schedule(static)
+            for (int a = 0; a < mdatoms->homenr; a++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    fIntegrate[a][d] += slowForceScale*fSlow[a][d];
+                }
+            }
+        }
+
         /* #########   START SECOND UPDATE STEP ################# */
 
         /* at the start of step, randomize or scale the velocities ((if vv. Restriction of Andersen controlled
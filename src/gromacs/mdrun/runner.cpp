@@ -376,6 +376,16 @@ static bool gpuAccelerationOfNonbondedIsUseful(const MDLogger   &mdlog,
         }
         return false;
     }
+    if (ir->vdwtype == evdwUSER)
+    {
+        /* The GPU kernels do not support user tables */
+        if (issueWarning)
+        {
+            GMX_LOG(mdlog.warning).asParagraph()
+                .appendText("User tabulated VdW interactions are not implemented for GPUs, falling back to the CPU.");
+        }
+        return false;
+    }
     return true;
 }
 
@@ -257,6 +257,13 @@ struct t_forcerec { // NOLINT (clang-analyzer-optin.performance.Padding)
     /* TODO: Replace the pointer by an object once we got rid of C */
     std::vector<gmx::RVec>  *forceBufferForDirectVirialContributions = nullptr;
 
+    /* Multiple time stepping: the slow forces, currently the PME mesh part,
+     * are computed every mtsFactor steps (only used by the md integrator)
+     */
+    int                      mtsFactor    = 1;
+    /* Buffer for the slow forces with multiple time stepping */
+    std::vector<gmx::RVec>  *forceMtsSlow = nullptr;
+
     /* Data for PPPM/PME/Ewald */
     struct gmx_pme_t *pmedata                = nullptr;
     int               ljpme_combination_rule = 0;
@@ -38,6 +38,11 @@
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/real.h"
 
+namespace gmx
+{
+class CubicSplineTable;
+}
+
 /* Used with force switching or a constant potential shift:
  * rsw       = max(r - r_switch, 0)
  * force/p   = r^-(p+1) + c2*rsw^2 + c3*rsw^3
@@ -129,6 +134,10 @@ struct interaction_const_t
        quadruplets are: F[i], F[i+1]-F[i], V[i], 0, this is used with
        single precision x86 SIMD for aligned loads */
     real *tabq_vdw_FDV0;
+
+    /* Dispersion and repulsion table for vdwtype=user with the Verlet
+     * scheme (when used), the functions are scaled by 1/6 and 1/12 */
+    const gmx::CubicSplineTable *vdwUserTable;
 };
 
 #endif
@@ -92,7 +92,6 @@ void nbnxn_atomdata_t::resizeForceBuffers()
 /* Initializes an nbnxn_atomdata_output_t data structure */
 nbnxn_atomdata_output_t::nbnxn_atomdata_output_t(Nbnxm::KernelType  kernelType,
                                                  int                numEnergyGroups,
-                                                 int                simdEnergyBufferStride,
                                                  gmx::PinningPolicy pinningPolicy) :
     f({}, {pinningPolicy}),
     fshift({}, {pinningPolicy}),
@@ -106,7 +105,7 @@ nbnxn_atomdata_output_t::nbnxn_atomdata_output_t(Nbnxm::KernelType  kernelType,
     if (Nbnxm::kernelTypeIsSimd(kernelType))
     {
         int cj_size     = Nbnxm::JClusterSizePerKernelType[kernelType];
-        int numElements = numEnergyGroups*numEnergyGroups*simdEnergyBufferStride*(cj_size/2)*cj_size;
+        int numElements = numEnergyGroups*numEnergyGroups*cj_size;
         VSvdw.resize(numElements);
         VSc.resize(numElements);
     }
@@ -129,23 +128,134 @@ static void copy_int_to_nbat_int(const int *a, int na, int na_round,
     }
 }
 
+/* Coordinate value for filler particles in partially filled cells.
+ *
+ * We complete partially filled cells, can only be the last one in each
+ * column, with coordinates farAway. The actual coordinate value does
+ * not influence the results, since these filler particles do not interact.
+ * Clusters with normal atoms + fillers have a bounding box based only
+ * on the coordinates of the atoms. Clusters with only fillers have as
+ * the bounding box the coordinates of the first filler. Such clusters
+ * are not considered as i-entries, but they are considered as j-entries.
+ * So for performance it is better to have their bounding boxes far away,
+ * such that filler only clusters don't end up in the pair list.
+ */
+static const real farAway = -1000000;
+
+#if GMX_SIMD_HAVE_REAL
+/* Returns whether we can convert packSize atoms of a packed nbat format
+ * with SIMD operations. With half-width SIMD support, one SIMD register
+ * covers two consecutive packs.
+ */
+template<int packSize>
+static constexpr bool simdSupportsPackSize()
+{
+    return (packSize == GMX_SIMD_REAL_WIDTH ||
+            (GMX_SIMD_HAVE_HSIMD_UTIL_REAL && 2*packSize == GMX_SIMD_REAL_WIDTH));
+}
+
+/* Stores GMX_SIMD_REAL_WIDTH values of one coordinate component starting
+ * at the (aligned) start of a pack in a packed nbat format.
+ */
+template<int packSize>
+static inline void gmx_simdcall
+storePacked(real *dest, SimdReal v)
+{
+#if GMX_SIMD_HAVE_HSIMD_UTIL_REAL
+    if (packSize < GMX_SIMD_REAL_WIDTH)
+    {
+        storeDualHsimd(dest, dest + DIM*packSize, v);
+        return;
+    }
+#endif
+    store(dest, v);
+}
+
+/* Loads GMX_SIMD_REAL_WIDTH values of one coordinate component starting
+ * at the (aligned) start of a pack in a packed nbat format.
+ */
+template<int packSize>
+static inline SimdReal gmx_simdcall
+loadPacked(const real *src)
+{
+#if GMX_SIMD_HAVE_HSIMD_UTIL_REAL
+    if (packSize < GMX_SIMD_REAL_WIDTH)
+    {
+        return loadDualHsimd(src, src + DIM*packSize);
+    }
+#endif
+    return load<SimdReal>(src);
+}
+#endif // GMX_SIMD_HAVE_REAL
+
+/* Copies na rvec elements from x to xnb in a packed format, see copy_rvec_to_nbat_real */
+template<int packSize>
+static void copy_rvec_to_nbat_real_packed(const int *a, int na, int na_round,
+                                          const rvec *x,
+                                          real *xnb, int a0)
+{
+    int i = 0;
+    int j = atom_to_x_index<packSize>(a0);
+    int c = a0 & (packSize - 1);
+
+#if GMX_SIMD_HAVE_REAL
+    if (simdSupportsPackSize<packSize>() && c == 0)
+    {
+        /* Gather and transpose whole SIMD widths of atoms from x,
+         * this requires the padding of x at the end.
+         */
+        alignas(GMX_SIMD_ALIGNMENT) std::int32_t offset[GMX_SIMD_REAL_WIDTH];
+
+        for (; i + GMX_SIMD_REAL_WIDTH <= na; i += GMX_SIMD_REAL_WIDTH)
+        {
+            for (int k = 0; k < GMX_SIMD_REAL_WIDTH; k++)
+            {
+                offset[k] = a[i + k];
+            }
+            SimdReal x_S, y_S, z_S;
+            gatherLoadUTranspose<DIM>(x[0], offset, &x_S, &y_S, &z_S);
+            storePacked<packSize>(xnb + j + XX*packSize, x_S);
+            storePacked<packSize>(xnb + j + YY*packSize, y_S);
+            storePacked<packSize>(xnb + j + ZZ*packSize, z_S);
+            j += (GMX_SIMD_REAL_WIDTH/packSize)*DIM*packSize;
+        }
+    }
+#endif
+
+    for (; i < na; i++)
+    {
+        xnb[j+XX*packSize] = x[a[i]][XX];
+        xnb[j+YY*packSize] = x[a[i]][YY];
+        xnb[j+ZZ*packSize] = x[a[i]][ZZ];
+        j++;
+        c++;
+        if (c == packSize)
+        {
+            j += (DIM-1)*packSize;
+            c  = 0;
+        }
+    }
+    /* Complete the partially filled last cell with far away coordinates */
+    for (; i < na_round; i++)
+    {
+        xnb[j+XX*packSize] = farAway;
+        xnb[j+YY*packSize] = farAway;
+        xnb[j+ZZ*packSize] = farAway;
+        j++;
+        c++;
+        if (c == packSize)
+        {
+            j += (DIM-1)*packSize;
+            c  = 0;
+        }
+    }
+}
+
 void copy_rvec_to_nbat_real(const int *a, int na, int na_round,
                             const rvec *x, int nbatFormat,
                             real *xnb, int a0)
 {
-    /* We complete partially filled cells, can only be the last one in each
-     * column, with coordinates farAway. The actual coordinate value does
-     * not influence the results, since these filler particles do not interact.
-     * Clusters with normal atoms + fillers have a bounding box based only
-     * on the coordinates of the atoms. Clusters with only fillers have as
-     * the bounding box the coordinates of the first filler. Such clusters
-     * are not considered as i-entries, but they are considered as j-entries.
-     * So for performance it is better to have their bounding boxes far away,
-     * such that filler only clusters don't end up in the pair list.
-     */
-    const real farAway = -1000000;
-
-    int        i, j, c;
+    int i, j;
 
     switch (nbatFormat)
     {
@@ -184,66 +294,10 @@ void copy_rvec_to_nbat_real(const int *a, int na, int na_round,
             }
             break;
         case nbatX4:
-            j = atom_to_x_index<c_packX4>(a0);
-            c = a0 & (c_packX4-1);
-            for (i = 0; i < na; i++)
-            {
-                xnb[j+XX*c_packX4] = x[a[i]][XX];
-                xnb[j+YY*c_packX4] = x[a[i]][YY];
-                xnb[j+ZZ*c_packX4] = x[a[i]][ZZ];
-                j++;
-                c++;
-                if (c == c_packX4)
-                {
-                    j += (DIM-1)*c_packX4;
-                    c  = 0;
-                }
-            }
-            /* Complete the partially filled last cell with zeros */
-            for (; i < na_round; i++)
-            {
-                xnb[j+XX*c_packX4] = farAway;
-                xnb[j+YY*c_packX4] = farAway;
-                xnb[j+ZZ*c_packX4] = farAway;
-                j++;
-                c++;
-                if (c == c_packX4)
-                {
-                    j += (DIM-1)*c_packX4;
-                    c  = 0;
-                }
-            }
+            copy_rvec_to_nbat_real_packed<c_packX4>(a, na, na_round, x, xnb, a0);
             break;
         case nbatX8:
-            j = atom_to_x_index<c_packX8>(a0);
-            c = a0 & (c_packX8 - 1);
-            for (i = 0; i < na; i++)
-            {
-                xnb[j+XX*c_packX8] = x[a[i]][XX];
-                xnb[j+YY*c_packX8] = x[a[i]][YY];
-                xnb[j+ZZ*c_packX8] = x[a[i]][ZZ];
-                j++;
-                c++;
-                if (c == c_packX8)
-                {
-                    j += (DIM-1)*c_packX8;
-                    c  = 0;
-                }
-            }
-            /* Complete the partially filled last cell with zeros */
-            for (; i < na_round; i++)
-            {
-                xnb[j+XX*c_packX8] = farAway;
-                xnb[j+YY*c_packX8] = farAway;
-                xnb[j+ZZ*c_packX8] = farAway;
-                j++;
-                c++;
-                if (c == c_packX8)
-                {
-                    j += (DIM-1)*c_packX8;
-                    c  = 0;
-                }
-            }
+            copy_rvec_to_nbat_real_packed<c_packX8>(a, na, na_round, x, xnb, a0);
             break;
         default:
             gmx_incons("Unsupported nbnxn_atomdata_t format");
@@ -598,10 +652,10 @@ static void nbnxn_atomdata_params_init(const gmx::MDLogger &mdlog,
         // We now check for energy groups already when starting mdrun
         GMX_RELEASE_ASSERT(n_energygroups == 1, "GPU kernels do not support energy groups");
     }
-    /* Temporary storage goes as #grp^3*simd_width^2/2, so limit to 64 */
-    if (params->nenergrp > 64)
+    /* The group indices of a cluster are packed into a single int, so limit to 128 */
+    if (params->nenergrp > 128)
     {
-        gmx_fatal(FARGS, "With NxN kernels not more than 64 energy groups are supported\n");
+        gmx_fatal(FARGS, "With NxN kernels not more than 128 energy groups are supported\n");
     }
     params->neg_2log = 1;
     while (params->nenergrp > (1<<params->neg_2log))
@@ -667,8 +721,7 @@ void nbnxn_atomdata_init(const gmx::MDLogger &mdlog,
     for (int i = 0; i < nout; i++)
     {
         const auto &pinningPolicy = nbat->params().type.get_allocator().pinningPolicy();
-        nbat->out.emplace_back(kernelType, nbat->params().nenergrp, 1 << nbat->params().neg_2log,
-                               pinningPolicy);
+        nbat->out.emplace_back(kernelType, nbat->params().nenergrp, pinningPolicy);
     }
 
     nbat->buffer_flags.flag        = nullptr;
@@ -899,6 +952,44 @@ static void nbnxn_atomdata_mask_fep(nbnxn_atomdata_t     *nbat,
     }
 }
 
+/* Sets the charges and atom types of both states for all atoms,
+ * these are used by the perturbed interactions in the cluster pair lists.
+ * Note that this needs to be called before masking out perturbed atoms.
+ */
+static void nbnxn_atomdata_set_fep_params(nbnxn_atomdata_t::Params *params,
+                                          const Nbnxm::GridSet     &gridSet,
+                                          const t_mdatoms          &mdatoms)
+{
+    const int numAtoms = gridSet.numGridAtomsTotal();
+
+    params->qA.resize(numAtoms);
+    params->qB.resize(numAtoms);
+    params->typeA.resize(numAtoms);
+    params->typeB.resize(numAtoms);
+
+    gmx::ArrayRef<const int> atomIndices = gridSet.atomIndices();
+
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const int a = atomIndices[i];
+        if (a >= 0)
+        {
+            params->qA[i]    = mdatoms.chargeA[a];
+            params->qB[i]    = mdatoms.chargeB[a];
+            params->typeA[i] = mdatoms.typeA[a];
+            params->typeB[i] = mdatoms.typeB[a];
+        }
+        else
+        {
+            /* Filler particles are non-interacting */
+            params->qA[i]    = 0;
+            params->qB[i]    = 0;
+            params->typeA[i] = params->numTypes - 1;
+            params->typeB[i] = params->numTypes - 1;
+        }
+    }
+}
+
 /* Copies the energy group indices to a reordered and packed array */
 static void copy_egp_to_nbat_egps(const int *a, int na, int na_round,
                                   int na_c, int bit_shift,
@@ -972,6 +1063,8 @@ void nbnxn_atomdata_set(nbnxn_atomdata_t     *nbat,
 
     if (gridSet.haveFep())
     {
+        nbnxn_atomdata_set_fep_params(&params, gridSet, *mdatoms);
+
         nbnxn_atomdata_mask_fep(nbat, gridSet);
     }
 
@@ -1153,7 +1246,9 @@ nbnxn_atomdata_reduce_reals_simd(real gmx_unused * gmx_restrict dest,
 #endif
 }
 
-/* Add part of the force array(s) from nbnxn_atomdata_t to f */
+/* Add part of the force array(s) from nbnxn_atomdata_t to f, for the formats
+ * with xyz per atom, the packed formats are handled by add_nbat_f_packed_to_f.
+ */
 static void
 nbnxn_atomdata_add_nbat_f_to_f_part(const Nbnxm::GridSet &gridSet,
                                     const nbnxn_atomdata_t *nbat,
@@ -1197,63 +1292,112 @@ nbnxn_atomdata_add_nbat_f_to_f_part(const Nbnxm::GridSet &gridSet,
                 }
             }
             break;
-        case nbatX4:
-            if (nfa == 1)
-            {
-                const real *fnb = out[0].f.data();
+        default:
+            gmx_incons("Unsupported nbnxn_atomdata_t format");
+    }
+}
 
-                for (int a = a0; a < a1; a++)
-                {
-                    int i = atom_to_x_index<c_packX4>(cell[a]);
+/* Adds the forces of the nbat atom range [i0, i1) stored in the packed
+ * format in fnb to f. Atoms are processed in nbat order, so the reading
+ * of fnb is contiguous and the writes to f are scattered. Filler particles
+ * are skipped. Different threads can process different nbat ranges
+ * concurrently, as each real atom occurs only once in nbat.
+ */
+template<int packSize>
+static void add_nbat_f_packed_to_f(const int  *atomIndices,
+                                   const real *fnb,
+                                   int         i0,
+                                   int         i1,
+                                   rvec       *f)
+{
+    int i = i0;
 
-                    f[a][XX] += fnb[i+XX*c_packX4];
-                    f[a][YY] += fnb[i+YY*c_packX4];
-                    f[a][ZZ] += fnb[i+ZZ*c_packX4];
-                }
-            }
-            else
-            {
-                for (int a = a0; a < a1; a++)
-                {
-                    int i = atom_to_x_index<c_packX4>(cell[a]);
+#if GMX_SIMD_HAVE_REAL
+    if (simdSupportsPackSize<packSize>())
+    {
+        alignas(GMX_SIMD_ALIGNMENT) std::int32_t offset[GMX_SIMD_REAL_WIDTH];
 
-                    for (int fa = 0; fa < nfa; fa++)
-                    {
-                        f[a][XX] += out[fa].f[i+XX*c_packX4];
-                        f[a][YY] += out[fa].f[i+YY*c_packX4];
-                        f[a][ZZ] += out[fa].f[i+ZZ*c_packX4];
-                    }
-                }
-            }
-            break;
-        case nbatX8:
-            if (nfa == 1)
+        /* Process the atoms up to a SIMD width boundary one by one */
+        for (; i < i1 && i % GMX_SIMD_REAL_WIDTH != 0; i++)
+        {
+            const int a = atomIndices[i];
+            if (a >= 0)
             {
-                const real *fnb = out[0].f.data();
+                const int ind = atom_to_x_index<packSize>(i);
 
-                for (int a = a0; a < a1; a++)
-                {
-                    int i = atom_to_x_index<c_packX8>(cell[a]);
+                f[a][XX] += fnb[ind + XX*packSize];
+                f[a][YY] += fnb[ind + YY*packSize];
+                f[a][ZZ] += fnb[ind + ZZ*packSize];
+            }
+        }
 
-                    f[a][XX] += fnb[i+XX*c_packX8];
-                    f[a][YY] += fnb[i+YY*c_packX8];
-                    f[a][ZZ] += fnb[i+ZZ*c_packX8];
-                }
+        for (; i + GMX_SIMD_REAL_WIDTH <= i1; i += GMX_SIMD_REAL_WIDTH)
+        {
+            bool haveFiller = false;
+            for (int k = 0; k < GMX_SIMD_REAL_WIDTH; k++)
+            {
+                offset[k]   = atomIndices[i + k];
+                haveFiller  = haveFiller || (offset[k] < 0);
+            }
+            const int ind = atom_to_x_index<packSize>(i);
+            if (!haveFiller)
+            {
+                transposeScatterIncrU<DIM>(f[0], offset,
+                                           loadPacked<packSize>(fnb + ind + XX*packSize),
+                                           loadPacked<packSize>(fnb + ind + YY*packSize),
+                                           loadPacked<packSize>(fnb + ind + ZZ*packSize));
             }
             else
             {
-                for (int a = a0; a < a1; a++)
+                /* Only the last cluster in each column can have fillers */
+                for (int k = 0; k < GMX_SIMD_REAL_WIDTH; k++)
                 {
-                    int i = atom_to_x_index<c_packX8>(cell[a]);
-
-                    for (int fa = 0; fa < nfa; fa++)
+                    const int a = offset[k];
+                    if (a >= 0)
                     {
-                        f[a][XX] += out[fa].f[i+XX*c_packX8];
-                        f[a][YY] += out[fa].f[i+YY*c_packX8];
-                        f[a][ZZ] += out[fa].f[i+ZZ*c_packX8];
+                        const int indK = atom_to_x_index<packSize>(i + k);
+
+                        f[a][XX] += fnb[indK + XX*packSize];
+                        f[a][YY] += fnb[indK + YY*packSize];
+                        f[a][ZZ] += fnb[indK + ZZ*packSize];
                     }
                 }
             }
+        }
+    }
+#endif
+
+    for (; i < i1; i++)
+    {
+        const int a = atomIndices[i];
+        if (a >= 0)
+        {
+            const int ind = atom_to_x_index<packSize>(i);
+
+            f[a][XX] += fnb[ind + XX*packSize];
+            f[a][YY] += fnb[ind + YY*packSize];
+            f[a][ZZ] += fnb[ind + ZZ*packSize];
+        }
+    }
+}
+
+/* Adds the forces of the nbat atom range [i0, i1) in buffer fnb to f,
+ * for packed nbat force formats only.
+ */
+static void add_nbat_f_packed_to_f(const nbnxn_atomdata_t *nbat,
+                                   const int              *atomIndices,
+                                   const real             *fnb,
+                                   int                     i0,
+                                   int                     i1,
+                                   rvec                   *f)
+{
+    switch (nbat->FFormat)
+    {
+        case nbatX4:
+            add_nbat_f_packed_to_f<c_packX4>(atomIndices, fnb, i0, i1, f);
+            break;
+        case nbatX8:
+            add_nbat_f_packed_to_f<c_packX8>(atomIndices, fnb, i0, i1, f);
             break;
         default:
             gmx_incons("Unsupported nbnxn_atomdata_t format");
@@ -1395,9 +1539,18 @@ static void nbnxn_atomdata_add_nbat_f_to_f_treereduce(nbnxn_atomdata_t *nbat,
     }
 }
 
-
+/* Reduces the force output buffers into buffer 0.
+ *
+ * When f!=nullptr, which is only supported for the packed formats, each
+ * block is added to f right after it has been reduced. Each thread then
+ * reads back the part of buffer 0 it just wrote, which is still in its
+ * cache, and there is no second parallel region.
+ */
 static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbnxn_atomdata_t *nbat,
-                                                     int               nth)
+                                                     int               nth,
+                                                     const int        *atomIndices,
+                                                     int               numGridAtoms,
+                                                     rvec             *f)
 {
 #pragma omp parallel for num_threads(nth) schedule(static)
     for (int th = 0; th < nth; th++)
@@ -1443,6 +1596,16 @@ static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbnxn_atomdata_t *nbat,
                 {
                     nbnxn_atomdata_clear_reals(nbat->out[0].f,
                                                i0, i1);
+                    /* There are no forces in this block */
+                    continue;
+                }
+
+                if (f != nullptr)
+                {
+                    add_nbat_f_packed_to_f(nbat, atomIndices, nbat->out[0].f.data(),
+                                           b*NBNXN_BUFFERFLAG_SIZE,
+                                           std::min((b + 1)*NBNXN_BUFFERFLAG_SIZE, numGridAtoms),
+                                           f);
                 }
             }
         }
@@ -1458,24 +1621,37 @@ void reduceForces(nbnxn_atomdata_t          *nbat,
 {
     int a0 = 0;
     int na = 0;
+    /* The atom index range in nbat, including fillers */
+    int gridAtomBegin = 0;
+    int gridAtomEnd   = 0;
     switch (locality)
     {
         case Nbnxm::AtomLocality::All:
         case Nbnxm::AtomLocality::Count:
-            a0 = 0;
-            na = gridSet.numRealAtomsTotal();
+            a0            = 0;
+            na            = gridSet.numRealAtomsTotal();
+            gridAtomBegin = 0;
+            gridAtomEnd   = gridSet.numGridAtomsTotal();
             break;
         case Nbnxm::AtomLocality::Local:
-            a0 = 0;
-            na = gridSet.numRealAtomsLocal();
+            a0            = 0;
+            na            = gridSet.numRealAtomsLocal();
+            gridAtomBegin = 0;
+            gridAtomEnd   = gridSet.grids()[0].atomIndexEnd();
             break;
         case Nbnxm::AtomLocality::NonLocal:
-            a0 = gridSet.numRealAtomsLocal();
-            na = gridSet.numRealAtomsTotal() - gridSet.numRealAtomsLocal();
+            a0            = gridSet.numRealAtomsLocal();
+            na            = gridSet.numRealAtomsTotal() - gridSet.numRealAtomsLocal();
+            gridAtomBegin = gridSet.grids()[0].atomIndexEnd();
+            gridAtomEnd   = gridSet.numGridAtomsTotal();
             break;
     }
 
-    int nth = gmx_omp_nthreads_get(emntNonbonded);
+    int        nth = gmx_omp_nthreads_get(emntNonbonded);
+
+    /* With the packed formats we loop over the atoms in nbat order */
+    const bool nbatOrder   = (nbat->FFormat == nbatX4 || nbat->FFormat == nbatX8);
+    const int *atomIndices = gridSet.atomIndices().data();
 
     if (nbat->out.size() > 1)
     {
@@ -1493,7 +1669,14 @@ void reduceForces(nbnxn_atomdata_t          *nbat,
         }
         else
         {
-            nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbat, nth);
+            nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbat, nth,
+                                                     atomIndices, gridAtomEnd,
+                                                     nbatOrder ? f : nullptr);
+            if (nbatOrder)
+            {
+                /* The reduction has already added the forces to f */
+                return;
+            }
         }
     }
 #pragma omp parallel for num_threads(nth) schedule(static)
@@ -1501,12 +1684,28 @@ void reduceForces(nbnxn_atomdata_t          *nbat,
     {
         try
         {
-            nbnxn_atomdata_add_nbat_f_to_f_part(gridSet, nbat,
-                                                nbat->out,
-                                                1,
-                                                a0+((th+0)*na)/nth,
-                                                a0+((th+1)*na)/nth,
-                                                f);
+            if (nbatOrder)
+            {
+                /* Divide the atoms over the threads in whole flag blocks,
+                 * as in the reduction, so each thread accesses the same
+                 * part of the nbat buffer as in the reduction.
+                 */
+                const int numBlocks = (gridAtomEnd - gridAtomBegin + NBNXN_BUFFERFLAG_SIZE - 1)/NBNXN_BUFFERFLAG_SIZE;
+                const int i0        = gridAtomBegin + ((th + 0)*numBlocks)/nth*NBNXN_BUFFERFLAG_SIZE;
+                const int i1        = gridAtomBegin + ((th + 1)*numBlocks)/nth*NBNXN_BUFFERFLAG_SIZE;
+                add_nbat_f_packed_to_f(nbat, atomIndices, nbat->out[0].f.data(),
+                                       i0, std::min(i1, gridAtomEnd),
+                                       f);
+            }
+            else
+            {
+                nbnxn_atomdata_add_nbat_f_to_f_part(gridSet, nbat,
+                                                    nbat->out,
+                                                    1,
+                                                    a0+((th+0)*na)/nth,
+                                                    a0+((th+1)*na)/nth,
+                                                    f);
+            }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
@@ -96,12 +96,10 @@ struct nbnxn_atomdata_output_t
      *
      * \param[in] kernelType              Type of non-bonded kernel
      * \param[in] numEnergyGroups         The number of energy groups
-     * \param[in] simdEnergyBufferStride  Stride for entries in the energy buffers for SIMD kernels
      * \param[in] pinningPolicy           Sets the pinning policy for all buffers used on the GPU
      */
     nbnxn_atomdata_output_t(Nbnxm::KernelType  kernelType,
                             int                numEnergyGroups,
-                            int                simdEnergyBUfferStride,
                             gmx::PinningPolicy pinningPolicy);
 
     gmx::HostVector<real> f;      // f, size natoms*fstride
@@ -178,6 +176,12 @@ struct nbnxn_atomdata_t
         int                   neg_2log;
         // The energy groups, one int entry per cluster, only set when needed
         gmx::HostVector<int>  energrp;
+        // State A and B charges per atom, only set with perturbed atoms
+        std::vector<real>     qA;
+        std::vector<real>     qB;
+        // State A and B atom types per atom, only set with perturbed atoms
+        std::vector<int>      typeA;
+        std::vector<int>      typeB;
     };
 
     // Diagonal and topology exclusion helper data for all SIMD kernels
@@ -271,6 +275,7 @@ struct nbnxn_atomdata_t
 
 /* Copy na rvec elements from x to xnb using nbatFormat, start dest a0,
  * and fills up to na_round with coordinates that are far away.
+ * With SIMD, x should be padded as in gmx::PaddedVector.
  */
 void copy_rvec_to_nbat_real(const int *a, int na, int na_round,
                             const rvec *x, int nbatFormat,
@@ -90,13 +90,14 @@ enum {
  *
  * The \p LJCUT_COMB refers to the LJ combination rule for the short range.
  * The \p EWALDCOMB refers to the combination rule for the grid part.
+ * \p USERTAB refers to user-tabulated dispersion and repulsion functions.
  * \p vdwktNR is the number of VdW treatments for the SIMD kernels.
  * \p vdwktNR_ref is the number of VdW treatments for the C reference kernels.
  * These two numbers differ, because currently only the reference kernels
  * support LB combination rules for the LJ-Ewald grid part.
  */
 enum {
-    vdwktLJCUT_COMBGEOM, vdwktLJCUT_COMBLB, vdwktLJCUT_COMBNONE, vdwktLJFORCESWITCH, vdwktLJPOTSWITCH, vdwktLJEWALDCOMBGEOM, vdwktLJEWALDCOMBLB, vdwktNR = vdwktLJEWALDCOMBLB, vdwktNR_ref
+    vdwktLJCUT_COMBGEOM, vdwktLJCUT_COMBLB, vdwktLJCUT_COMBNONE, vdwktLJFORCESWITCH, vdwktLJPOTSWITCH, vdwktLJEWALDCOMBGEOM, vdwktUSERTAB, vdwktLJEWALDCOMBLB, vdwktNR = vdwktLJEWALDCOMBLB, vdwktNR_ref
 };
 
 /*! \brief Clears the force buffer.
@@ -0,0 +1,422 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ *
+ * \brief
+ * Defines the free-energy kernel for cluster-pair lists.
+ *
+ * The interactions computed here are identical to those of
+ * gmx_nb_free_energy_kernel() for pairs without soft-core, the pair
+ * interactions are evaluated with the same functions from
+ * nb_free_energy_pair.h. Forces are accumulated in the thread-local
+ * nbnxm force buffers, so no atomics are needed.
+ */
+
+#include "gmxpre.h"
+
+#include "kernel_free_energy.h"
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "gromacs/gmxlib/nonbonded/nb_free_energy_pair.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/group.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/atomdata.h"
+#include "gromacs/nbnxm/pairlist.h"
+#include "gromacs/utility/fatalerror.h"
+
+/*! \brief Returns the index of the x-component of atom \p a in an nbnxm buffer
+ *
+ * \param[in] a         The atom index
+ * \param[in] packSize  The pack size, 0 for buffers with a fixed stride per atom
+ * \param[in] stride    The stride per atom for buffers that are not packed
+ */
+static inline int bufferIndex(int a, int packSize, int stride)
+{
+    if (packSize > 0)
+    {
+        return DIM*(a & ~(packSize - 1)) + (a & (packSize - 1));
+    }
+    else
+    {
+        return a*stride;
+    }
+}
+
+//! Returns the pack size for nbnxm buffer \p format, 0 when not packed
+static inline int bufferPackSize(int format)
+{
+    switch (format)
+    {
+        case nbatX4: return c_packX4;
+        case nbatX8: return c_packX8;
+        default:     return 0;
+    }
+}
+
+//! Returns the energy group of nbnxm atom \p a
+static inline int energyGroup(const nbnxn_atomdata_t::Params &params,
+                              int                             a)
+{
+    if (params.nenergrp == 1)
+    {
+        return 0;
+    }
+
+    const int egpMask = (1 << params.neg_2log) - 1;
+
+    return (params.energrp[a/c_nbnxnCpuIClusterSize] >> ((a % c_nbnxnCpuIClusterSize)*params.neg_2log)) & egpMask;
+}
+
+void
+nbnxn_kernel_free_energy_cluster(const NbnxnPairlistFep &nbl,
+                                 const nbnxn_atomdata_t &nbat,
+                                 const t_forcerec       &fr,
+                                 const real             *lambda,
+                                 real                   *f,
+                                 rvec                   *fshift,
+                                 real                   *vCoulomb,
+                                 real                   *vVdw,
+                                 double                 *dvdl)
+{
+#define  STATE_A  0
+#define  STATE_B  1
+#define  NSTATES  2
+
+    const real                      half       = 0.5;
+
+    const interaction_const_t      &ic         = *fr.ic;
+    const nbnxn_atomdata_t::Params &params     = nbat.params();
+
+    /* Note that gmx_nb_free_energy_kernel only supports the combinations
+     * below with the Verlet scheme, so we can assume the same here.
+     */
+    const bool ewald        = EEL_PME_EWALD(ic.eeltype);
+    const bool ljEwald      = EVDW_PME(ic.vdwtype);
+    if ((ewald   && ic.coulomb_modifier == eintmodPOTSWITCH) ||
+        (ljEwald && ic.vdw_modifier     == eintmodPOTSWITCH))
+    {
+        gmx_incons("Unimplemented non-bonded setup");
+    }
+
+    const real facel        = ic.epsfac;
+    const real krf          = ic.k_rf;
+    const real crf          = ic.c_rf;
+    const real shEwald      = ic.sh_ewald;
+    const real shInvrc6     = ic.sh_invrc6;
+    const real shLJEwald    = (ljEwald ? ic.sh_lj_ewald : 0);
+    const real rcoulomb     = ic.rcoulomb;
+    const real rvdw         = ic.rvdw;
+    const real rCutoffMax2  = gmx::square(std::max(ic.rcoulomb, ic.rvdw));
+
+    const real *ewaldTable          = ic.tabq_coul_FDV0;
+    const real  ewaldTableScale     = ic.tabq_scale;
+    const real  ewaldTableHalfSpace = half/ewaldTableScale;
+    const real *ljEwaldTableF       = ic.tabq_vdw_F;
+    const real *ljEwaldTableV       = ic.tabq_vdw_V;
+
+    const bool         elecPotSwitch = (ic.coulomb_modifier == eintmodPOTSWITCH);
+    FepPotentialSwitch elecSwitch;
+    if (elecPotSwitch)
+    {
+        elecSwitch = FepPotentialSwitch(ic.rcoulomb, ic.rcoulomb_switch);
+    }
+    const bool         vdwPotSwitch = (ic.vdw_modifier == eintmodPOTSWITCH);
+    FepPotentialSwitch vdwSwitch;
+    if (vdwPotSwitch)
+    {
+        vdwSwitch = FepPotentialSwitch(ic.rvdw, ic.rvdw_switch);
+    }
+
+    /* The lambda factors and their derivatives, all interactions here are linear in lambda */
+    const real LFC[NSTATES] = { 1 - lambda[efptCOUL], lambda[efptCOUL] };
+    const real LFV[NSTATES] = { 1 - lambda[efptVDW], lambda[efptVDW] };
+    const real DLF[NSTATES] = { -1, 1 };
+
+    const int   ntype     = fr.ntype;
+    const real *nbfp      = fr.nbfp;
+    const real *nbfpGrid  = fr.ljpme_c6grid;
+    const real *qA        = params.qA.data();
+    const real *qB        = params.qB.data();
+    const int  *typeA     = params.typeA.data();
+    const int  *typeB     = params.typeB.data();
+    const int   numGroups = params.nenergrp;
+
+    const real *x         = nbat.x().data();
+    const int   xPackSize = bufferPackSize(nbat.XFormat);
+    const int   xStride   = (xPackSize > 0 ? xPackSize : 1);
+    const int   fPackSize = bufferPackSize(nbat.FFormat);
+    const int   fStride   = (fPackSize > 0 ? fPackSize : 1);
+
+    const int   na_ci     = nbl.na_ci;
+    const int   na_cj     = nbl.na_cj;
+
+    double      dvdlCoulomb = 0;
+    double      dvdlVdw     = 0;
+
+    for (const nbnxn_ci_t &ciEntry : nbl.ci)
+    {
+        const int   shift       = ciEntry.shift & NBNXN_CI_SHIFT;
+        /* As the other CPU kernels, we use the shift vectors in t_forcerec */
+        const real *shiftVector = fr.shift_vec[shift];
+
+        rvec        fShiftSum   = { 0, 0, 0 };
+
+        for (int i = 0; i < na_ci; i++)
+        {
+            const int ia   = ciEntry.ci*na_ci + i;
+            const int xi   = bufferIndex(ia, xPackSize, nbat.xstride);
+            const int fi   = bufferIndex(ia, fPackSize, nbat.fstride);
+
+            const real ix  = shiftVector[XX] + x[xi];
+            const real iy  = shiftVector[YY] + x[xi + xStride];
+            const real iz  = shiftVector[ZZ] + x[xi + 2*xStride];
+            const real iq[NSTATES]  = { facel*qA[ia], facel*qB[ia] };
+            const int  nti[NSTATES] = { ntype*typeA[ia], ntype*typeB[ia] };
+            const int  egpI = energyGroup(params, ia);
+
+            real       fix = 0;
+            real       fiy = 0;
+            real       fiz = 0;
+
+            for (int cjInd = ciEntry.cj_ind_start; cjInd < ciEntry.cj_ind_end; cjInd++)
+            {
+                const nbnxn_fep_cj_t &cjEntry = nbl.cj[cjInd];
+
+                const unsigned int    iMask       = (1U << na_cj) - 1;
+                const unsigned int    interaction = (cjEntry.interaction >> (i*na_cj)) & iMask;
+                const unsigned int    exclusion   = (cjEntry.exclusion   >> (i*na_cj)) & iMask;
+
+                if ((interaction | exclusion) == 0)
+                {
+                    continue;
+                }
+
+                for (int j = 0; j < na_cj; j++)
+                {
+                    const bool pairInteracts = ((interaction >> j) & 1) != 0;
+
+                    if (!pairInteracts && ((exclusion >> j) & 1) == 0)
+                    {
+                        continue;
+                    }
+
+                    const int  ja  = cjEntry.cj*na_cj + j;
+                    const int  xj  = bufferIndex(ja, xPackSize, nbat.xstride);
+
+                    const real dx  = ix - x[xj];
+                    const real dy  = iy - x[xj + xStride];
+                    const real dz  = iz - x[xj + 2*xStride];
+                    const real rSq = dx*dx + dy*dy + dz*dz;
+
+                    if (rSq >= rCutoffMax2)
+                    {
+                        continue;
+                    }
+
+                    /* As in the free-energy kernel, we avoid 0/0 for
+                     * excluded pairs, the force at r=0 is zero.
+                     */
+                    const real rInv  = (rSq > 0 ? gmx::invsqrt(rSq) : 0);
+                    const real r     = rSq*rInv;
+                    const real rInv2 = rInv*rInv;
+
+                    const real qq[NSTATES] = { iq[STATE_A]*qA[ja], iq[STATE_B]*qB[ja] };
+                    const int  tj[NSTATES] = { 2*(nti[STATE_A] + typeA[ja]), 2*(nti[STATE_B] + typeB[ja]) };
+
+                    /* The scalar force, with 1/r applied, and the energies */
+                    real       fScal = 0;
+                    real       vC    = 0;
+                    real       vV    = 0;
+
+                    if (pairInteracts)
+                    {
+                        /* The A and B states are computed separately with the
+                         * same functions as gmx_nb_free_energy_kernel(), as there
+                         * is no soft-core they are simply combined linearly.
+                         */
+                        for (int s = 0; s < NSTATES; s++)
+                        {
+                            real vCoulState  = 0;
+                            real rFCoulState = 0;
+                            if (qq[s] != 0 && r < rcoulomb)
+                            {
+                                if (ewald)
+                                {
+                                    /* Ewald FEP is done only on the 1/r part */
+                                    ewaldCoulomb(qq[s], rInv, shEwald, &vCoulState, &rFCoulState);
+                                }
+                                else
+                                {
+                                    reactionFieldCoulomb(qq[s], rInv, r, krf, crf, &vCoulState, &rFCoulState);
+                                }
+                                if (elecPotSwitch)
+                                {
+                                    applyPotentialSwitch(elecSwitch, r, &vCoulState, &rFCoulState);
+                                }
+                            }
+
+                            const real c6  = nbfp[tj[s]];
+                            const real c12 = nbfp[tj[s] + 1];
+                            real       vVdwState  = 0;
+                            real       rFVdwState = 0;
+                            if ((c6 != 0 || c12 != 0) && r < rvdw)
+                            {
+                                const real c6Grid = (ljEwald ? nbfpGrid[tj[s]] : 0);
+                                const real rInv6  = rInv2*rInv2*rInv2;
+
+                                lennardJones(c6, c12, c6Grid, rInv6, shInvrc6, shLJEwald, &vVdwState, &rFVdwState);
+                                if (vdwPotSwitch)
+                                {
+                                    applyPotentialSwitch(vdwSwitch, r, &vVdwState, &rFVdwState);
+                                }
+                            }
+
+                            vC          += LFC[s]*vCoulState;
+                            vV          += LFV[s]*vVdwState;
+                            fScal       += (LFC[s]*rFCoulState + LFV[s]*rFVdwState)*rInv2;
+                            dvdlCoulomb += DLF[s]*vCoulState;
+                            dvdlVdw     += DLF[s]*vVdwState;
+                        }
+                    }
+                    else if (!ewald)
+                    {
+                        real vUnit, fUnit;
+                        reactionFieldExclusionCorrection(krf, crf, rSq, &vUnit, &fUnit);
+                        if (ia == ja)
+                        {
+                            vUnit *= half;
+                        }
+                        for (int s = 0; s < NSTATES; s++)
+                        {
+                            vC          += LFC[s]*qq[s]*vUnit;
+                            fScal       += LFC[s]*qq[s]*fUnit;
+                            dvdlCoulomb += DLF[s]*qq[s]*vUnit;
+                        }
+                    }
+
+                    if (ewald && r < rcoulomb)
+                    {
+                        /* Subtract the reciprocal-space part which is
+                         * included in the mesh part, see the free-energy kernel.
+                         */
+                        real vLR, fLR;
+                        ewaldReciprocalCorrection(ewaldTable, ewaldTableScale, ewaldTableHalfSpace,
+                                                  r, rInv, &vLR, &fLR);
+                        if (ia == ja)
+                        {
+                            vLR *= half;
+                        }
+                        for (int s = 0; s < NSTATES; s++)
+                        {
+                            vC          -= LFC[s]*qq[s]*vLR;
+                            fScal       -= LFC[s]*qq[s]*fLR;
+                            dvdlCoulomb -= DLF[s]*qq[s]*vLR;
+                        }
+                    }
+
+                    if (ljEwald && r < rvdw)
+                    {
+                        /* Add the reciprocal-space part of LJ-PME */
+                        real vLR, fLR;
+                        ljEwaldReciprocalCorrection(ljEwaldTableF, ljEwaldTableV,
+                                                    ewaldTableScale, ewaldTableHalfSpace,
+                                                    r, rInv, &vLR, &fLR);
+                        if (ia == ja)
+                        {
+                            vLR *= half;
+                        }
+                        for (int s = 0; s < NSTATES; s++)
+                        {
+                            const real c6Grid = nbfpGrid[tj[s]];
+                            vV          += LFV[s]*c6Grid*vLR;
+                            fScal       += LFV[s]*c6Grid*fLR;
+                            dvdlVdw     += DLF[s]*c6Grid*vLR;
+                        }
+                    }
+
+                    const int egp = GID(egpI, energyGroup(params, ja), numGroups);
+                    vCoulomb[egp] += vC;
+                    vVdw[egp]     += vV;
+
+                    if (f != nullptr)
+                    {
+                        const real tx = fScal*dx;
+                        const real ty = fScal*dy;
+                        const real tz = fScal*dz;
+                        fix          += tx;
+                        fiy          += ty;
+                        fiz          += tz;
+
+                        const int  fj = bufferIndex(ja, fPackSize, nbat.fstride);
+                        f[fj]                -= tx;
+                        f[fj + fStride]      -= ty;
+                        f[fj + 2*fStride]    -= tz;
+                    }
+                }
+            }
+
+            if (f != nullptr)
+            {
+                f[fi]             += fix;
+                f[fi + fStride]   += fiy;
+                f[fi + 2*fStride] += fiz;
+
+                fShiftSum[XX]     += fix;
+                fShiftSum[YY]     += fiy;
+                fShiftSum[ZZ]     += fiz;
+            }
+        }
+
+        if (fshift != nullptr)
+        {
+            rvec_inc(fshift[shift], fShiftSum);
+        }
+    }
+
+    dvdl[efptCOUL] += dvdlCoulomb;
+    dvdl[efptVDW]  += dvdlVdw;
+
+#undef STATE_A
+#undef STATE_B
+#undef NSTATES
+}
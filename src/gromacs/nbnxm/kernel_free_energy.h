@@ -0,0 +1,85 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ *
+ * \brief
+ * Declares the free-energy kernel for cluster-pair lists.
+ *
+ * Perturbed atom pairs that do not use soft-core have interactions that
+ * are linear in lambda. These are put in cluster-pair lists and computed
+ * with charges and LJ parameters interpolated between the A and B states,
+ * avoiding most of the cost of the general free-energy kernel.
+ */
+
+#ifndef GMX_NBXNM_KERNEL_FREE_ENERGY_H
+#define GMX_NBXNM_KERNEL_FREE_ENERGY_H
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+struct nbnxn_atomdata_t;
+struct NbnxnPairlistFep;
+struct t_forcerec;
+
+/*! \brief Computes the perturbed interactions in a cluster-pair list
+ *
+ * Forces are added to \p f, which should have the layout of the nbnxm
+ * force output buffers. Shift forces, energies and dV/dlambda are added
+ * to the output buffers. The energy buffers are indexed by the energy
+ * group pair index as returned by GID().
+ *
+ * \param[in]     nbl       The cluster-pair list
+ * \param[in]     nbat      The atom data
+ * \param[in]     fr        The force record
+ * \param[in]     lambda    The lambda values, indexed by efpt
+ * \param[in,out] f         The force output buffer, can be nullptr when no forces are needed
+ * \param[in,out] fshift    The shift force output buffer, can be nullptr when not needed
+ * \param[in,out] vCoulomb  The Coulomb energies per energy group pair
+ * \param[in,out] vVdw      The VdW energies per energy group pair
+ * \param[in,out] dvdl      The dV/dlambda output, Coulomb and VdW components are set
+ */
+void
+nbnxn_kernel_free_energy_cluster(const NbnxnPairlistFep &nbl,
+                                 const nbnxn_atomdata_t &nbat,
+                                 const t_forcerec       &fr,
+                                 const real             *lambda,
+                                 real                   *f,
+                                 rvec                   *fshift,
+                                 real                   *vCoulomb,
+                                 real                   *vVdw,
+                                 double                 *dvdl);
+
+#endif
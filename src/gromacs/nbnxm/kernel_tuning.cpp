@@ -0,0 +1,494 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ *
+ * \brief Implements the run-time selection of the CPU non-bonded kernel setup
+ *
+ * \ingroup __module_nb_verlet
+ */
+
+#include "gmxpre.h"
+
+#include "kernel_tuning.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+
+#include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/gmxlib/network.h"
+#include "gromacs/hardware/cpuinfo.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm_geometry.h"
+#include "gromacs/nbnxm/nbnxm_simd.h"
+#include "gromacs/nbnxm/pairlistset.h"
+#include "gromacs/timing/wallcycle.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/logger.h"
+#include "gromacs/utility/strconvert.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace Nbnxm
+{
+
+//! The number of pair-list periods to skip after a switch of kernel setup
+static const int c_numWarmupPeriods = 1;
+//! The number of pair-list periods to time for each kernel setup
+static const int c_numTimedPeriods  = 2;
+
+//! Returns the name of the layout of a SIMD kernel type as used in the cache file
+static const char *layoutName(KernelType kernelType)
+{
+    return (kernelType == KernelType::Cpu4xN_Simd_4xN ? "4xN" : "2xNN");
+}
+
+//! Returns the name of an Ewald exclusion type as used in the cache file
+static const char *ewaldName(EwaldExclusionType ewaldExclusionType)
+{
+    return (ewaldExclusionType == EwaldExclusionType::Analytical ? "analytical" : "table");
+}
+
+//! Returns a description of a kernel setup for the log file
+static std::string setupDescription(const KernelSetup &setup,
+                                    const t_inputrec  &ir)
+{
+    std::string description =
+        gmx::formatString("SIMD %s kernels",
+                          setup.kernelType == KernelType::Cpu4xN_Simd_4xN ? "4xN" : "2x(N+N)");
+    if (EEL_PME_EWALD(ir.coulombtype))
+    {
+        description += gmx::formatString(" with %s Ewald",
+                                         setup.ewaldExclusionType == EwaldExclusionType::Analytical ? "analytical" : "tabulated");
+    }
+
+    return description;
+}
+
+//! Returns whether two kernel setups are equal
+static bool setupsAreEqual(const KernelSetup &setup1,
+                           const KernelSetup &setup2)
+{
+    return (setup1.kernelType == setup2.kernelType &&
+            setup1.ewaldExclusionType == setup2.ewaldExclusionType);
+}
+
+//! Returns the number of PP ranks
+static int numPPRanks(const t_commrec *cr)
+{
+    return (DOMAINDECOMP(cr) ? cr->dd->nnodes : 1);
+}
+
+std::string kernelSetupCacheKey(const t_inputrec &ir,
+                                const t_commrec  *cr,
+                                const gmx_mtop_t &mtop,
+                                const matrix      box)
+{
+    const double atomDensity = mtop.natoms/det(box);
+
+    std::string  key =
+        gmx::formatString("%s|%s_simd%d|%s_%s|rc%g_rvdw%g|omp%d_pp%d|rho%d",
+                          gmx::CpuInfo::detect().brandString().c_str(),
+                          GMX_DOUBLE ? "double" : "mixed",
+                          GMX_SIMD_REAL_WIDTH,
+                          EELTYPE(ir.coulombtype),
+                          EVDWTYPE(ir.vdwtype),
+                          ir.rcoulomb, ir.rvdw,
+                          gmx_omp_nthreads_get(emntNonbonded),
+                          numPPRanks(cr),
+                          /* Round the density to 10 atoms/nm^3 */
+                          10*static_cast<int>(atomDensity/10 + 0.5));
+    std::replace(key.begin(), key.end(), ' ', '_');
+
+    return key;
+}
+
+/*! \brief Looks up \p key in the cache file and sets \p setup when found
+ *
+ * \returns whether \p key was found
+ */
+static bool readCachedSetup(const std::string &fileName,
+                            const std::string &key,
+                            KernelSetup       *setup)
+{
+    if (!gmx_fexist(fileName))
+    {
+        return false;
+    }
+
+    FILE *fp    = gmx_ffopen(fileName, "r");
+    bool  found = false;
+    char  line[STRLEN];
+    while (fgets(line, STRLEN, fp) != nullptr)
+    {
+        char lineKey[STRLEN], layout[STRLEN], ewald[STRLEN];
+        if (sscanf(line, "%s %s %s", lineKey, layout, ewald) == 3 &&
+            key == lineKey)
+        {
+            /* Later entries override earlier ones */
+            setup->kernelType         = (strcmp(layout, "4xN") == 0 ?
+                                         KernelType::Cpu4xN_Simd_4xN :
+                                         KernelType::Cpu4xN_Simd_2xNN);
+            setup->ewaldExclusionType = (strcmp(ewald, "analytical") == 0 ?
+                                         EwaldExclusionType::Analytical :
+                                         EwaldExclusionType::Table);
+            found                     = true;
+        }
+    }
+    gmx_ffclose(fp);
+
+    return found;
+}
+
+KernelSetupTuner::KernelSetupTuner(const gmx::MDLogger            &mdlog,
+                                   const t_inputrec               &ir,
+                                   const t_commrec                *cr,
+                                   const gmx_mtop_t               &mtop,
+                                   const t_forcerec               &fr,
+                                   const std::vector<KernelSetup> &setups,
+                                   const std::string              &cacheFile,
+                                   const std::string              &cacheKey,
+                                   bool                            applyCachedSetup) :
+    mdlog_(mdlog),
+    ir_(ir),
+    cr_(cr),
+    mtop_(mtop),
+    haveFep_(fr.nbv->pairlistSets().params().haveFep),
+    current_(0),
+    isActive_(true),
+    applyCachedSetup_(applyCachedSetup),
+    numStepsCounted_(-1),
+    cyclesCounted_(0),
+    cacheFile_(cacheFile),
+    cacheKey_(cacheKey)
+{
+    GMX_RELEASE_ASSERT(!setups.empty() && setupsAreEqual(setups[0], fr.nbv->kernelSetup()),
+                       "The first setup should be the one in use");
+    GMX_RELEASE_ASSERT(!applyCachedSetup || setups.size() == 2,
+                       "With a cached setup we need exactly two setups");
+
+    for (const KernelSetup &setup : setups)
+    {
+        timedSetups_.push_back({ setup, 0, 0 });
+    }
+}
+
+void KernelSetupTuner::switchToSetup(int         setupIndex,
+                                     t_forcerec *fr,
+                                     matrix      box)
+{
+    /* We do not print anything about the new setup here, the tuner logs
+     * the results at the end. The new object puts the atoms on its grid
+     * at the coming search step, so no atom data needs to be transferred.
+     */
+    fr->nbv  = init_nb_verlet(gmx::MDLogger(), timedSetups_[setupIndex].setup,
+                              haveFep_, &ir_, fr, cr_, &mtop_, box);
+    current_ = setupIndex;
+}
+
+void KernelSetupTuner::tune(t_forcerec    *fr,
+                            matrix         box,
+                            gmx_wallcycle *wcycle,
+                            int64_t        step)
+{
+    if (!isActive_)
+    {
+        return;
+    }
+
+    int    numSteps;
+    double cycles;
+    wallcycle_get(wcycle, ewcSTEP, &numSteps, &cycles);
+
+    const bool haveReference = (numStepsCounted_ >= 0);
+    const int  numStepsDiff  = numSteps - numStepsCounted_;
+    double     cyclesPerStep = (numStepsDiff > 0 ? (cycles - cyclesCounted_)/numStepsDiff : 0);
+    numStepsCounted_         = numSteps;
+    cyclesCounted_           = cycles;
+
+    /* With DD, the first step of a continuation run does not repartition,
+     * so the atoms would not be put on the grid of a new Nbnxm object.
+     */
+    const bool canSwitch = (haveReference ||
+                            !(DOMAINDECOMP(cr_) && ir_.bContinuation));
+
+    if (applyCachedSetup_)
+    {
+        if (canSwitch)
+        {
+            switchToSetup(1, fr, box);
+            isActive_ = false;
+        }
+        return;
+    }
+
+    if (!haveReference)
+    {
+        /* This is the first search step, nothing has been timed yet */
+        return;
+    }
+    if (numStepsDiff <= 0)
+    {
+        /* The cycle counters have been reset, skip this period */
+        return;
+    }
+
+    if (PAR(cr_))
+    {
+        /* Average over the PP ranks, so all ranks make the same choice */
+        gmx_sumd(1, &cyclesPerStep, cr_);
+        cyclesPerStep /= numPPRanks(cr_);
+    }
+
+    TimedSetup &timedSetup = timedSetups_[current_];
+    timedSetup.numPeriods++;
+    if (timedSetup.numPeriods > c_numWarmupPeriods)
+    {
+        if (timedSetup.numPeriods == c_numWarmupPeriods + 1 ||
+            cyclesPerStep < timedSetup.cyclesPerStep)
+        {
+            timedSetup.cyclesPerStep = cyclesPerStep;
+        }
+    }
+    if (timedSetup.numPeriods < c_numWarmupPeriods + c_numTimedPeriods)
+    {
+        return;
+    }
+
+    const int numSetups = static_cast<int>(timedSetups_.size());
+    if (current_ + 1 < numSetups)
+    {
+        switchToSetup(current_ + 1, fr, box);
+
+        return;
+    }
+
+    /* All setups have been timed, select the fastest */
+    int best = 0;
+    for (int i = 1; i < numSetups; i++)
+    {
+        if (timedSetups_[i].cyclesPerStep < timedSetups_[best].cyclesPerStep)
+        {
+            best = i;
+        }
+    }
+    if (best != current_)
+    {
+        switchToSetup(best, fr, box);
+    }
+    isActive_ = false;
+
+    std::string message =
+        gmx::formatString("Timings of the non-bonded kernel setups at step %s:\n",
+                          gmx::toString(step).c_str());
+    for (const TimedSetup &timedSetup : timedSetups_)
+    {
+        message += gmx::formatString("  %-42s %8.3f M-cycles/step\n",
+                                     setupDescription(timedSetup.setup, ir_).c_str(),
+                                     timedSetup.cyclesPerStep*1e-6);
+    }
+    message += gmx::formatString("Using %s",
+                                 setupDescription(timedSetups_[best].setup, ir_).c_str());
+    GMX_LOG(mdlog_.info).asParagraph().appendText(message);
+
+    if (!cacheFile_.empty() && MASTER(cr_))
+    {
+        FILE *fp = gmx_ffopen(cacheFile_, "a");
+        fprintf(fp, "%s %s %s\n",
+                cacheKey_.c_str(),
+                layoutName(timedSetups_[best].setup.kernelType),
+                ewaldName(timedSetups_[best].setup.ewaldExclusionType));
+        gmx_ffclose(fp);
+    }
+}
+
+std::unique_ptr<KernelSetupTuner>
+makeKernelSetupTuner(const gmx::MDLogger &mdlog,
+                     const t_inputrec    &ir,
+                     const t_commrec     *cr,
+                     const gmx_mtop_t    &mtop,
+                     const t_forcerec    &fr,
+                     const matrix         box,
+                     bool                 reproducible,
+                     bool                 useTimings)
+{
+    if (getenv("GMX_NBNXN_TUNE_KERNELS") == nullptr)
+    {
+        return nullptr;
+    }
+
+    const char *cacheEnv = getenv("GMX_NBNXN_TUNE_KERNELS_CACHE");
+
+    return makeKernelSetupTuner(mdlog, ir, cr, mtop, fr, box,
+                                reproducible, useTimings,
+                                cacheEnv != nullptr ? cacheEnv : "");
+}
+
+std::unique_ptr<KernelSetupTuner>
+makeKernelSetupTuner(const gmx::MDLogger &mdlog,
+                     const t_inputrec    &ir,
+                     const t_commrec     *cr,
+                     const gmx_mtop_t    &mtop,
+                     const t_forcerec    &fr,
+                     const matrix         box,
+                     bool                 reproducible,
+                     bool                 useTimings,
+                     const std::string   &cacheFile)
+{
+    if (fr.nbv == nullptr)
+    {
+        return nullptr;
+    }
+
+    /* Also a cached setup depends on timings, so it should not be used */
+    if (reproducible)
+    {
+        GMX_LOG(mdlog.info).asParagraph().appendText("Non-bonded kernel tuning was requested, but is not supported with reproducible runs");
+        return nullptr;
+    }
+
+    const KernelSetup &currentSetup = fr.nbv->kernelSetup();
+    if (!kernelTypeIsSimd(currentSetup.kernelType))
+    {
+        GMX_LOG(mdlog.info).asParagraph().appendText("Non-bonded kernel tuning was requested, but is only supported with SIMD kernels on the CPU");
+        return nullptr;
+    }
+
+    /* Collect all setups that are supported and not fixed by the user,
+     * the setup in use goes first.
+     */
+    std::vector<KernelType> kernelTypes = { currentSetup.kernelType };
+#if defined GMX_NBNXN_SIMD_2XNN && defined GMX_NBNXN_SIMD_4XN
+    if (getenv("GMX_NBNXN_SIMD_4XN") == nullptr &&
+        getenv("GMX_NBNXN_SIMD_2XNN") == nullptr)
+    {
+        kernelTypes.push_back(currentSetup.kernelType == KernelType::Cpu4xN_Simd_4xN ?
+                              KernelType::Cpu4xN_Simd_2xNN :
+                              KernelType::Cpu4xN_Simd_4xN);
+    }
+#endif
+    std::vector<EwaldExclusionType> ewaldTypes = { currentSetup.ewaldExclusionType };
+    if (EEL_PME_EWALD(ir.coulombtype) &&
+        getenv("GMX_NBNXN_EWALD_TABLE") == nullptr &&
+        getenv("GMX_NBNXN_EWALD_ANALYTICAL") == nullptr)
+    {
+        ewaldTypes.push_back(currentSetup.ewaldExclusionType == EwaldExclusionType::Analytical ?
+                             EwaldExclusionType::Table :
+                             EwaldExclusionType::Analytical);
+    }
+
+    std::vector<KernelSetup> setups;
+    for (KernelType kernelType : kernelTypes)
+    {
+        for (EwaldExclusionType ewaldType : ewaldTypes)
+        {
+            KernelSetup setup;
+            setup.kernelType         = kernelType;
+            setup.ewaldExclusionType = ewaldType;
+            setups.push_back(setup);
+        }
+    }
+
+    if (setups.size() < 2)
+    {
+        GMX_LOG(mdlog.info).asParagraph().appendText("Non-bonded kernel tuning was requested, but there is only one kernel setup available");
+        return nullptr;
+    }
+
+    const std::string key = kernelSetupCacheKey(ir, cr, mtop, box);
+
+    if (!cacheFile.empty())
+    {
+        /* The master reads the cache, so all ranks use the same setup */
+        int         found = 0;
+        KernelSetup cachedSetup;
+        if (MASTER(cr))
+        {
+            found = readCachedSetup(cacheFile, key, &cachedSetup) ? 1 : 0;
+        }
+        if (PAR(cr))
+        {
+            gmx_bcast(sizeof(found), &found, cr);
+            gmx_bcast(sizeof(cachedSetup), &cachedSetup, cr);
+        }
+
+        if (found &&
+            std::find_if(setups.begin(), setups.end(),
+                         [&cachedSetup](const KernelSetup &setup)
+                         { return setupsAreEqual(setup, cachedSetup); }) != setups.end())
+        {
+            GMX_LOG(mdlog.info).asParagraph().appendTextFormatted(
+                    "Using %s, as found for this setup in the kernel tuning cache file %s",
+                    setupDescription(cachedSetup, ir).c_str(), cacheFile.c_str());
+
+            if (setupsAreEqual(cachedSetup, currentSetup))
+            {
+                return nullptr;
+            }
+
+            return std::make_unique<KernelSetupTuner>(mdlog, ir, cr, mtop, fr,
+                                                      std::vector<KernelSetup> { currentSetup, cachedSetup },
+                                                      "", key, true);
+        }
+    }
+
+    if (!useTimings)
+    {
+        GMX_LOG(mdlog.info).asParagraph().appendText("Non-bonded kernel tuning was requested, but is not supported without cycle counters or while PME tuning is active");
+        return nullptr;
+    }
+
+    GMX_LOG(mdlog.info).asParagraph().appendTextFormatted(
+            "Will time %zu non-bonded kernel setups over the first %d pair-list periods",
+            setups.size(),
+            static_cast<int>(setups.size())*(c_numWarmupPeriods + c_numTimedPeriods) + 1);
+
+    return std::make_unique<KernelSetupTuner>(mdlog, ir, cr, mtop, fr,
+                                              setups, cacheFile, key, false);
+}
+
+} // namespace Nbnxm
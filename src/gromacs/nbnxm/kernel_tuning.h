@@ -0,0 +1,252 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \libinternal \file
+ *
+ * \brief Declares the run-time selection of the CPU non-bonded kernel setup
+ *
+ * Which SIMD kernel layout, 4xN or 2x(N+N), and which Ewald exclusion
+ * correction, analytical or tabulated, is fastest depends on the CPU,
+ * the cut-off and the atom density. The heuristics in nbnxm_setup.cpp
+ * can not capture all of this. When requested by setting the environment
+ * variable GMX_NBNXN_TUNE_KERNELS, mdrun times all available setups
+ * during the first pair-list periods of the run and continues with
+ * the fastest. The choice can be stored in a file given by
+ * GMX_NBNXN_TUNE_KERNELS_CACHE, so later runs of the same setup
+ * on the same CPU type can skip the tuning.
+ *
+ * \inlibraryapi
+ * \ingroup __module_nb_verlet
+ */
+
+#ifndef NBNXM_KERNEL_TUNING_H
+#define NBNXM_KERNEL_TUNING_H
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/nbnxm/nbnxm.h"
+
+namespace gmx
+{
+class MDLogger;
+}
+
+struct gmx_mtop_t;
+struct gmx_wallcycle;
+struct t_commrec;
+struct t_forcerec;
+struct t_inputrec;
+
+namespace Nbnxm
+{
+
+/*! \libinternal
+ * \brief Times the available CPU non-bonded kernel setups and selects the fastest
+ *
+ * All kernel setups are timed using the cycle counts of complete MD steps
+ * over whole pair-list periods, so the pair search and list pruning cost,
+ * which differs between the layouts, is included. A switch of setup
+ * replaces the Nbnxm object in the force record, which is only allowed
+ * at search steps.
+ */
+class KernelSetupTuner
+{
+    public:
+        /*! \brief Constructor, should only be called through makeKernelSetupTuner()
+         *
+         * \param[in] mdlog      Logger
+         * \param[in] ir         The input parameter record
+         * \param[in] cr         The communication record
+         * \param[in] mtop       The global topology
+         * \param[in] fr         The force record, with the Nbnxm object using the default setup
+         * \param[in] setups     The setups to time, the first is the current one
+         * \param[in] cacheFile  Name of the file to store the result in, can be empty
+         * \param[in] cacheKey   The key for the result in the cache file
+         * \param[in] applyCachedSetup  Only switch to the cached setup, which is the second in \p setups
+         */
+        KernelSetupTuner(const gmx::MDLogger            &mdlog,
+                         const t_inputrec               &ir,
+                         const t_commrec                *cr,
+                         const gmx_mtop_t               &mtop,
+                         const t_forcerec               &fr,
+                         const std::vector<KernelSetup> &setups,
+                         const std::string              &cacheFile,
+                         const std::string              &cacheKey,
+                         bool                            applyCachedSetup);
+
+        //! Returns whether we are still timing kernel setups
+        bool isActive() const
+        {
+            return isActive_;
+        }
+
+        /*! \brief Times the last pair-list period and switches setup when needed
+         *
+         * The setup is never switched at the first call with domain
+         * decomposition when continuing a run, as the first step then
+         * does not repartition.
+         *
+         * Should be called on all PP ranks at each search step (step % nstlist == 0),
+         * before domain repartitioning and before the timing of the step starts.
+         *
+         * \param[in,out] fr      The force record, fr->nbv can be replaced
+         * \param[in]     box     The current unit cell
+         * \param[in]     wcycle  The wallcycle accounting
+         * \param[in]     step    The MD step
+         */
+        void tune(t_forcerec    *fr,
+                  matrix         box,
+                  gmx_wallcycle *wcycle,
+                  int64_t        step);
+
+    private:
+        //! Replaces the Nbnxm object in \p fr by one using setup \p setupIndex
+        void switchToSetup(int         setupIndex,
+                           t_forcerec *fr,
+                           matrix      box);
+
+        //! Timing data of a kernel setup
+        struct TimedSetup
+        {
+            //! The kernel setup
+            KernelSetup setup;
+            //! The number of list periods run with this setup
+            int         numPeriods;
+            //! The lowest cycle count per step over the timed periods
+            double      cyclesPerStep;
+        };
+
+        //! Logger
+        const gmx::MDLogger     &mdlog_;
+        //! The input parameter record
+        const t_inputrec        &ir_;
+        //! The communication record
+        const t_commrec         *cr_;
+        //! The global topology
+        const gmx_mtop_t        &mtop_;
+        //! Whether we have perturbed non-bonded interactions
+        bool                     haveFep_;
+        //! The setups to time
+        std::vector<TimedSetup>  timedSetups_;
+        //! The index of the setup currently in use
+        int                      current_;
+        //! Whether we are still timing
+        bool                     isActive_;
+        //! Whether we only switch to the cached setup, without timing
+        bool                     applyCachedSetup_;
+        //! The step count of the step cycle counter at the previous call
+        int                      numStepsCounted_;
+        //! The cycle count of the step cycle counter at the previous call
+        double                   cyclesCounted_;
+        //! The file to store the selected setup in, empty when not used
+        std::string              cacheFile_;
+        //! The key for the selected setup in the cache file
+        std::string              cacheKey_;
+};
+
+/*! \brief Returns the key identifying the CPU and the simulation setup in the cache file
+ *
+ * The key contains all parameters that affect the relative performance
+ * of the kernel setups. Spaces are replaced by underscores, so the key
+ * is a single word.
+ */
+std::string kernelSetupCacheKey(const t_inputrec &ir,
+                                const t_commrec  *cr,
+                                const gmx_mtop_t &mtop,
+                                const matrix      box);
+
+/*! \brief Sets up run-time selection of the CPU non-bonded kernel setup
+ *
+ * Returns a tuner object when tuning was requested with the environment
+ * variable GMX_NBNXN_TUNE_KERNELS and more than one kernel setup is
+ * available, returns nullptr otherwise. When a cache file is given
+ * with GMX_NBNXN_TUNE_KERNELS_CACHE and it contains a result for the
+ * current setup, the returned tuner only switches to the cached kernel
+ * setup at the first search step. With reproducible runs nothing is
+ * tuned and the cache file is not read, as the cached setup is based
+ * on timings.
+ *
+ * Should be called on all PP ranks before the first MD step.
+ *
+ * \param[in]     mdlog        Logger
+ * \param[in]     ir           The input parameter record
+ * \param[in]     cr           The communication record
+ * \param[in]     mtop         The global topology
+ * \param[in]     fr           The force record
+ * \param[in]     box          The unit cell
+ * \param[in]     reproducible Whether the run should be reproducible
+ * \param[in]     useTimings   Whether timings are reliable, i.e. no other tuning is active and cycle counters work
+ */
+std::unique_ptr<KernelSetupTuner>
+makeKernelSetupTuner(const gmx::MDLogger &mdlog,
+                     const t_inputrec    &ir,
+                     const t_commrec     *cr,
+                     const gmx_mtop_t    &mtop,
+                     const t_forcerec    &fr,
+                     const matrix         box,
+                     bool                 reproducible,
+                     bool                 useTimings);
+
+/*! \brief As makeKernelSetupTuner() above, but with tuning requested and the cache file passed explicitly
+ *
+ * \param[in]     mdlog        Logger
+ * \param[in]     ir           The input parameter record
+ * \param[in]     cr           The communication record
+ * \param[in]     mtop         The global topology
+ * \param[in]     fr           The force record
+ * \param[in]     box          The unit cell
+ * \param[in]     reproducible Whether the run should be reproducible
+ * \param[in]     useTimings   Whether timings are reliable, i.e. no other tuning is active and cycle counters work
+ * \param[in]     cacheFile    The name of the cache file, empty when not used
+ */
+std::unique_ptr<KernelSetupTuner>
+makeKernelSetupTuner(const gmx::MDLogger &mdlog,
+                     const t_inputrec    &ir,
+                     const t_commrec     *cr,
+                     const gmx_mtop_t    &mtop,
+                     const t_forcerec    &fr,
+                     const matrix         box,
+                     bool                 reproducible,
+                     bool                 useTimings,
+                     const std::string   &cacheFile);
+
+} // namespace Nbnxm
+
+#endif /* NBNXM_KERNEL_TUNING_H */
@@ -35,10 +35,14 @@
 
 #include "gmxpre.h"
 
+#include <vector>
+
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/gmxlib/nonbonded/nb_free_energy.h"
 #include "gromacs/gmxlib/nonbonded/nb_kernel.h"
 #include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/vec.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdlib/force.h"
 #include "gromacs/mdlib/force_flags.h"
@@ -53,11 +57,13 @@
 #include "gromacs/nbnxm/nbnxm_simd.h"
 #include "gromacs/nbnxm/pairlist.h"
 #include "gromacs/nbnxm/kernels_reference/kernel_gpu_ref.h"
+#include "gromacs/pbcutil/ishift.h"
 #include "gromacs/simd/simd.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/real.h"
 
 #include "kernel_common.h"
+#include "kernel_free_energy.h"
 #define INCLUDE_KERNELFUNCTION_TABLES
 #include "gromacs/nbnxm/kernels_reference/kernel_ref.h"
 #ifdef GMX_NBNXN_SIMD_2XNN
@@ -83,81 +89,60 @@ static void clearGroupEnergies(nbnxn_atomdata_output_t *out)
 /*! \brief Reduce the group-pair energy buffers produced by a SIMD kernel
  * to single terms in the output buffers.
  *
- * The SIMD kernels produce a large number of energy buffer in SIMD registers
- * to avoid scattered reads and writes.
+ * The SIMD kernels accumulate energies per group pair into unrollj entries,
+ * one per j-atom in the cluster, to avoid horizontal reductions in the kernel.
+ * The size of these buffers is numGroups*numGroups*unrollj, so the cost
+ * of clearing and reducing scales as the number of group pairs.
  *
  * \tparam        unrollj         The unroll size for j-particles in the SIMD kernel
  * \param[in]     numGroups       The number of energy groups
- * \param[in]     numGroups_2log  Log2 of numGroups, rounded up
  * \param[in,out] out             Struct with energy buffers
  */
 template <int unrollj> static void
 reduceGroupEnergySimdBuffers(int                       numGroups,
-                             int                       numGroups_2log,
                              nbnxn_atomdata_output_t  *out)
 {
-    const int                 unrollj_half     = unrollj/2;
-    /* Energies are stored in SIMD registers with size 2^numGroups_2log */
-    const int                 numGroupsStorage = (1 << numGroups_2log);
-
     const real * gmx_restrict vVdwSimd     = out->VSvdw.data();
     const real * gmx_restrict vCoulombSimd = out->VSc.data();
     real * gmx_restrict       vVdw         = out->Vvdw.data();
     real * gmx_restrict       vCoulomb     = out->Vc.data();
 
-    /* The size of the SIMD energy group buffer array is:
-     * numGroups*numGroups*numGroupsStorage*unrollj_half*simd_width
-     */
-    for (int i = 0; i < numGroups; i++)
+    for (int i = 0; i < numGroups*numGroups; i++)
     {
-        for (int j1 = 0; j1 < numGroups; j1++)
+        for (int s = 0; s < unrollj; s++)
         {
-            for (int j0 = 0; j0 < numGroups; j0++)
-            {
-                int c = ((i*numGroups + j1)*numGroupsStorage + j0)*unrollj_half*unrollj;
-                for (int s = 0; s < unrollj_half; s++)
-                {
-                    vVdw    [i*numGroups + j0] += vVdwSimd    [c + 0];
-                    vVdw    [i*numGroups + j1] += vVdwSimd    [c + 1];
-                    vCoulomb[i*numGroups + j0] += vCoulombSimd[c + 0];
-                    vCoulomb[i*numGroups + j1] += vCoulombSimd[c + 1];
-                    c                          += unrollj + 2;
-                }
-            }
+            vVdw    [i] += vVdwSimd    [i*unrollj + s];
+            vCoulomb[i] += vCoulombSimd[i*unrollj + s];
         }
     }
 }
 
-/*! \brief Dispatches the non-bonded N versus M atom cluster CPU kernels.
+/*! \brief Runs the non-bonded N versus M atom cluster CPU kernel on one pairlist.
  *
- * OpenMP parallelization is performed within this function.
- * Energy reduction, but not force and shift force reduction, is performed
- * within this function.
+ * Each pairlist has its own force, shift force and energy output buffer,
+ * so different lists can be computed concurrently by different threads.
  *
  * \param[in]     pairlistSet   Pairlists with local or non-local interactions to compute
+ * \param[in]     listIndex     The index of the pairlist in \p pairlistSet to compute
  * \param[in]     kernelSetup   The non-bonded kernel setup
  * \param[in,out] nbat          The atomdata for the interactions
  * \param[in]     ic            Non-bonded interaction constants
  * \param[in]     shiftVectors  The PBC shift vectors
  * \param[in]     forceFlags    Flags that tell what to compute
  * \param[in]     clearF        Enum that tells if to clear the force output buffer
- * \param[out]    fshift        Shift force output buffer
- * \param[out]    vCoulomb      Output buffer for Coulomb energies
- * \param[out]    vVdw          Output buffer for Van der Waals energies
+ * \param[out]    fshift        Shift force output buffer, only used with a single list
  */
 static void
-nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
-                 const Nbnxm::KernelSetup       &kernelSetup,
-                 nbnxn_atomdata_t               *nbat,
-                 const interaction_const_t      &ic,
-                 rvec                           *shiftVectors,
-                 int                             forceFlags,
-                 int                             clearF,
-                 real                           *fshift,
-                 real                           *vCoulomb,
-                 real                           *vVdw)
+nbnxn_kernel_cpu_list(const PairlistSet              &pairlistSet,
+                      int                             listIndex,
+                      const Nbnxm::KernelSetup       &kernelSetup,
+                      nbnxn_atomdata_t               *nbat,
+                      const interaction_const_t      &ic,
+                      rvec                           *shiftVectors,
+                      int                             forceFlags,
+                      int                             clearF,
+                      real                           *fshift)
 {
-
     int                      coulkt;
     if (EEL_RF(ic.eeltype) || ic.eeltype == eelCUT)
     {
@@ -230,6 +215,11 @@ nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
             GMX_RELEASE_ASSERT(kernelSetup.kernelType == Nbnxm::KernelType::Cpu4x4_PlainC, "Only the C reference nbnxn SIMD kernel supports LJ-PME with LB combination rules");
         }
     }
+    else if (ic.vdwtype == evdwUSER)
+    {
+        GMX_RELEASE_ASSERT(ic.vdwUserTable, "The user VdW table should be set up with the Verlet scheme");
+        vdwkt = vdwktUSERTAB;
+    }
     else
     {
         GMX_RELEASE_ASSERT(false, "Unsupported VdW interaction type");
@@ -237,190 +227,222 @@ nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
 
     gmx::ArrayRef<const NbnxnPairlistCpu> pairlists = pairlistSet.cpuLists();
 
-    int gmx_unused                        nthreads = gmx_omp_nthreads_get(emntNonbonded);
-#pragma omp parallel for schedule(static) num_threads(nthreads)
-    for (int nb = 0; nb < pairlists.ssize(); nb++)
+    nbnxn_atomdata_output_t *out = &nbat->out[listIndex];
+
+    if (clearF == enbvClearFYes)
     {
-        // Presently, the kernels do not call C++ code that can throw,
-        // so no need for a try/catch pair in this OpenMP region.
-        nbnxn_atomdata_output_t *out = &nbat->out[nb];
+        clear_f(nbat, listIndex, out->f.data());
+    }
+
+    real *fshift_p;
+    if ((forceFlags & GMX_FORCE_VIRIAL) && pairlists.ssize() == 1)
+    {
+        fshift_p = fshift;
+    }
+    else
+    {
+        fshift_p = out->fshift.data();
 
         if (clearF == enbvClearFYes)
         {
-            clear_f(nbat, nb, out->f.data());
+            clear_fshift(fshift_p);
         }
+    }
 
-        real *fshift_p;
-        if ((forceFlags & GMX_FORCE_VIRIAL) && pairlists.ssize() == 1)
-        {
-            fshift_p = fshift;
-        }
-        else
-        {
-            fshift_p = out->fshift.data();
+    // TODO: Change to reference
+    const NbnxnPairlistCpu *pairlist = &pairlists[listIndex];
 
-            if (clearF == enbvClearFYes)
-            {
-                clear_fshift(fshift_p);
-            }
+    if (!(forceFlags & GMX_FORCE_ENERGY))
+    {
+        /* Don't calculate energies */
+        switch (kernelSetup.kernelType)
+        {
+            case Nbnxm::KernelType::Cpu4x4_PlainC:
+                nbnxn_kernel_noener_ref[coulkt][vdwkt](pairlist, nbat,
+                                                       &ic,
+                                                       shiftVectors,
+                                                       out->f.data(),
+                                                       fshift_p);
+                break;
+#ifdef GMX_NBNXN_SIMD_2XNN
+            case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
+                nbnxm_kernel_noener_simd_2xmm[coulkt][vdwkt](pairlist, nbat,
+                                                             &ic,
+                                                             shiftVectors,
+                                                             out->f.data(),
+                                                             fshift_p);
+                break;
+#endif
+#ifdef GMX_NBNXN_SIMD_4XN
+            case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
+                nbnxm_kernel_noener_simd_4xm[coulkt][vdwkt](pairlist, nbat,
+                                                            &ic,
+                                                            shiftVectors,
+                                                            out->f.data(),
+                                                            fshift_p);
+                break;
+#endif
+            default:
+                GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
         }
+    }
+    else if (out->Vvdw.size() == 1)
+    {
+        /* A single energy group (pair) */
+        out->Vvdw[0] = 0;
+        out->Vc[0]   = 0;
 
-        // TODO: Change to reference
-        const NbnxnPairlistCpu *pairlist = &pairlists[nb];
-
-        if (!(forceFlags & GMX_FORCE_ENERGY))
+        switch (kernelSetup.kernelType)
         {
-            /* Don't calculate energies */
-            switch (kernelSetup.kernelType)
-            {
-                case Nbnxm::KernelType::Cpu4x4_PlainC:
-                    nbnxn_kernel_noener_ref[coulkt][vdwkt](pairlist, nbat,
+            case Nbnxm::KernelType::Cpu4x4_PlainC:
+                nbnxn_kernel_ener_ref[coulkt][vdwkt](pairlist, nbat,
+                                                     &ic,
+                                                     shiftVectors,
+                                                     out->f.data(),
+                                                     fshift_p,
+                                                     out->Vvdw.data(),
+                                                     out->Vc.data());
+                break;
+#ifdef GMX_NBNXN_SIMD_2XNN
+            case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
+                nbnxm_kernel_ener_simd_2xmm[coulkt][vdwkt](pairlist, nbat,
                                                            &ic,
                                                            shiftVectors,
                                                            out->f.data(),
-                                                           fshift_p);
-                    break;
-#ifdef GMX_NBNXN_SIMD_2XNN
-                case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
-                    nbnxm_kernel_noener_simd_2xmm[coulkt][vdwkt](pairlist, nbat,
-                                                                 &ic,
-                                                                 shiftVectors,
-                                                                 out->f.data(),
-                                                                 fshift_p);
-                    break;
+                                                           fshift_p,
+                                                           out->Vvdw.data(),
+                                                           out->Vc.data());
+                break;
 #endif
 #ifdef GMX_NBNXN_SIMD_4XN
-                case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
-                    nbnxm_kernel_noener_simd_4xm[coulkt][vdwkt](pairlist, nbat,
-                                                                &ic,
-                                                                shiftVectors,
-                                                                out->f.data(),
-                                                                fshift_p);
-                    break;
+            case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
+                nbnxm_kernel_ener_simd_4xm[coulkt][vdwkt](pairlist, nbat,
+                                                          &ic,
+                                                          shiftVectors,
+                                                          out->f.data(),
+                                                          fshift_p,
+                                                          out->Vvdw.data(),
+                                                          out->Vc.data());
+                break;
 #endif
-                default:
-                    GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
-            }
+            default:
+                GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
         }
-        else if (out->Vvdw.size() == 1)
-        {
-            /* A single energy group (pair) */
-            out->Vvdw[0] = 0;
-            out->Vc[0]   = 0;
+    }
+    else
+    {
+        /* Calculate energy group contributions */
+        clearGroupEnergies(out);
 
-            switch (kernelSetup.kernelType)
-            {
-                case Nbnxm::KernelType::Cpu4x4_PlainC:
-                    nbnxn_kernel_ener_ref[coulkt][vdwkt](pairlist, nbat,
-                                                         &ic,
-                                                         shiftVectors,
-                                                         out->f.data(),
-                                                         fshift_p,
-                                                         out->Vvdw.data(),
-                                                         out->Vc.data());
-                    break;
+        int unrollj = 0;
+
+        switch (kernelSetup.kernelType)
+        {
+            case Nbnxm::KernelType::Cpu4x4_PlainC:
+                unrollj = c_nbnxnCpuIClusterSize;
+                nbnxn_kernel_energrp_ref[coulkt][vdwkt](pairlist, nbat,
+                                                        &ic,
+                                                        shiftVectors,
+                                                        out->f.data(),
+                                                        fshift_p,
+                                                        out->Vvdw.data(),
+                                                        out->Vc.data());
+                break;
 #ifdef GMX_NBNXN_SIMD_2XNN
-                case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
-                    nbnxm_kernel_ener_simd_2xmm[coulkt][vdwkt](pairlist, nbat,
-                                                               &ic,
-                                                               shiftVectors,
-                                                               out->f.data(),
-                                                               fshift_p,
-                                                               out->Vvdw.data(),
-                                                               out->Vc.data());
-                    break;
-#endif
-#ifdef GMX_NBNXN_SIMD_4XN
-                case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
-                    nbnxm_kernel_ener_simd_4xm[coulkt][vdwkt](pairlist, nbat,
+            case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
+                unrollj = GMX_SIMD_REAL_WIDTH/2;
+                nbnxm_kernel_energrp_simd_2xmm[coulkt][vdwkt](pairlist, nbat,
                                                               &ic,
                                                               shiftVectors,
                                                               out->f.data(),
                                                               fshift_p,
-                                                              out->Vvdw.data(),
-                                                              out->Vc.data());
-                    break;
+                                                              out->VSvdw.data(),
+                                                              out->VSc.data());
+                break;
 #endif
-                default:
-                    GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
-            }
+#ifdef GMX_NBNXN_SIMD_4XN
+            case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
+                unrollj = GMX_SIMD_REAL_WIDTH;
+                nbnxm_kernel_energrp_simd_4xm[coulkt][vdwkt](pairlist, nbat,
+                                                             &ic,
+                                                             shiftVectors,
+                                                             out->f.data(),
+                                                             fshift_p,
+                                                             out->VSvdw.data(),
+                                                             out->VSc.data());
+                break;
+#endif
+            default:
+                GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
         }
-        else
-        {
-            /* Calculate energy group contributions */
-            clearGroupEnergies(out);
-
-            int unrollj = 0;
 
-            switch (kernelSetup.kernelType)
+        if (kernelSetup.kernelType != Nbnxm::KernelType::Cpu4x4_PlainC)
+        {
+            switch (unrollj)
             {
-                case Nbnxm::KernelType::Cpu4x4_PlainC:
-                    unrollj = c_nbnxnCpuIClusterSize;
-                    nbnxn_kernel_energrp_ref[coulkt][vdwkt](pairlist, nbat,
-                                                            &ic,
-                                                            shiftVectors,
-                                                            out->f.data(),
-                                                            fshift_p,
-                                                            out->Vvdw.data(),
-                                                            out->Vc.data());
+                case 2:
+                    reduceGroupEnergySimdBuffers<2>(nbatParams.nenergrp,
+                                                    out);
                     break;
-#ifdef GMX_NBNXN_SIMD_2XNN
-                case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
-                    unrollj = GMX_SIMD_REAL_WIDTH/2;
-                    nbnxm_kernel_energrp_simd_2xmm[coulkt][vdwkt](pairlist, nbat,
-                                                                  &ic,
-                                                                  shiftVectors,
-                                                                  out->f.data(),
-                                                                  fshift_p,
-                                                                  out->VSvdw.data(),
-                                                                  out->VSc.data());
+                case 4:
+                    reduceGroupEnergySimdBuffers<4>(nbatParams.nenergrp,
+                                                    out);
                     break;
-#endif
-#ifdef GMX_NBNXN_SIMD_4XN
-                case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
-                    unrollj = GMX_SIMD_REAL_WIDTH;
-                    nbnxm_kernel_energrp_simd_4xm[coulkt][vdwkt](pairlist, nbat,
-                                                                 &ic,
-                                                                 shiftVectors,
-                                                                 out->f.data(),
-                                                                 fshift_p,
-                                                                 out->VSvdw.data(),
-                                                                 out->VSc.data());
+                case 8:
+                    reduceGroupEnergySimdBuffers<8>(nbatParams.nenergrp,
+                                                    out);
                     break;
-#endif
                 default:
-                    GMX_RELEASE_ASSERT(false, "Unsupported kernel architecture");
-            }
-
-            if (kernelSetup.kernelType != Nbnxm::KernelType::Cpu4x4_PlainC)
-            {
-                switch (unrollj)
-                {
-                    case 2:
-                        reduceGroupEnergySimdBuffers<2>(nbatParams.nenergrp,
-                                                        nbatParams.neg_2log,
-                                                        out);
-                        break;
-                    case 4:
-                        reduceGroupEnergySimdBuffers<4>(nbatParams.nenergrp,
-                                                        nbatParams.neg_2log,
-                                                        out);
-                        break;
-                    case 8:
-                        reduceGroupEnergySimdBuffers<8>(nbatParams.nenergrp,
-                                                        nbatParams.neg_2log,
-                                                        out);
-                        break;
-                    default:
-                        GMX_RELEASE_ASSERT(false, "Unsupported j-unroll size");
-                }
+                    GMX_RELEASE_ASSERT(false, "Unsupported j-unroll size");
             }
         }
     }
+}
+
+/*! \brief Dispatches the non-bonded N versus M atom cluster CPU kernels.
+ *
+ * OpenMP parallelization is performed within this function.
+ * Energy reduction, but not force and shift force reduction, is performed
+ * within this function.
+ *
+ * \param[in]     pairlistSet   Pairlists with local or non-local interactions to compute
+ * \param[in]     kernelSetup   The non-bonded kernel setup
+ * \param[in,out] nbat          The atomdata for the interactions
+ * \param[in]     ic            Non-bonded interaction constants
+ * \param[in]     shiftVectors  The PBC shift vectors
+ * \param[in]     forceFlags    Flags that tell what to compute
+ * \param[in]     clearF        Enum that tells if to clear the force output buffer
+ * \param[out]    fshift        Shift force output buffer
+ * \param[out]    vCoulomb      Output buffer for Coulomb energies
+ * \param[out]    vVdw          Output buffer for Van der Waals energies
+ */
+static void
+nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
+                 const Nbnxm::KernelSetup       &kernelSetup,
+                 nbnxn_atomdata_t               *nbat,
+                 const interaction_const_t      &ic,
+                 rvec                           *shiftVectors,
+                 int                             forceFlags,
+                 int                             clearF,
+                 real                           *fshift,
+                 real                           *vCoulomb,
+                 real                           *vVdw)
+{
+    const int   numLists = pairlistSet.cpuLists().ssize();
+
+    int gmx_unused nthreads = gmx_omp_nthreads_get(emntNonbonded);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+    for (int nb = 0; nb < numLists; nb++)
+    {
+        // Presently, the kernels do not call C++ code that can throw,
+        // so no need for a try/catch pair in this OpenMP region.
+        nbnxn_kernel_cpu_list(pairlistSet, nb, kernelSetup, nbat, ic,
+                              shiftVectors, forceFlags, clearF, fshift);
+    }
 
     if (forceFlags & GMX_FORCE_ENERGY)
     {
-        reduce_energies_over_lists(nbat, pairlists.ssize(), vVdw, vCoulomb);
+        reduce_energies_over_lists(nbat, numLists, vVdw, vCoulomb);
     }
 }
 
@@ -539,6 +561,153 @@ nonbonded_verlet_t::dispatchNonbondedKernel(Nbnxm::InteractionLocality iLocality
     accountFlops(nrnb, pairlistSet, *this, ic, forceFlags);
 }
 
+int
+nonbonded_verlet_t::numCpuKernelTasks(Nbnxm::InteractionLocality iLocality) const
+{
+    return pairlistSets().pairlistSet(iLocality).cpuLists().ssize();
+}
+
+void
+nonbonded_verlet_t::dispatchCpuKernelTask(Nbnxm::InteractionLocality  iLocality,
+                                          const interaction_const_t  &ic,
+                                          int                         forceFlags,
+                                          int                         clearF,
+                                          t_forcerec                 *fr,
+                                          int                         task)
+{
+    GMX_ASSERT(kernelSetup().kernelType != Nbnxm::KernelType::Gpu8x8x8 &&
+               kernelSetup().kernelType != Nbnxm::KernelType::Cpu8x8x8_PlainC,
+               "Kernel tasks are only supported with the CPU cluster kernels");
+
+    nbnxn_kernel_cpu_list(pairlistSets().pairlistSet(iLocality),
+                          task,
+                          kernelSetup(),
+                          nbat.get(),
+                          ic,
+                          fr->shift_vec,
+                          forceFlags,
+                          clearF,
+                          fr->fshift[0]);
+}
+
+void
+nonbonded_verlet_t::finishCpuKernelTasks(Nbnxm::InteractionLocality  iLocality,
+                                         const interaction_const_t  &ic,
+                                         int                         forceFlags,
+                                         t_forcerec                 *fr,
+                                         gmx_enerdata_t             *enerd,
+                                         t_nrnb                     *nrnb)
+{
+    const PairlistSet &pairlistSet = pairlistSets().pairlistSet(iLocality);
+
+    if (forceFlags & GMX_FORCE_ENERGY)
+    {
+        reduce_energies_over_lists(nbat.get(), pairlistSet.cpuLists().ssize(),
+                                   fr->bBHAM ?
+                                   enerd->grpp.ener[egBHAMSR] :
+                                   enerd->grpp.ener[egLJSR],
+                                   enerd->grpp.ener[egCOULSR]);
+    }
+
+    accountFlops(nrnb, pairlistSet, *this, ic, forceFlags);
+}
+
+/*! \brief Dispatches the free-energy kernel for the perturbed pairs in cluster-pair lists
+ *
+ * These interactions are linear in lambda, so dV/dlambda is added
+ * to the linear contributions, which are also used for the foreign
+ * lambda energy differences.
+ *
+ * \param[in]     pairlistSet   Pairlists with local or non-local interactions to compute
+ * \param[in,out] nbat          The atomdata for the interactions, forces are added to the output buffers
+ * \param[in,out] fr            The force record, shift forces are added to fr->fshift
+ * \param[in]     lambda        The lambda values
+ * \param[in,out] enerd         The energy data
+ * \param[in]     forceFlags    Flags that tell what to compute
+ * \param[in,out] nrnb          Flop accounting
+ */
+static void
+dispatchFreeEnergyClusterKernel(const PairlistSet &pairlistSet,
+                                nbnxn_atomdata_t  *nbat,
+                                t_forcerec        *fr,
+                                const real        *lambda,
+                                gmx_enerdata_t    *enerd,
+                                const int          forceFlags,
+                                t_nrnb            *nrnb)
+{
+    gmx::ArrayRef<const NbnxnPairlistFep> fepClusterLists = pairlistSet.fepClusterLists();
+
+    int numPairs = 0;
+    for (const NbnxnPairlistFep &fepClusterList : fepClusterLists)
+    {
+        numPairs += fepClusterList.numPairs;
+    }
+    if (numPairs == 0)
+    {
+        return;
+    }
+
+    const int  numLists            = fepClusterLists.ssize();
+    const int  numEnergyGroupPairs = gmx::square(nbat->params().nenergrp);
+    const bool computeForces       = ((forceFlags & GMX_FORCE_FORCES) != 0);
+    const bool computeVirial       = ((forceFlags & GMX_FORCE_VIRIAL) != 0);
+
+    /* Separate output per list, reduced in fixed order below */
+    std::vector<real>      energies(numLists*2*numEnergyGroupPairs, 0);
+    std::vector<gmx::RVec> shiftForces(computeVirial ? numLists*SHIFTS : 0, { 0, 0, 0 });
+    std::vector<double>    dvdl(numLists*efptNR, 0);
+
+    GMX_ASSERT(gmx::ssize(nbat->out) == numLists, "We need one output buffer per list");
+
+#pragma omp parallel for schedule(static) num_threads(numLists)
+    for (int th = 0; th < numLists; th++)
+    {
+        try
+        {
+            /* The forces are added to the output buffer used for the normal
+             * cluster-pair list of this thread, as the pair search has set
+             * the buffer reduction flags for all clusters in that list.
+             */
+            nbnxn_kernel_free_energy_cluster(fepClusterLists[th], *nbat, *fr, lambda,
+                                             computeForces ? nbat->out[th].f.data() : nullptr,
+                                             computeVirial ? as_rvec_array(shiftForces.data() + th*SHIFTS) : nullptr,
+                                             energies.data() + (2*th    )*numEnergyGroupPairs,
+                                             energies.data() + (2*th + 1)*numEnergyGroupPairs,
+                                             dvdl.data() + th*efptNR);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    for (int th = 0; th < numLists; th++)
+    {
+        if (forceFlags & GMX_FORCE_ENERGY)
+        {
+            for (int i = 0; i < numEnergyGroupPairs; i++)
+            {
+                enerd->grpp.ener[egCOULSR][i] += energies[(2*th    )*numEnergyGroupPairs + i];
+                enerd->grpp.ener[egLJSR][i]   += energies[(2*th + 1)*numEnergyGroupPairs + i];
+            }
+        }
+        if (computeVirial)
+        {
+            for (int s = 0; s < SHIFTS; s++)
+            {
+                rvec_inc(fr->fshift[s], shiftForces[th*SHIFTS + s]);
+            }
+        }
+        enerd->dvdl_lin[efptCOUL] += dvdl[th*efptNR + efptCOUL];
+        enerd->dvdl_lin[efptVDW]  += dvdl[th*efptNR + efptVDW];
+    }
+
+    /* Estimate flops: 12 per i-atom and 60 per atom pair */
+    int numIAtoms = 0;
+    for (const NbnxnPairlistFep &fepClusterList : fepClusterLists)
+    {
+        numIAtoms += fepClusterList.ci.size()*fepClusterList.na_ci;
+    }
+    inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, numIAtoms*12 + numPairs*60);
+}
+
 void
 nonbonded_verlet_t::dispatchFreeEnergyKernel(Nbnxm::InteractionLocality  iLocality,
                                              t_forcerec                 *fr,
@@ -551,10 +720,21 @@ nonbonded_verlet_t::dispatchFreeEnergyKernel(Nbnxm::InteractionLocality  iLocali
                                              const int                   forceFlags,
                                              t_nrnb                     *nrnb)
 {
-    const gmx::ArrayRef<t_nblist const * const > nbl_fep = pairlistSets().pairlistSet(iLocality).fepLists();
+    if (!pairlistSets().params().haveFep)
+    {
+        return;
+    }
+
+    const PairlistSet &pairlistSet = pairlistSets().pairlistSet(iLocality);
+
+    /* Perturbed pairs without soft-core are computed on cluster-pair lists */
+    dispatchFreeEnergyClusterKernel(pairlistSet, nbat.get(), fr, lambda,
+                                    enerd, forceFlags, nrnb);
+
+    const gmx::ArrayRef<t_nblist const * const > nbl_fep = pairlistSet.fepLists();
 
     /* When the first list is empty, all are empty and there is nothing to do */
-    if (!pairlistSets().params().haveFep || nbl_fep[0]->nrj == 0)
+    if (nbl_fep[0]->nrj == 0)
     {
         return;
     }
@@ -612,36 +792,44 @@ nonbonded_verlet_t::dispatchFreeEnergyKernel(Nbnxm::InteractionLocality  iLocali
 
     /* If we do foreign lambda and we have soft-core interactions
      * we have to recalculate the (non-linear) energies contributions.
+     * All foreign lambda values are evaluated in a single pass over the lists.
      */
     if (fepvals->n_lambda > 0 && (forceFlags & GMX_FORCE_DHDL) && fepvals->sc_alpha != 0)
     {
-        real lam_i[efptNR];
-        kernel_data.flags          = (donb_flags & ~(GMX_NONBONDED_DO_FORCE | GMX_NONBONDED_DO_SHIFTFORCE)) | GMX_NONBONDED_DO_FOREIGNLAMBDA;
-        kernel_data.lambda         = lam_i;
-        kernel_data.energygrp_elec = enerd->foreign_grpp.ener[egCOULSR];
-        kernel_data.energygrp_vdw  = enerd->foreign_grpp.ener[egLJSR];
-        /* Note that we add to kernel_data.dvdl, but ignore the result */
+        const int         numLambdas = enerd->n_lambda;
+        std::vector<real> lambdaCoul(numLambdas);
+        std::vector<real> lambdaVdw(numLambdas);
+        for (int i = 0; i < numLambdas; i++)
+        {
+            lambdaCoul[i] = (i == 0 ? lambda[efptCOUL] : fepvals->all_lambda[efptCOUL][i-1]);
+            lambdaVdw[i]  = (i == 0 ? lambda[efptVDW]  : fepvals->all_lambda[efptVDW][i-1]);
+        }
 
-        for (int i = 0; i < enerd->n_lambda; i++)
+        /* Separate output per list, reduced in fixed order below */
+        std::vector<double> foreignEnergy(nbl_fep.ssize()*numLambdas, 0.0);
+
+#pragma omp parallel for schedule(static) num_threads(nbl_fep.ssize())
+        for (int th = 0; th < nbl_fep.ssize(); th++)
         {
-            for (int j = 0; j < efptNR; j++)
+            try
             {
-                lam_i[j] = (i == 0 ? lambda[j] : fepvals->all_lambda[j][i-1]);
+                gmx_nb_free_energy_foreign_lambda_kernel(nbl_fep[th],
+                                                         x, fr, &mdatoms,
+                                                         numLambdas,
+                                                         lambdaCoul.data(),
+                                                         lambdaVdw.data(),
+                                                         foreignEnergy.data() + th*numLambdas,
+                                                         nrnb);
             }
-            reset_foreign_enerdata(enerd);
-#pragma omp parallel for schedule(static) num_threads(nbl_fep.ssize())
-            for (int th = 0; th < nbl_fep.ssize(); th++)
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+
+        for (int th = 0; th < nbl_fep.ssize(); th++)
+        {
+            for (int i = 0; i < numLambdas; i++)
             {
-                try
-                {
-                    gmx_nb_free_energy_kernel(nbl_fep[th],
-                                              x, f, fr, &mdatoms, &kernel_data, nrnb);
-                }
-                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+                enerd->enerpart_lambda[i] += foreignEnergy[th*numLambdas + i];
             }
-
-            sum_epot(&(enerd->foreign_grpp), enerd->foreign_term);
-            enerd->enerpart_lambda[i] += enerd->foreign_term[F_EPOT];
         }
     }
 }
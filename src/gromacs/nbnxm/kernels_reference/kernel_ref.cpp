@@ -48,6 +48,7 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/pbcutil/ishift.h"
+#include "gromacs/tables/cubicsplinetable.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -72,6 +73,9 @@
 #undef LJ_EWALD_COMB_LB
 #undef LJ_CUT
 #undef LJ_EWALD
+#define LJ_USER_TABLE
+#include "gromacs/nbnxm/kernels_reference/kernel_ref_includes.h"
+#undef LJ_USER_TABLE
 #undef CALC_COUL_RF
 
 
@@ -96,6 +100,9 @@
 #undef LJ_EWALD_COMB_LB
 #undef LJ_CUT
 #undef LJ_EWALD
+#define LJ_USER_TABLE
+#include "gromacs/nbnxm/kernels_reference/kernel_ref_includes.h"
+#undef LJ_USER_TABLE
 /* Twin-range cut-off kernels */
 #define VDW_CUTOFF_CHECK
 #define LJ_CUT
@@ -117,5 +124,8 @@
 #undef LJ_EWALD_COMB_LB
 #undef LJ_CUT
 #undef LJ_EWALD
+#define LJ_USER_TABLE
+#include "gromacs/nbnxm/kernels_reference/kernel_ref_includes.h"
+#undef LJ_USER_TABLE
 #undef VDW_CUTOFF_CHECK
 #undef CALC_COUL_TAB
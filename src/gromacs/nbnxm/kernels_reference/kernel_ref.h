@@ -42,48 +42,57 @@ nbk_func_noener nbnxn_kernel_ElecRF_VdwLJFsw_F_ref;
 nbk_func_noener nbnxn_kernel_ElecRF_VdwLJPsw_F_ref;
 nbk_func_noener nbnxn_kernel_ElecRF_VdwLJEwCombGeom_F_ref;
 nbk_func_noener nbnxn_kernel_ElecRF_VdwLJEwCombLB_F_ref;
+nbk_func_noener nbnxn_kernel_ElecRF_VdwUserTab_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTab_VdwLJ_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTab_VdwLJFsw_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTab_VdwLJPsw_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTab_VdwLJEwCombGeom_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTab_VdwLJEwCombLB_F_ref;
+nbk_func_noener nbnxn_kernel_ElecQSTab_VdwUserTab_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTabTwinCut_VdwLJ_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_F_ref;
 nbk_func_noener nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_F_ref;
+nbk_func_noener nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_F_ref;
 
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJ_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJFsw_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJPsw_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJEwCombGeom_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJEwCombLB_VF_ref;
+nbk_func_ener   nbnxn_kernel_ElecRF_VdwUserTab_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJ_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJFsw_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJPsw_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJEwCombGeom_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJEwCombLB_VF_ref;
+nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwUserTab_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJ_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VF_ref;
+nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_VF_ref;
 
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJ_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJFsw_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJPsw_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJEwCombGeom_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecRF_VdwLJEwCombLB_VgrpF_ref;
+nbk_func_ener   nbnxn_kernel_ElecRF_VdwUserTab_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJ_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJFsw_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJPsw_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJEwCombGeom_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwLJEwCombLB_VgrpF_ref;
+nbk_func_ener   nbnxn_kernel_ElecQSTab_VdwUserTab_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJ_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VgrpF_ref;
 nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VgrpF_ref;
+nbk_func_ener   nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_VgrpF_ref;
 
 #ifdef INCLUDE_KERNELFUNCTION_TABLES
 
@@ -102,6 +111,7 @@ static p_nbk_func_noener nbnxn_kernel_noener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecRF_VdwLJFsw_F_ref,
         nbnxn_kernel_ElecRF_VdwLJPsw_F_ref,
         nbnxn_kernel_ElecRF_VdwLJEwCombGeom_F_ref,
+        nbnxn_kernel_ElecRF_VdwUserTab_F_ref,
         nbnxn_kernel_ElecRF_VdwLJEwCombLB_F_ref
     },
     {
@@ -111,6 +121,7 @@ static p_nbk_func_noener nbnxn_kernel_noener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTab_VdwLJFsw_F_ref,
         nbnxn_kernel_ElecQSTab_VdwLJPsw_F_ref,
         nbnxn_kernel_ElecQSTab_VdwLJEwCombGeom_F_ref,
+        nbnxn_kernel_ElecQSTab_VdwUserTab_F_ref,
         nbnxn_kernel_ElecQSTab_VdwLJEwCombLB_F_ref
     },
     {
@@ -120,6 +131,7 @@ static p_nbk_func_noener nbnxn_kernel_noener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_F_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_F_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_F_ref,
+        nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_F_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_F_ref
     },
     {
@@ -129,6 +141,7 @@ static p_nbk_func_noener nbnxn_kernel_noener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_F_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_F_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_F_ref,
+        nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_F_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_F_ref
     }
 };
@@ -142,6 +155,7 @@ static p_nbk_func_ener nbnxn_kernel_ener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecRF_VdwLJFsw_VF_ref,
         nbnxn_kernel_ElecRF_VdwLJPsw_VF_ref,
         nbnxn_kernel_ElecRF_VdwLJEwCombGeom_VF_ref,
+        nbnxn_kernel_ElecRF_VdwUserTab_VF_ref,
         nbnxn_kernel_ElecRF_VdwLJEwCombLB_VF_ref
     },
     {
@@ -151,6 +165,7 @@ static p_nbk_func_ener nbnxn_kernel_ener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTab_VdwLJFsw_VF_ref,
         nbnxn_kernel_ElecQSTab_VdwLJPsw_VF_ref,
         nbnxn_kernel_ElecQSTab_VdwLJEwCombGeom_VF_ref,
+        nbnxn_kernel_ElecQSTab_VdwUserTab_VF_ref,
         nbnxn_kernel_ElecQSTab_VdwLJEwCombLB_VF_ref
     },
     {
@@ -160,6 +175,7 @@ static p_nbk_func_ener nbnxn_kernel_ener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VF_ref,
+        nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_VF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VF_ref
     },
     {
@@ -169,6 +185,7 @@ static p_nbk_func_ener nbnxn_kernel_ener_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VF_ref,
+        nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_VF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VF_ref
     }
 };
@@ -182,6 +199,7 @@ static p_nbk_func_ener nbnxn_kernel_energrp_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecRF_VdwLJFsw_VgrpF_ref,
         nbnxn_kernel_ElecRF_VdwLJPsw_VgrpF_ref,
         nbnxn_kernel_ElecRF_VdwLJEwCombGeom_VgrpF_ref,
+        nbnxn_kernel_ElecRF_VdwUserTab_VgrpF_ref,
         nbnxn_kernel_ElecRF_VdwLJEwCombLB_VgrpF_ref
     },
     {
@@ -191,6 +209,7 @@ static p_nbk_func_ener nbnxn_kernel_energrp_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTab_VdwLJFsw_VgrpF_ref,
         nbnxn_kernel_ElecQSTab_VdwLJPsw_VgrpF_ref,
         nbnxn_kernel_ElecQSTab_VdwLJEwCombGeom_VgrpF_ref,
+        nbnxn_kernel_ElecQSTab_VdwUserTab_VgrpF_ref,
         nbnxn_kernel_ElecQSTab_VdwLJEwCombLB_VgrpF_ref
     },
     {
@@ -200,6 +219,7 @@ static p_nbk_func_ener nbnxn_kernel_energrp_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VgrpF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VgrpF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VgrpF_ref,
+        nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_VgrpF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VgrpF_ref
     },
     {
@@ -209,6 +229,7 @@ static p_nbk_func_ener nbnxn_kernel_energrp_ref[coulktNR][vdwktNR_ref] =
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJFsw_VgrpF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJPsw_VgrpF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VgrpF_ref,
+        nbnxn_kernel_ElecQSTabTwinCut_VdwUserTab_VgrpF_ref,
         nbnxn_kernel_ElecQSTabTwinCut_VdwLJEwCombLB_VgrpF_ref
     }
 };
@@ -67,9 +67,13 @@
             int             aj;
             real            dx, dy, dz;
             real            rsq, rinv;
-            real            rinvsq, rinvsix;
+            real            rinvsq;
+#ifndef LJ_USER_TABLE
+            real            rinvsix;
+            real            FrLJ6 = 0, FrLJ12 = 0;
+#endif
             real            c6, c12;
-            real            FrLJ6 = 0, FrLJ12 = 0, frLJ = 0;
+            real            frLJ = 0;
             real            VLJ gmx_unused;
 #if defined LJ_FORCE_SWITCH || defined LJ_POT_SWITCH
             real            r, rsw;
@@ -166,6 +170,24 @@
 #endif
 #endif
 
+#ifdef LJ_USER_TABLE
+                {
+                    real r, disp, dispDer, rep, repDer;
+
+                    /* r is zero beyond the cut-off, since rinv is masked */
+                    r       = rsq*rinv;
+#ifdef VDW_CUTOFF_CHECK
+                    /* Avoid table lookups beyond the VdW cut-off */
+                    r       = (rsq < rvdw2) ? r : 0;
+#endif
+                    ic->vdwUserTable->evaluateFunctionAndDerivative(r, &disp, &dispDer, &rep, &repDer);
+                    frLJ    = -interact*(c6*dispDer + c12*repDer)*r;
+#ifdef CALC_ENERGIES
+                    VLJ     = c6*disp + c12*rep;
+#endif
+                }
+#endif
+
 #if defined LJ_FORCE_SWITCH || defined LJ_POT_SWITCH
                 /* Force or potential switching from ic->rvdw_switch */
                 r       = rsq*rinv;
@@ -77,6 +77,8 @@ static_assert(UNROLLI == c_nbnxnCpuIClusterSize, "UNROLLI should match the i-clu
 #else
 #define NBK_FUNC_NAME(feg) NBK_FUNC_NAME2(_VdwLJEwCombLB, feg)
 #endif
+#elif defined LJ_USER_TABLE
+#define NBK_FUNC_NAME(feg) NBK_FUNC_NAME2(_VdwUserTab, feg)
 #else
 #error "No VdW type defined"
 #endif
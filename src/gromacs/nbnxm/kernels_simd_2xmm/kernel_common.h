@@ -39,6 +39,9 @@
 #ifdef CALC_COUL_EWALD
 #include "gromacs/math/utilities.h"
 #endif
+#ifdef LJ_USER_TABLE
+#include "gromacs/tables/cubicsplinetable.h"
+#endif
 
 #include "config.h"
 
@@ -70,16 +73,31 @@ static_assert(UNROLLI == c_nbnxnCpuIClusterSize, "UNROLLI should match the i-clu
 #endif
 
 #if defined UNROLLJ
-/* As add_ener_grp, but for two groups of UNROLLJ/2 stored in
- * a single SIMD register.
+/* Add energy register to the group-pair energy buffers of two i-atoms,
+ * stored in the two halves of a SIMD register. The buffers have UNROLLJ
+ * entries per j-group, offset_j contains the offset of the j-group for
+ * each j-atom. When all j-atoms are in the same group, which is the
+ * common case, we add each half to a single entry.
  */
 static inline void
-add_ener_grp_halves(gmx::SimdReal e_S, real *v0, real *v1, const int *offset_jj)
+add_ener_grp_halves(gmx::SimdReal e_S, real *v0, real *v1, gmx_bool jUniform, const int *offset_j)
 {
-    for (int jj = 0; jj < (UNROLLJ/2); jj++)
+    using namespace gmx;
+
+    if (jUniform)
+    {
+        incrDualHsimd(v0+offset_j[0], v1+offset_j[0], e_S);
+    }
+    else
     {
-        incrDualHsimd(v0+offset_jj[jj]+jj*GMX_SIMD_REAL_WIDTH/2,
-                      v1+offset_jj[jj]+jj*GMX_SIMD_REAL_WIDTH/2, e_S);
+        alignas(GMX_SIMD_ALIGNMENT) real e[GMX_SIMD_REAL_WIDTH];
+
+        store(e, e_S);
+        for (int jj = 0; jj < UNROLLJ; jj++)
+        {
+            v0[offset_j[jj] + jj] += e[jj];
+            v1[offset_j[jj] + jj] += e[UNROLLJ + jj];
+        }
     }
 }
 #endif
@@ -66,8 +66,10 @@
     int        cj, aj, ajx, ajy, ajz;
 
 #ifdef ENERGY_GROUPS
-    /* Energy group indices for two atoms packed into one int */
-    int        egp_jj[UNROLLJ/2];
+    /* Energy group buffer offsets for each j-atom */
+    int        egp_j[UNROLLJ];
+    /* Whether all j-atoms are in the same energy group */
+    gmx_bool   egp_j_uniform;
 #endif
 
 #ifdef CHECK_EXCLS
@@ -93,7 +95,7 @@
 #endif
 #endif
 
-#if (defined CALC_COULOMB && defined CALC_COUL_TAB) || defined LJ_FORCE_SWITCH || defined LJ_POT_SWITCH
+#if (defined CALC_COULOMB && defined CALC_COUL_TAB) || defined LJ_FORCE_SWITCH || defined LJ_POT_SWITCH || defined LJ_USER_TABLE
     SimdReal r_S0;
 #if (defined CALC_COULOMB && defined CALC_COUL_TAB) || !defined HALF_LJ
     SimdReal r_S2;
@@ -186,7 +188,7 @@
 #endif
 
     /* Intermediate variables for LJ calculation */
-#ifndef LJ_COMB_LB
+#if !defined LJ_COMB_LB && !defined LJ_USER_TABLE
     SimdReal  rinvsix_S0;
 #ifndef HALF_LJ
     SimdReal  rinvsix_S2;
@@ -497,6 +499,7 @@
 #endif
 
 #ifndef LJ_COMB_LB
+#ifndef LJ_USER_TABLE
     rinvsix_S0  = rinvsq_S0 * rinvsq_S0 * rinvsq_S0;
 #ifdef EXCL_FORCES
     rinvsix_S0  = selectByMask(rinvsix_S0, interact_S0);
@@ -507,6 +510,7 @@
     rinvsix_S2  = selectByMask(rinvsix_S2, interact_S2);
 #endif
 #endif
+#endif /* not LJ_USER_TABLE */
 
 #if defined LJ_CUT || defined LJ_POT_SWITCH
     /* We have plain LJ or LJ-PME with simple C6/6 C12/12 coefficients */
@@ -548,6 +552,47 @@
 #undef add_fr_switch
 #endif /* LJ_FORCE_SWITCH */
 
+#ifdef LJ_USER_TABLE
+    /* Interpolate the user dispersion and repulsion functions,
+     * r is set to zero beyond the (VdW) cut-off to stay within the table.
+     */
+    SimdReal disp_S0, dispDer_S0, rep_S0, repDer_S0;
+    r_S0        = rsq_S0 * rinv_S0;
+#ifdef VDW_CUTOFF_CHECK
+    r_S0        = selectByMask(r_S0, wco_vdw_S0);
+#endif
+#ifdef EXCL_FORCES
+    r_S0        = selectByMask(r_S0, interact_S0);
+#endif
+    ic->vdwUserTable->evaluateFunctionAndDerivative(r_S0, &disp_S0, &dispDer_S0, &rep_S0, &repDer_S0);
+#ifndef HALF_LJ
+    SimdReal disp_S2, dispDer_S2, rep_S2, repDer_S2;
+    r_S2        = rsq_S2 * rinv_S2;
+#ifdef VDW_CUTOFF_CHECK
+    r_S2        = selectByMask(r_S2, wco_vdw_S2);
+#endif
+#ifdef EXCL_FORCES
+    r_S2        = selectByMask(r_S2, interact_S2);
+#endif
+    ic->vdwUserTable->evaluateFunctionAndDerivative(r_S2, &disp_S2, &dispDer_S2, &rep_S2, &repDer_S2);
+#endif
+    /* With these definitions frLJ = FrLJ12 - FrLJ6 = -dV/dr*r */
+    FrLJ6_S0    = c6_S0 * dispDer_S0 * r_S0;
+#ifndef HALF_LJ
+    FrLJ6_S2    = c6_S2 * dispDer_S2 * r_S2;
+#endif
+    FrLJ12_S0   = -c12_S0 * repDer_S0 * r_S0;
+#ifndef HALF_LJ
+    FrLJ12_S2   = -c12_S2 * repDer_S2 * r_S2;
+#endif
+#ifdef CALC_ENERGIES
+    SimdReal VLJ_S0 = fma(c6_S0, disp_S0, c12_S0 * rep_S0);
+#ifndef HALF_LJ
+    SimdReal VLJ_S2 = fma(c6_S2, disp_S2, c12_S2 * rep_S2);
+#endif
+#endif
+#endif /* LJ_USER_TABLE */
+
 #endif /* not LJ_COMB_LB */
 
 #ifdef LJ_COMB_LB
@@ -796,15 +841,16 @@
 
 #ifdef CALC_ENERGIES
 #ifdef ENERGY_GROUPS
-    /* Extract the group pair index per j pair.
+    /* Extract the energy group buffer offset per j-atom.
      * Energy groups are stored per i-cluster, so things get
      * complicated when the i- and j-cluster size don't match.
      */
     {
         int egps_j;
 #if UNROLLJ == 2
-        egps_j    = nbatParams.energrp[cj >> 1];
-        egp_jj[0] = ((egps_j >> ((cj & 1)*egps_jshift)) & egps_jmask)*egps_jstride;
+        egps_j    = nbatParams.energrp[cj >> 1] >> ((cj & 1)*2*egps_ishift);
+        egp_j[0]  = (egps_j & egps_imask)*UNROLLJ;
+        egp_j[1]  = ((egps_j >> egps_ishift) & egps_imask)*UNROLLJ;
 #else
         /* We assume UNROLLI <= UNROLLJ */
         int jdi;
@@ -812,12 +858,17 @@
         {
             int jj;
             egps_j = nbatParams.energrp[cj*(UNROLLJ/UNROLLI) + jdi];
-            for (jj = 0; jj < (UNROLLI/2); jj++)
+            for (jj = 0; jj < UNROLLI; jj++)
             {
-                egp_jj[jdi*(UNROLLI/2)+jj] = ((egps_j >> (jj*egps_jshift)) & egps_jmask)*egps_jstride;
+                egp_j[jdi*UNROLLI+jj] = ((egps_j >> (jj*egps_ishift)) & egps_imask)*UNROLLJ;
             }
         }
 #endif
+        egp_j_uniform = TRUE;
+        for (int jj = 1; jj < UNROLLJ; jj++)
+        {
+            egp_j_uniform = egp_j_uniform && (egp_j[jj] == egp_j[0]);
+        }
     }
 #endif
 
@@ -825,8 +876,8 @@
 #ifndef ENERGY_GROUPS
     vctot_S      = vctot_S + vcoul_S0 + vcoul_S2;
 #else
-    add_ener_grp_halves(vcoul_S0, vctp[0], vctp[1], egp_jj);
-    add_ener_grp_halves(vcoul_S2, vctp[2], vctp[3], egp_jj);
+    add_ener_grp_halves(vcoul_S0, vctp[0], vctp[1], egp_j_uniform, egp_j);
+    add_ener_grp_halves(vcoul_S2, vctp[2], vctp[3], egp_j_uniform, egp_j);
 #endif
 #endif
 
@@ -838,9 +889,9 @@
 #endif
     ;
 #else
-    add_ener_grp_halves(VLJ_S0, vvdwtp[0], vvdwtp[1], egp_jj);
+    add_ener_grp_halves(VLJ_S0, vvdwtp[0], vvdwtp[1], egp_j_uniform, egp_j);
 #ifndef HALF_LJ
-    add_ener_grp_halves(VLJ_S2, vvdwtp[2], vvdwtp[3], egp_jj);
+    add_ener_grp_halves(VLJ_S2, vvdwtp[2], vvdwtp[3], egp_j_uniform, egp_j);
 #endif
 #endif
 #endif /* CALC_LJ */
@@ -45,7 +45,6 @@
 #ifdef ENERGY_GROUPS
     int         Vstride_i;
     int         egps_ishift, egps_imask;
-    int         egps_jshift, egps_jmask, egps_jstride;
     int         egps_i;
     real       *vvdwtp[UNROLLI];
     real       *vctp[UNROLLI];
@@ -238,7 +237,7 @@
 #endif
 
     /* LJ function constants */
-#if defined CALC_ENERGIES || defined LJ_POT_SWITCH
+#if (defined CALC_ENERGIES && !defined LJ_USER_TABLE) || defined LJ_POT_SWITCH
     SimdReal sixth_S      = SimdReal(1.0/6.0);
     SimdReal twelveth_S   = SimdReal(1.0/12.0);
 #endif
@@ -331,11 +330,10 @@
 #ifdef ENERGY_GROUPS
     egps_ishift  = nbatParams.neg_2log;
     egps_imask   = (1<<egps_ishift) - 1;
-    egps_jshift  = 2*nbatParams.neg_2log;
-    egps_jmask   = (1<<egps_jshift) - 1;
-    egps_jstride = (UNROLLJ>>1)*UNROLLJ;
-    /* Major division is over i-particle energy groups, determine the stride */
-    Vstride_i    = nbatParams.nenergrp*(1 << nbatParams.neg_2log)*egps_jstride;
+    /* Major division is over i-particle energy groups, minor over j-groups,
+     * each group pair has UNROLLJ entries, determine the stride.
+     */
+    Vstride_i    = nbatParams.nenergrp*UNROLLJ;
 #endif
 
     l_cj = nbl->cj.data();
@@ -432,7 +430,7 @@
 
                     qi = q[sci+ia];
 #ifdef ENERGY_GROUPS
-                    vctp[ia][((egps_i>>(ia*egps_ishift)) & egps_imask)*egps_jstride]
+                    vctp[ia][((egps_i>>(ia*egps_ishift)) & egps_imask)*UNROLLJ]
 #else
                     Vc[0]
 #endif
@@ -450,7 +448,7 @@
 
                     c6_i = nbatParams.nbfp[nbatParams.type[sci+ia]*(nbatParams.numTypes + 1)*2]/6;
 #ifdef ENERGY_GROUPS
-                    vvdwtp[ia][((egps_i>>(ia*egps_ishift)) & egps_imask)*egps_jstride]
+                    vvdwtp[ia][((egps_i>>(ia*egps_ishift)) & egps_imask)*UNROLLJ]
 #else
                     Vvdw[0]
 #endif
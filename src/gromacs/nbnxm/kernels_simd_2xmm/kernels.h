@@ -48,30 +48,35 @@ nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJ_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJFSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJPSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJEwCombGeom_VgrpF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecRF_VdwUserTab_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJCombGeom_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJCombLB_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJ_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJFSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJPSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJEwCombGeom_VgrpF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwUserTab_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombGeom_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombLB_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJ_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJFSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJPSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VgrpF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwUserTab_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJCombGeom_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJCombLB_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJ_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJFSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJPSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJEwCombGeom_VgrpF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecEw_VdwUserTab_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJCombGeom_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJCombLB_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJ_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJFSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJPSw_VgrpF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJEwCombGeom_VgrpF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwUserTab_VgrpF_2xmm;
 
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJCombGeom_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJCombLB_VF_2xmm;
@@ -79,30 +84,35 @@ nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJ_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJFSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJPSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecRF_VdwLJEwCombGeom_VF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecRF_VdwUserTab_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJCombGeom_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJCombLB_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJ_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJFSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJPSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwLJEwCombGeom_VF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecQSTab_VdwUserTab_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombGeom_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombLB_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJ_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJFSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJPSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecQSTabTwinCut_VdwUserTab_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJCombGeom_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJCombLB_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJ_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJFSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJPSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEw_VdwLJEwCombGeom_VF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecEw_VdwUserTab_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJCombGeom_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJCombLB_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJ_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJFSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJPSw_VF_2xmm;
 nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwLJEwCombGeom_VF_2xmm;
+nbk_func_ener         nbnxm_kernel_ElecEwTwinCut_VdwUserTab_VF_2xmm;
 
 nbk_func_noener       nbnxm_kernel_ElecRF_VdwLJCombGeom_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecRF_VdwLJCombLB_F_2xmm;
@@ -110,30 +120,35 @@ nbk_func_noener       nbnxm_kernel_ElecRF_VdwLJ_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecRF_VdwLJFSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecRF_VdwLJPSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecRF_VdwLJEwCombGeom_F_2xmm;
+nbk_func_noener       nbnxm_kernel_ElecRF_VdwUserTab_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwLJCombGeom_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwLJCombLB_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwLJ_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwLJFSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwLJPSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwLJEwCombGeom_F_2xmm;
+nbk_func_noener       nbnxm_kernel_ElecQSTab_VdwUserTab_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombGeom_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombLB_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwLJ_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwLJFSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwLJPSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_F_2xmm;
+nbk_func_noener       nbnxm_kernel_ElecQSTabTwinCut_VdwUserTab_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEw_VdwLJCombGeom_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEw_VdwLJCombLB_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEw_VdwLJ_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEw_VdwLJFSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEw_VdwLJPSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEw_VdwLJEwCombGeom_F_2xmm;
+nbk_func_noener       nbnxm_kernel_ElecEw_VdwUserTab_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwLJCombGeom_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwLJCombLB_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwLJ_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwLJFSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwLJPSw_F_2xmm;
 nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwLJEwCombGeom_F_2xmm;
+nbk_func_noener       nbnxm_kernel_ElecEwTwinCut_VdwUserTab_F_2xmm;
 
 
 
@@ -152,6 +167,7 @@ static p_nbk_func_noener nbnxm_kernel_noener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecRF_VdwLJFSw_F_2xmm,
         nbnxm_kernel_ElecRF_VdwLJPSw_F_2xmm,
         nbnxm_kernel_ElecRF_VdwLJEwCombGeom_F_2xmm,
+        nbnxm_kernel_ElecRF_VdwUserTab_F_2xmm,
     },
     {
         nbnxm_kernel_ElecQSTab_VdwLJCombGeom_F_2xmm,
@@ -160,6 +176,7 @@ static p_nbk_func_noener nbnxm_kernel_noener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecQSTab_VdwLJFSw_F_2xmm,
         nbnxm_kernel_ElecQSTab_VdwLJPSw_F_2xmm,
         nbnxm_kernel_ElecQSTab_VdwLJEwCombGeom_F_2xmm,
+        nbnxm_kernel_ElecQSTab_VdwUserTab_F_2xmm,
     },
     {
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombGeom_F_2xmm,
@@ -168,6 +185,7 @@ static p_nbk_func_noener nbnxm_kernel_noener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJFSw_F_2xmm,
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJPSw_F_2xmm,
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_F_2xmm,
+        nbnxm_kernel_ElecQSTabTwinCut_VdwUserTab_F_2xmm,
     },
     {
         nbnxm_kernel_ElecEw_VdwLJCombGeom_F_2xmm,
@@ -176,6 +194,7 @@ static p_nbk_func_noener nbnxm_kernel_noener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecEw_VdwLJFSw_F_2xmm,
         nbnxm_kernel_ElecEw_VdwLJPSw_F_2xmm,
         nbnxm_kernel_ElecEw_VdwLJEwCombGeom_F_2xmm,
+        nbnxm_kernel_ElecEw_VdwUserTab_F_2xmm,
     },
     {
         nbnxm_kernel_ElecEwTwinCut_VdwLJCombGeom_F_2xmm,
@@ -184,6 +203,7 @@ static p_nbk_func_noener nbnxm_kernel_noener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecEwTwinCut_VdwLJFSw_F_2xmm,
         nbnxm_kernel_ElecEwTwinCut_VdwLJPSw_F_2xmm,
         nbnxm_kernel_ElecEwTwinCut_VdwLJEwCombGeom_F_2xmm,
+        nbnxm_kernel_ElecEwTwinCut_VdwUserTab_F_2xmm,
     },
 };
 
@@ -196,6 +216,7 @@ static p_nbk_func_ener nbnxm_kernel_ener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecRF_VdwLJFSw_VF_2xmm,
         nbnxm_kernel_ElecRF_VdwLJPSw_VF_2xmm,
         nbnxm_kernel_ElecRF_VdwLJEwCombGeom_VF_2xmm,
+        nbnxm_kernel_ElecRF_VdwUserTab_VF_2xmm,
     },
     {
         nbnxm_kernel_ElecQSTab_VdwLJCombGeom_VF_2xmm,
@@ -204,6 +225,7 @@ static p_nbk_func_ener nbnxm_kernel_ener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecQSTab_VdwLJFSw_VF_2xmm,
         nbnxm_kernel_ElecQSTab_VdwLJPSw_VF_2xmm,
         nbnxm_kernel_ElecQSTab_VdwLJEwCombGeom_VF_2xmm,
+        nbnxm_kernel_ElecQSTab_VdwUserTab_VF_2xmm,
     },
     {
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombGeom_VF_2xmm,
@@ -212,6 +234,7 @@ static p_nbk_func_ener nbnxm_kernel_ener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJFSw_VF_2xmm,
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJPSw_VF_2xmm,
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VF_2xmm,
+        nbnxm_kernel_ElecQSTabTwinCut_VdwUserTab_VF_2xmm,
     },
     {
         nbnxm_kernel_ElecEw_VdwLJCombGeom_VF_2xmm,
@@ -220,6 +243,7 @@ static p_nbk_func_ener nbnxm_kernel_ener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecEw_VdwLJFSw_VF_2xmm,
         nbnxm_kernel_ElecEw_VdwLJPSw_VF_2xmm,
         nbnxm_kernel_ElecEw_VdwLJEwCombGeom_VF_2xmm,
+        nbnxm_kernel_ElecEw_VdwUserTab_VF_2xmm,
     },
     {
         nbnxm_kernel_ElecEwTwinCut_VdwLJCombGeom_VF_2xmm,
@@ -228,6 +252,7 @@ static p_nbk_func_ener nbnxm_kernel_ener_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecEwTwinCut_VdwLJFSw_VF_2xmm,
         nbnxm_kernel_ElecEwTwinCut_VdwLJPSw_VF_2xmm,
         nbnxm_kernel_ElecEwTwinCut_VdwLJEwCombGeom_VF_2xmm,
+        nbnxm_kernel_ElecEwTwinCut_VdwUserTab_VF_2xmm,
     },
 };
 
@@ -240,6 +265,7 @@ static p_nbk_func_ener nbnxm_kernel_energrp_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecRF_VdwLJFSw_VgrpF_2xmm,
         nbnxm_kernel_ElecRF_VdwLJPSw_VgrpF_2xmm,
         nbnxm_kernel_ElecRF_VdwLJEwCombGeom_VgrpF_2xmm,
+        nbnxm_kernel_ElecRF_VdwUserTab_VgrpF_2xmm,
     },
     {
         nbnxm_kernel_ElecQSTab_VdwLJCombGeom_VgrpF_2xmm,
@@ -248,6 +274,7 @@ static p_nbk_func_ener nbnxm_kernel_energrp_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecQSTab_VdwLJFSw_VgrpF_2xmm,
         nbnxm_kernel_ElecQSTab_VdwLJPSw_VgrpF_2xmm,
         nbnxm_kernel_ElecQSTab_VdwLJEwCombGeom_VgrpF_2xmm,
+        nbnxm_kernel_ElecQSTab_VdwUserTab_VgrpF_2xmm,
     },
     {
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJCombGeom_VgrpF_2xmm,
@@ -256,6 +283,7 @@ static p_nbk_func_ener nbnxm_kernel_energrp_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJFSw_VgrpF_2xmm,
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJPSw_VgrpF_2xmm,
         nbnxm_kernel_ElecQSTabTwinCut_VdwLJEwCombGeom_VgrpF_2xmm,
+        nbnxm_kernel_ElecQSTabTwinCut_VdwUserTab_VgrpF_2xmm,
     },
     {
         nbnxm_kernel_ElecEw_VdwLJCombGeom_VgrpF_2xmm,
@@ -264,6 +292,7 @@ static p_nbk_func_ener nbnxm_kernel_energrp_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecEw_VdwLJFSw_VgrpF_2xmm,
         nbnxm_kernel_ElecEw_VdwLJPSw_VgrpF_2xmm,
         nbnxm_kernel_ElecEw_VdwLJEwCombGeom_VgrpF_2xmm,
+        nbnxm_kernel_ElecEw_VdwUserTab_VgrpF_2xmm,
     },
     {
         nbnxm_kernel_ElecEwTwinCut_VdwLJCombGeom_VgrpF_2xmm,
@@ -272,6 +301,7 @@ static p_nbk_func_ener nbnxm_kernel_energrp_simd_2xmm[coulktNR][vdwktNR] =
         nbnxm_kernel_ElecEwTwinCut_VdwLJFSw_VgrpF_2xmm,
         nbnxm_kernel_ElecEwTwinCut_VdwLJPSw_VgrpF_2xmm,
         nbnxm_kernel_ElecEwTwinCut_VdwLJEwCombGeom_VgrpF_2xmm,
+        nbnxm_kernel_ElecEwTwinCut_VdwUserTab_VgrpF_2xmm,
     },
 };
 
@@ -40,6 +40,9 @@
 #ifdef CALC_COUL_EWALD
 #include "gromacs/math/utilities.h"
 #endif
+#ifdef LJ_USER_TABLE
+#include "gromacs/tables/cubicsplinetable.h"
+#endif
 
 #include "config.h"
 
@@ -71,22 +74,32 @@ static_assert(UNROLLI == c_nbnxnCpuIClusterSize, "UNROLLI should match the i-clu
 
 
 #ifdef UNROLLJ
-/* Add energy register to possibly multiple terms in the energy array */
-static inline void add_ener_grp(gmx::SimdReal e_S, real *v, const int *offset_jj)
+/* Add energy register to the group-pair energy buffer of one i-atom.
+ * The buffer has UNROLLJ entries per j-group, offset_j contains the offset
+ * of the j-group for each j-atom. When all j-atoms are in the same group,
+ * which is the common case, we add the whole register to a single entry.
+ * Otherwise we resolve the groups per j-atom.
+ */
+static inline void add_ener_grp(gmx::SimdReal e_S, real *v, gmx_bool jUniform, const int *offset_j)
 {
     using namespace gmx;
-    int jj;
 
-    /* We need to balance the number of store operations with
-     * the rapidly increases number of combinations of energy groups.
-     * We add to a temporary buffer for 1 i-group vs 2 j-groups.
-     */
-    for (jj = 0; jj < (UNROLLJ/2); jj++)
+    if (jUniform)
     {
         SimdReal v_S;
 
-        v_S = load<SimdReal>(v+offset_jj[jj]+jj*GMX_SIMD_REAL_WIDTH);
-        store(v+offset_jj[jj]+jj*GMX_SIMD_REAL_WIDTH, v_S + e_S);
+        v_S = load<SimdReal>(v+offset_j[0]);
+        store(v+offset_j[0], v_S + e_S);
+    }
+    else
+    {
+        alignas(GMX_SIMD_ALIGNMENT) real e[GMX_SIMD_REAL_WIDTH];
+
+        store(e, e_S);
+        for (int jj = 0; jj < UNROLLJ; jj++)
+        {
+            v[offset_j[jj] + jj] += e[jj];
+        }
     }
 }
 #endif
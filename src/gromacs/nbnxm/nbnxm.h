@@ -156,6 +156,8 @@ struct NbnxnListParameters
 
     PairlistType pairlistType;           //!< The type of cluster-pair list
     bool         haveFep;                //!< Tells whether we have perturbed interactions
+    bool         useSoftCoreCoulomb;     //!< Tells whether soft-core is used for perturbed Coulomb interactions
+    bool         useSoftCoreVdw;         //!< Tells whether soft-core is used for perturbed VdW interactions
     real         rlistOuter;             //!< Cut-off of the larger, outer pair-list
     real         rlistInner;             //!< Cut-off of the smaller, inner pair-list
     bool         haveMultipleDomains;    //!< True when using DD with multiple domains
@@ -432,6 +434,31 @@ struct nonbonded_verlet_t
                                      gmx_enerdata_t             *enerd,
                                      t_nrnb                     *nrnb);
 
+        //! Returns the number of CPU kernel tasks, one per pairlist, for the given locality
+        int numCpuKernelTasks(Nbnxm::InteractionLocality iLocality) const;
+
+        /*! \brief Executes the CPU non-bonded kernel for pairlist \p task of the given locality
+         *
+         * Each task writes to its own output buffer, so different tasks
+         * can be executed concurrently by any thread, in any order.
+         * After all tasks have been executed, finishCpuKernelTasks()
+         * should be called.
+         */
+        void dispatchCpuKernelTask(Nbnxm::InteractionLocality  iLocality,
+                                   const interaction_const_t  &ic,
+                                   int                         forceFlags,
+                                   int                         clearF,
+                                   t_forcerec                 *fr,
+                                   int                         task);
+
+        //! Reduces the energies and counts the flops of all CPU kernel tasks of the given locality
+        void finishCpuKernelTasks(Nbnxm::InteractionLocality  iLocality,
+                                  const interaction_const_t  &ic,
+                                  int                         forceFlags,
+                                  t_forcerec                 *fr,
+                                  gmx_enerdata_t             *enerd,
+                                  t_nrnb                     *nrnb);
+
         //! Executes the non-bonded free-energy kernel, always runs on the CPU
         void dispatchFreeEnergyKernel(Nbnxm::InteractionLocality  iLocality,
                                       t_forcerec                 *fr,
@@ -490,6 +517,22 @@ init_nb_verlet(const gmx::MDLogger     &mdlog,
                const gmx_mtop_t        *mtop,
                matrix                   box);
 
+/*! \brief Creates an Nbnxm object with the given CPU kernel setup
+ *
+ * Used to switch between CPU kernel setups during a run, e.g. for tuning.
+ * Also GPU emulation can be set up, which is useful for testing.
+ * Nothing is printed to \p mdlog about the kernel choice.
+ */
+std::unique_ptr<nonbonded_verlet_t>
+init_nb_verlet(const gmx::MDLogger &mdlog,
+               const KernelSetup   &kernelSetup,
+               gmx_bool             bFEP_NonBonded,
+               const t_inputrec    *ir,
+               const t_forcerec    *fr,
+               const t_commrec     *cr,
+               const gmx_mtop_t    *mtop,
+               matrix               box);
+
 } // namespace Nbnxm
 
 /*! \brief Put the atoms on the pair search grid.
@@ -239,6 +239,11 @@ pick_nbnxn_kernel(const gmx::MDLogger     &mdlog,
 
     if (nonbondedResource == NonbondedResource::EmulateGpu)
     {
+        if (ir->vdwtype == evdwUSER)
+        {
+            gmx_fatal(FARGS, "User tabulated VdW interactions are not supported with GPU emulation");
+        }
+
         kernelSetup.kernelType         = KernelType::Cpu8x8x8_PlainC;
         kernelSetup.ewaldExclusionType = EwaldExclusionType::DecidedByGpuModule;
 
@@ -346,40 +351,22 @@ static int getMinimumIlistCountForGpuBalancing(gmx_nbnxn_gpu_t *nbnxmGpu)
     return minimumIlistCount;
 }
 
-std::unique_ptr<nonbonded_verlet_t>
-init_nb_verlet(const gmx::MDLogger     &mdlog,
-               gmx_bool                 bFEP_NonBonded,
-               const t_inputrec        *ir,
-               const t_forcerec        *fr,
-               const t_commrec         *cr,
-               const gmx_hw_info_t     &hardwareInfo,
-               const gmx_device_info_t *deviceInfo,
-               const gmx_mtop_t        *mtop,
-               matrix                   box)
+/*! \brief Creates an Nbnxm object for the given kernel setup */
+static std::unique_ptr<nonbonded_verlet_t>
+makeNbnxm(const gmx::MDLogger     &mdlog,
+          const KernelSetup       &kernelSetup,
+          gmx_bool                 bFEP_NonBonded,
+          const t_inputrec        *ir,
+          const t_forcerec        *fr,
+          const t_commrec         *cr,
+          const gmx_device_info_t *deviceInfo,
+          const gmx_mtop_t        *mtop,
+          matrix                   box)
 {
-    const bool          emulateGpu = (getenv("GMX_EMULATE_GPU") != nullptr);
-    const bool          useGpu     = deviceInfo != nullptr;
-
-    GMX_RELEASE_ASSERT(!(emulateGpu && useGpu), "When GPU emulation is active, there cannot be a GPU assignment");
-
-    NonbondedResource nonbondedResource;
-    if (useGpu)
-    {
-        nonbondedResource = NonbondedResource::Gpu;
-    }
-    else if (emulateGpu)
-    {
-        nonbondedResource = NonbondedResource::EmulateGpu;
-    }
-    else
-    {
-        nonbondedResource = NonbondedResource::Cpu;
-    }
+    const bool          emulateGpu = (kernelSetup.kernelType == KernelType::Cpu8x8x8_PlainC);
+    const bool          useGpu     = (kernelSetup.kernelType == KernelType::Gpu8x8x8);
 
-    Nbnxm::KernelSetup kernelSetup =
-        pick_nbnxn_kernel(mdlog, fr->use_simd_kernels, hardwareInfo,
-                          nonbondedResource, ir,
-                          fr->bNonbonded);
+    GMX_RELEASE_ASSERT(!useGpu || deviceInfo != nullptr, "With GPU kernels we need a GPU assignment");
 
     const bool          haveMultipleDomains = (DOMAINDECOMP(cr) && cr->dd->nnodes > 1);
 
@@ -387,6 +374,11 @@ init_nb_verlet(const gmx::MDLogger     &mdlog,
                                    bFEP_NonBonded,
                                    ir->rlist,
                                    havePPDomainDecomposition(cr));
+    if (bFEP_NonBonded)
+    {
+        listParams.useSoftCoreCoulomb = (fr->sc_alphacoul != 0);
+        listParams.useSoftCoreVdw     = (fr->sc_alphavdw != 0);
+    }
 
     setupDynamicPairlistPruning(mdlog, ir, mtop, box, fr->ic,
                                 &listParams);
@@ -474,6 +466,64 @@ init_nb_verlet(const gmx::MDLogger     &mdlog,
                                                 gpu_nbv);
 }
 
+std::unique_ptr<nonbonded_verlet_t>
+init_nb_verlet(const gmx::MDLogger     &mdlog,
+               gmx_bool                 bFEP_NonBonded,
+               const t_inputrec        *ir,
+               const t_forcerec        *fr,
+               const t_commrec         *cr,
+               const gmx_hw_info_t     &hardwareInfo,
+               const gmx_device_info_t *deviceInfo,
+               const gmx_mtop_t        *mtop,
+               matrix                   box)
+{
+    const bool          emulateGpu = (getenv("GMX_EMULATE_GPU") != nullptr);
+    const bool          useGpu     = deviceInfo != nullptr;
+
+    GMX_RELEASE_ASSERT(!(emulateGpu && useGpu), "When GPU emulation is active, there cannot be a GPU assignment");
+
+    NonbondedResource nonbondedResource;
+    if (useGpu)
+    {
+        nonbondedResource = NonbondedResource::Gpu;
+    }
+    else if (emulateGpu)
+    {
+        nonbondedResource = NonbondedResource::EmulateGpu;
+    }
+    else
+    {
+        nonbondedResource = NonbondedResource::Cpu;
+    }
+
+    Nbnxm::KernelSetup kernelSetup =
+        pick_nbnxn_kernel(mdlog, fr->use_simd_kernels, hardwareInfo,
+                          nonbondedResource, ir,
+                          fr->bNonbonded);
+
+    return makeNbnxm(mdlog, kernelSetup, bFEP_NonBonded, ir, fr, cr,
+                     deviceInfo, mtop, box);
+}
+
+std::unique_ptr<nonbonded_verlet_t>
+init_nb_verlet(const gmx::MDLogger &mdlog,
+               const KernelSetup   &kernelSetup,
+               gmx_bool             bFEP_NonBonded,
+               const t_inputrec    *ir,
+               const t_forcerec    *fr,
+               const t_commrec     *cr,
+               const gmx_mtop_t    *mtop,
+               matrix               box)
+{
+    GMX_RELEASE_ASSERT(kernelSetup.kernelType == KernelType::Cpu4x4_PlainC ||
+                       kernelSetup.kernelType == KernelType::Cpu8x8x8_PlainC ||
+                       kernelTypeIsSimd(kernelSetup.kernelType),
+                       "Only CPU kernels and GPU emulation can be set up without GPU information");
+
+    return makeNbnxm(mdlog, kernelSetup, bFEP_NonBonded, ir, fr, cr,
+                     nullptr, mtop, box);
+}
+
 } // namespace Nbnxm
 
 nonbonded_verlet_t::nonbonded_verlet_t(std::unique_ptr<PairlistSets>      pairlistSets,
@@ -658,6 +658,15 @@ NbnxnPairlistCpu::NbnxnPairlistCpu() :
 {
 }
 
+NbnxnPairlistFep::NbnxnPairlistFep() :
+    na_ci(c_nbnxnCpuIClusterSize),
+    na_cj(0),
+    useSoftCoreCoulomb(false),
+    useSoftCoreVdw(false),
+    numPairs(0)
+{
+}
+
 NbnxnPairlistGpu::NbnxnPairlistGpu(gmx::PinningPolicy pinningPolicy) :
     na_ci(c_nbnxnGpuClusterSize),
     na_cj(c_nbnxnGpuClusterSize),
@@ -743,6 +752,16 @@ PairlistSet::PairlistSet(const Nbnxm::InteractionLocality  locality,
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
+
+        if (isCpuType_)
+        {
+            fepClusterLists_.resize(numLists);
+            for (NbnxnPairlistFep &fepClusterList : fepClusterLists_)
+            {
+                fepClusterList.useSoftCoreCoulomb = params_.useSoftCoreCoulomb;
+                fepClusterList.useSoftCoreVdw     = params_.useSoftCoreVdw;
+            }
+        }
     }
 }
 
@@ -1464,10 +1483,72 @@ static inline void fep_list_new_nri_copy(t_nblist *nlist)
  */
 const int max_nrj_fep = 40;
 
+/* Returns whether the interaction of a non-excluded perturbed atom pair
+ * is linear in lambda. This is the case when no soft-core is applied,
+ * i.e. when both states have non-zero C12 or when there is no soft-core
+ * for the interaction types present. ai and aj are nbnxm atom indices.
+ */
+static inline bool fepPairIsLinear(const nbnxn_atomdata_t::Params &params,
+                                   const NbnxnPairlistFep         &nblFep,
+                                   int                             ai,
+                                   int                             aj)
+{
+    const int  numTypes = params.numTypes;
+    const real c6A      = params.nbfp[(params.typeA[ai]*numTypes + params.typeA[aj])*2    ];
+    const real c12A     = params.nbfp[(params.typeA[ai]*numTypes + params.typeA[aj])*2 + 1];
+    const real c6B      = params.nbfp[(params.typeB[ai]*numTypes + params.typeB[aj])*2    ];
+    const real c12B     = params.nbfp[(params.typeB[ai]*numTypes + params.typeB[aj])*2 + 1];
+
+    /* The free-energy kernel only uses soft-core with a zero C12 end state */
+    if (c12A > 0 && c12B > 0)
+    {
+        return true;
+    }
+
+    const bool haveCoulomb = (params.qA[ai]*params.qA[aj] != 0 ||
+                              params.qB[ai]*params.qB[aj] != 0);
+    const bool haveVdw     = (c6A != 0 || c12A != 0 || c6B != 0 || c12B != 0);
+
+    return ((!nblFep.useSoftCoreCoulomb || !haveCoulomb) &&
+            (!nblFep.useSoftCoreVdw     || !haveVdw));
+}
+
+/* Adds the cluster-pair entries for the perturbed pairs of the i-entry
+ * which have been set in nblFep->cj from index cjFepStart, removes
+ * entries without pairs.
+ */
+static void closeFepClusterEntry(NbnxnPairlistFep *nblFep,
+                                 const int         ci,
+                                 const int         shift,
+                                 const int         cjFepStart)
+{
+    int cjFepEnd = cjFepStart;
+    for (int cjFep = cjFepStart; cjFep < gmx::ssize(nblFep->cj); cjFep++)
+    {
+        if ((nblFep->cj[cjFep].interaction | nblFep->cj[cjFep].exclusion) != 0)
+        {
+            nblFep->cj[cjFepEnd++] = nblFep->cj[cjFep];
+        }
+    }
+    nblFep->cj.resize(cjFepEnd);
+
+    if (cjFepEnd > cjFepStart)
+    {
+        nbnxn_ci_t ciEntry;
+        ciEntry.ci           = ci;
+        ciEntry.shift        = shift;
+        ciEntry.cj_ind_start = cjFepStart;
+        ciEntry.cj_ind_end   = cjFepEnd;
+        nblFep->ci.push_back(ciEntry);
+    }
+}
+
 /* Exclude the perturbed pairs from the Verlet list. This is only done to avoid
  * singularities for overlapping particles (0/0), since the charges and
  * LJ parameters have been zeroed in the nbnxn data structure.
- * Simultaneously make a group pair list for the perturbed pairs.
+ * Simultaneously make pair lists for the perturbed pairs. When nblFep
+ * is not nullptr, pairs that are linear in lambda are put in the
+ * cluster-pair list nblFep, all other pairs in the group pair list nlist.
  */
 static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
                           const nbnxn_atomdata_t   *nbat,
@@ -1480,7 +1561,8 @@ static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
                           real gmx_unused           rlist_fep2,
                           const Grid               &iGrid,
                           const Grid               &jGrid,
-                          t_nblist                 *nlist)
+                          t_nblist                 *nlist,
+                          NbnxnPairlistFep         *nblFep)
 {
     int      ci, cj_ind_start, cj_ind_end, cja, cjr;
     int      nri_max;
@@ -1531,6 +1613,19 @@ static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
     egp_shift = nbatParams.neg_2log;
     egp_mask  = (1 << egp_shift) - 1;
 
+    /* Reserve a cluster-pair entry for every j-cluster, empty entries
+     * are removed after the loop over the atom pairs.
+     */
+    const int cjFepStart = (nblFep ? nblFep->cj.size() : 0);
+    if (nblFep)
+    {
+        nblFep->na_cj = nbl->na_cj;
+        for (int cj_ind = cj_ind_start; cj_ind < cj_ind_end; cj_ind++)
+        {
+            nblFep->cj.push_back({ nbl->cj[cj_ind].cj, 0U, 0U });
+        }
+    }
+
     /* Loop over the atoms in the i sub-cell */
     bFEP_i_all = TRUE;
     for (int i = 0; i < nbl->na_ci; i++)
@@ -1609,6 +1704,34 @@ static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
                             (bFEP_i || (fep_cj & (1 << j))) &&
                             (!bDiagRemoved || ind_j >= ind_i))
                         {
+                            const unsigned int pairBit      = 1U << (i*nbl->na_cj + j);
+                            const bool         pairInteracts = ((nbl->cj[cj_ind].excl & pairBit) != 0);
+
+                            /* Exclude it from the normal list.
+                             * Note that the charge has been set to zero,
+                             * but we need to avoid 0/0, as perturbed atoms
+                             * can be on top of each other.
+                             */
+                            nbl->cj[cj_ind].excl &= ~pairBit;
+
+                            if (nblFep != nullptr &&
+                                (!pairInteracts || fepPairIsLinear(nbatParams, *nblFep, ind_i, ind_j)))
+                            {
+                                /* Add it to the cluster-pair list */
+                                nbnxn_fep_cj_t &cjFep = nblFep->cj[cjFepStart + cj_ind - cj_ind_start];
+                                if (pairInteracts)
+                                {
+                                    cjFep.interaction |= pairBit;
+                                }
+                                else
+                                {
+                                    cjFep.exclusion   |= pairBit;
+                                }
+                                nblFep->numPairs++;
+
+                                continue;
+                            }
+
                             if (ngid > 1)
                             {
                                 gid_j = (gid_cj >> (j*egp_shift)) & egp_mask;
@@ -1632,15 +1755,8 @@ static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
 
                             /* Add it to the FEP list */
                             nlist->jjnr[nlist->nrj]     = aj;
-                            nlist->excl_fep[nlist->nrj] = (nbl->cj[cj_ind].excl >> (i*nbl->na_cj + j)) & 1;
+                            nlist->excl_fep[nlist->nrj] = pairInteracts;
                             nlist->nrj++;
-
-                            /* Exclude it from the normal list.
-                             * Note that the charge has been set to zero,
-                             * but we need to avoid 0/0, as perturbed atoms
-                             * can be on top of each other.
-                             */
-                            nbl->cj[cj_ind].excl &= ~(1U << (i*nbl->na_cj + j));
                         }
                     }
                 }
@@ -1655,6 +1771,11 @@ static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
         }
     }
 
+    if (nblFep)
+    {
+        closeFepClusterEntry(nblFep, ci, nbl_ci->shift & NBNXN_CI_SHIFT, cjFepStart);
+    }
+
     if (bFEP_i_all)
     {
         /* All interactions are perturbed, we can skip this entry */
@@ -1693,8 +1814,11 @@ static void make_fep_list(gmx::ArrayRef<const int>  atomIndices,
                           real                      rlist_fep2,
                           const Grid               &iGrid,
                           const Grid               &jGrid,
-                          t_nblist                 *nlist)
+                          t_nblist                 *nlist,
+                          NbnxnPairlistFep gmx_unused *nblFep)
 {
+    GMX_ASSERT(nblFep == nullptr, "Cluster-pair free-energy lists are only supported with CPU lists");
+
     int                nri_max;
     int                c_abs;
     int                ind_i, ind_j, ai, aj;
@@ -2224,6 +2348,13 @@ static void clear_pairlist(NbnxnPairlistGpu *nbl)
 }
 
 /* Clears a group scheme pair list */
+static void clear_pairlist(NbnxnPairlistFep *nbl)
+{
+    nbl->ci.clear();
+    nbl->cj.clear();
+    nbl->numPairs = 0;
+}
+
 static void clear_pairlist_fep(t_nblist *nl)
 {
     nl->nri = 0;
@@ -3142,7 +3273,8 @@ static void nbnxn_make_pairlist_part(const PairSearch &pairSearch,
                                      float nsubpair_tot_est,
                                      int th, int nth,
                                      T *nbl,
-                                     t_nblist *nbl_fep)
+                                     t_nblist *nbl_fep,
+                                     NbnxnPairlistFep *nbl_fep_cluster)
 {
     int               na_cj_2log;
     matrix            box;
@@ -3611,7 +3743,7 @@ static void nbnxn_make_pairlist_part(const PairSearch &pairSearch,
                                       getOpenIEntry(nbl),
                                       shx, shy, shz,
                                       rl_fep2,
-                                      iGrid, jGrid, nbl_fep);
+                                      iGrid, jGrid, nbl_fep, nbl_fep_cluster);
                     }
 
                     /* Close this ci list */
@@ -3642,6 +3774,10 @@ static void nbnxn_make_pairlist_part(const PairSearch &pairSearch,
         if (haveFep)
         {
             fprintf(debug, "nbl FEP list pairs: %d\n", nbl_fep->nrj);
+            if (nbl_fep_cluster)
+            {
+                fprintf(debug, "nbl FEP cluster list pairs: %d\n", nbl_fep_cluster->numPairs);
+            }
         }
     }
 }
@@ -3995,6 +4131,10 @@ PairlistSet::constructPairlists(PairSearch                *pairSearch,
         {
             clear_pairlist_fep(fepLists_[th]);
         }
+        if (!fepClusterLists_.empty())
+        {
+            clear_pairlist(&fepClusterLists_[th]);
+        }
     }
 
     const gmx_domdec_zones_t *ddZones = pairSearch->domainSetup().zones;
@@ -4061,7 +4201,8 @@ PairlistSet::constructPairlists(PairSearch                *pairSearch,
 
                     searchWork->cycleCounter.start();
 
-                    t_nblist *fepListPtr = (fepLists_.empty() ? nullptr : fepLists_[th]);
+                    t_nblist         *fepListPtr        = (fepLists_.empty() ? nullptr : fepLists_[th]);
+                    NbnxnPairlistFep *fepClusterListPtr = (fepClusterLists_.empty() ? nullptr : &fepClusterLists_[th]);
 
                     /* Divide the i cells equally over the pairlists */
                     if (isCpuType_)
@@ -4076,7 +4217,8 @@ PairlistSet::constructPairlists(PairSearch                *pairSearch,
                                                  progBal, nsubpair_tot_est,
                                                  th, numLists,
                                                  &cpuLists_[th],
-                                                 fepListPtr);
+                                                 fepListPtr,
+                                                 fepClusterListPtr);
                     }
                     else
                     {
@@ -4090,7 +4232,8 @@ PairlistSet::constructPairlists(PairSearch                *pairSearch,
                                                  progBal, nsubpair_tot_est,
                                                  th, numLists,
                                                  &gpuLists_[th],
-                                                 fepListPtr);
+                                                 fepListPtr,
+                                                 nullptr);
                     }
 
                     searchWork->cycleCounter.stop();
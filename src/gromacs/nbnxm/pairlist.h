@@ -240,6 +240,38 @@ struct NbnxnPairlistCpu
     gmx_cache_protect_t                   cp1;
 };
 
+/* The j-entry of a cluster-pair list for perturbed interactions.
+ * The bits in both masks are indexed i-major, j-minor, as in nbnxn_cj_t.
+ * Excluded pairs only contribute exclusion corrections for reaction-field
+ * and Ewald interactions, which is why these need to be listed as well.
+ */
+struct nbnxn_fep_cj_t
+{
+    int          cj;          /* The j-cluster                                */
+    unsigned int interaction; /* Bits set for interacting perturbed pairs     */
+    unsigned int exclusion;   /* Bits set for excluded perturbed pairs        */
+};
+
+/* Cluster pairlist type for perturbed atom pairs for use on CPUs
+ *
+ * Only pairs without soft-core are put in this list, their interactions
+ * are linear in lambda and can be computed with parameters interpolated
+ * between the A and B states. All other perturbed pairs are put in
+ * the atom-pair lists for the free-energy kernel.
+ */
+struct NbnxnPairlistFep
+{
+    NbnxnPairlistFep();
+
+    int                         na_ci;              /* The number of atoms per i-cluster     */
+    int                         na_cj;              /* The number of atoms per j-cluster     */
+    bool                        useSoftCoreCoulomb; /* Is soft-core used for Coulomb         */
+    bool                        useSoftCoreVdw;     /* Is soft-core used for Van der Waals   */
+    FastVector<nbnxn_ci_t>      ci;                 /* The i-cluster list                    */
+    FastVector<nbnxn_fep_cj_t>  cj;                 /* The j-cluster list                    */
+    int                         numPairs;           /* The number of atom pairs in the list  */
+};
+
 /* Cluster pairlist type, with extra hierarchies, for on the GPU
  *
  * NOTE: for better performance when combining lists over threads,
@@ -331,6 +363,12 @@ class PairlistSet
             return fepLists_;
         }
 
+        //! Returns the lists of free-energy cluster pairlists, empty when not perturbed or not using CPU lists
+        gmx::ArrayRef<const NbnxnPairlistFep> fepClusterLists() const
+        {
+            return fepClusterLists_;
+        }
+
     private:
         //! The locality of the pairlist set
         Nbnxm::InteractionLocality     locality_;
@@ -348,6 +386,8 @@ class PairlistSet
         gmx_bool                       isCpuType_;
         //! Lists for perturbed interactions in simple atom-atom layout
         std::vector<t_nblist *>        fepLists_;
+        //! Lists for perturbed interactions without soft-core in CPU cluster layout
+        std::vector<NbnxnPairlistFep>  fepClusterLists_;
 
     public:
         /* Pair counts for flop counting */
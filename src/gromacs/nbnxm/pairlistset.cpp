@@ -59,6 +59,8 @@ NbnxnListParameters::NbnxnListParameters(const Nbnxm::KernelType kernelType,
                                          const real              rlist,
                                          const bool              haveMultipleDomains) :
     haveFep(haveFep),
+    useSoftCoreCoulomb(false),
+    useSoftCoreVdw(false),
     rlistOuter(rlist),
     rlistInner(rlist),
     haveMultipleDomains(haveMultipleDomains),
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the run-time selection of the CPU non-bonded kernel setup.
+ *
+ * \ingroup __module_nb_verlet
+ */
+#include "gmxpre.h"
+
+#include "gromacs/nbnxm/kernel_tuning.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/nbnxm_simd.h"
+#include "gromacs/utility/logger.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/testfilemanager.h"
+
+#include "testsystem.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Test fixture with an Nbnxm object using a SIMD kernel and tabulated
+ * Ewald exclusions and a cache file selecting analytical Ewald exclusions
+ */
+class KernelSetupTunerTest : public ::testing::Test
+{
+    public:
+        KernelSetupTunerTest() :
+            system_(ewaldOptions())
+        {
+#if GMX_SIMD
+            Nbnxm::KernelSetup setup;
+#ifdef GMX_NBNXN_SIMD_4XN
+            setup.kernelType         = Nbnxm::KernelType::Cpu4xN_Simd_4xN;
+#else
+            setup.kernelType         = Nbnxm::KernelType::Cpu4xN_Simd_2xNN;
+#endif
+            setup.ewaldExclusionType = Nbnxm::EwaldExclusionType::Table;
+            system_.setupNbnxm(setup, 1);
+
+            cacheFile_ = fileManager_.getTemporaryFilePath("kernelcache.txt");
+            const std::string key = Nbnxm::kernelSetupCacheKey(system_.ir, system_.cr,
+                                                               system_.mtop, system_.box);
+            TextWriter::writeFileFromString(cacheFile_,
+                                            key + (setup.kernelType == Nbnxm::KernelType::Cpu4xN_Simd_4xN ?
+                                                   " 4xN" : " 2xNN") +
+                                            " analytical\n");
+#endif
+        }
+
+        //! Returns the options for a system with Ewald electrostatics
+        static TestSystemOptions ewaldOptions()
+        {
+            TestSystemOptions options;
+            options.coulombType = eelPME;
+
+            return options;
+        }
+
+        //! Calls makeKernelSetupTuner() with the cache file
+        std::unique_ptr<Nbnxm::KernelSetupTuner> makeTuner(bool reproducible,
+                                                           bool useTimings)
+        {
+            return Nbnxm::makeKernelSetupTuner(mdlog_, system_.ir, system_.cr,
+                                               system_.mtop, system_.fr, system_.box,
+                                               reproducible, useTimings, cacheFile_);
+        }
+
+        //! Logger, the tuner keeps a reference
+        MDLogger        mdlog_;
+        //! Manager for the cache file
+        TestFileManager fileManager_;
+        //! The test system
+        TestSystem      system_;
+        //! The name of the cache file
+        std::string     cacheFile_;
+};
+
+#if GMX_SIMD
+
+TEST_F(KernelSetupTunerTest, AppliesCachedSetupWithoutTimings)
+{
+    std::unique_ptr<Nbnxm::KernelSetupTuner> tuner = makeTuner(false, false);
+
+    ASSERT_NE(tuner, nullptr);
+    EXPECT_TRUE(tuner->isActive());
+}
+
+TEST_F(KernelSetupTunerTest, ReproducibleRunDoesNotReadCache)
+{
+    EXPECT_EQ(makeTuner(true, true), nullptr);
+    EXPECT_EQ(makeTuner(true, false), nullptr);
+}
+
+#endif
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
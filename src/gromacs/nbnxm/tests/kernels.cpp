@@ -0,0 +1,360 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the nbnxm CPU non-bonded kernels.
+ *
+ * \ingroup __module_nb_verlet
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/nbnxm_simd.h"
+#include "gromacs/nbnxm/pairlist.h"
+#include "gromacs/nbnxm/pairlistset.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+#include "testsystem.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The largest number of energy groups for which all group pairs have interactions in the test system
+constexpr int c_maxNumEnergyGroupsWithAllPairsInteracting = 3;
+
+//! Returns all SIMD kernel setups supported by this build
+std::vector<Nbnxm::KernelSetup> simdKernelSetups()
+{
+    std::vector<Nbnxm::KernelType> kernelTypes;
+#ifdef GMX_NBNXN_SIMD_4XN
+    kernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_4xN);
+#endif
+#ifdef GMX_NBNXN_SIMD_2XNN
+    kernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_2xNN);
+#endif
+
+    std::vector<Nbnxm::KernelSetup> setups;
+    for (Nbnxm::KernelType kernelType : kernelTypes)
+    {
+        for (Nbnxm::EwaldExclusionType ewaldType : { Nbnxm::EwaldExclusionType::Table,
+                                                     Nbnxm::EwaldExclusionType::Analytical })
+        {
+            Nbnxm::KernelSetup setup;
+            setup.kernelType         = kernelType;
+            setup.ewaldExclusionType = ewaldType;
+            setups.push_back(setup);
+        }
+    }
+
+    return setups;
+}
+
+//! Returns the plain-C reference kernel setup
+Nbnxm::KernelSetup plainCKernelSetup()
+{
+    Nbnxm::KernelSetup setup;
+    setup.kernelType         = Nbnxm::KernelType::Cpu4x4_PlainC;
+    setup.ewaldExclusionType = Nbnxm::EwaldExclusionType::Table;
+
+    return setup;
+}
+
+//! Returns a description of \p setup for tracing test failures
+std::string describeKernelSetup(const Nbnxm::KernelSetup &setup)
+{
+    return gmx::formatString("%s kernel with %s Ewald exclusions",
+                             Nbnxm::lookup_kernel_name(setup.kernelType),
+                             setup.ewaldExclusionType == Nbnxm::EwaldExclusionType::Table ? "tabulated" : "analytical");
+}
+
+//! Returns the maximum absolute value of the elements of \p values
+real maxAbsValue(const std::vector<real> &values)
+{
+    real maxAbs = 0;
+    for (real value : values)
+    {
+        maxAbs = std::max(maxAbs, std::abs(value));
+    }
+
+    return maxAbs;
+}
+
+//! Checks that \p output matches \p reference, relative to the largest force and energy
+void compareOutput(const NbnxmOutput &reference,
+                   const NbnxmOutput &output)
+{
+    ASSERT_EQ(reference.f.size(), output.f.size());
+    ASSERT_EQ(reference.vCoulomb.size(), output.vCoulomb.size());
+
+    real maxAbsForce = 0;
+    for (const RVec &f : reference.f)
+    {
+        maxAbsForce = std::max(maxAbsForce, norm(f));
+    }
+    const FloatingPointTolerance forceTolerance =
+        relativeToleranceAsFloatingPoint(maxAbsForce, 1e-4);
+    for (size_t a = 0; a < reference.f.size(); a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], forceTolerance)
+            << "for atom " << a << " dimension " << d;
+        }
+    }
+
+    const FloatingPointTolerance coulombTolerance =
+        relativeToleranceAsFloatingPoint(maxAbsValue(reference.vCoulomb), 1e-5);
+    const FloatingPointTolerance vdwTolerance =
+        relativeToleranceAsFloatingPoint(maxAbsValue(reference.vVdw), 1e-5);
+    for (size_t i = 0; i < reference.vCoulomb.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.vCoulomb[i], output.vCoulomb[i], coulombTolerance)
+        << "for energy group pair " << i;
+        EXPECT_REAL_EQ_TOL(reference.vVdw[i], output.vVdw[i], vdwTolerance)
+        << "for energy group pair " << i;
+    }
+
+    EXPECT_REAL_EQ_TOL(reference.dvdlCoulomb, output.dvdlCoulomb,
+                       relativeToleranceAsFloatingPoint(reference.dvdlCoulomb, 1e-4));
+    EXPECT_REAL_EQ_TOL(reference.dvdlVdw, output.dvdlVdw,
+                       relativeToleranceAsFloatingPoint(reference.dvdlVdw, 1e-4));
+}
+
+//! Returns the number of perturbed pairs in the cluster-pair free-energy lists of \p fr
+int numFepClusterPairs(const t_forcerec &fr)
+{
+    const PairlistSet &pairlistSet = fr.nbv->pairlistSets().pairlistSet(Nbnxm::InteractionLocality::Local);
+
+    int                numPairs    = 0;
+    for (const NbnxnPairlistFep &fepClusterList : pairlistSet.fepClusterLists())
+    {
+        numPairs += fepClusterList.numPairs;
+    }
+
+    return numPairs;
+}
+
+//! The Coulomb type, the number of energy groups and whether the groups are uniform within the clusters
+typedef std::tuple<int, int, bool> KernelTestParams;
+
+//! Test fixture for comparing the nbnxm kernels
+class NbnxmKernelTest : public ::testing::TestWithParam<KernelTestParams>
+{
+    public:
+        //! Returns the test system options for the test parameters
+        TestSystemOptions options() const
+        {
+            TestSystemOptions options;
+            std::tie(options.coulombType,
+                     options.numEnergyGroups,
+                     options.clusterUniformEnergyGroups) = GetParam();
+
+            return options;
+        }
+};
+
+TEST_P(NbnxmKernelTest, SimdKernelsMatchPlainCKernel)
+{
+    TestSystem system(options());
+
+    const NbnxmOutput reference = system.computeForces(plainCKernelSetup(), 1);
+    /* Check that all group pairs have interactions, with many groups
+     * only few atoms are in each group and many pairs do not interact.
+     */
+    if (options().numEnergyGroups <= c_maxNumEnergyGroupsWithAllPairsInteracting)
+    {
+        for (real v : reference.vVdw)
+        {
+            EXPECT_NE(v, 0);
+        }
+    }
+
+    for (const Nbnxm::KernelSetup &setup : simdKernelSetups())
+    {
+        SCOPED_TRACE(describeKernelSetup(setup));
+        compareOutput(reference, system.computeForces(setup, 1));
+    }
+}
+
+TEST_P(NbnxmKernelTest, MultithreadedForceReductionMatchesSingleThread)
+{
+    TestSystem system(options());
+
+    const NbnxmOutput reference = system.computeForces(plainCKernelSetup(), 1);
+
+    /* With multiple threads, each thread has its own force buffer, which
+     * are reduced and converted to the rvec layout, for SIMD kernels
+     * from the packed nbat force layouts.
+     */
+    std::vector<Nbnxm::KernelSetup> setups = simdKernelSetups();
+    setups.push_back(plainCKernelSetup());
+    for (const Nbnxm::KernelSetup &setup : setups)
+    {
+        SCOPED_TRACE(describeKernelSetup(setup));
+        compareOutput(reference, system.computeForces(setup, 4));
+    }
+}
+
+TEST_P(NbnxmKernelTest, KernelTasksInReverseOrderMatchDispatch)
+{
+    TestSystem system(options());
+
+    /* Each pairlist task has its own output buffer, so the order
+     * in which the tasks are computed should not matter.
+     */
+    std::vector<Nbnxm::KernelSetup> setups = simdKernelSetups();
+    setups.push_back(plainCKernelSetup());
+    for (const Nbnxm::KernelSetup &setup : setups)
+    {
+        SCOPED_TRACE(describeKernelSetup(setup));
+        const NbnxmOutput reference = system.computeForces(setup, 4);
+        const NbnxmOutput output    = system.computeForces(setup, 4, true);
+        EXPECT_EQ(4, system.fr.nbv->numCpuKernelTasks(Nbnxm::InteractionLocality::Local));
+        compareOutput(reference, output);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(EnergyGroups, NbnxmKernelTest,
+                            ::testing::Combine(::testing::Values(eelRF, eelPME),
+                                                   ::testing::Values(1, 3),
+                                                   ::testing::Values(false)));
+
+/* With the groups uniform within the j-clusters, the SIMD kernels
+ * add the energies of a whole j-cluster to a single group pair.
+ */
+INSTANTIATE_TEST_CASE_P(ClusterUniformEnergyGroups, NbnxmKernelTest,
+                            ::testing::Combine(::testing::Values(eelRF, eelPME),
+                                                   ::testing::Values(3),
+                                                   ::testing::Values(true)));
+
+/* The energy groups of a cluster are packed into a single int, test
+ * beyond 64 groups, with a count that is not a power of 2 and at the limit of 128.
+ */
+INSTANTIATE_TEST_CASE_P(ManyEnergyGroups, NbnxmKernelTest,
+                            ::testing::Combine(::testing::Values(eelPME),
+                                                   ::testing::Values(100, 128),
+                                                   ::testing::Values(false)));
+
+//! The Coulomb type and the number of energy groups
+typedef std::tuple<int, int> UserVdwTableKernelTestParams;
+
+//! Test fixture for the kernels with user VdW tables
+class NbnxmUserVdwTableKernelTest : public ::testing::TestWithParam<UserVdwTableKernelTestParams>
+{
+};
+
+TEST_P(NbnxmUserVdwTableKernelTest, SimdKernelsMatchPlainCKernel)
+{
+    TestSystemOptions options;
+    std::tie(options.coulombType, options.numEnergyGroups) = GetParam();
+    options.vdwType = evdwUSER;
+    TestSystem        system(options);
+
+    const NbnxmOutput reference = system.computeForces(plainCKernelSetup(), 1);
+    for (real v : reference.vVdw)
+    {
+        EXPECT_NE(v, 0);
+    }
+
+    for (const Nbnxm::KernelSetup &setup : simdKernelSetups())
+    {
+        SCOPED_TRACE(describeKernelSetup(setup));
+        compareOutput(reference, system.computeForces(setup, 1));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(UserVdwTable, NbnxmUserVdwTableKernelTest,
+                            ::testing::Combine(::testing::Values(eelRF, eelPME),
+                                                   ::testing::Values(1, 3)));
+
+//! Test fixture for the free-energy kernels, the parameter is the Coulomb type
+class NbnxmFreeEnergyKernelTest : public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P(NbnxmFreeEnergyKernelTest, ClusterPairKernelMatchesListKernel)
+{
+    TestSystemOptions options;
+    options.coulombType        = GetParam();
+    options.havePerturbedAtoms = true;
+    TestSystem        system(options);
+
+    /* With GPU emulation, all perturbed pairs are put in the t_nblist lists
+     * for gmx_nb_free_energy_kernel(). The CPU kernel setups put the pairs
+     * without soft-core in cluster-pair lists instead.
+     */
+    Nbnxm::KernelSetup referenceSetup;
+    referenceSetup.kernelType         = Nbnxm::KernelType::Cpu8x8x8_PlainC;
+    referenceSetup.ewaldExclusionType = Nbnxm::EwaldExclusionType::Analytical;
+    const NbnxmOutput  reference      = system.computeForces(referenceSetup, 1);
+    EXPECT_NE(reference.dvdlCoulomb, 0);
+    EXPECT_NE(reference.dvdlVdw, 0);
+
+    std::vector<Nbnxm::KernelSetup> setups = simdKernelSetups();
+    setups.push_back(plainCKernelSetup());
+    for (const Nbnxm::KernelSetup &setup : setups)
+    {
+        for (int numThreads : { 1, 2 })
+        {
+            SCOPED_TRACE(describeKernelSetup(setup) + gmx::formatString(" on %d threads", numThreads));
+            const NbnxmOutput output = system.computeForces(setup, numThreads);
+            EXPECT_GT(numFepClusterPairs(system.fr), 0);
+            compareOutput(reference, output);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(FreeEnergy, NbnxmFreeEnergyKernelTest,
+                            ::testing::Values(eelRF, eelPME));
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
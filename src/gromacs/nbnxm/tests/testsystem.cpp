@@ -0,0 +1,400 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements a small test system for the nbnxm tests.
+ *
+ * \ingroup __module_nb_verlet
+ */
+#include "gmxpre.h"
+
+#include "testsystem.h"
+
+#include <cmath>
+
+#include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/gmxlib/network.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/force.h"
+#include "gromacs/mdlib/force_flags.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/tables/cubicsplinetable.h"
+#include "gromacs/utility/logger.h"
+#include "gromacs/utility/smalloc.h"
+
+namespace gmx
+{
+namespace test
+{
+
+namespace
+{
+
+//! The number of lattice sites along each dimension
+constexpr int  c_numSitesPerDim             = 6;
+//! The lattice spacing
+constexpr real c_spacing                    = 0.4;
+//! The maximum displacement of the atoms from their lattice sites along each dimension
+constexpr real c_jitter                     = 0.05;
+//! The interaction cut-off
+constexpr real c_cutoff                     = 0.9;
+//! The pair-list cut-off, longer than the interaction cut-off so the kernels need to check distances
+constexpr real c_rlist                      = 1.0;
+//! The number of atom types, the last type has no LJ interactions
+constexpr int  c_numTypes                   = 4;
+//! The number of lattice sites along x per slab of atoms with cluster-uniform energy groups
+constexpr int  c_numSitesPerEnergyGroupSlab = 2;
+/*! \brief The atom density for the search grid setup
+ *
+ * This is slightly higher than the actual density, so with both 4 and 8
+ * atoms per cell the grid columns cover two by two lattice sites,
+ * independently of rounding. The energy-group slabs rely on this.
+ */
+constexpr real c_gridAtomDensity            = 1.02/(c_spacing*c_spacing*c_spacing);
+//! The squared distance added to r^2 in the user VdW functions, so they are finite at r=0
+constexpr double c_userVdwSoftening         = 0.01;
+//! The start of the range of the user VdW table, below the shortest non-excluded pair distance
+constexpr real   c_userVdwTableStart        = 0.2;
+
+//! Returns the user dispersion function, scaled by 1/6 as the nbnxm kernels expect
+double userDispersion(double r)
+{
+    return -1/(6*gmx::power3(r*r + c_userVdwSoftening));
+}
+
+//! Returns the derivative of userDispersion()
+double userDispersionDerivative(double r)
+{
+    return r/gmx::power4(r*r + c_userVdwSoftening);
+}
+
+//! Returns the user repulsion function, scaled by 1/12 as the nbnxm kernels expect
+double userRepulsion(double r)
+{
+    return 1/(12*gmx::power6(r*r + c_userVdwSoftening));
+}
+
+//! Returns the derivative of userRepulsion()
+double userRepulsionDerivative(double r)
+{
+    return -r/(gmx::power6(r*r + c_userVdwSoftening)*(r*r + c_userVdwSoftening));
+}
+
+}   // namespace
+
+TestSystem::TestSystem(const TestSystemOptions &options) :
+    cr(init_commrec()),
+    lambda_(efptNR, 0),
+    shiftVec_(SHIFTS, { 0, 0, 0 }),
+    fshift_(SHIFTS, { 0, 0, 0 }),
+    nbfp_(2*c_numTypes*c_numTypes, 0)
+{
+    const int numAtoms = gmx::power3(c_numSitesPerDim);
+
+    clear_mat(box);
+    for (int d = 0; d < DIM; d++)
+    {
+        box[d][d] = c_numSitesPerDim*c_spacing;
+    }
+
+    DefaultRandomEngine           rng(123456);
+    UniformRealDistribution<real> dist(-c_jitter, c_jitter);
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const int site[DIM] = {
+            i % c_numSitesPerDim,
+            (i / c_numSitesPerDim) % c_numSitesPerDim,
+            i / (c_numSitesPerDim*c_numSitesPerDim)
+        };
+        RVec      x;
+        for (int d = 0; d < DIM; d++)
+        {
+            x[d] = (site[d] + 0.5)*c_spacing + dist(rng);
+        }
+        x_.push_back(x);
+    }
+
+    /* Geometric combination of C6 and C12, stored scaled by 6 and 12 */
+    const real c6[c_numTypes]  = { 2.6e-3, 1.7e-3, 3.4e-3, 0 };
+    const real c12[c_numTypes] = { 2.6e-6, 1.1e-6, 4.5e-6, 0 };
+    for (int i = 0; i < c_numTypes; i++)
+    {
+        for (int j = 0; j < c_numTypes; j++)
+        {
+            nbfp_[2*(i*c_numTypes + j)]     = 6*std::sqrt(c6[i]*c6[j]);
+            nbfp_[2*(i*c_numTypes + j) + 1] = 12*std::sqrt(c12[i]*c12[j]);
+        }
+    }
+
+    /* Alternate the sign of the charges, so each excluded pair is neutral */
+    const real chargeMagnitude[c_numTypes - 1] = { 0.5, 0.3, 0.7 };
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const int  type   = i % (c_numTypes - 1);
+        const real charge = (i % 2 == 0 ? 1 : -1)*chargeMagnitude[type];
+        chargeA_.push_back(charge);
+        typeA_.push_back(type);
+        chargeB_.push_back(charge);
+        typeB_.push_back(type);
+
+        /* The slabs of two lattice sites along x match the grid columns,
+         * so the atoms in each cluster all have the same group.
+         */
+        const int energyGroup = (options.clusterUniformEnergyGroups ?
+                                 (i % c_numSitesPerDim)/c_numSitesPerEnergyGroupSlab :
+                                 i) % options.numEnergyGroups;
+        int       atomInfo    = 0;
+        SET_CGINFO_GID(atomInfo, energyGroup);
+        SET_CGINFO_HAS_VDW(atomInfo);
+        SET_CGINFO_HAS_Q(atomInfo);
+        if (options.havePerturbedAtoms && i % 9 == 4)
+        {
+            /* Non-zero C12 in both states, so no soft-core */
+            chargeB_[i] = -charge;
+            typeB_[i]   = (type + 1) % (c_numTypes - 1);
+            SET_CGINFO_FEP(atomInfo);
+        }
+        if (options.havePerturbedAtoms && i % 9 == 7)
+        {
+            /* The atom vanishes, so its pairs use soft-core */
+            chargeB_[i] = 0;
+            typeB_[i]   = c_numTypes - 1;
+            SET_CGINFO_FEP(atomInfo);
+        }
+        atomInfo_.push_back(atomInfo);
+
+        /* Each atom excludes itself and its partner 2i or 2i+1 */
+        exclusionIndex_.push_back(exclusionAtoms_.size());
+        exclusionAtoms_.push_back(i - i % 2);
+        exclusionAtoms_.push_back(i - i % 2 + 1);
+    }
+    exclusionIndex_.push_back(exclusionAtoms_.size());
+    exclusions_.nr     = numAtoms;
+    exclusions_.index  = exclusionIndex_.data();
+    exclusions_.nra    = exclusionAtoms_.size();
+    exclusions_.a      = exclusionAtoms_.data();
+
+    mdatoms_.nr        = numAtoms;
+    mdatoms_.homenr    = numAtoms;
+    mdatoms_.chargeA   = chargeA_.data();
+    mdatoms_.chargeB   = chargeB_.data();
+    mdatoms_.typeA     = typeA_.data();
+    mdatoms_.typeB     = typeB_.data();
+
+    mtop.natoms        = numAtoms;
+
+    ic.cutoff_scheme    = ecutsVERLET;
+    ic.eeltype          = options.coulombType;
+    ic.coulomb_modifier = eintmodPOTSHIFT;
+    ic.rcoulomb         = c_cutoff;
+    ic.epsilon_r        = 1;
+    ic.epsfac           = ONE_4PI_EPS0;
+    if (EEL_PME_EWALD(ic.eeltype))
+    {
+        ic.ewaldcoeff_q = calc_ewaldcoeff_q(c_cutoff, 1e-5);
+        ic.sh_ewald     = std::erfc(ic.ewaldcoeff_q*c_cutoff)/c_cutoff;
+    }
+    else
+    {
+        ic.k_rf         = 0.48;
+        ic.c_rf         = 1/c_cutoff + ic.k_rf*c_cutoff*c_cutoff;
+    }
+    ic.vdwtype                = options.vdwType;
+    ic.rvdw                   = c_cutoff;
+    if (ic.vdwtype == evdwUSER)
+    {
+        /* The user table is applied without modifier, as with mdrun */
+        ic.vdw_modifier = eintmodNONE;
+        vdwUserTable_   = std::make_unique<CubicSplineTable>(
+                    std::initializer_list<AnalyticalSplineTableInput> {
+                        { "Dispersion", userDispersion, userDispersionDerivative },
+                        { "Repulsion", userRepulsion, userRepulsionDerivative }
+                    },
+                    std::pair<real, real>(c_userVdwTableStart, c_rlist));
+        ic.vdwUserTable = vdwUserTable_.get();
+    }
+    else
+    {
+        ic.vdw_modifier          = eintmodPOTSHIFT;
+        ic.dispersion_shift.cpot = -1.0/gmx::power6(c_cutoff);
+        ic.repulsion_shift.cpot  = -1.0/gmx::power12(c_cutoff);
+        ic.sh_invrc6             = -ic.dispersion_shift.cpot;
+    }
+    init_interaction_const_tables(nullptr, &ic, 0);
+
+    ir.cutoff_scheme          = ecutsVERLET;
+    ir.ePBC                   = epbcXYZ;
+    ir.coulombtype            = ic.eeltype;
+    ir.vdwtype                = ic.vdwtype;
+    ir.rcoulomb               = c_cutoff;
+    ir.rvdw                   = c_cutoff;
+    ir.rlist                  = c_rlist;
+    /* No dynamic pruning, the lists are only used at the search step */
+    ir.verletbuf_tol          = -1;
+    ir.opts.ngener            = options.numEnergyGroups;
+    ir.efep                   = (options.havePerturbedAtoms ? efepYES : efepNO);
+    ir.fepvals->sc_alpha      = 0.5;
+
+    calc_shifts(box, as_rvec_array(shiftVec_.data()));
+
+    fr.ic                     = &ic;
+    fr.cutoff_scheme          = ecutsVERLET;
+    fr.use_simd_kernels       = TRUE;
+    fr.bNonbonded             = TRUE;
+    fr.efep                   = ir.efep;
+    fr.ntype                  = c_numTypes;
+    fr.nbfp                   = nbfp_.data();
+    fr.cginfo                 = atomInfo_.data();
+    fr.shift_vec              = as_rvec_array(shiftVec_.data());
+    fr.fshift                 = as_rvec_array(fshift_.data());
+    fr.sc_alphacoul           = ir.fepvals->sc_alpha;
+    fr.sc_alphavdw            = ir.fepvals->sc_alpha;
+    fr.sc_power               = 1;
+    fr.sc_r_power             = 6.0;
+    fr.sc_sigma6_def          = gmx::power6(0.3);
+    fr.sc_sigma6_min          = 0;
+
+    lambda_[efptCOUL]         = 0.4;
+    lambda_[efptVDW]          = 0.7;
+}
+
+TestSystem::~TestSystem()
+{
+    sfree_aligned(ic.tabq_coul_FDV0);
+    sfree_aligned(ic.tabq_coul_F);
+    sfree_aligned(ic.tabq_coul_V);
+    done_commrec(cr);
+}
+
+void TestSystem::setupNbnxm(const Nbnxm::KernelSetup &kernelSetup,
+                            const int                 numThreads)
+{
+    gmx_omp_nthreads_set(emntNonbonded, numThreads);
+    gmx_omp_nthreads_set(emntPairsearch, numThreads);
+
+    fr.nbv = Nbnxm::init_nb_verlet(MDLogger(), kernelSetup,
+                                   ir.efep != efepNO,
+                                   &ir, &fr, cr, &mtop, box);
+}
+
+NbnxmOutput TestSystem::computeForces(const Nbnxm::KernelSetup &kernelSetup,
+                                      const int                 numThreads,
+                                      const bool                useKernelTasks)
+{
+    setupNbnxm(kernelSetup, numThreads);
+
+    nonbonded_verlet_t *nbv = fr.nbv.get();
+
+    const int           numAtoms = x_.size();
+    const rvec          lowerCorner = { 0, 0, 0 };
+    const rvec          upperCorner = { box[XX][XX], box[YY][YY], box[ZZ][ZZ] };
+    nbnxn_put_on_grid(nbv, box, 0, lowerCorner, upperCorner,
+                      nullptr, 0, numAtoms, c_gridAtomDensity,
+                      atomInfo_.data(), x_,
+                      0, nullptr);
+    nbv->setAtomProperties(mdatoms_, *atomInfo_.data());
+
+    t_nrnb nrnb;
+    init_nrnb(&nrnb);
+    nbv->constructPairlist(Nbnxm::InteractionLocality::Local,
+                           &exclusions_, 0, &nrnb);
+
+    const int      numEnergyGroups = ir.opts.ngener;
+    gmx_enerdata_t enerd;
+    init_enerdata(numEnergyGroups, 0, &enerd);
+
+    const int forceFlags = GMX_FORCE_NONBONDED | GMX_FORCE_FORCES | GMX_FORCE_ENERGY;
+    if (useKernelTasks)
+    {
+        const int numTasks = nbv->numCpuKernelTasks(Nbnxm::InteractionLocality::Local);
+        for (int task = numTasks - 1; task >= 0; task--)
+        {
+            nbv->dispatchCpuKernelTask(Nbnxm::InteractionLocality::Local,
+                                       ic, forceFlags, enbvClearFYes, &fr, task);
+        }
+        nbv->finishCpuKernelTasks(Nbnxm::InteractionLocality::Local,
+                                  ic, forceFlags, &fr, &enerd, &nrnb);
+    }
+    else
+    {
+        nbv->dispatchNonbondedKernel(Nbnxm::InteractionLocality::Local,
+                                     ic, forceFlags, enbvClearFYes,
+                                     &fr, &enerd, &nrnb);
+    }
+
+    NbnxmOutput output;
+    output.f.resize(numAtoms, { 0, 0, 0 });
+    if (ir.efep != efepNO)
+    {
+        nbv->dispatchFreeEnergyKernel(Nbnxm::InteractionLocality::Local,
+                                      &fr, as_rvec_array(x_.data()), as_rvec_array(output.f.data()),
+                                      mdatoms_, ir.fepvals, lambda_.data(),
+                                      &enerd, forceFlags, &nrnb);
+    }
+    nbv->atomdata_add_nbat_f_to_f(Nbnxm::AtomLocality::All,
+                                  as_rvec_array(output.f.data()), nullptr);
+
+    for (int i = 0; i < numEnergyGroups; i++)
+    {
+        for (int j = i; j < numEnergyGroups; j++)
+        {
+            const int ij = i*numEnergyGroups + j;
+            const int ji = j*numEnergyGroups + i;
+            output.vCoulomb.push_back(enerd.grpp.ener[egCOULSR][ij] +
+                                      (i != j ? enerd.grpp.ener[egCOULSR][ji] : 0));
+            output.vVdw.push_back(enerd.grpp.ener[egLJSR][ij] +
+                                  (i != j ? enerd.grpp.ener[egLJSR][ji] : 0));
+        }
+    }
+    output.dvdlCoulomb = enerd.dvdl_lin[efptCOUL] + enerd.dvdl_nonlin[efptCOUL];
+    output.dvdlVdw     = enerd.dvdl_lin[efptVDW] + enerd.dvdl_nonlin[efptVDW];
+
+    destroy_enerdata(&enerd);
+
+    return output;
+}
+
+}  // namespace test
+}  // namespace gmx
@@ -0,0 +1,180 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares a small test system for the nbnxm tests.
+ *
+ * \ingroup __module_nb_verlet
+ */
+#ifndef GMX_NBNXM_TESTS_TESTSYSTEM_H
+#define GMX_NBNXM_TESTS_TESTSYSTEM_H
+
+#include <memory>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/topology/block.h"
+#include "gromacs/topology/topology.h"
+
+struct t_commrec;
+
+namespace gmx
+{
+
+class CubicSplineTable;
+
+namespace test
+{
+
+//! The options for setting up a TestSystem
+struct TestSystemOptions
+{
+    //! The Coulomb type, eelRF or eelPME
+    int  coulombType                = eelRF;
+    //! The VdW type, evdwCUT or evdwUSER
+    int  vdwType                    = evdwCUT;
+    //! The number of energy groups
+    int  numEnergyGroups            = 1;
+    //! Whether the energy groups are uniform within the clusters, otherwise they alternate between atoms
+    bool clusterUniformEnergyGroups = false;
+    //! Whether some atoms are perturbed
+    bool havePerturbedAtoms         = false;
+};
+
+//! The forces and energies computed by the nbnxm module for a TestSystem
+struct NbnxmOutput
+{
+    //! The forces
+    std::vector<RVec> f;
+    //! Coulomb energies per energy group pair i<=j, with the (i,j) and (j,i) terms summed
+    std::vector<real> vCoulomb;
+    //! Van der Waals energies per energy group pair i<=j
+    std::vector<real> vVdw;
+    //! dV/dlambda for Coulomb, linear and non-linear contributions summed
+    real              dvdlCoulomb = 0;
+    //! dV/dlambda for Van der Waals
+    real              dvdlVdw     = 0;
+};
+
+/*! \internal
+ * \brief A small periodic system of charged LJ atoms with exclusions
+ *
+ * The atoms are placed on a jittered lattice, so all pairs are at
+ * a reasonable distance. Atoms 2i and 2i+1 exclude each other.
+ * The atoms are distributed cyclically over the energy groups, or with
+ * cluster-uniform groups, slabs along x of two lattice sites are.
+ * With perturbed atoms, some atoms change charge and atom type with
+ * non-zero C12 in both states, so no soft-core is applied to their
+ * pairs, and some atoms vanish, so their pairs use soft-core.
+ * With user VdW tables, softened Lennard-Jones functions are tabulated,
+ * which are finite at zero distance.
+ */
+class TestSystem
+{
+    public:
+        //! Sets up the system for \p options
+        explicit TestSystem(const TestSystemOptions &options);
+
+        ~TestSystem();
+
+        //! Sets up an Nbnxm object with \p kernelSetup in the force record, using \p numThreads OpenMP threads
+        void setupNbnxm(const Nbnxm::KernelSetup &kernelSetup,
+                        int                       numThreads);
+
+        /*! \brief Computes the forces and energies with an Nbnxm object set up with \p kernelSetup
+         *
+         * With \p useKernelTasks, the non-bonded kernel is run per pairlist,
+         * in reverse order, with dispatchCpuKernelTask() and
+         * finishCpuKernelTasks(), as in do_force() with force tasks.
+         */
+        NbnxmOutput computeForces(const Nbnxm::KernelSetup &kernelSetup,
+                                  int                       numThreads,
+                                  bool                      useKernelTasks = false);
+
+        //! The input parameter record
+        t_inputrec          ir;
+        //! The interaction constants
+        interaction_const_t ic = {};
+        //! The force record
+        t_forcerec          fr;
+        //! The global topology, only the atom count is set
+        gmx_mtop_t          mtop;
+        //! The communication record
+        t_commrec          *cr;
+        //! The unit cell
+        matrix              box;
+
+    private:
+        //! The lambda values for Coulomb and VdW, when perturbed
+        std::vector<real>   lambda_;
+        //! The coordinates
+        std::vector<RVec>   x_;
+        //! The shift vectors
+        std::vector<RVec>   shiftVec_;
+        //! The shift forces
+        std::vector<RVec>   fshift_;
+        //! Charges in state A
+        std::vector<real>   chargeA_;
+        //! Charges in state B
+        std::vector<real>   chargeB_;
+        //! Atom types in state A
+        std::vector<int>    typeA_;
+        //! Atom types in state B
+        std::vector<int>    typeB_;
+        //! The LJ parameter matrix, C6 and C12 scaled by 6 and 12
+        std::vector<real>   nbfp_;
+        //! The atom info flags
+        std::vector<int>    atomInfo_;
+        //! The exclusion indices
+        std::vector<int>    exclusionIndex_;
+        //! The excluded atoms
+        std::vector<int>    exclusionAtoms_;
+        //! The exclusions
+        t_blocka            exclusions_ = {};
+        //! The atom data
+        t_mdatoms           mdatoms_    = {};
+        //! The user VdW table, when used
+        std::unique_ptr<CubicSplineTable> vdwUserTable_;
+};
+
+}  // namespace test
+}  // namespace gmx
+
+#endif
@@ -41,6 +41,8 @@
 #include <cmath>
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/functions.h"
@@ -50,10 +52,14 @@
 #include "gromacs/mdtypes/fcdata.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/nblist.h"
+#include "gromacs/tables/cubicsplinetable.h"
+#include "gromacs/tables/splineutil.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 /* All the possible (implemented) table functions */
 enum {
@@ -1517,3 +1523,94 @@ t_forcetable *makeDispersionCorrectionTable(FILE                      *fp,
 
     return dispersionCorrectionTable;
 }
+
+std::unique_ptr<gmx::CubicSplineTable>
+makeUserVdwSplineTable(FILE *fp, const char *fn, real rtab)
+{
+    t_tabledata td[etiNR];
+
+    read_tables(fp, fn, etiNR, 0, td);
+
+    const int    nx      = td[0].nx;
+    const double spacing = 1.0/td[0].tabscale;
+
+    if (td[0].x[nx-1] < rtab)
+    {
+        gmx_fatal(FARGS, "Tables in file %s not long enough for cut-off:\n"
+                  "\tshould be at least %f nm\n", fn, rtab);
+    }
+
+    /* Scale down the functions and derivatives by 6 and 12, since the c6
+     * and c12 parameters of the nbnxm kernels include these factors.
+     * Note that the table file stores minus the derivative.
+     */
+    std::vector<double> dispersion(nx), dispersionDerivative(nx);
+    std::vector<double> repulsion(nx), repulsionDerivative(nx);
+    int                 firstNonZero = nx;
+    for (int i = 0; i < nx; i++)
+    {
+        dispersion[i]           =  td[etiLJ6].v[i]/6.0;
+        dispersionDerivative[i] = -td[etiLJ6].f[i]/6.0;
+        repulsion[i]            =  td[etiLJ12].v[i]/12.0;
+        repulsionDerivative[i]  = -td[etiLJ12].f[i]/12.0;
+        if (firstNonZero == nx &&
+            (dispersion[i] != 0 || dispersionDerivative[i] != 0 ||
+             repulsion[i] != 0 || repulsionDerivative[i] != 0))
+        {
+            firstNonZero = i;
+        }
+    }
+    for (int k = 0; k < etiNR; k++)
+    {
+        done_tabledata(&td[k]);
+    }
+
+    /* Tables usually contain zeros up to some short distance,
+     * we exclude those points, which are not sampled in practice,
+     * from the consistency checks and the spacing estimate.
+     */
+    std::pair<real, real> range(std::min(firstNonZero + 0.5, nx - 1.0)*spacing, rtab);
+
+    /* We want to use the input spacing. With the default tolerance
+     * the spline table could require a finer spacing than the input has,
+     * for instance when the third derivative is non-zero close to
+     * a point where the derivative goes to zero. So we set the tolerance
+     * such that the spacing is at least the input spacing.
+     */
+    double minQuotient = GMX_REAL_MAX;
+    for (const std::vector<double> *derivative : { &dispersionDerivative, &repulsionDerivative })
+    {
+        minQuotient = std::min(minQuotient,
+                               static_cast<double>(gmx::internal::findSmallestQuotientOfFunctionAndThirdDerivative(*derivative, spacing, range)));
+    }
+    minQuotient = std::max(minQuotient, static_cast<double>(GMX_REAL_MIN));
+    real tolerance = std::max(gmx::CubicSplineTable::defaultTolerance,
+                              static_cast<real>(1.001*spacing*spacing*spacing/(72*std::sqrt(3.0)*minQuotient)));
+
+    const std::string                      dispersionDesc("User dispersion");
+    const std::string                      repulsionDesc("User repulsion");
+    std::unique_ptr<gmx::CubicSplineTable> table;
+    try
+    {
+        table = std::make_unique<gmx::CubicSplineTable>(std::initializer_list<gmx::NumericalSplineTableInput>
+                                                        {
+                                                            { dispersionDesc, dispersion, dispersionDerivative, spacing },
+                                                            { repulsionDesc, repulsion, repulsionDerivative, spacing }
+                                                        },
+                                                        range, tolerance);
+    }
+    catch (gmx::GromacsException &ex)
+    {
+        ex.prependContext(gmx::formatString("Error using the user table file %s with the Verlet cut-off scheme", fn));
+        throw;
+    }
+
+    if (fp)
+    {
+        fprintf(fp, "Generated cubic spline table for the user dispersion and repulsion\n"
+                "with %g points/nm from %g to %g nm\n",
+                1/table->tableSpacing(), range.first, range.second);
+    }
+
+    return table;
+}
@@ -46,11 +46,18 @@
 
 #include <cstdio>
 
+#include <memory>
+
 #include "gromacs/mdtypes/fcdata.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/utility/real.h"
 
+namespace gmx
+{
+class CubicSplineTable;
+}
+
 /*! \brief Flag to select user tables for make_tables */
 #define GMX_MAKETABLES_FORCEUSER  (1<<0)
 /*! \brief Flag to only make 1,4 pair tables for make_tables */
@@ -149,4 +156,25 @@ bondedtable_t make_bonded_table(FILE *fplog, const char *fn, int angle);
 t_forcetable *makeDispersionCorrectionTable(FILE *fp, const interaction_const_t *ic,
                                             real rtab, const char *tabfn);
 
+/*! \brief Return a cubic spline table with the user dispersion and repulsion
+ *
+ * Reads the user table file \p fn in the same format as make_tables()
+ * and returns a table with the dispersion function g(r)/6 as function 0
+ * and the repulsion function h(r)/12 as function 1, so the table can be
+ * used directly with the 6*C6 and 12*C12 parameters of the nbnxm kernels.
+ * The table spacing is the spacing of the input file.
+ * The Coulomb columns are ignored.
+ *
+ * \param fp    Log file pointer, can be nullptr
+ * \param fn    File name from which to read the user table
+ * \param rtab  Largest interaction distance to tabulate
+ *
+ * \return The two-function cubic spline table
+ *
+ * \throws InconsistentInputError when the forces in the file do not match
+ *         minus the derivative of the potentials.
+ */
+std::unique_ptr<gmx::CubicSplineTable>
+makeUserVdwSplineTable(FILE *fp, const char *fn, real rtab);
+
 #endif  /* GMX_TABLES_FORCETABLE_H */
@@ -0,0 +1,151 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the user table spline conversion in forcetable.cpp.
+ *
+ * \ingroup module_tables
+ */
+#include "gmxpre.h"
+
+#include "gromacs/tables/forcetable.h"
+
+#include <cmath>
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/tables/cubicsplinetable.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! Spacing of the user table files written by the tests
+constexpr double c_tableSpacing = 0.002;
+//! Number of points in the user table files
+constexpr int    c_numTablePoints = 601;
+//! Below this distance the table files contain zeros, as usual
+constexpr double c_tableZeroDistance = 0.04;
+
+/*! \brief Writes a user table file with Lennard-Jones dispersion and repulsion
+ *
+ * The Coulomb columns contain 1/r. When \p forceSign is -1
+ * the VdW force columns have the wrong sign.
+ */
+std::string writeLJUserTable(TestFileManager *fileManager, double forceSign)
+{
+    std::string contents;
+    for (int i = 0; i < c_numTablePoints; i++)
+    {
+        const double r = i*c_tableSpacing;
+        double       f = 0, fd = 0, g = 0, gd = 0, h = 0, hd = 0;
+        if (r >= c_tableZeroDistance)
+        {
+            f  = 1/r;
+            fd = 1/(r*r);
+            g  = -1/std::pow(r, 6);
+            gd = forceSign*-6/std::pow(r, 7);
+            h  = 1/std::pow(r, 12);
+            hd = forceSign*12/std::pow(r, 13);
+        }
+        contents += formatString("%10.6f %15.8e %15.8e %15.8e %15.8e %15.8e %15.8e\n",
+                                 r, f, fd, g, gd, h, hd);
+    }
+    std::string fileName = fileManager->getTemporaryFilePath("table.xvg");
+    TextWriter::writeFileFromString(fileName, contents);
+
+    return fileName;
+}
+
+TEST(UserVdwSplineTableTest, ReproducesScaledLennardJones)
+{
+    TestFileManager                   fileManager;
+    const std::string                 fileName = writeLJUserTable(&fileManager, 1);
+    const real                        rtab     = 1.1;
+
+    std::unique_ptr<CubicSplineTable> table = makeUserVdwSplineTable(nullptr, fileName.c_str(), rtab);
+
+    /* The spacing of the input file should be used, up to rounding
+     * of the number of points in the table range.
+     */
+    EXPECT_REAL_EQ_TOL(c_tableSpacing, table->tableSpacing(), relativeToleranceAsFloatingPoint(c_tableSpacing, 1e-3));
+
+    /* The interpolation error of r^-12 near the lower end of the tested
+     * range dominates the tolerance.
+     */
+    const FloatingPointTolerance tolerance = relativeToleranceAsFloatingPoint(1, 1e-4);
+    for (real r = 0.3; r < rtab; r += 0.0137) // NOLINT(clang-analyzer-security.FloatLoopCounter)
+    {
+        real dispersion, dispersionDerivative, repulsion, repulsionDerivative;
+        table->evaluateFunctionAndDerivative(r, &dispersion, &dispersionDerivative,
+                                             &repulsion, &repulsionDerivative);
+
+        /* The dispersion and repulsion should be scaled by 1/6 and 1/12 */
+        const double refDispersion = -1/(6*std::pow(r, 6));
+        const double refRepulsion  = 1/(12*std::pow(r, 12));
+        EXPECT_REAL_EQ_TOL(1, dispersion/refDispersion, tolerance) << "at r = " << r;
+        EXPECT_REAL_EQ_TOL(1, dispersionDerivative/(-6*refDispersion/r), tolerance) << "at r = " << r;
+        EXPECT_REAL_EQ_TOL(1, repulsion/refRepulsion, tolerance) << "at r = " << r;
+        EXPECT_REAL_EQ_TOL(1, repulsionDerivative/(-12*refRepulsion/r), tolerance) << "at r = " << r;
+    }
+}
+
+TEST(UserVdwSplineTableTest, ThrowsWithInconsistentForces)
+{
+    TestFileManager   fileManager;
+    const std::string fileName = writeLJUserTable(&fileManager, -1);
+
+    EXPECT_THROW_GMX(makeUserVdwSplineTable(nullptr, fileName.c_str(), 1.1), InconsistentInputError);
+}
+
+}      // namespace
+
+}      // namespace test
+
+}      // namespace gmx
@@ -127,6 +127,7 @@ static const char *wcsn[ewcsNR] =
     "Listed buffer ops.",
     "Nonbonded pruning",
     "Nonbonded F",
+    "NB+bonded task wait",
     "Launch NB GPU tasks",
     "Launch Bonded GPU tasks",
     "Launch PME GPU tasks",
@@ -1123,3 +1124,12 @@ void wallcycle_sub_stop(gmx_wallcycle_t wc, int ewcs)
         wc->wcsc[ewcs].n++;
     }
 }
+
+void wallcycle_sub_add(gmx_wallcycle_t wc, int ewcs, double cycles)
+{
+    if (useCycleSubcounters && wc != nullptr)
+    {
+        wc->wcsc[ewcs].c += static_cast<gmx_cycles_t>(cycles);
+        wc->wcsc[ewcs].n++;
+    }
+}
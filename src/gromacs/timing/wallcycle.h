@@ -73,6 +73,7 @@ enum {
     ewcsLISTED_BUF_OPS,
     ewcsNONBONDED_PRUNING,
     ewcsNONBONDED,
+    ewcsFORCE_TASKS_WAIT,
     ewcsLAUNCH_GPU_NONBONDED,
     ewcsLAUNCH_GPU_BONDED,
     ewcsLAUNCH_GPU_PME,
@@ -128,4 +129,9 @@ void wallcycle_sub_start_nocount(gmx_wallcycle_t wc, int ewcs);
 void wallcycle_sub_stop(gmx_wallcycle_t wc, int ewcs);
 /* Stop the sub cycle count for ewcs */
 
+void wallcycle_sub_add(gmx_wallcycle_t wc, int ewcs, double cycles);
+/* Add cycles measured elsewhere, e.g. averaged over the threads
+ * of an OpenMP region, to ewcs and increase the call count
+ */
+
 #endif
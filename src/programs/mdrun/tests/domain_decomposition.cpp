@@ -42,19 +42,37 @@
  */
 #include "gmxpre.h"
 
+#include <cstdlib>
+
 #include <string>
 
 #include <gtest/gtest.h>
 
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+
 #include "testutils/cmdlinetest.h"
+#include "testutils/simulationdatabase.h"
+#include "testutils/testasserts.h"
 
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "mdruncomparison.h"
 #include "moduletest.h"
+#include "trajectorycomparison.h"
+#include "trajectoryreader.h"
 
+namespace gmx
+{
+namespace test
+{
 namespace
 {
 
 //! Test fixture for domain decomposition special cases
-class DomainDecompositionSpecialCasesTest : public gmx::test::MdrunTestFixture
+class DomainDecompositionSpecialCasesTest : public MdrunTestFixture
 {
 };
 
@@ -74,4 +92,92 @@ TEST_F(DomainDecompositionSpecialCasesTest, AnEmptyDomainWorks)
     ASSERT_EQ(0, runner_.callMdrun());
 }
 
+/*! \brief Checks the atom lookup after repartitioning against a full rebuild
+ *
+ * With GMX_DD_DEBUG set, mdrun checks after each partitioning that
+ * the global to local atom lookup, which is updated in place for home
+ * atoms, matches a lookup rebuilt from scratch. With nstlist=8 the
+ * 24 steps repartition the system three times.
+ */
+TEST_F(DomainDecompositionSpecialCasesTest, RepartitioningKeepsTheAtomLookupConsistent)
+{
+    auto mdpFieldValues = prepareMdpFieldValues("spc216", "md", "no", "no");
+    mdpFieldValues["nsteps"] = "24";
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    setenv("GMX_DD_DEBUG", "1", 1);
+    const int returnValue = runner_.callMdrun();
+    unsetenv("GMX_DD_DEBUG");
+    ASSERT_EQ(0, returnValue);
+}
+
+/*! \brief Checks that the local constraints and vsites do not depend on the number of domdec threads
+ *
+ * The threads assign the local constraints, settles and vsites
+ * in thread order, which should give the same local topology as
+ * a single thread. Then nothing else in the run differs, so the runs
+ * should be bitwise identical.
+ */
+TEST_F(DomainDecompositionSpecialCasesTest, LocalTopologyDoesNotDependOnDomdecThreads)
+{
+    const std::string simulationName = "alanine_vsite_solvated";
+    auto              mdpFieldValues = prepareMdpFieldValues(simulationName.c_str(), "md", "no", "no");
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    /* The module thread counts are only picked up from the environment
+     * by the first mdrun call in this process, so we also set them
+     * directly for the later calls.
+     */
+    const int numThreadsDefault = gmx_omp_nthreads_get(emntDomdec);
+    for (int numThreads : { 1, 4 })
+    {
+        const std::string name = "domdec" + std::to_string(numThreads);
+        runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(name + ".edr");
+        runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(name + ".trr");
+        setenv("GMX_DOMDEC_NUM_THREADS", std::to_string(numThreads).c_str(), 1);
+        gmx_omp_nthreads_set(emntDomdec, numThreads);
+        const int returnValue = runner_.callMdrun();
+        unsetenv("GMX_DOMDEC_NUM_THREADS");
+        gmx_omp_nthreads_set(emntDomdec, numThreadsDefault);
+        ASSERT_EQ(0, returnValue);
+    }
+
+    const FloatingPointTolerance exact = absoluteTolerance(0);
+    EnergyTolerances             energiesToMatch
+    {{
+         { interaction_function[F_EPOT].longname, exact },
+         { interaction_function[F_PRES].longname, exact },
+         { interaction_function[F_EKIN].longname, exact },
+     }};
+    auto energyComparator = [&energiesToMatch](const EnergyFrame &reference, const EnergyFrame &test)
+        {
+            compareEnergyFrames(reference, test, energiesToMatch);
+        };
+    FramePairManager<EnergyFrameReader, EnergyFrame>
+    energyManager(openEnergyFileToReadFields(fileManager_.getTemporaryFilePath("domdec1.edr"), getKeys(energiesToMatch)),
+                  openEnergyFileToReadFields(fileManager_.getTemporaryFilePath("domdec4.edr"), getKeys(energiesToMatch)));
+    energyManager.compareAllFramePairs(energyComparator);
+
+    TrajectoryFrameMatchSettings trajectoryMatchSettings {
+        true, true, false, false, true, true
+    };
+    TrajectoryTolerances         trajectoryTolerances {
+        exact, exact, exact, exact
+    };
+    auto trajectoryComparator = [&trajectoryMatchSettings, &trajectoryTolerances](const TrajectoryFrame &reference, const TrajectoryFrame &test)
+        {
+            compareTrajectoryFrames(reference, test, trajectoryMatchSettings, trajectoryTolerances);
+        };
+    FramePairManager<TrajectoryFrameReader, TrajectoryFrame>
+    trajectoryManager(std::make_unique<TrajectoryFrameReader>(fileManager_.getTemporaryFilePath("domdec1.trr")),
+                      std::make_unique<TrajectoryFrameReader>(fileManager_.getTemporaryFilePath("domdec4.trr")));
+    trajectoryManager.compareAllFramePairs(trajectoryComparator);
+}
+
 } // namespace
+} // namespace test
+} // namespace gmx
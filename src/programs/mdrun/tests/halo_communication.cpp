@@ -0,0 +1,279 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the direct and asynchronous domain decomposition halo
+ * communication modes reproduce the staged halo communication.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+#include <tuple>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/simulationdatabase.h"
+#include "testutils/testasserts.h"
+
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "mdruncomparison.h"
+#include "moduletest.h"
+#include "trajectorycomparison.h"
+#include "trajectoryreader.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Log line written when the single-stage direct halo communication is used
+const char *const c_directHaloLogLine = "using the single-stage direct halo communication";
+//! Log line written when direct halo communication was requested, but the staged one is used
+const char *const c_stagedHaloLogLine = "using the staged halo communication";
+//! Log text written when the coordinate communication is overlapped with the local non-bonded computation
+const char *const c_asyncHaloLogText = "overlapping the coordinate communication with the local non-bonded computation";
+
+/*! \brief Test fixture for the halo communication modes
+ *
+ * All runs use SPC water with PME, without dynamic load balancing,
+ * so the decomposition is the same for all runs and the only
+ * difference is the order in which the halo forces are reduced.
+ */
+class HaloCommunicationTest : public MdrunTestFixture
+{
+    public:
+        //! Runs grompp for SPC water with PME
+        void prepareTpr()
+        {
+            auto mdpFieldValues = prepareMdpFieldValues("spc216", "md", "no", "no");
+            mdpFieldValues["nstcalcenergy"] = "4";
+            mdpFieldValues["other"]        += "\ncoulombtype = PME";
+            runner_.useTopGroAndNdxFromDatabase("spc216");
+            runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+            CommandLine caller;
+            caller.append("grompp");
+            ASSERT_EQ(0, runner_.callGrompp(caller));
+        }
+        /*! \brief Runs mdrun on the \c ddGrid grid of PP ranks, with the other ranks doing PME
+         *
+         * Sets the environment variable \c environmentVariable to 1,
+         * when it is not nullptr. The output files are named after \c name.
+         */
+        void runMdrun(const std::string &name, const char *environmentVariable,
+                      const std::tuple<int, int, int> &ddGrid)
+        {
+            const int numPpRanks = std::get<0>(ddGrid)*std::get<1>(ddGrid)*std::get<2>(ddGrid);
+            runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(name + ".trr");
+            runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(name + ".edr");
+            runner_.logFileName_                     = fileManager_.getTemporaryFilePath(name + ".log");
+            CommandLine caller;
+            caller.append("mdrun");
+            caller.append("-dd");
+            caller.append(std::to_string(std::get<0>(ddGrid)));
+            caller.append(std::to_string(std::get<1>(ddGrid)));
+            caller.append(std::to_string(std::get<2>(ddGrid)));
+            caller.addOption("-npme", getNumberOfTestMpiRanks() - numPpRanks);
+            caller.addOption("-dlb", "no");
+            if (environmentVariable != nullptr)
+            {
+                setenv(environmentVariable, "1", 1);
+            }
+            const int   returnValue = runner_.callMdrun(caller);
+            if (environmentVariable != nullptr)
+            {
+                unsetenv(environmentVariable);
+            }
+            ASSERT_EQ(0, returnValue);
+        }
+        //! Returns the contents of the log file of run \c name
+        std::string readLog(const std::string &name)
+        {
+            return TextReader::readFileToString(fileManager_.getTemporaryFilePath(name + ".log"));
+        }
+        //! Checks that the energies and forces of the runs \c referenceName and \c testName agree
+        void compareRuns(const std::string &referenceName, const std::string &testName)
+        {
+            /* The coordinates are communicated exactly, but the halo forces
+             * are reduced in a different order. So the first frame should
+             * agree to within a few ULP, but the trajectories diverge
+             * over the steps. The potential energy is only sensitive to
+             * that divergence in the last digits.
+             */
+            EnergyTolerances energiesToMatch
+            {{
+                 { interaction_function[F_EPOT].longname, relativeToleranceAsPrecisionDependentUlp(1e4, 64, 64) },
+                 { interaction_function[F_COUL_SR].longname, relativeToleranceAsPrecisionDependentUlp(1e4, 64, 64) },
+             }};
+            auto energyComparator = [&energiesToMatch](const EnergyFrame &reference, const EnergyFrame &test)
+                {
+                    compareEnergyFrames(reference, test, energiesToMatch);
+                };
+            FramePairManager<EnergyFrameReader, EnergyFrame>
+            energyManager(openEnergyFileToReadFields(fileManager_.getTemporaryFilePath(referenceName + ".edr"), getKeys(energiesToMatch)),
+                          openEnergyFileToReadFields(fileManager_.getTemporaryFilePath(testName + ".edr"), getKeys(energiesToMatch)));
+            energyManager.compareAllFramePairs(energyComparator);
+
+            TrajectoryFrameReader referenceTrajectory(fileManager_.getTemporaryFilePath(referenceName + ".trr"));
+            TrajectoryFrameReader testTrajectory(fileManager_.getTemporaryFilePath(testName + ".trr"));
+            ASSERT_TRUE(referenceTrajectory.readNextFrame());
+            ASSERT_TRUE(testTrajectory.readNextFrame());
+            TrajectoryFrameMatchSettings trajectoryMatchSettings {
+                true, true, false, false, true, true
+            };
+            TrajectoryTolerances         trajectoryTolerances {
+                absoluteTolerance(0), absoluteTolerance(0), absoluteTolerance(0),
+                relativeToleranceAsPrecisionDependentUlp(1e3, 16, 16)
+            };
+            compareTrajectoryFrames(referenceTrajectory.frame(), testTrajectory.frame(),
+                                    trajectoryMatchSettings, trajectoryTolerances);
+        }
+};
+
+//! Returns whether the test has enough ranks for \c ddGrid, prints a message if not
+bool haveRanksForGrid(const std::tuple<int, int, int> &ddGrid)
+{
+    const int numRanks   = getNumberOfTestMpiRanks();
+    const int numPpRanks = std::get<0>(ddGrid)*std::get<1>(ddGrid)*std::get<2>(ddGrid);
+    if (numRanks < numPpRanks)
+    {
+        fprintf(stdout, "A %d x %d x %d decomposition cannot run with %d ranks.\n",
+                std::get<0>(ddGrid), std::get<1>(ddGrid), std::get<2>(ddGrid), numRanks);
+        return false;
+    }
+    return true;
+}
+
+//! Parameters: the decomposition grid and whether the direct halo communication can be used with it
+typedef std::tuple<std::tuple<int, int, int>, bool> DirectHaloTestParams;
+
+class DirectHaloTest : public HaloCommunicationTest,
+                       public ::testing::WithParamInterface<DirectHaloTestParams>
+{
+};
+
+class AsyncHaloTest : public HaloCommunicationTest,
+                      public ::testing::WithParamInterface<DirectHaloTestParams>
+{
+};
+
+TEST_P(DirectHaloTest, ReproducesStagedPulses)
+{
+    const auto ddGrid                  = std::get<0>(GetParam());
+    const bool expectDirectHaloIsUsed  = std::get<1>(GetParam());
+    if (!haveRanksForGrid(ddGrid))
+    {
+        return;
+    }
+
+    prepareTpr();
+    runMdrun("staged", nullptr, ddGrid);
+    runMdrun("direct", "GMX_DD_DIRECT_HALO", ddGrid);
+
+    const std::string log = readLog("direct");
+    if (expectDirectHaloIsUsed)
+    {
+        EXPECT_NE(std::string::npos, log.find(c_directHaloLogLine));
+        EXPECT_EQ(std::string::npos, log.find(c_stagedHaloLogLine));
+    }
+    else
+    {
+        EXPECT_EQ(std::string::npos, log.find(c_directHaloLogLine));
+        EXPECT_NE(std::string::npos, log.find(c_stagedHaloLogLine));
+    }
+    compareRuns("staged", "direct");
+}
+
+/* With 0.7 nm cut-offs SPC216 supports two cells along a dimension
+ * with a single pulse, but four cells need two pulses. The direct
+ * communication is not used with one dimension or multiple pulses.
+ */
+INSTANTIATE_TEST_CASE_P(WithDecompositions, DirectHaloTest,
+                            ::testing::Values(DirectHaloTestParams { std::make_tuple(2, 1, 1), false },
+                                              DirectHaloTestParams { std::make_tuple(2, 2, 1), true },
+                                              DirectHaloTestParams { std::make_tuple(4, 1, 1), false },
+                                              DirectHaloTestParams { std::make_tuple(2, 2, 2), true },
+                                              DirectHaloTestParams { std::make_tuple(4, 2, 1), false }));
+
+TEST_P(AsyncHaloTest, ReproducesStagedPulses)
+{
+    const auto ddGrid                 = std::get<0>(GetParam());
+    const bool expectDirectHaloIsUsed = std::get<1>(GetParam());
+    if (!haveRanksForGrid(ddGrid))
+    {
+        return;
+    }
+
+    prepareTpr();
+    runMdrun("staged", nullptr, ddGrid);
+    runMdrun("async", "GMX_DD_ASYNC_HALO", ddGrid);
+
+    /* The overlap builds on the direct communication and is only used with it */
+    const std::string log = readLog("async");
+    if (expectDirectHaloIsUsed)
+    {
+        EXPECT_NE(std::string::npos, log.find(c_directHaloLogLine + std::string(", ") + c_asyncHaloLogText));
+    }
+    else
+    {
+        EXPECT_EQ(std::string::npos, log.find(c_asyncHaloLogText));
+        EXPECT_NE(std::string::npos, log.find(c_stagedHaloLogLine));
+    }
+    compareRuns("staged", "async");
+}
+
+INSTANTIATE_TEST_CASE_P(WithDecompositions, AsyncHaloTest,
+                            ::testing::Values(DirectHaloTestParams { std::make_tuple(2, 1, 1), false },
+                                              DirectHaloTestParams { std::make_tuple(2, 2, 1), true },
+                                              DirectHaloTestParams { std::make_tuple(2, 2, 2), true }));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,233 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for multiple time stepping of the PME mesh forces
+ * with GMX_MTS_FACTOR.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include "config.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include <algorithm>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+
+#include "testutils/simulationdatabase.h"
+#include "testutils/testasserts.h"
+
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "mdruncomparison.h"
+#include "moduletest.h"
+#include "trajectorycomparison.h"
+#include "trajectoryreader.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Name of the total energy term in the .edr file, which is conserved in NVE
+const std::string c_totalEnergyName = interaction_function[F_ETOT].longname;
+
+//! How much larger the total energy fluctuation with multiple time stepping may be than without
+const real        c_maxDeviationRatio = 4;
+
+/*! \brief Test fixture for multiple time stepping
+ *
+ * All runs use plain MD in the NVE ensemble on SPC water with PME,
+ * so the conserved energy is the total energy.
+ */
+class MultipleTimeSteppingTest : public MdrunTestFixture
+{
+    public:
+        //! Runs grompp for \c nsteps steps with energy and force output every 4 steps
+        void prepareTpr(int nsteps)
+        {
+            auto mdpFieldValues = prepareMdpFieldValues("spc216", "md", "no", "no");
+            mdpFieldValues["nsteps"]        = std::to_string(nsteps);
+            mdpFieldValues["nstcalcenergy"] = "4";
+            mdpFieldValues["other"]        += "\ncoulombtype = PME";
+            runner_.useTopGroAndNdxFromDatabase("spc216");
+            runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+            CommandLine caller;
+            caller.append("grompp");
+            ASSERT_EQ(0, runner_.callGrompp(caller));
+        }
+        /*! \brief Runs mdrun with GMX_MTS_FACTOR set to \c mtsFactor
+         *
+         * With \c mtsFactor empty GMX_MTS_FACTOR is unset.
+         */
+        void runMdrun(const std::string &name, const std::string &mtsFactor)
+        {
+            runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(name + ".trr");
+            runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(name + ".edr");
+            if (mtsFactor.empty())
+            {
+                unsetenv("GMX_MTS_FACTOR");
+            }
+            else
+            {
+                setenv("GMX_MTS_FACTOR", mtsFactor.c_str(), 1);
+            }
+            CommandLine caller;
+            caller.append("mdrun");
+            const int   returnValue = runner_.callMdrun(caller);
+            unsetenv("GMX_MTS_FACTOR");
+            ASSERT_EQ(0, returnValue);
+        }
+        //! Returns the energy term \c energyName of all frames in the energy file of run \c name
+        std::vector<real> readEnergies(const std::string &name, const std::string &energyName)
+        {
+            std::vector<real> energies;
+            auto              reader = openEnergyFileToReadFields(fileManager_.getTemporaryFilePath(name + ".edr"),
+                                                                  { energyName });
+            while (reader->readNextFrame())
+            {
+                energies.push_back(reader->frame().at(energyName));
+            }
+            return energies;
+        }
+};
+
+TEST_F(MultipleTimeSteppingTest, FactorOneReproducesNormalMd)
+{
+    prepareTpr(16);
+    runMdrun("normal", "");
+    runMdrun("mts1", "1");
+
+    /* A factor of one does not take the multiple time stepping code
+     * path, so all output should be bitwise identical.
+     */
+    const FloatingPointTolerance exact = absoluteTolerance(0);
+    EnergyTolerances             energiesToMatch
+    {{
+         { interaction_function[F_EPOT].longname, exact },
+         { interaction_function[F_EKIN].longname, exact },
+         { c_totalEnergyName, exact },
+         { interaction_function[F_PRES].longname, exact },
+     }};
+    auto energyComparator = [&energiesToMatch](const EnergyFrame &reference, const EnergyFrame &test)
+        {
+            compareEnergyFrames(reference, test, energiesToMatch);
+        };
+    FramePairManager<EnergyFrameReader, EnergyFrame>
+    energyManager(openEnergyFileToReadFields(fileManager_.getTemporaryFilePath("normal.edr"), getKeys(energiesToMatch)),
+                  openEnergyFileToReadFields(runner_.edrFileName_, getKeys(energiesToMatch)));
+    energyManager.compareAllFramePairs(energyComparator);
+
+    TrajectoryFrameMatchSettings trajectoryMatchSettings {
+        true, true, false, false, true, true
+    };
+    TrajectoryTolerances         trajectoryTolerances {
+        exact, exact, exact, exact
+    };
+    auto trajectoryComparator = [&trajectoryMatchSettings, &trajectoryTolerances](const TrajectoryFrame &reference, const TrajectoryFrame &test)
+        {
+            compareTrajectoryFrames(reference, test, trajectoryMatchSettings, trajectoryTolerances);
+        };
+    FramePairManager<TrajectoryFrameReader, TrajectoryFrame>
+    trajectoryManager(std::make_unique<TrajectoryFrameReader>(fileManager_.getTemporaryFilePath("normal.trr")),
+                      std::make_unique<TrajectoryFrameReader>(runner_.fullPrecisionTrajectoryFileName_));
+    trajectoryManager.compareAllFramePairs(trajectoryComparator);
+}
+
+TEST_F(MultipleTimeSteppingTest, FactorTwoConservesEnergy)
+{
+    prepareTpr(100);
+    runMdrun("normal", "");
+    runMdrun("mts2", "2");
+
+    /* The initial state is the same and the slow forces are always
+     * computed at output steps, so the potential energy and forces
+     * of the first frame should agree up to the summation order of
+     * the forces. The kinetic energy differs, since at step 0 leap-frog
+     * averages over the half steps around it and the first half step
+     * already uses the slow force impulse.
+     */
+    const std::string potentialEnergyName = interaction_function[F_EPOT].longname;
+    EXPECT_REAL_EQ_TOL(readEnergies("normal", potentialEnergyName)[0],
+                       readEnergies("mts2", potentialEnergyName)[0],
+                       relativeToleranceAsFloatingPoint(1e4, GMX_DOUBLE ? 1e-10 : 1e-6));
+
+    TrajectoryFrameReader normalTrajectory(fileManager_.getTemporaryFilePath("normal.trr"));
+    TrajectoryFrameReader mtsTrajectory(fileManager_.getTemporaryFilePath("mts2.trr"));
+    ASSERT_TRUE(normalTrajectory.readNextFrame());
+    ASSERT_TRUE(mtsTrajectory.readNextFrame());
+    TrajectoryFrameMatchSettings trajectoryMatchSettings {
+        true, true, false, false, false, true
+    };
+    TrajectoryTolerances         trajectoryTolerances {
+        absoluteTolerance(0), absoluteTolerance(0), defaultRealTolerance(),
+        relativeToleranceAsFloatingPoint(100.0, GMX_DOUBLE ? 1.0e-7 : 1.0e-5)
+    };
+    compareTrajectoryFrames(normalTrajectory.frame(), mtsTrajectory.frame(),
+                            trajectoryMatchSettings, trajectoryTolerances);
+
+    /* The impulses of the slow forces cause some additional fluctuation
+     * of the total energy, but as long as the slow forces are integrated
+     * correctly this should stay of the order of that of normal MD.
+     */
+    std::vector<real> normalEnergies = readEnergies("normal", c_totalEnergyName);
+    std::vector<real> mtsEnergies    = readEnergies("mts2", c_totalEnergyName);
+    ASSERT_EQ(normalEnergies.size(), mtsEnergies.size());
+    ASSERT_GT(mtsEnergies.size(), 1U);
+    real normalMaxDeviation = 0;
+    real mtsMaxDeviation    = 0;
+    for (size_t i = 0; i < mtsEnergies.size(); i++)
+    {
+        normalMaxDeviation = std::max(normalMaxDeviation, std::abs(normalEnergies[i] - normalEnergies[0]));
+        mtsMaxDeviation    = std::max(mtsMaxDeviation, std::abs(mtsEnergies[i] - mtsEnergies[0]));
+    }
+    EXPECT_LT(mtsMaxDeviation, c_maxDeviationRatio*normalMaxDeviation)
+    << "Maximum deviation of the total energy with normal MD: " << normalMaxDeviation;
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
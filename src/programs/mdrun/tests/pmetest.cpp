@@ -48,8 +48,12 @@
  */
 #include "gmxpre.h"
 
+#include <cstdlib>
+
+#include <algorithm>
 #include <map>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <gtest/gtest-spi.h>
@@ -58,7 +62,10 @@
 #include "gromacs/gpu_utils/gpu_utils.h"
 #include "gromacs/hardware/detecthardware.h"
 #include "gromacs/hardware/gpu_hw_info.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/trajectory/energyframe.h"
+#include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/loggerbuilder.h"
@@ -70,6 +77,7 @@
 
 #include "energyreader.h"
 #include "moduletest.h"
+#include "trajectoryreader.h"
 
 namespace gmx
 {
@@ -265,6 +273,122 @@ TEST_F(PmeTest, ScalesTheBox)
     runTest(runModes);
 }
 
+//! Parameters for LJ-PME tests: whether free-energy perturbation is used and the Coulomb type
+typedef std::tuple<bool, const char *> PmeLjLorentzBerthelotTestParams;
+
+//! Test fixture for LJ-PME with Lorentz-Berthelot combination rules
+class PmeLjLorentzBerthelotTest : public MdrunTestFixture,
+                                  public ::testing::WithParamInterface<PmeLjLorentzBerthelotTestParams>
+{
+};
+
+/* With Lorentz-Berthelot combination rules, LJ-PME spreads, transforms
+ * and gathers seven grids per state. We check the energies and forces
+ * with one and two PME threads, which wrap the spread grids differently.
+ * As part of mdrun-mpi-test with multiple ranks, the coefficients are
+ * redistributed over the ranks and the gathers add to the forces of
+ * the previous grids and state. Without Coulomb PME, the first LJ gather
+ * of each state is the one that has to clear or keep the forces.
+ */
+TEST_P(PmeLjLorentzBerthelotTest, ReproducesEnergiesAndForces)
+{
+    const bool        useFep      = std::get<0>(GetParam());
+    const char       *coulombType = std::get<1>(GetParam());
+    const std::string inputFile   = "nonanol_vacuo";
+    std::string       theMdpFile  = "integrator       = sd\n"
+        "nsteps           = 0\n"
+        "cutoff-scheme    = Verlet\n"
+        "tc-grps          = System\n"
+        "tau-t            = 1\n"
+        "ref-t            = 298\n"
+        "vdwtype          = PME\n"
+        "lj-pme-comb-rule = Lorentz-Berthelot\n"
+        "nstcalcenergy    = 1\n"
+        "nstenergy        = 1\n"
+        "nstfout          = 1\n";
+    theMdpFile += formatString("coulombtype      = %s\n", coulombType);
+    if (useFep)
+    {
+        /* Decouple the LJ and charges of nonanol, so both states have
+         * non-zero LJ-PME contributions, which differ.
+         */
+        theMdpFile += "free-energy      = yes\n"
+            "couple-moltype   = nonanol\n"
+            "couple-lambda0   = vdw-q\n"
+            "couple-lambda1   = none\n"
+            "init-lambda      = 0.4\n";
+    }
+    runner_.useStringAsMdpFile(theMdpFile);
+    runner_.useTopGroAndNdxFromDatabase(inputFile);
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    TestReferenceData    refData;
+    TestReferenceChecker rootChecker(refData.rootChecker());
+    const bool           thisRankChecks = (gmx_node_rank() == 0);
+    if (!thisRankChecks)
+    {
+        EXPECT_NONFATAL_FAILURE(rootChecker.checkUnusedEntries(), ""); // skip checks on other ranks
+    }
+
+    std::vector<std::string> energyNames = { "LJ recip.", "Potential" };
+    if (useFep)
+    {
+        energyNames.emplace_back("dVremain/dl");
+    }
+
+    /* The number of threads per module is only picked up from the environment
+     * by the first mdrun call in this process, so we also set it directly.
+     */
+    const int numPmeThreadsDefault = gmx_omp_nthreads_get(emntPME);
+    for (int numThreads : { 1, 2 })
+    {
+        const std::string name = formatString("%s_%dthreads", inputFile.c_str(), numThreads);
+        runner_.edrFileName_                     = fileManager_.getTemporaryFilePath(name + ".edr");
+        runner_.fullPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(name + ".trr");
+
+        CommandLine commandLine;
+        commandLine.addOption("-nb", "cpu");
+        commandLine.addOption("-pme", "cpu");
+        commandLine.append("-notunepme");
+
+        setenv("GMX_PME_NUM_THREADS", std::to_string(numThreads).c_str(), 1);
+        gmx_omp_nthreads_set(emntPME, numThreads);
+        const int returnValue = runner_.callMdrun(commandLine);
+        unsetenv("GMX_PME_NUM_THREADS");
+        gmx_omp_nthreads_set(emntPME, numPmeThreadsDefault);
+        ASSERT_EQ(0, returnValue);
+
+        if (thisRankChecks)
+        {
+            auto energyReader = openEnergyFileToReadFields(runner_.edrFileName_, energyNames);
+            ASSERT_TRUE(energyReader->readNextFrame());
+            const EnergyFrame &energyFrame   = energyReader->frame();
+            auto               energyChecker = rootChecker.checkCompound("Step", "Energies");
+            energyChecker.setDefaultTolerance(relativeToleranceAsFloatingPoint(energyFrame.at("Potential"), 1e-5));
+            for (const std::string &energyName : energyNames)
+            {
+                energyChecker.checkReal(energyFrame.at(energyName), energyName.c_str());
+            }
+
+            TrajectoryFrameReader trajectoryReader(runner_.fullPrecisionTrajectoryFileName_);
+            ASSERT_TRUE(trajectoryReader.readNextFrame());
+            const TrajectoryFrame     trajectoryFrame = trajectoryReader.frame();
+            const ArrayRef<const RVec> forces         = trajectoryFrame.f();
+            real                       maxForce       = 0;
+            for (const RVec &force : forces)
+            {
+                maxForce = std::max(maxForce, norm(force));
+            }
+            auto forceChecker = rootChecker.checkCompound("Step", "Forces");
+            forceChecker.setDefaultTolerance(relativeToleranceAsFloatingPoint(maxForce, 1e-4));
+            forceChecker.checkSequence(forces.begin(), forces.end(), "Force");
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithAndWithoutFep, PmeLjLorentzBerthelotTest,
+                        ::testing::Combine(::testing::Bool(), ::testing::Values("PME", "Reaction-Field")));
+
 }  // namespace
 }  // namespace test
 }  // namespace gmx
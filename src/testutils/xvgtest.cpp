@@ -49,7 +49,9 @@
 
 #include <vector>
 
+#include "gromacs/fileio/xvgr.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textstream.h"
 
@@ -144,6 +146,22 @@ void checkXvgFile(TextInputStream        *input,
     legendChecker.checkTextBlock(legendText, "XvgLegend");
 }
 
+std::vector<double> readXvgColumn(const std::string &fileName, int column)
+{
+    double            **data;
+    int                 numColumns;
+    int                 numRows = read_xvg(fileName.c_str(), &data, &numColumns);
+    GMX_RELEASE_ASSERT(column < numColumns, "The xvg file has too few columns");
+    std::vector<double> values(data[column], data[column] + numRows);
+    for (int i = 0; i < numColumns; i++)
+    {
+        sfree(data[i]);
+    }
+    sfree(data);
+
+    return values;
+}
+
 TextBlockMatcherPointer XvgMatch::createMatcher() const
 {
     return TextBlockMatcherPointer(new XvgMatcher(settings_));
@@ -45,6 +45,7 @@
 #define GMX_TESTUTILS_XVGTESTS_H
 
 #include <string>
+#include <vector>
 
 #include "testutils/testasserts.h"
 #include "testutils/textblockmatchers.h"
@@ -88,6 +89,17 @@ void checkXvgFile(TextInputStream        *input,
                   TestReferenceChecker   *checker,
                   const XvgMatchSettings &settings);
 
+/*! \brief
+ * Reads one data column of an xvg file.
+ *
+ * \param[in] fileName Name of the xvg file.
+ * \param[in] column   Index of the column to return, 0 is the x value.
+ *
+ * Use this to compare data between xvg files written by the tool under
+ * test, when the values are not checked against reference data.
+ */
+std::vector<double> readXvgColumn(const std::string &fileName, int column);
+
 /*! \libinternal \brief
  * Match the contents as an xvg file.
  *